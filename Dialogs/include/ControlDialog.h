@@ -62,6 +62,8 @@ struct ControlStruct {
   double Accuracy;
   double AccuracyL;
   bool   use_fractional_tune;
+  bool   use_ad_gradient;      // fitter: gradient by forward-mode differentiation
+  bool   use_least_squares;    // fitter: Levenberg-Marquardt instead of steepest descent
 
   ControlStruct( ControlStruct const& o); 
   ControlStruct(); 
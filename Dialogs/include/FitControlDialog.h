@@ -47,6 +47,8 @@ namespace Ui { class FitControlDialog;}
 struct FitControlStruct {
 
   bool   use_fractional_tune;
+  bool   use_ad_gradient;
+  bool   use_least_squares;
 
 };
 
@@ -61,6 +61,8 @@ ControlStruct::ControlStruct()
   IsRingCh         = false;
   AccuracyL           = 0.0;
   use_fractional_tune = false;
+  use_ad_gradient     = true;
+  use_least_squares   = true;
 
 
 }
@@ -89,6 +91,8 @@ ControlStruct& ControlStruct::operator=( ControlStruct const& rhs )
   Accuracy         = rhs.Accuracy;
   AccuracyL        = rhs.AccuracyL;
   use_fractional_tune = rhs.use_fractional_tune;
+  use_ad_gradient     = rhs.use_ad_gradient;
+  use_least_squares   = rhs.use_least_squares;
 
   return *this; 
 }
@@ -125,6 +129,8 @@ ControlDialog::ControlDialog(QWidget* parent)
   data_.Accuracy         = 1.0e-7;
   data_.AccuracyL        = 1.0e-7;
   data_.use_fractional_tune    = false;
+  data_.use_ad_gradient        = true;
+  data_.use_least_squares      = true;
 }
 
 
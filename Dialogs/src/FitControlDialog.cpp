@@ -72,6 +72,15 @@ void FitControlDialog::set()
   else { 
     ui_->radioButtonFullTune->setChecked(true);
   }
+
+  ui_->checkBoxADGradient->setChecked(data_.use_ad_gradient);
+
+  if (data_.use_least_squares) {
+    ui_->radioButtonLeastSquares->setChecked(true);
+  }
+  else { 
+    ui_->radioButtonSteepestDescent->setChecked(true);
+  }
 }
 
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
@@ -86,6 +95,9 @@ void FitControlDialog::accept()
     data_.use_fractional_tune = false;
   }    
 
+  data_.use_ad_gradient   = ui_->checkBoxADGradient->isChecked();
+  data_.use_least_squares = ui_->radioButtonLeastSquares->isChecked();
+
   QDialog::accept();
 }
 
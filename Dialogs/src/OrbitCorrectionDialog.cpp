@@ -0,0 +1,115 @@
+//  =================================================================
+//
+//  OrbitCorrectionDialog.cpp
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+#include <OrbitCorrectionDialog.h>
+#include <OrbitResponse.h>
+#include <ui_orbit_correction_dialog.h>
+
+OrbitCorrectionStruct::OrbitCorrectionStruct()
+  : method(OrbitResponse::SVD),
+    cutoff(1.0e-3),
+    lambda(1.0e-2),
+    ncorrectors(10),
+    xplane(true),
+    yplane(true),
+    monitors("*"),
+    correctors("*"),
+    MatchCase(false),
+    apply(false)
+{}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+OrbitCorrectionDialog::OrbitCorrectionDialog( QWidget* parent) 
+: QDialog(parent), ui_(new Ui::OrbitCorrectionDialog)
+{
+   ui_->setupUi(this);
+
+   ui_->comboBoxMethod->addItem("SVD",      int(OrbitResponse::SVD) );
+   ui_->comboBoxMethod->addItem("Tikhonov", int(OrbitResponse::Tikhonov) );
+   ui_->comboBoxMethod->addItem("MICADO",   int(OrbitResponse::Micado) );
+
+   ui_->spinBoxNCorrectors->setRange(1,10000);
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+OrbitCorrectionDialog::~OrbitCorrectionDialog()
+{
+  delete ui_; 
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+
+void OrbitCorrectionDialog::accept()
+{
+  data_.method      = ui_->comboBoxMethod->itemData( ui_->comboBoxMethod->currentIndex()).toInt(); 
+  data_.cutoff      = ui_->doubleSpinBoxCutoff->value();
+  data_.lambda      = ui_->doubleSpinBoxLambda->value();
+  data_.ncorrectors = ui_->spinBoxNCorrectors->value();
+  data_.xplane      = ui_->checkBoxX->isChecked();
+  data_.yplane      = ui_->checkBoxY->isChecked();
+  data_.monitors    = ui_->lineEditMonitors->text().toStdString();
+  data_.correctors  = ui_->lineEditCorrectors->text().toStdString();
+  data_.MatchCase   = ui_->checkBoxMatchCase->isChecked();
+  data_.apply       = ui_->checkBoxApply->isChecked();
+
+  QDialog::accept();
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+
+void OrbitCorrectionDialog::set()
+{
+  ui_->comboBoxMethod->setCurrentIndex( ui_->comboBoxMethod->findData(data_.method) );
+  ui_->doubleSpinBoxCutoff->setValue(data_.cutoff);
+  ui_->doubleSpinBoxLambda->setValue(data_.lambda);
+  ui_->spinBoxNCorrectors->setValue(data_.ncorrectors);
+  ui_->checkBoxX->setChecked(data_.xplane);
+  ui_->checkBoxY->setChecked(data_.yplane);
+  ui_->lineEditMonitors->setText(QString::fromStdString(data_.monitors));
+  ui_->lineEditCorrectors->setText(QString::fromStdString(data_.correctors));
+  ui_->checkBoxMatchCase->setChecked(data_.MatchCase);
+  ui_->checkBoxApply->setChecked(data_.apply);
+}
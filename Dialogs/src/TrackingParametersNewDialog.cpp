@@ -51,6 +51,7 @@ TrackingParametersNewDialog::TrackingParametersNewDialog( QWidget* parent)
 
   ui_->spinBoxNTurn->setRange(1,100000 );
   ui_->spinBoxNElm->setRange( 1,100000 );
+  ui_->spinBoxCheckpoint->setRange(0,100000 );
   ui_->spinBoxNElm->setValue(data_.ielm  );
   ui_->lineEditFilter->setEnabled(false); 
   ui_->spinBoxNElm->setEnabled(false); 
@@ -81,6 +82,8 @@ void TrackingParametersNewDialog::accept()
   data_.IncrementTurns =  ui_->checkBoxIncrementTurn->isChecked();
   //data_.FastTracking   =  ui_->checkBoxFastTracking->isChecked();
   data_.PrintResults   =  ui_->checkBoxPrintResults->isChecked();
+  data_.CheckpointInterval = ui_->spinBoxCheckpoint->value();
+  data_.Resume         =  ui_->checkBoxResume->isChecked();
   strcpy(data_.Filter, ui_->lineEditFilter->text().toUtf8().data());
 
   if (ui_->radioButtonAll->isChecked() )       data_.dataspec = TrackerParameters::all;
@@ -100,6 +103,8 @@ void TrackingParametersNewDialog::set(TrackerParameters const& data)
   ui_->checkBoxMatchCase->setChecked(data.MatchCase );  
   //ui_->checkBoxFastTracking->setChecked( data.FastTracking );
   ui_->checkBoxPrintResults->setChecked( data.PrintResults );
+  ui_->spinBoxCheckpoint->setValue( data.CheckpointInterval );
+  ui_->checkBoxResume->setChecked( data.Resume );
   ui_->lineEditFilter->setText(data.Filter); 
   ui_->radioButtonAll->setChecked( data.all );
 }
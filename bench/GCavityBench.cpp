@@ -0,0 +1,206 @@
+//  =================================================================
+//
+//  GCavityBench.cpp
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+
+// Benchmark of the GCavity field integration (src/GCavity.cpp): transfer matrix accuracy against 
+// step count, for the adaptive Dormand-Prince scheme and for the fixed step rk3 scheme it replaced. 
+//
+// Build with the bench targets (cmake -DOPTIMX_BENCH=ON .. && make gcavitybench) and run: 
+//
+//   ./gcavitybench [energy]
+//
+// The cavity is a synthetic 5 cell, 805 MHz standing wave structure (gain 5 MeV, phase -30 deg)
+// for protons of kinetic energy [MeV] (default 100). The reference matrix is computed with 
+// rtol = 1e-13. For each scheme, the table gives the no of integration steps, the largest 
+// deviation of a matrix element from the reference, and the time of GCavity::rmatrix(): for the 
+// adaptive scheme, on the first pass (mesh computed) and on later passes (cached mesh).  
+//  =================================================================
+
+#include <Element.h>
+#include <Cavity.h>
+#include <DormandPrince.h>
+#include <RMatrix.h>
+#include <SplineInterpolator.h>
+#include <Structs.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+  double const ms      = 938.27208816;    // proton [MeV]
+  double const lambda  = 37.24;           // rf wavelength [cm] 
+  double const gain    = 5.0;             // [MeV]
+  double const phase   = -30.0;           // [deg]
+  int    const ncells  = 5;
+
+  using clock = std::chrono::steady_clock;
+
+  //.......................................................................................
+
+  void fieldTable( ExtData& ext, double energy)
+  {
+    double gamma = 1.0 + energy/ms;
+    double beta  = sqrt(1.0 - 1.0/(gamma*gamma));
+    double cell  = 0.5*beta*lambda;
+    int    n     = 101*ncells; 
+
+    std::snprintf(ext.name, sizeof(ext.name), "BENCH");
+    ext.n = n;
+    ext.x.resize(n);
+    ext.y.resize(n);
+    for (int i=0; i<n; ++i) {
+      double x  = ncells*cell*i/(n-1);
+      double u  = x/(ncells*cell);
+      ext.x[i]  = x;
+      ext.y[i]  = sin(M_PI*x/cell)*(1.0 - 0.5*pow(2.0*u-1.0, 8));  // end cells at reduced field 
+    }
+  }
+
+  //.......................................................................................
+
+  void setup( GCavity& cav, ExtData const& ext, int* nstep, double rtol)
+  {
+    double dat[] = { ext.x.back()-ext.x.front(), gain, phase, lambda, 0.0 };
+    cav.setParameters(5, dat, &ext, nstep);    // also drops the cached meshes 
+    cav.rtol_ = rtol;
+    cav.atol_ = 1.0e-3*rtol;
+  }
+
+  //.......................................................................................
+
+  RMatrix matrix( GCavity const& cav, double energy)
+  {
+    double alfap = 0.0;
+    double tetaY = 0.0;
+    return cav.rmatrix(alfap, energy, ms, tetaY, 0.0);
+  }
+
+  //.......................................................................................
+
+  double deviation( RMatrix const& m, RMatrix const& ref)
+  {
+    double d = 0.0;
+    for (int i=0; i<6; ++i) {
+      for (int j=0; j<6; ++j) d = std::max(d, std::fabs(m[i][j]-ref[i][j]));
+    }
+    return d;
+  }
+
+  //.......................................................................................
+
+  int meshSteps( ExtData const& ext, double energy, double rtol)
+  {
+    // the mesh of GCavity::fieldMatrix(), recomputed through the same static functions  
+
+    SplineInterpolator f(&ext.x[0], &ext.y[0], ext.n);
+    ODEparam p;
+    p.fieldtbl = &ext;
+    p.field    = &f;
+    p.ms       = ms;
+    p.wavelen  = lambda;
+
+    DormandPrince::Tolerance tol;
+    tol.rtol = rtol;
+    tol.atol = 1.0e-3*rtol;
+    DormandPrince dp(tol);
+    if (GCavity::get_cav_phase(energy, gain, &p, 0, &dp)) return -1;
+    return dp.steps();
+  }
+
+  //.......................................................................................
+
+  double millis( clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); }
+
+}
+
+//|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int main(int argc, char* argv[])
+{
+  double energy = (argc > 1) ? std::atof(argv[1]) : 100.0;
+  int    passes = 20;
+
+  ExtData ext;
+  fieldTable(ext, energy);
+
+  int     nstep = 100;
+  GCavity cav("WBENCH");
+
+  setup(cav, ext, &nstep, 1.0e-13);
+  RMatrix ref = matrix(cav, energy);
+
+  std::printf("energy %g MeV, %d cells, field table of %d points\n\n", energy, ncells, ext.n);
+  std::printf("%-16s %8s %12s %12s %12s\n", "scheme", "steps", "max |dM|", "first [ms]", "next [ms]");
+
+  static double const rtols[] = { 1.0e-6, 1.0e-8, 1.0e-10, 1.0e-12 };
+  for (double rtol : rtols) {
+    setup(cav, ext, &nstep, rtol);
+    auto    t0 = clock::now();
+    RMatrix m  = matrix(cav, energy);
+    auto    t1 = clock::now();
+    for (int k=0; k<passes; ++k) m = matrix(cav, energy);
+    auto    t2 = clock::now();
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "DP rtol=%g", rtol);
+    std::printf("%-16s %8d %12.3e %12.3f %12.3f\n", name, meshSteps(ext, energy, rtol), deviation(m, ref), millis(t1-t0), millis(t2-t1)/passes);
+  }
+
+  static int const nsteps[] = { 25, 50, 100, 200, 400, 800 };
+  for (int n : nsteps) {
+    nstep = n;
+    setup(cav, ext, &nstep, 0.0);
+    auto    t0 = clock::now();
+    RMatrix m  = matrix(cav, energy);
+    auto    t1 = clock::now();
+    for (int k=0; k<passes; ++k) m = matrix(cav, energy);
+    auto    t2 = clock::now();
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "rk3 NStep=%d", n);
+    int steps = n*(1.0 + 4*sqrt(gain/energy));  // see GCavity::fieldMatrix() 
+    std::printf("%-16s %8d %12.3e %12.3f %12.3f\n", name, steps, deviation(m, ref), millis(t1-t0), millis(t2-t1)/passes);
+  }
+
+  return 0;
+}
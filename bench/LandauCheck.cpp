@@ -0,0 +1,210 @@
+//  =================================================================
+//
+//  LandauCheck.cpp
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+
+// Check of the tabulated Landau sampler (src/Landau.cpp) against the density Utility::Landau(). 
+//
+// Build with the bench targets (cmake -DOPTIMX_BENCH=ON .. && make landaucheck) and run: 
+//
+//   ./landaucheck [nsamples]
+//
+// The reference density is Utility::Landau() for lambda < 0. For lambda >= 0, where the integral 
+// evaluated by Utility::Landau() loses accuracy (its cdf is ~2.0e-3 high at lambda = 20), it is 
+// Landau::pdf(), which is Utility::Landau() below 0. The reference cdf is the integral (Simpson) of 
+// the density over [-10, lambda]; the cdf of Utility::Landau() alone is printed alongside. Three 
+// comparisons are made: 
+//
+//   - Landau::quantile(u) against the reference cdf, at fixed u 
+//   - the quantiles of nsamples draws (default 4000000) against the reference quantiles 
+//   - the mean and rms of the draws below lambda = 20 (the Landau moments do not exist) 
+//     against the truncated moments of the reference density 
+//
+// Sample statistics are reported in units of their standard error; the exit status is 1 
+// when a deviation exceeds 5 standard errors or the cdf error exceeds 1.0e-3.
+//  =================================================================
+
+#include <Landau.h>
+#include <Utility.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+  double const lo = -10.0;      // reference cdf lower limit
+  double const hi =  90.0;      // Utility::Landau() switches to its asymptotic form at 100  
+  double const h  =  1.0e-3;    // integration step 
+
+  double density( double l) { return (l < 0.0) ? Utility::Landau(l) : Landau::pdf(l); }
+
+  struct Reference {
+
+    Reference();
+
+    double cdf( double l) const;
+    double quantile( double u) const;
+
+    std::vector<double> F;      // cdf at lo + i*h 
+    std::vector<double> Fu;     // cdf of Utility::Landau() alone 
+    std::vector<double> m1;     // int lambda p  
+    std::vector<double> m2;     // int lambda^2 p  
+  };
+
+  //.......................................................................................
+
+  Reference::Reference()
+  {
+    int n = (hi-lo)/h;
+    F.resize(n+1);  Fu.resize(n+1);  m1.resize(n+1);  m2.resize(n+1);
+    double p0 = density(lo);
+    double u0 = Utility::Landau(lo);
+    for (int i=0; i<n; ++i) {
+      double a  = lo + i*h;
+      double b  = a + h;
+      double c  = a + 0.5*h;
+      double pc = density(c);
+      double p1 = density(b);
+      double uc = Utility::Landau(c);
+      double u1 = Utility::Landau(b);
+      F[i+1]  = F[i]  + h*(p0     + 4.0*pc     + p1    )/6.0;
+      Fu[i+1] = Fu[i] + h*(u0     + 4.0*uc     + u1    )/6.0;
+      m1[i+1] = m1[i] + h*(a*p0   + 4.0*c*pc   + b*p1  )/6.0;
+      m2[i+1] = m2[i] + h*(a*a*p0 + 4.0*c*c*pc + b*b*p1)/6.0;
+      p0 = p1;
+      u0 = u1;
+    }
+  }
+
+  //.......................................................................................
+
+  double interpolate( std::vector<double> const& F, double l)
+  {
+    double x = (l-lo)/h;
+    int    i = std::max(0, std::min(int(x), int(F.size())-2));
+    return F[i] + (x-i)*(F[i+1]-F[i]);
+  }
+
+  //.......................................................................................
+
+  double Reference::cdf( double l) const
+  {
+    return interpolate(F, l);
+  }
+
+  //.......................................................................................
+
+  double Reference::quantile( double u) const
+  {
+    int i = std::upper_bound(F.begin(), F.end(), u) - F.begin();
+    i = std::max(1, std::min(i, int(F.size())-1));
+    return lo + h*((i-1) + (u-F[i-1])/(F[i]-F[i-1]));
+  }
+
+}
+
+//|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int main(int argc, char* argv[])
+{
+  int nsamples = (argc > 1) ? std::atoi(argv[1]) : 4000000;
+
+  static double const us[] = { 1.0e-3, 0.01, 0.05, 0.1, 0.25, 0.5, 0.75, 0.9, 0.95 };
+
+  int       status = 0; 
+  Reference ref;
+
+  std::printf("%10s %12s %12s %12s %12s\n", "u", "quantile", "cdf(ref)", "error", "cdf(Utility)");
+  for (double u : us) {
+    double l = Landau::quantile(u);
+    double e = ref.cdf(l) - u;
+    if (std::fabs(e) > 1.0e-3) status = 1;
+    std::printf("%10.4g %12.6f %12.6f %12.2e %12.6f\n", u, l, ref.cdf(l), e, interpolate(ref.Fu, l));
+  }
+
+  std::mt19937                           gen(12345);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  Landau                                 landau([&]() { return uniform(gen); });
+
+  auto t0 = std::chrono::steady_clock::now();
+  std::vector<double> x(nsamples);
+  for (auto& v : x) v = landau();
+  auto t1 = std::chrono::steady_clock::now();
+  std::printf("\n%d samples: %.1f ns/sample\n\n", nsamples, std::chrono::duration<double, std::nano>(t1-t0).count()/nsamples);
+
+  std::printf("%10s %12s %12s %10s\n", "u", "sampled", "reference", "sigma");
+  for (double u : us) {
+    int k = u*(nsamples-1);
+    std::nth_element(x.begin(), x.begin()+k, x.end());
+    double q  = ref.quantile(u);
+    double se = std::sqrt(u*(1.0-u)/nsamples)/density(q);
+    double d  = (x[k]-q)/se;
+    if (std::fabs(d) > 5.0) status = 1;
+    std::printf("%10.4g %12.6f %12.6f %10.2f\n", u, x[k], q, d);
+  }
+
+  double const lc = 20.0;
+  int    n  = 0;
+  double s1 = 0.0;
+  double s2 = 0.0;
+  for (double v : x) {
+    if (v >= lc) continue;
+    ++n;  s1 += v;  s2 += v*v;
+  }
+  double mean  = s1/n;
+  double var   = s2/n - mean*mean;
+  int    ic    = (lc-lo)/h;
+  double rmean = ref.m1[ic]/ref.F[ic];
+  double rvar  = ref.m2[ic]/ref.F[ic] - rmean*rmean;
+  double dmean = (mean-rmean)/std::sqrt(rvar/n);
+  double dvar  = (var-rvar)/std::sqrt(2.0*rvar*rvar/n);   // gaussian estimate; the truncated density has a heavier tail 
+  if (std::fabs(dmean) > 5.0 || std::fabs(dvar) > 5.0) status = 1;
+
+  std::printf("\n%10s %12s %12s %10s\n", "lambda<20", "sampled", "reference", "sigma");
+  std::printf("%10s %12.6f %12.6f %10.2f\n", "mean", mean, rmean, dmean);
+  std::printf("%10s %12.6f %12.6f %10.2f\n", "variance", var, rvar, dvar);
+  std::printf("%10s %12.6f %12.6f\n", "fraction", double(n)/nsamples, ref.F[ic]);
+
+  std::printf("\n%s\n", status ? "FAILED" : "passed");
+  return status;
+}
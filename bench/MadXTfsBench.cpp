@@ -0,0 +1,175 @@
+//  =================================================================
+//
+//  MadXTfsBench.cpp
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+// Benchmark of the MADX TFS importer (src/MadXTfs.cpp). 
+//
+// Build with the bench targets (cmake -DOPTIMX_BENCH=ON .. && make madxtfsbench), or from the 
+// top level directory: 
+//
+//   g++ -O2 -std=c++17 -Iinclude bench/MadXTfsBench.cpp src/MadXTfs.cpp -o madxtfsbench
+//   ./madxtfsbench [file.tfs]
+//
+// Without an argument, a synthetic twiss table of 100000 elements with 65 columns 
+// is generated in memory. The file, when given, is read into memory before timing.
+//  =================================================================
+
+#include <MadXTfs.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+  std::string synthetic(int nelm)
+  {
+    static char const* extra[] = { "MUX", "MUY", "X", "PX", "Y", "PY", "T", "PT", "WX", "PHIX", "DMUX", "WY", "PHIY", "DMUY",
+                                   "DDX", "DDPX", "DDY", "DDPY", "R11", "R12", "R21", "R22", "ENERGY", "K3L", "K3SL", "VOLT", 
+                                   "LAG", "FREQ", "HARMON", "MECH_SEP", "V_POS", "KMAX", "KMIN", "CALIB" };  
+    static char const* used[]  = { "L", "ANGLE", "K0L", "K0SL", "K1L", "K1SL", "K2L", "K2SL", "TILT", "E1", "E2", "H1", "HGAP", 
+                                   "FINT", "FINTX", "KSI", "HKICK", "VKICK", "BETX", "ALFX", "BETY", "ALFY", "DX", "DPX", "DY", "DPY" }; 
+
+    std::ostringstream os;
+    os << "@ NAME             %05s \"TWISS\"\n";
+    os << "@ TYPE             %05s \"TWISS\"\n";
+    os << "@ SEQUENCE         %05s \"RING\"\n";
+    os << "@ PARTICLE         %06s \"PROTON\"\n";
+    os << "@ MASS             %le   0.9382720882\n";
+    os << "@ ENERGY           %le   7000\n";
+    os << "@ PC               %le   6999.999937\n";
+    os << "@ GAMMA            %le   7460.522473\n";
+    os << "@ TITLE            %08s \"no-title\"\n";
+    os << "@ ORIGIN           %16s \"5.08.01 Linux 64\"\n";
+    os << "@ DATE             %08s \"01/01/26\"\n";
+    os << "@ TIME             %08s \"00.00.00\"\n";
+
+    os << "* NAME KEYWORD S";
+    for (auto c : used)  os << " " << c; 
+    for (auto c : extra) os << " " << c; 
+    os << " PARENT COMMENTS\n";
+    os << "$ %s %s %le";
+    for (auto c : used)  { (void) c; os << " %le"; }
+    for (auto c : extra) { (void) c; os << " %le"; }
+    os << " %s %s\n";
+
+    static char const* types[] = { "DRIFT", "QUADRUPOLE", "DRIFT", "SBEND", "DRIFT", "SEXTUPOLE", "MONITOR", "HKICKER", 
+                                   "DRIFT", "QUADRUPOLE", "DRIFT", "RBEND", "DRIFT", "MULTIPOLE", "MARKER", "VKICKER" };
+    double s = 0.0;
+    char   buf[64];
+    for (int i=0; i<nelm; ++i) {
+      char const* type = types[i%16];
+      std::string t(type);
+      double v[26] = {};
+      v[0]  = (t == "MONITOR" || t == "MARKER" || t == "MULTIPOLE") ? 0.0 : 0.5 + 0.001*(i%97);                 // L
+      v[1]  = (t == "SBEND" || t == "RBEND") ? 0.0125 : 0.0;                                                       // ANGLE
+      v[4]  = (t == "QUADRUPOLE") ? ((i%32 < 16) ? 0.0217 : -0.0217)*v[0] : ( t == "MULTIPOLE" ? 1.0e-4 : 0.0);   // K1L
+      v[6]  = (t == "SEXTUPOLE") ? 0.034*v[0] : 0.0;                                                              // K2L
+      v[13] = (t == "SBEND" || t == "RBEND") ? 0.5 : 0.0;                                                         // FINT
+      v[12] = (t == "SBEND" || t == "RBEND") ? 0.025 : 0.0;                                                       // HGAP
+      v[16] = (t == "HKICKER") ? 1.0e-5 : 0.0;                                                                    // HKICK
+      v[17] = (t == "VKICKER") ? -1.0e-5 : 0.0;                                                                   // VKICK
+      v[18] = 30.0 + 10.0*sin(0.01*i);  v[19] = cos(0.01*i);                                                      // BETX ALFX
+      v[20] = 30.0 - 10.0*sin(0.01*i);  v[21] = -cos(0.01*i);                                                     // BETY ALFY
+      v[22] = 1.5 + 0.5*cos(0.02*i);    v[23] = 0.01*sin(0.02*i);                                                 // DX DPX
+      s    += v[0];
+
+      std::snprintf(buf, sizeof(buf), "\"E%d\" \"%s\"", i, type);
+      os << " " << buf;
+      std::snprintf(buf, sizeof(buf), " %18.10e", s);
+      os << buf;
+      for (double x : v) { std::snprintf(buf, sizeof(buf), " %18.10e", x); os << buf; }
+      for (auto c : extra) { (void) c; std::snprintf(buf, sizeof(buf), " %18.10e", 1.0e-3*(i%13)); os << buf; }
+      os << " \"\" \"\"\n";
+    }
+    return os.str();
+  }
+
+}
+
+//|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int main(int argc, char* argv[])
+{
+  using clock = std::chrono::steady_clock;
+  auto ms = [](clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+
+  std::string contents;
+  if (argc > 1) {
+    std::ifstream ifs(argv[1], std::ios::binary);
+    if (!ifs) { std::cerr << "Error opening file " << argv[1] << std::endl; return 1; }
+    std::ostringstream os;
+    os << ifs.rdbuf();
+    contents = os.str();
+  }
+  else {
+    contents = synthetic(100000);
+  }
+
+  auto t0 = clock::now();
+
+  MadX::Tfs   tfs;
+  std::string err;
+  if (int line = tfs.parse(contents.data(), contents.data()+contents.size(), err)) {
+    std::cerr << "line " << line << ": " << err << std::endl;
+    return 1;
+  }
+
+  auto t1 = clock::now();
+
+  double brho = (tfs.param("PC")*1.0e9)/(2.99792458e8);
+  std::vector<std::string>                     beamline;
+  std::unordered_map<std::string, std::string> element_dict;
+  beamline.reserve(3*tfs.rows.size()/2);
+  element_dict.reserve(tfs.rows.size());
+  for (auto const& row : tfs.rows) MadX::make_element(beamline, element_dict, row, brho);
+
+  auto t2 = clock::now();
+
+  std::printf("%zu bytes, %zu rows, %zu columns\n", contents.size(), tfs.rows.size(), tfs.columns.size());
+  std::printf("parse   : %8.1f ms\n", ms(t1-t0));
+  std::printf("convert : %8.1f ms  (%zu beamline entries, %zu definitions)\n", ms(t2-t1), beamline.size(), element_dict.size());
+  std::printf("total   : %8.1f ms\n", ms(t2-t0));
+  return 0;
+}
@@ -41,6 +41,7 @@
 
 #include <utility>
 #include <string>
+#include <vector>
 #include <ostream>
 #include <complex>
 #include <SymMatrix.h>
@@ -54,13 +55,36 @@ struct sqlite3_value;
 struct sqlite3;
 
 class  Bunch;
+struct Coordinates;
 struct BeamMoments;
 
 std::ostream& operator<<( std::ostream& os, BeamMoments const& m);
 
+//.............................................................................................
+// Raw sums over a set of particles, from which the moments are computed. Partial sums
+// accumulated independently (e.g. by different threads over different blocks of particles)
+// are combined with merge().
+//.............................................................................................
+
+struct MomentSums {
+
+  MomentSums();
+
+  void add(   Coordinates const& p);
+  void merge( MomentSums const& o);
+
+  int    n;           // no of particles, including lost particles
+  int    nlost;       // no of lost particles
+  double mu[6];       // sum of coordinates
+  double smtx[6][6];  // sum of products (lower triangle only)
+  double umin[6];
+  double umax[6];
+};
+
 struct BeamMoments { 
  
   BeamMoments(double gamma, Bunch const& v, int n, bool parallel_tracking=false); 
+  BeamMoments(double gamma, MomentSums const& sums); 
   BeamMoments();
 
   double&       emitX()       { return eps[0];} 
@@ -134,9 +158,17 @@ struct BeamMoments {
   
   void dbWrite(sqlite::connection& con, int turn, int idx, int nturns);
   void  dbRead(sqlite::connection& con, std::string const& query);
+  static void dbFlush(sqlite::connection& con);   // commits the rows buffered by dbWrite  
 
   static void init_moments_table( sqlite::connection& db);
 
+  // Besides the blobs, the Moments table holds each covariance entry, centroid and min/max as a REAL
+  // column, so that queries can read them without decoding the blobs row by row. In order:
+  // cov00, cov10, cov11, ... cov55 (i>=j, the packed order of the covariance blob), avg0..5, min0..5, max0..5.
+
+  static std::vector<std::string> const& dbScalarColumns();
+  static std::string                     dbCovColumn(int i, int j); // the column holding cov[i][j]
+
   static void  initDBCustomFunctions(sqlite3* db);
   static void  initDBCustomFunctions(sqlite::connection& con);
   static void     extract_lf_xFunc( sqlite3_context* context, int n, sqlite3_value** values);
@@ -147,6 +179,8 @@ struct BeamMoments {
  
   void          compute_moments( Bunch const& v, double* mu, SymMatrix_t<6,double>& sigma_mtx,  RMatrix_t<4,double>& sigma4_mtx);
   void compute_moments_parallel( Bunch const& v, double* mu, SymMatrix_t<6,double>& sigma_mtx,  RMatrix_t<4,double>& sigma4_mtx);
+  void    compute_moments_sums( MomentSums const& sums, double* mu, SymMatrix_t<6,double>& sigma_mtx,  RMatrix_t<4,double>& sigma4_mtx);
+  void      compute_eigenmodes( RMatrix_t<4,double> const& sigma4_mtx);
 
 };
 
@@ -40,14 +40,19 @@
 #define BUNCH_H
 
 #include <vector>
+#include <cstdio>
 #include <Coordinates.h>
 
 class Bunch {
 
  public:
 
-  // NOTE: for now the lost_particles_ array is NOT used.
-  //       in the future, it will store lost particles, and the Coordinates::lost attribute will be eliminated. 
+  // Particles are kept in two ranges. The active range [0, active()) holds the particles that are
+  // still tracked (lost particles not yet compacted included); it is followed by the particles removed
+  // by compact(). A copy of every removed particle (pid, nelem, npass and coordinates at loss) is kept
+  // in lostParticles() and counted in the loss profile, a histogram of losses indexed by element
+  // (Coordinates::nelem, 1-based). Compaction is stable, so that survivors keep their relative order;
+  // particles are identified by their pid.
 
   typedef std::vector<Coordinates>::iterator iterator;  
   typedef std::vector<Coordinates>::const_iterator const_iterator;  
@@ -58,12 +63,18 @@ class Bunch {
   Coordinates const& operator[](int i) const { return particles_[i]; } 
   Coordinates&       operator[](int i)       { return particles_[i]; } 
 
-  std::vector<int>& lossProfile();  
+  int  compact();                                // moves lost particles out of the active range; returns the no removed 
+  std::vector<int>&  lossProfile();              // compacts and returns the loss histogram (per element)
+  std::vector<Coordinates> const& lostParticles() const { return lost_particles_; } 
 
   int    size()     const;      // to TOTAL no of particles
+  int    active()   const { return active_; }  // the no of particles in the active range   
   int    nlost()    const;      // the no of lost particles
 
-  void resize(unsigned int n)        { lost_particles_.resize(0); particles_.resize(n); }
+  int  write(FILE* fp) const;                    // binary (native byte order) dump of the full state; returns 0 on success 
+  int  read(FILE* fp);                           // restores a state written by write(); returns 0 on success 
+
+  void resize(unsigned int n)        { lost_particles_.resize(0); loss_profile_.resize(0); particles_.resize(n); active_ = n; }
 
   iterator begin() {return particles_.begin(); } 
   iterator end()   {return particles_.end(); } 
@@ -77,6 +88,7 @@ private:
   std::vector<Coordinates>      particles_;   
   std::vector<Coordinates> lost_particles_;   
   std::vector<int>           loss_profile_; 
+  int                              active_;
 };
 
 
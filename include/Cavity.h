@@ -43,17 +43,19 @@
 #include <RMatrixFwd.h>
 
 struct  ODEparam;
+class   SplineInterpolator;
 
 enum INTEGRERR { NO_ERR, SPLINE_ERR, SMALL_STEP, TOO_MANY_STEPS, No_Conv_Phase };
 
 
 struct ODEparam {
-    ExtData const* fieldtbl;
-    double         ampl;
-    double         ms;
-    double         wavelen;
-    double         phase;
-    double         phase0;
+    ExtData const*            fieldtbl;
+    SplineInterpolator const* field;     // interpolation of fieldtbl  
+    double                    ampl;
+    double                    ms;
+    double                    wavelen;
+    double                    phase;
+    double                    phase0;
 };
 
 
@@ -0,0 +1,108 @@
+//  =================================================================
+//
+//  ClosedOrbit.h
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+
+#ifndef CLOSEDORBIT_H
+#define CLOSEDORBIT_H
+
+#include <memory>
+#include <vector>
+#include <RMatrix.h>
+#include <Coordinates.h>
+
+class Element;
+
+//....................................................................................................
+// Closed orbit of the nonlinear one-turn map, by Newton iterations. 
+//
+// The Jacobian of the one-turn map is obtained together with the map itself, in a single
+// tracked pass which propagates the tangent map through the elements (Element::trackTangent).
+// The Jacobian from the last solution is kept and reused as long as the iterations converge
+// fast enough, so that the orbit can be updated after a small change of the lattice (e.g. a
+// corrector knob step) at the cost of a couple of plain tracked passes, plus one tangent pass
+// at the solution. 
+//
+// In 4D mode, dp/p = v[5] is fixed and only the transverse coordinates are closed.   
+//....................................................................................................
+
+class ClosedOrbit {
+
+ public:
+
+  enum Status { converged = 0, lost = 1, singular = 2, maxiters = 3 };
+
+  ClosedOrbit();
+
+  Status operator()( std::vector<std::shared_ptr<Element>> const& line, double ms, double Enr, double tetaY,
+                     Coordinates& v, int dim=4 );
+
+  // one pass through line; jac (if not null) is multiplied by the Jacobian of the pass and record (if not null) receives
+  // the coordinates at the exit of every element. Returns 0, or the (1-based) index of the element where the particle is lost.   
+
+  static int track( std::vector<std::shared_ptr<Element>> const& line, double ms, double Enr, double tetaY,
+                    Coordinates& v, int turn=0, RMatrix* jac=0, std::vector<Coordinates>* record=0 );
+
+  // Jacobian of the one-turn map about v by central differences of tracked passes (step h). Unlike map(), 
+  // it includes the full momentum dependence of every element, e.g. the chromatic focusing of quadrupoles
+  // and bends. Returns 0, or the (1-based) index of the element where a displaced particle is lost.   
+
+  static int jacobian( std::vector<std::shared_ptr<Element>> const& line, double ms, double Enr, double tetaY,
+                       Coordinates const& v, RMatrix& m, double h=1.0e-7 );
+
+  RMatrix const& map()   const { return jac_;    }   // linearized one-turn map about the closed orbit  
+  int     iterations()   const { return niters_; }
+  int     tangentPasses() const { return njac_;  }   
+
+  void    reuseJacobian( bool reuse) { reuse_ = reuse; }
+  void    maxIterations( int n)      { maxiters_ = n; }
+  void    tolerance( double tol)     { tol_ = tol; }
+  void    reset()                    { valid_ = false; }   // discard the cached Jacobian 
+
+ private:
+
+  RMatrix jac_;
+  bool    valid_;
+  bool    reuse_;
+  int     dim_;
+  int     maxiters_;
+  double  tol_;
+  int     niters_;
+  int     njac_;
+};
+
+#endif // CLOSEDORBIT_H
@@ -0,0 +1,101 @@
+//  =================================================================
+//
+//  DormandPrince.h
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+#ifndef DORMANDPRINCE_H
+#define DORMANDPRINCE_H
+
+#include <vector>
+#include <Cavity.h>
+
+//....................................................................................................
+// Embedded Runge-Kutta integrator of Dormand and Prince, order 5(4), with dense output. 
+// 
+// integrate() adapts the step to the requested tolerance: a step is accepted when the rms of the
+// error estimate, scaled by atol + rtol*|y|, is below 1. The mesh of accepted steps is recorded.
+// replay() integrates (possibly another system, or from other initial values) along the recorded
+// mesh, without error control: the trajectories of a finite difference (e.g. the columns of a transfer
+// matrix) then share the same discretization, and a mesh computed once can be reused (cached) for 
+// later passes. After either, dense() returns the solution anywhere in the interval (4th order 
+// continuous extension).
+//
+// The right-hand side has the signature of the functions used with odeintfs() (field map elements).  
+//....................................................................................................
+
+class DormandPrince {
+
+ public:
+
+  typedef INTEGRERR (*Derivs)(double x, double* y, double* dy, ODEparam* p);
+
+  struct Tolerance {
+    double rtol     = 1.0e-9;    // relative tolerance  
+    double atol     = 1.0e-12;   // absolute tolerance 
+    int    maxsteps = 100000;    // max no of steps (accepted and rejected) 
+  };
+
+  DormandPrince();
+  explicit DormandPrince( Tolerance const& tol);
+
+  INTEGRERR integrate( double x1, double x2, int nvar, double ystart[], Derivs derivs, ODEparam* p); // ystart is replaced by y(x2)
+  INTEGRERR replay( int nvar, double ystart[], Derivs derivs, ODEparam* p);                          // along the recorded mesh 
+
+  bool dense( double x, double y[]) const;   // y(x) from the last integration; false if x is out of range 
+
+  void                       setMesh( std::vector<double> const& mesh) { mesh_ = mesh; }
+  std::vector<double> const& mesh()        const { return mesh_; }                 // x1, ..., x2
+  int                        steps()       const { return mesh_.empty() ? 0 : mesh_.size()-1; }
+  int                        evaluations() const { return nfev_; }                 // right-hand side evaluations, since construction 
+
+ private:
+
+  void      resize( int nvar);
+  INTEGRERR step( double x, double h, double const y[], Derivs derivs, ODEparam* p);  // k_[0] = f(x,y) on entry 
+  double    error( double h, double const y[]) const;
+  void      keep( double h, double const y[]);                                        // dense output coefficients of the step 
+
+  Tolerance            tol_;
+  int                  nvar_;
+  int                  nfev_;
+  std::vector<double>  mesh_;
+  std::vector<double>  cont_;   // 5*nvar_ dense output coefficients per step  
+  std::vector<double>  k_;      // 7*nvar_ stages; k_[6] = f(x+h, ynew_) is k_[0] of the next step (FSAL)  
+  std::vector<double>  ytmp_;
+  std::vector<double>  ynew_;
+};
+
+#endif // DORMANDPRINCE_H
@@ -0,0 +1,179 @@
+//  =================================================================
+//
+//  Dual.h
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+
+#ifndef DUAL_H
+#define DUAL_H
+
+#include <array>
+#include <cmath>
+#include <ostream>
+
+//.............................................................................
+// Forward-mode automatic differentiation.
+//
+// A Dual_t<N> carries a value and the partial derivatives of that value with
+// respect to N independent parameters. Arithmetic and the elementary
+// functions below propagate the derivatives exactly (chain rule), so that a
+// single evaluation of an expression yields both its value and its gradient.
+//
+// Comparisons act on the value only. This is what is needed for the branches
+// (focusing vs defocusing, zero field etc.) found in the matrix computations.
+//.............................................................................
+
+template <int N>
+class Dual_t {
+
+ public:
+
+  constexpr Dual_t()           : v_(0.0), d_{} {}
+  constexpr Dual_t( double v ) : v_(v),   d_{} {}              // a constant: all derivatives vanish
+
+  static Dual_t variable(double v, int i, double seed=1.0) { Dual_t x(v); x.d_[i] = seed; return x; }
+
+  double  value()            const { return v_;    }
+  double  deriv(int i)       const { return d_[i]; }
+  double& deriv(int i)             { return d_[i]; }
+
+  Dual_t& operator+=( Dual_t const& rhs) { v_ += rhs.v_; for (int i=0; i<N; ++i) d_[i] += rhs.d_[i]; return *this; }
+  Dual_t& operator-=( Dual_t const& rhs) { v_ -= rhs.v_; for (int i=0; i<N; ++i) d_[i] -= rhs.d_[i]; return *this; }
+
+  Dual_t& operator*=( Dual_t const& rhs)
+  {
+    for (int i=0; i<N; ++i) d_[i] = d_[i]*rhs.v_ + v_*rhs.d_[i];
+    v_ *= rhs.v_;
+    return *this;
+  }
+
+  Dual_t& operator/=( Dual_t const& rhs)
+  {
+    double inv = 1.0/rhs.v_;
+    for (int i=0; i<N; ++i) d_[i] = (d_[i] - v_*inv*rhs.d_[i])*inv;
+    v_ *= inv;
+    return *this;
+  }
+
+  Dual_t& operator+=( double rhs) { v_ += rhs; return *this; }
+  Dual_t& operator-=( double rhs) { v_ -= rhs; return *this; }
+  Dual_t& operator*=( double rhs) { v_ *= rhs; for (int i=0; i<N; ++i) d_[i] *= rhs; return *this; }
+  Dual_t& operator/=( double rhs) { return (*this) *= (1.0/rhs); }
+
+  Dual_t  operator-() const { Dual_t r(*this); r.v_ = -v_; for (int i=0; i<N; ++i) r.d_[i] = -d_[i]; return r; }
+
+  // f(x) given f(v) and f'(v)
+
+  Dual_t  chain( double f, double df) const { Dual_t r(f); for (int i=0; i<N; ++i) r.d_[i] = df*d_[i]; return r; }
+
+ private:
+
+  double               v_;
+  std::array<double,N> d_;
+};
+
+//.............................................................................
+
+template <int N> inline Dual_t<N> operator+( Dual_t<N> lhs, Dual_t<N> const& rhs) { return lhs += rhs; }
+template <int N> inline Dual_t<N> operator-( Dual_t<N> lhs, Dual_t<N> const& rhs) { return lhs -= rhs; }
+template <int N> inline Dual_t<N> operator*( Dual_t<N> lhs, Dual_t<N> const& rhs) { return lhs *= rhs; }
+template <int N> inline Dual_t<N> operator/( Dual_t<N> lhs, Dual_t<N> const& rhs) { return lhs /= rhs; }
+
+template <int N> inline Dual_t<N> operator+( Dual_t<N> lhs, double rhs) { return lhs += rhs; }
+template <int N> inline Dual_t<N> operator-( Dual_t<N> lhs, double rhs) { return lhs -= rhs; }
+template <int N> inline Dual_t<N> operator*( Dual_t<N> lhs, double rhs) { return lhs *= rhs; }
+template <int N> inline Dual_t<N> operator/( Dual_t<N> lhs, double rhs) { return lhs /= rhs; }
+
+template <int N> inline Dual_t<N> operator+( double lhs, Dual_t<N> rhs) { return rhs += lhs; }
+template <int N> inline Dual_t<N> operator-( double lhs, Dual_t<N> const& rhs) { return (-rhs) += lhs; }
+template <int N> inline Dual_t<N> operator*( double lhs, Dual_t<N> rhs) { return rhs *= lhs; }
+template <int N> inline Dual_t<N> operator/( double lhs, Dual_t<N> const& rhs) { return Dual_t<N>(lhs) /= rhs; }
+
+template <int N> inline bool operator< ( Dual_t<N> const& lhs, Dual_t<N> const& rhs) { return lhs.value() <  rhs.value(); }
+template <int N> inline bool operator> ( Dual_t<N> const& lhs, Dual_t<N> const& rhs) { return lhs.value() >  rhs.value(); }
+template <int N> inline bool operator< ( Dual_t<N> const& lhs, double rhs) { return lhs.value() <  rhs; }
+template <int N> inline bool operator> ( Dual_t<N> const& lhs, double rhs) { return lhs.value() >  rhs; }
+template <int N> inline bool operator<=( Dual_t<N> const& lhs, double rhs) { return lhs.value() <= rhs; }
+template <int N> inline bool operator>=( Dual_t<N> const& lhs, double rhs) { return lhs.value() >= rhs; }
+template <int N> inline bool operator!=( Dual_t<N> const& lhs, double rhs) { return lhs.value() != rhs; }
+template <int N> inline bool operator==( Dual_t<N> const& lhs, double rhs) { return lhs.value() == rhs; }
+
+//.............................................................................
+// elementary functions (found by ADL)
+//.............................................................................
+
+template <int N> inline Dual_t<N> sqrt( Dual_t<N> const& x) { double s = std::sqrt(x.value()); return x.chain( s, 0.5/s); }
+template <int N> inline Dual_t<N>  sin( Dual_t<N> const& x) { return x.chain( std::sin(x.value()),   std::cos(x.value()));  }
+template <int N> inline Dual_t<N>  cos( Dual_t<N> const& x) { return x.chain( std::cos(x.value()),  -std::sin(x.value()));  }
+template <int N> inline Dual_t<N> sinh( Dual_t<N> const& x) { return x.chain( std::sinh(x.value()),  std::cosh(x.value())); }
+template <int N> inline Dual_t<N> cosh( Dual_t<N> const& x) { return x.chain( std::cosh(x.value()),  std::sinh(x.value())); }
+template <int N> inline Dual_t<N> fabs( Dual_t<N> const& x) { return x.value() < 0.0 ? -x : x; }
+template <int N> inline Dual_t<N>  abs( Dual_t<N> const& x) { return fabs(x); }
+
+template <int N>
+inline Dual_t<N> atan2( Dual_t<N> const& y, Dual_t<N> const& x)
+{
+  // d atan2(y,x) = (x dy - y dx)/(x^2 + y^2)
+
+  double r2 = x.value()*x.value() + y.value()*y.value();
+  Dual_t<N> r = (x*y.chain(0.0, 1.0) - y*x.chain(0.0, 1.0))/r2;  // derivative part only  
+  r += std::atan2(y.value(), x.value());
+  return r;
+}
+
+template <int N>
+inline Dual_t<N> modf( Dual_t<N> const& x, double* intpart)
+{
+  // the integer part is locally constant
+  return x.chain( std::modf(x.value(), intpart), 1.0);
+}
+
+//.............................................................................
+// uniform access to the value of a scalar, whether it is a dual or a double
+//.............................................................................
+
+inline double                  primal( double x)           { return x; }
+template <int N> inline double primal( Dual_t<N> const& x) { return x.value(); }
+
+template <int N>
+std::ostream& operator<<( std::ostream& os, Dual_t<N> const& x)
+{
+  os << x.value() << " [";
+  for (int i=0; i<N; ++i) os << (i ? " " : "") << x.deriv(i);
+  return os << "]";
+}
+
+#endif // DUAL_H
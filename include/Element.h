@@ -51,15 +51,22 @@
 
 class Channel;
 class Beamline;
+class Bunch;
+class DormandPrince;
 
 struct ExtData;
 struct TrackParam;
 
+template <int NO, int NV> class Tpsa_t;
+using Tpsa = Tpsa_t<6,6>;   // see Tpsa.h 
+
 class  element_private_access;
 
 class Element {
 
   friend class element_private_access;
+  friend class LatticeProgram;        // loss tests 
+  friend class SliceArena;            // slice(), assign() 
   
  public:
    static std::string type(char etype); 
@@ -78,7 +85,8 @@ class Element {
 
    virtual Element* clone() const;
 
-   virtual Element*      split(int nslices) const;      // return a sliced element
+   Element*              split(int nslices) const;      // return a sliced element (a new copy; see also SliceRef) 
+   virtual bool     splittable() const { return true; } // false if a slice is the whole element 
 
    char  etype()  const;                          // the element type, encoded as a single upper case character
    
@@ -100,6 +108,9 @@ class Element {
    double tilt() const; 
    double tilt(double val); 
    double tiltErr() const; 
+   double tiltErr(double val); 
+   double fieldErr() const;             // relative dipole field error of a bend, applied as a kick (error studies) 
+   double fieldErr(double val); 
 
    int    plane() const; 
   
@@ -120,6 +131,9 @@ class Element {
    void virtual preTrack( double ms,    double Enr0,  double tetaY, int n_elem, TrackParam& prm, RMatrix& m1) const;
    int  virtual trackOnce( double ms,   double& Enr0,    int n_elem, int n_turn, TrackParam& prm, RMatrix const& m1, Coordinates& v) const;
    int  virtual     track( double ms,   double& Enr0,  Coordinates& v, double& tetaY ) const; // track trajectory
+   int  virtual trackTangent( double ms, double& Enr0, int n_elem, int n_turn, TrackParam& prm, RMatrix const& m1, Coordinates& v, RMatrix& jac) const; // track and propagate the tangent map 
+   int  virtual trackMap( double ms, double& Enr0, int n_elem, TrackParam& prm, RMatrix const& m1, Tpsa* u) const; // propagate a truncated power series map u[6] 
+   int  virtual trackBunch( double ms, double Enr0, int n_elem, int n_turn, TrackParam& prm, RMatrix const& m1, Bunch& v, int N, bool parallel) const; // particles [0,N) of v 
 
    //.......................................................................................
    // new interface ... 
@@ -151,6 +165,9 @@ class Element {
    
  protected: 
 
+  virtual  void slice( int nslices);           // in place: reduce this copy to one of nslices equal slices   
+  virtual  void assign( Element const& o);     // copy the parameters of o (same type) reusing the storage of this element  
+
   static   int backwardTest( TrackParam& pm, int n_elem, int n_turn, Coordinates& v); 
   static   int transAmpTest( TrackParam& pm, int n_elem, int n_turn, Coordinates& v); 
 
@@ -159,6 +176,7 @@ class Element {
 
    double        L_;  // length
    double  TiltErr_;
+   double  FieldErr_;
    int       plane_; 
    double        T_;  // Tilt ( rotation about local z-axis) 
    double ofsX_; 
@@ -186,6 +204,10 @@ class Drift : public Element {
    Drift*  clone() const;
 
    int  trackOnce( double ms,   double &Enr0,  int n_elem,   int n_turn, TrackParam& prm, RMatrix const& m1, Coordinates& v) const;
+   int  trackMap( double ms, double& Enr0, int n_elem, TrackParam& prm, RMatrix const& m1, Tpsa* u) const;
+
+   template <typename T> 
+   static void transport( double L, double ms, TrackParam const& prm, T* v); // field free region; T is double or Tpsa 
 
    void toString( char* buf) const;
    void setParameters( int np, double attributes[], ... );
@@ -204,6 +226,7 @@ class Instrument : public Element {
   Instrument& operator = (Instrument const& rhs); 
 
   int  trackOnce( double ms,   double &Enr0,  int n_elem,   int n_turn, TrackParam& prm, RMatrix const& m1, Coordinates& v) const;
+  int  trackMap( double ms, double& Enr0, int n_elem, TrackParam& prm, RMatrix const& m1, Tpsa* u) const;
 
   //virtual RMatrix rmatrix( double& alfap, double& energy, double ms, double& tetaY, double dalfa, int st=3);  
   virtual RMatrix rmatrixsc( double& alphap, double& Enr,    double ms, double current, BeamSize& bs,double& tetaY, double dalfa, int st=3 ) const;
@@ -230,6 +253,7 @@ class CFBend : public Element {
  
   void preTrack( double ms,    double Enr0,  double tetaY, int n_elem,  TrackParam& prm, RMatrix& m1) const;
   int  trackOnce( double ms,   double &Enr0,  int n_elem,   int n_turn, TrackParam& prm, RMatrix const& m1, Coordinates& v) const;
+  int  trackMap( double ms, double& Enr0, int n_elem, TrackParam& prm, RMatrix const& m1, Tpsa* u) const;
   int  track( double ms, double& Enr0,  Coordinates& v, double& tetaY ) const;
 
   void    propagate( double hr, double ms, RMatrix_t<3>& W, Vector_t<3>& R ) const; // propagate Coordinate system and postion according to OPTIMX convention 
@@ -243,6 +267,9 @@ class CFBend : public Element {
  private:
 
   void    propagate( double hr, double ms, RMatrix_t<3>& W) const; // propagate W only as Frenet-Serret. OPTIMX correction not applied.   
+
+  template <typename T> bool dipole( double ms, TrackParam const& prm, T* v) const;    // ideal dipole; false if the particle is lost 
+  template <typename T> void tiltKick( TrackParam const& prm, T* v) const;            // dipole tilt and field errors  
   
 };
 
@@ -270,7 +297,9 @@ class Edge : public Element {
 
    bool   isupstream;
    double bendGradient;
-  
+
+ protected:
+   void assign( Element const& o);
 };
 
 class Quadrupole : public Element {
@@ -282,18 +311,24 @@ class Quadrupole : public Element {
    Quadrupole& operator = (Quadrupole const& rhs); 
 
    Quadrupole*  clone() const { return new Quadrupole(*this);}
-   Quadrupole* split(int nslices) const; // return a sliced element
 
    RMatrix rmatrix( double& alfap, double& energy, double ms, double& tetaY, double dalfa, int st=3) const;
    RMatrix rmatrixsc( double& alphap, double& Enr,    double ms, double current, BeamSize& bs,double& tetaY, double dalfa, int st=3 ) const;
    RMatrix   rmatrix( RMatrix_t<3>& frame, double& energy, double ms, int st=3) const;
 
     int  trackOnce( double ms,   double &Enr0,  int n_elem,   int n_turn, TrackParam& prm, RMatrix const& m1, Coordinates& v) const;
+    int  trackMap( double ms, double& Enr0, int n_elem, TrackParam& prm, RMatrix const& m1, Tpsa* u) const;
+
+    template <typename T> 
+    void transport( double ms, TrackParam const& prm, T* v) const; // T is double or Tpsa 
 
    void toString( char* buf) const;
    void setParameters( int np, double attributes[], ... );
    void setParameters( int np, std::vector<double> const&, ... );
 
+ protected:
+
+   void slice( int nslices);
 };
 
 class Solenoid : public Element {
@@ -305,7 +340,6 @@ class Solenoid : public Element {
  ~Solenoid() {}
 
   Beamline*  splitnew(int nslices) const;      // return a sliced element as a beamline 
-  Solenoid* split(int nslices) const;
 
   int trackOnce( double ms,   double &Enr0,  int n_elem,   int n_turn, TrackParam& prm, RMatrix const& m1, Coordinates& v) const;
 
@@ -319,6 +353,9 @@ class Solenoid : public Element {
   void setParameters( int np, double attributes[], ... );
   void setParameters( int np, std::vector<double> const&, ... );
 
+ protected:
+  void slice( int nslices);
+
  private:
   static void SolLinearEdge(RMatrix& mi, double k, double a, int edge);
   static void    SolEdge(Coordinates& v, double k, double a, int edge);
@@ -337,6 +374,8 @@ class Sextupole : public Element {
   static void     sext_trans(Element const* el, double Hr, Coordinates* vp, Coordinates const* v);
 
   int  trackOnce( double ms,   double& Enr0,  int n_elem,   int n_turn, TrackParam& prm, RMatrix const& m1, Coordinates& v) const;
+  int  trackTangent( double ms, double& Enr0,  int n_elem,   int n_turn, TrackParam& prm, RMatrix const& m1, Coordinates& v, RMatrix& jac) const;
+  int  trackMap( double ms, double& Enr0, int n_elem, TrackParam& prm, RMatrix const& m1, Tpsa* u) const;
 
   // virtual RMatrix rmatrix( double& alfap, double& energy, double ms, double& tetaY, double dalfa, int st=3) const;
   virtual RMatrix rmatrixsc( double& alphap, double& Enr,    double ms, double current, BeamSize& bs,double& tetaY, double dalfa, int st=3 ) const;
@@ -360,6 +399,8 @@ class Multipole : public Element {
 
   Beamline*  splitnew(int nslices) const;      // return a sliced element as a beamline 
   int  trackOnce( double ms,   double& Enr0,  int n_elem,   int n_turn, TrackParam& prm, RMatrix const& m1, Coordinates& v) const;
+  int  trackTangent( double ms, double& Enr0,  int n_elem,   int n_turn, TrackParam& prm, RMatrix const& m1, Coordinates& v, RMatrix& jac) const;
+  int  trackMap( double ms, double& Enr0, int n_elem, TrackParam& prm, RMatrix const& m1, Tpsa* u) const;
 
   void    propagate( double hr, double ms, RMatrix_t<3>& W, Vector_t<3>& R ) const;
 
@@ -396,7 +437,7 @@ class PCavity : public Element {
    void   setParameters( int np, double attributes[], ... );
    void setParameters( int np, std::vector<double> const&, ... );
    void        toString( char* buf) const;
-   PCavity*       split( int nslices) const; // return a sliced element
+   bool       splittable() const { return false; } // the cavity is never sliced 
 
 };
 
@@ -409,6 +450,7 @@ class GCavity : public Element
   GCavity( char const* nm, char const* fnm="");
   GCavity( GCavity const& o); 
   GCavity& operator = (GCavity const& rhs); 
+  void assign( Element const& o);
 
   Beamline*  splitnew(int nslices) const;      // return a sliced element as a beamline 
 
@@ -419,7 +461,7 @@ class GCavity : public Element
   void      toString(char* buf) const;
   void setParameters(int np, double attributes[], ... );
   void setParameters( int np, std::vector<double> const&, ... );
-  GCavity*     split(int nslices) const; // return a sliced element
+  bool      splittable() const { return false; } // the cavity is never sliced 
 
   void preTrack( double ms,    double Enr0,  double tetaY, int n_elem, TrackParam& prm, RMatrix& m1) const;
   void preTrack( RMatrix_t<3>& frame, double ms,    double Enr0, int n_elem, TrackParam& prm, RMatrix& m1) const;
@@ -429,6 +471,9 @@ class GCavity : public Element
   ExtData const* ext_dat_;
   int*     NStep_;
 
+  double   rtol_;  // field integration tolerances (see DormandPrince::Tolerance); rtol_ <= 0 selects the fixed step rk3 scheme (*NStep_ steps)
+  double   atol_;
+
   SplineInterpolator e_;
   
   //ExtData const* const fieldtbl_;
@@ -444,11 +489,20 @@ class GCavity : public Element
 
   static INTEGRERR TransvEquations(double      x,  double *y,   double   *dy, ODEparam *p);
 
-  static INTEGRERR      get_energy(ODEparam   *p,  double Enr1, double *Enr2,       int n);
+  // dp != 0: the integrations replay the mesh of dp (get_cav_phase() computes it when dp has none) 
+
+  static INTEGRERR      get_energy(ODEparam   *p,  double Enr1, double *Enr2,       int n, DormandPrince* dp=0);
+
+  static INTEGRERR   get_cav_phase(double    En1,  double dEn,  ODEparam  *p,       int m, DormandPrince* dp=0);
 
-  static INTEGRERR   get_cav_phase(double    En1,  double dEn,  ODEparam  *p,       int m);
+  static INTEGRERR      get_matrix(ODEparam   *p,  double Enr1, double *Enr2,  RMatrix& m, int n, DormandPrince* dp=0);
 
-  static INTEGRERR      get_matrix(ODEparam   *p,  double Enr1, double *Enr2,  RMatrix& m, int n);
+ private:
+
+  RMatrix fieldMatrix( double& energy, double ms) const;   // integrates the field table; energy -> final energy
+
+  struct MeshCache;                                        // integration meshes, per energy and cavity setting 
+  mutable std::shared_ptr<MeshCache> meshes_;
 
 
 };
@@ -471,10 +525,12 @@ class EAcc : public Element {
   RMatrix rmatrixsc( double& alfap,  double& energy, double ms, double current, BeamSize& bs,double& tetaY, double dalfa, int st=3 ) const;
   RMatrix   rmatrix( RMatrix_t<3>& frame, double& energy, double ms, int st=3) const;
   
-  EAcc*  split(int nslices) const;
   void toString(char* buf) const;
   void setParameters( int np, double attributes[], ... );
   void setParameters( int np, std::vector<double> const&, ... );
+
+ protected:
+  void slice( int nslices);
 };
 
 class CFEBend : public Element {
@@ -532,6 +588,7 @@ class TCorrector : public Element {
   
   void preTrack( double ms,    double  Enr0,  double tetaY, int n_elem, TrackParam& prm, RMatrix& m1) const;
   int  trackOnce( double ms,   double& Enr0,  int n_elem,   int n_turn, TrackParam& prm, RMatrix const& m1, Coordinates& v) const; 
+  int  trackMap( double ms, double& Enr0, int n_elem, TrackParam& prm, RMatrix const& m1, Tpsa* u) const;
 
   RMatrix rmatrix(double& alfap, double& energy, double ms, double& tetaY, double dalfa, int st=3) const;
   virtual RMatrix rmatrixsc( double& alphap, double& Enr,    double ms, double current, BeamSize& bs,double& tetaY, double dalfa, int st=3 ) const;
@@ -553,6 +610,7 @@ class LCorrector : public Element {
   LCorrector*  clone() const { return new LCorrector(*this);}
 
   int  trackOnce( double ms,   double& Enr0,  int n_elem,   int n_turn, TrackParam& prm, RMatrix const& m1, Coordinates& v) const;
+  int  trackMap( double ms, double& Enr0, int n_elem, TrackParam& prm, RMatrix const& m1, Tpsa* u) const;
 
   //  virtual RMatrix rmatrix( double& alfap, double& energy, double ms, double& tetaY, double dalfa, int st=3);
   RMatrix rmatrixsc( double& alphap, double& Enr,    double ms, double current, BeamSize& bs,double& tetaY, double dalfa, int st=3 ) const;
@@ -604,11 +662,12 @@ class XferMatrix : public Element  {
   int  trackOnce( double ms,   double &Enr0,  int n_elem,   int n_turn, TrackParam& prm, RMatrix const& m1, Coordinates& v) const;
 
   XferMatrix*  clone() const { return new XferMatrix(*this);}
+  void            assign( Element const& o);
   void     setParameters( int np, double attributes[], ... );
   void setParameters( int np, std::vector<double> const&, ... );
   void         setMatrix( RMatrix const& tm);
   void          toString( char* buf) const;
-  XferMatrix*     split(int nslices) const; // return a sliced element
+  bool      splittable() const { return false; } // a matrix is never sliced 
 
   RMatrix tmat_;    
 
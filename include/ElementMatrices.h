@@ -0,0 +1,255 @@
+//  =================================================================
+//
+//  ElementMatrices.h
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+
+#ifndef ELEMENTMATRICES_H
+#define ELEMENTMATRICES_H
+
+#include <cmath>
+#include <limits>
+#include <RMatrix.h>
+#include <Dual.h>
+
+//.............................................................................................
+// Linear transfer matrices of the most common elements, written once for a generic scalar
+// type T. The element classes instantiate these with T = double (see e.g. Quadrupole::rmatrix).
+// The matrix is filled in place; RMatrix_t is not cheap to copy.
+// The optics fitter instantiates them with T = Dual_t<N> so that a single pass through
+// the lattice yields the matrices together with their derivatives w/r to the fit parameters.
+//
+// Only the untilted ("straight") part of the matrix is computed here. Rotations, edges and
+// soft fringe corrections remain the responsibility of the element rmatrix() functions.
+//
+// hr     : magnetic rigidity  [kG cm]
+// gamma1 : relativistic factor
+//.............................................................................................
+
+namespace ElementMatrices {
+
+  //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+  
+  template <typename T>
+  void drift( RMatrix_t<6,T>& mi, T const& L, double gamma1)
+  {
+    mi.toUnity();
+
+    mi[0][1] = mi[2][3] = L;
+    mi[4][5] = L/(gamma1*gamma1);
+  }
+
+  //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+  template <typename T>
+  void quadrupole( RMatrix_t<6,T>& mi, T const& L, T const& G, double hr, double gamma1)
+  {
+    using std::sqrt; using std::sin; using std::cos; using std::sinh; using std::cosh;
+
+    mi.toUnity();
+
+    mi[4][5] = L/(gamma1*gamma1);
+
+    if( std::fabs(primal(G)) < std::numeric_limits<double>::epsilon() ) {
+      mi[0][1] = mi[2][3]= L;
+      return;
+    }
+
+    T ks;
+    T fi;
+    
+    if( primal(G) > 0.0 ) { // hor focusing, ver defocusing 
+      ks  = sqrt( G / hr );
+      fi  = ks * L;
+      mi[0][0] = mi[1][1] = cos(fi);
+      mi[0][1] = sin(fi)/ks;
+      mi[1][0] = -ks*ks * mi[0][1];
+      mi[2][2] = mi[3][3] = cosh(fi);
+      mi[2][3] = sinh(fi)/ks;
+      mi[3][2] = ks*ks * mi[2][3];
+    }
+    else   { // ver focusing, hor defocusing 
+      ks  = sqrt( - G / hr );
+      fi  = ks*L;
+      mi[0][0] = mi[1][1] = cosh(fi);
+      mi[0][1] = sinh(fi)/ks;
+      mi[1][0] = ks*ks * mi[0][1];
+      mi[2][2] = mi[3][3] = cos(fi);
+      mi[2][3] = sin(fi)/ks;
+      mi[3][2] = -ks*ks* mi[2][3];
+    }
+  }
+
+  //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+  template <typename T>
+  void cfbend( RMatrix_t<6,T>& mi, T const& L, T const& B, T const& G, double hr, double gamma1)
+  {
+    // Combined function sector bend. See CFBend::rmatrix for references and conventions.
+
+    using std::sqrt; using std::sin; using std::cos; using std::sinh; using std::cosh;
+
+    static double constexpr eps = 100.0*std::numeric_limits<double>::epsilon();
+    
+    mi.toUnity();
+
+    // zero field and zero gradient -- behaves as a drift 
+ 
+    if( std::fabs(primal(B)) < eps && std::fabs(primal(G)) < eps ) {
+      mi[0][1] = L;
+      mi[2][3] = L;
+      mi[4][5] = L/(gamma1*gamma1);
+      return;
+    }	
+
+    T ks;
+    T fi;
+    
+    // vertical motion
+
+    T ky2  = -(G/hr);
+  
+    if( std::fabs(primal(ky2)) < eps ) { // no ver focusing
+      mi[2][3] = L;
+    }
+    else if ( primal(ky2) >= 0.0) {  // G > 0  vertical defocusing 
+      ks  = sqrt(ky2);
+      fi = L*ks;
+      mi[2][2] =  mi[3][3] = cos(fi);
+      mi[2][3] =  (std::fabs(primal(ks)) < 1.0e-12 ? L : sin(fi)/ks);
+      mi[3][2] = -ks*ks * mi[2][3];
+    }
+    else {
+      ks  = sqrt( -ky2 );
+      fi = L*ks;
+      mi[2][2] =  mi[3][3] = cosh(fi);
+      mi[2][3] =  (std::fabs(primal(ks)) < 1.0e-12 ? L : sinh(fi)/ks);
+      mi[3][2] =  ks*ks * mi[2][3];
+    }
+    
+    // horizontal motion
+
+    T ri   = B / hr; // inverse curvature radius
+    T kx2  = (G/hr) +  ri*ri;
+
+    if ( std::fabs(primal(kx2)) < eps )  { // some bending but no net hor focusing 
+      mi[0][1] = L;
+
+      mi[0][5] = 0.5 * L * L * ri;
+      mi[4][1] = -mi[0][5];
+      mi[1][5] = L * ri;
+      mi[4][0] = -mi[1][5];
+
+      mi[4][5] = mi[1][5] * mi[1][5] * L /6.;
+      mi[4][5] = L/(gamma1*gamma1) - mi[4][5];
+      return;
+    }
+
+    if ( primal(kx2) >= 0.0) {  // hor focusing
+      ks  = sqrt(kx2);
+      fi  = L * ks;
+      mi[0][0] =  mi[1][1] = cos(fi);
+      mi[0][1] = (std::fabs(primal(ks)) < 1.0e-12 ? L : sin(fi)/ks);
+      mi[1][0] = -ks*ks*mi[0][1];
+    }
+    else {
+      ks = sqrt(-kx2);
+      fi = L * ks;
+      mi[0][0] = mi[1][1] = cosh(fi);
+      mi[0][1] = (std::fabs(primal(ks)) < 1.0e-12 ? L: sinh(fi)/ks);
+      mi[1][0] = ks*ks*mi[0][1];
+    }
+
+    // longitudinal motion
+  
+    mi[0][5] =   (ri/kx2) * (1.0 - mi[0][0]);
+    mi[1][5] =   ri*mi[0][1];
+
+    mi[4][0] =  -mi[1][5];
+    mi[4][1] =  -mi[0][5];
+    mi[4][5] =  L*(ri*ri)/kx2* ( 1.0- mi[0][1]/L );
+    mi[4][5] =  L/(gamma1*gamma1) - mi[4][5];
+  }
+
+  //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+  template <typename T>
+  void solenoid( RMatrix_t<6,T>& mi, T const& L, T const& B, double hr, double gamma1, bool focusing_only)
+  {
+    // Hard edge solenoid body. When focusing_only is true, the rotation is
+    // omitted ("pseudo-solenoid", element names starting with SC).
+
+    using std::sin; using std::cos;
+
+    mi.toUnity();
+
+    mi[4][5]  = L/(gamma1*gamma1);
+
+    T k  =  B / hr;
+    T fi =  L * k;
+
+    if (std::fabs(primal(k)) < std::numeric_limits<double>::epsilon() ) {
+      mi[0][1] = mi[2][3] = L;
+      return;
+    }
+
+    if ( focusing_only ) {   
+      T s = sin(fi/2.);
+      T c = cos(fi/2.);
+      mi[0][0] = mi[1][1] =  mi[2][2]=mi[3][3] = c;
+      mi[0][1] = mi[2][3] =  2.*s/k;
+      mi[1][0] = mi[3][2] = -k*s/2.;
+    }
+    else {                   // 4-dimensional transfer matrix
+      T s = sin(fi);
+      T c = cos(fi);
+      mi[0][0] =  mi[1][1] 
+               =  mi[2][2]
+               =  mi[3][3] = (1.0+c)/2.;
+      mi[0][1] =  mi[2][3] =  s/k;
+      mi[1][0] =  mi[3][2] = -k*s/4.;
+      mi[0][2] =  mi[1][3] =  s/2.;
+      mi[2][0] =  mi[3][1] = -s/2.;
+      mi[0][3] =  (1.0-c)/k;
+      mi[2][1] = -mi[0][3];
+      mi[1][2] = -(1.0-c)*k/4.;
+      mi[3][0] = -mi[1][2];
+    }
+  }
+
+} // namespace ElementMatrices
+
+#endif // ELEMENTMATRICES_H
@@ -0,0 +1,106 @@
+//  =================================================================
+//
+//  ErrorStudy.h
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+
+#ifndef ERRORSTUDY_H
+#define ERRORSTUDY_H
+
+#include <random>
+#include <string>
+#include <vector>
+#include <sqlite/connection.hpp>
+
+class Element;
+
+//....................................................................................................
+// Monte-Carlo error studies. An error specification assigns a random error, drawn from
+// a (truncated) gaussian distribution, to every element whose name matches a filter.
+// The specification file has one entry per line 
+//
+//     filter   kind   sigma   [cut]   [MatchCase]
+//
+// kind : X, Y - horizontal/vertical offset [cm] (quadrupoles) 
+//        R    - roll [deg]; for bends, the error tilt (dipole kick), otherwise added to the tilt 
+//        B    - relative field error        dB/B; for bends, a dipole kick (the reference orbit is unchanged)
+//        G    - relative gradient error     dG/G  
+// cut  : truncation, in units of sigma (0 = no truncation)    
+//....................................................................................................
+
+struct ErrorSpec {
+
+  enum Kind { OffsetX = 'X', OffsetY = 'Y', Roll = 'R', Field = 'B', Gradient = 'G' };
+
+  std::string filter;
+  bool        match_case = true;
+  Kind        kind       = OffsetX;
+  double      sigma      = 0.0;
+  double      cut        = 3.0;
+
+  static int read( char const* fname, std::vector<ErrorSpec>& specs, char* msg); // returns 0 on success 
+
+  bool matches( Element const& e) const;
+  void apply( Element& e, std::mt19937& gen) const; 
+};
+
+//....................................................................................................
+// per-seed summary of an error study
+//....................................................................................................
+
+struct ErrorSeedSummary {
+
+  enum Status { ok = 0, unstableX = 1, unstableY = 2, unstableXY = 3, noclosure = 4 };
+
+  int    seed    = 0;
+  int    status  = ok;
+  double nux     = 0.0;   // tunes 
+  double nuy     = 0.0;
+  double xrms    = 0.0;   // closed orbit [cm]
+  double yrms    = 0.0;
+  double xmax    = 0.0;
+  double ymax    = 0.0;
+  double bbxrms  = 0.0;   // beta-beat  (beta-beta0)/beta0 
+  double bbyrms  = 0.0;
+  double bbxmax  = 0.0;
+  double bbymax  = 0.0;
+  int    turns   = 0;     // no of turns survived by the probe particle (tracking only) 
+
+  static void init_table( sqlite::connection& con);
+  void dbWrite( sqlite::connection& con) const;
+};
+
+#endif // ERRORSTUDY_H
@@ -46,6 +46,7 @@
 class Vavilov;
 class Landau;
 class Moliere;
+class RandomStream;
 
 struct FoilNew: public Element
 {
@@ -61,12 +62,16 @@ struct FoilNew: public Element
   void preTrack( RMatrix_t<3>& frame, double ms,    double Enr0, int n_elem, TrackParam& prm, RMatrix& m1) const;
 
   int  virtual trackOnce( double ms,   double& Enr0,    int n_elem, int n_turn, TrackParam& prm, RMatrix const& m1, Coordinates& v ) const;
+  int  trackBunch( double ms, double Enr0, int n_elem, int n_turn, TrackParam& prm, RMatrix const& m1, Bunch& v, int N, bool parallel) const;
   //int  virtual track( double ms, double& Enr0,  Coordinates& v, double& tetaY ) const; // track trajectory
 
   //  virtual RMatrix rmatrix( double& alfap, double& energy, double ms, double& tetaY, double dalfa, int st) const;
   void toString( char* buf) const;
   void setParameters( int np, double attributes[], ... );
 
+ protected:
+
+  void assign( Element const& o);
 
  private:
 
@@ -75,6 +80,15 @@ struct FoilNew: public Element
   //static double radLength( OptimX::MaterialType );
   void initialize(double bg, double gma);
 
+  struct Draw {                 // random part of the kick given to one particle 
+    double x, y, xp, yp;        // Moliere multiple scattering  
+    double dEv;                 // Vavilov energy loss fluctuation [eV] 
+    double alpha;               // azimuth of the scattering correlated with the loss 
+  };
+
+  Draw draw( RandomStream& rng) const;
+  void kick( Draw const& d, double ms, double Enr0, Coordinates& v) const;
+
   double A_;      // atomic mass  
   int    Z_;      // atomic number  
   double X0_;     // radiation length  
@@ -88,8 +102,8 @@ struct FoilNew: public Element
   double I0_;     // ionization energy
   double dE_;     // average energy loss (WARNING: particle energy dependent)
 
-  mutable std::shared_ptr<Vavilov> vavilov_;
-  mutable std::shared_ptr<Moliere> moliere_;
+  mutable std::shared_ptr<Vavilov const> vavilov_;
+  mutable std::shared_ptr<Moliere const> moliere_;
   mutable std::shared_ptr<Landau>  landau_;
 
   //  static std::random_device                     dev_;           // random device to initialize seed
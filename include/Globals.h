@@ -93,6 +93,8 @@ struct OptimPreferences
     bool                use_set_rng_seed;
     bool                parallel_tracking;
     std::string         moments_db; 
+    std::string         moments_archive;  // on-disk store for older turns and rollups ("": temporary file)
+    uint                moments_window;   // no of most recent turns kept at full resolution in moments_db (0: all)
     sqlite::connection* con; 
 };
 
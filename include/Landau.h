@@ -49,6 +49,9 @@ class Landau {
 
   double operator()(); 
 
+  static double quantile( double u);     // inverse cdf, 0 < u < 1; tabulated once, O(1) per call  
+  static double pdf( double lambda);     // density of the normalized Landau distribution 
+
 private:
 
   std::function<double()> random_; // uniform rng over [0,1]  
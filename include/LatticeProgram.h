@@ -0,0 +1,114 @@
+//  =================================================================
+//
+//  LatticeProgram.h
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+
+
+#ifndef LATTICEPROGRAM_H
+#define LATTICEPROGRAM_H
+
+#include <memory>
+#include <variant>
+#include <vector>
+#include <RMatrix.h>
+#include <TrackParam.h>
+
+class Element;
+class Quadrupole;
+class Bunch;
+
+//....................................................................................................
+// Beamline lowered to a flat array of tracking instructions.
+//
+// compile() runs preTrack() once for every element and records, in one contiguous array, an
+// instruction tagged with the element kind and its precomputed parameters. The energy follows the
+// accelerating elements, so that a program covers one turn from a given energy and frame. The common elements
+// (drifts, instruments, quadrupoles, sextupoles, multipoles, and the elements tracked with their
+// transfer matrix) are executed directly, through non-virtual kernels; the others fall back to 
+// Element::trackOnce(). Dispatch happens once per instruction and block of particles (std::visit), 
+// not once per particle, and there is no shared_ptr or element name access in the tracking loop. 
+// The results are identical to those of Element::trackOnce(). Collective elements (wake fields) 
+// need the whole bunch and the tracker state; they compile to a no-op that the caller replaces 
+// (see collective()). 
+//
+// The Element hierarchy remains the authoring model: the program holds raw pointers to the 
+// elements of the line, which must outlive it, and it must be recompiled when the line changes.   
+//....................................................................................................
+
+class LatticeProgram {
+
+ public:
+
+  LatticeProgram();
+
+  void compile( std::vector<std::shared_ptr<Element>> const& line, RMatrix_t<3>& frame, double ms, double Enr, double tetaY ); 
+
+  void run( int i, int n_turn, Bunch& v, int jbeg, int jend ) const;   // instruction i, particles [jbeg, jend)  
+  void run( int i, int n_turn, Bunch& v, int N, bool parallel ) const; // instruction i, particles [0, N), in parallel blocks 
+
+  int    size()              const { return ops_.size(); }
+  bool   collective( int i ) const { return std::holds_alternative<CollectiveOp>(ops_[i]); }
+  double energy( int i )     const { return enr_[i]; }   // kinetic energy at the entrance of instruction i (i = size(): at the exit) 
+
+ private:
+
+  struct DriftOp   { double L; };                                  // drift, instrument 
+  struct QuadOp    { Quadrupole const* e; };
+  struct SextOp    { Element const* e; };
+  struct MultOp    { Element const* e; int N; double kx, ky; };    // kx, ky: N = 0 kick per unit dp/p  
+  struct MatrixOp  { };                                            // Element::trackOnce(): v -> m1 v 
+  struct ElementOp { Element const* e; };                          // virtual Element::trackOnce() 
+  struct CollectiveOp { };                                         // tracked by the caller 
+
+  using Op = std::variant<DriftOp, QuadOp, SextOp, MultOp, MatrixOp, ElementOp, CollectiveOp>;
+
+  void exec( DriftOp   const& op, int i, int n_turn, Bunch& v, int jbeg, int jend ) const;
+  void exec( QuadOp    const& op, int i, int n_turn, Bunch& v, int jbeg, int jend ) const;
+  void exec( SextOp    const& op, int i, int n_turn, Bunch& v, int jbeg, int jend ) const;
+  void exec( MultOp    const& op, int i, int n_turn, Bunch& v, int jbeg, int jend ) const;
+  void exec( MatrixOp  const& op, int i, int n_turn, Bunch& v, int jbeg, int jend ) const;
+  void exec( ElementOp const& op, int i, int n_turn, Bunch& v, int jbeg, int jend ) const;
+  void exec( CollectiveOp const&, int, int, Bunch&, int, int ) const {}
+
+  std::vector<Op>                 ops_;
+  mutable std::vector<TrackParam> prm_;    // trackOnce() and the loss tests take a non-const TrackParam  
+  std::vector<RMatrix>            m1_;
+  std::vector<double>             enr_;
+  double                          ms_;
+};
+
+#endif // LATTICEPROGRAM_H
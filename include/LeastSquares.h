@@ -0,0 +1,96 @@
+//  =================================================================
+//
+//  LeastSquares.h
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+
+#ifndef LEASTSQUARES_H
+#define LEASTSQUARES_H
+
+#include <functional>
+#include <vector>
+
+//....................................................................................................
+// Levenberg-Marquardt (trust region) solver for nonlinear least squares problems
+//
+//               minimize  C(x) = sum_k r_k(x)^2
+//
+// The Jacobian is computed by the user-supplied function only when needed: after an
+// accepted step, it is updated using Broyden's rank-one formula. A full Jacobian evaluation
+// is triggered when a step based on an updated Jacobian is rejected, or every
+// refreshInterval() accepted steps.
+//....................................................................................................
+
+class LeastSquares {
+
+ public:
+
+  // residuals : computes r(x); returns 0 on success, != 0 if r cannot be evaluated at x  
+  // jacobian  : computes J[k][i] = dr_k/dx_i at x, given r(x); returns 0 on success 
+  // monitor   : called after each iteration with the current cost; returns false to abort  
+
+  using Residuals = std::function<int( std::vector<double> const& x, std::vector<double>& r)>;
+  using Jacobian  = std::function<int( std::vector<double> const& x, std::vector<double> const& r, std::vector<std::vector<double>>& J)>;
+  using Monitor   = std::function<bool( int iter, double cost)>;
+
+  enum Status { converged = 0, stalled = 1, maxiters = 2, aborted = 3, failed = -1 };
+
+  LeastSquares( int n, Residuals f, Jacobian df, Monitor monitor = [](int, double) { return true; } );
+
+  Status operator()( std::vector<double>& x, double target, int niters=100 ); 
+
+  double cost()        const { return cost_;  }
+  int    evaluations() const { return nf_;    }   // no of residual evaluations 
+  int    jacobians()   const { return njac_;  }   // no of full Jacobian evaluations 
+
+  void   refreshInterval(int n) { nrefresh_ = n; }
+
+ private:
+
+  static bool solve( std::vector<std::vector<double>>& A, std::vector<double>& b); // Cholesky; A and b are overwritten  
+
+  int  n_;
+  Residuals  f_;
+  Jacobian  df_;
+  Monitor   monitor_;
+
+  double cost_;
+  int    nf_;
+  int    njac_;
+  int    nrefresh_; 
+};
+
+#endif // LEASTSQUARES_H
@@ -0,0 +1,120 @@
+//  =================================================================
+//
+//  MadXTfs.h
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+#ifndef MADXTFS_H
+#define MADXTFS_H
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// -------------------------------------------------------------------------------------
+// Reader for MADX TFS (twiss) tables held in memory (typically a memory mapped file).
+// The table is lexed in place; only the columns used by the translator are converted.
+//
+// MAD-X sequence files are not read: the import relies on the table written by 
+// "twiss, file=..." for the selected sequence, in which the SEQUENCE/REFER/AT placement, 
+// the element classes and the inherited attributes are already resolved, one row per 
+// element in beamline order (see help/htmldoc/import_madx.html).  
+// -------------------------------------------------------------------------------------
+
+namespace MadX {
+
+  struct Attributes {   // MADX units; the attributes missing from the table are 0.     
+    double L     = 0.0;
+    double ANGLE = 0.0;
+    double K0L   = 0.0;
+    double K0SL  = 0.0;
+    double K1L   = 0.0;
+    double K1SL  = 0.0;
+    double K2L   = 0.0;
+    double K2SL  = 0.0;
+    double LRAD  = 0.0;
+    double TILT  = 0.0;
+    double E1    = 0.0;
+    double E2    = 0.0;
+    double H1    = 0.0;
+    double HGAP  = 0.0;
+    double FINT  = 0.0;
+    double FINTX = 0.0;
+    double KSI   = 0.0;
+    double HKICK = 0.0;
+    double VKICK = 0.0;
+    double BETX  = 0.0;
+    double BETY  = 0.0;
+    double ALFX  = 0.0;
+    double ALFY  = 0.0;
+    double DX    = 0.0;
+    double DPX   = 0.0;
+    double DY    = 0.0;
+    double DPY   = 0.0;
+  };
+
+  struct Row {
+    std::string_view label;   // NAME     (quotes removed); points into the table buffer 
+    std::string_view type;    // KEYWORD  (quotes removed); points into the table buffer
+    Attributes       a;
+  };
+
+  class Tfs {
+
+   public:
+
+    // The buffer must outlive the table. Returns 0, or the (1-based) line number of the first error,
+    // which is described in err. The first two columns must be the element label and type.  
+
+    int    parse(char const* begin, char const* end, std::string& err);
+
+    double      param(char const* name, double dflt=0.0)       const;  // numerical @ parameter
+    std::string text (char const* name)                        const;  // text @ parameter (quotes removed)
+
+    std::unordered_map<std::string, std::string_view> params;  // @ parameters, by name 
+    std::vector<std::string>                          columns; 
+    std::vector<Row>                                  rows;
+  };
+
+  // appends the OptiM elements equivalent to a TFS row to the beamline and defines them in element_dict. 
+  // brho is in T-m.   
+
+  void make_element( std::vector<std::string>& beamline, std::unordered_map<std::string, std::string>& element_dict,
+		     Row const& row, double brho);
+
+} // namespace MadX
+
+#endif // MADXTFS_H
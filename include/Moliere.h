@@ -41,6 +41,8 @@
 
 #include <gsl/gsl_integration.h>
 
+class RandomStream;
+
 class Moliere {
 
 public:
@@ -69,14 +71,17 @@ public:
   Moliere(Parameters const& data);
  ~Moliere();
 
-  Fluctuation   operator()();
-  Distribution  operator()(int N); // random generation 
-  double pdf( double theta, double Lc);
+  Fluctuation   operator()() const;
+  Fluctuation   operator()(RandomStream& rng) const;  // draws from a per-particle stream 
+  Distribution  operator()(int N) const; // random generation 
+  double pdf( double theta, double Lc) const;
   double theta0() const {return theta0_;}
   double Lc()     const {return Lc_;}
 
  private:
 
+  Fluctuation fluctuation( double z1, double z2, double z3, double z4, double u1, double u2) const; // z: N(0,1), u: U(0,1) deviates
+
   double Lc_;
   double theta0_;
   double thetamin_;
@@ -85,11 +90,8 @@ public:
   double epsabs_;   // integration absolute error 
   double epsrel_;   // integration relative error
   size_t limit_;    // maximum number of iteration allowed for integration   
-  gsl_integration_romberg_workspace* workspace_; // integration workspace  
 
-  std::default_random_engine              generator_;
-  std::normal_distribution<double>        rnorm_;
-  std::uniform_real_distribution<double>  rnd_;
+  std::mt19937&                           generator_;  // shared engine (GlobalState::generator)
   
 };
 
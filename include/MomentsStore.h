@@ -0,0 +1,79 @@
+//  =================================================================
+//
+//  MomentsStore.h
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+#ifndef MOMENTSSTORE_H
+#define MOMENTSSTORE_H
+
+#include <string>
+#include <sqlite/connection.hpp>
+
+struct BeamMoments;
+
+// Tiered storage for the Moments table. 
+//
+// The most recent turns (Globals::preferences().moments_window) are kept at full resolution in the
+// Moments table of the tracking db (usually in memory); older turns are moved to the same table in an
+// attached on-disk db (schema "arch"). The temporary view MomentsAll covers both. 
+//
+// In addition, rollups over blocks of 16^level turns (level = 1 ... 4) are maintained incrementally in
+// arch.MomentsRollup, one row per (level, stat, turn, eidx), where stat = 0, 1, 2 holds the min, mean and
+// max of every moment over the block and turn is the first turn of the block. The rollup rows have the
+// same columns as Moments (plus level, stat and n, the no of samples), so that the queries written for
+// Moments run unchanged against the view MomentsPlot (see plotView()). Eigenvectors (mode1..3) are not
+// averaged; a block holds those of its last sample. flush() also saves the exact state of the blocks in
+// progress in arch.MomentsBlocks; restore() reloads it from a copy of the archive (checkpoint/restart).      
+
+class MomentsStore {
+
+ public:
+
+  static int  const factor    = 16;  // block size ratio between consecutive levels   
+  static int  const maxlevel  = 4;  
+
+  static void init(sqlite::connection& con);                                       // called by BeamMoments::init_moments_table 
+  static void record(sqlite::connection& con, BeamMoments const& m, int turn, int eidx); // called by BeamMoments::dbWrite 
+  static void flush(sqlite::connection& con);                                      // writes the blocks in progress
+  static void restore(sqlite::connection& con, std::string const& schema);          // reloads them from <schema>.MomentsBlocks 
+
+  // (Re)creates the temporary view MomentsPlot used by the tracker plots: MomentsAll when the no of 
+  // turns stored does not exceed maxpoints, otherwise the finest rollup level that does.   
+
+  static void plotView(sqlite::connection& con, int stat=1, int maxpoints=4096);
+};
+
+#endif // MOMENTSSTORE_H
@@ -0,0 +1,104 @@
+//  =================================================================
+//
+//  OneTurnMap.h
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+
+#ifndef ONETURNMAP_H
+#define ONETURNMAP_H
+
+#include <memory>
+#include <vector>
+#include <Coordinates.h>
+#include <Tpsa.h>
+
+class Element;
+
+//....................................................................................................
+// Nth order one-turn map.
+//
+// The map is extracted by tracking truncated power series (Tpsa) through the lattice, using the same
+// templated kernels as the element tracking code (Element::trackMap). It is expanded about a reference
+// orbit v0, normally the closed orbit; the map variables are the deviations v - v0.
+//
+// Particles are tracked through the map either directly (evaluation of the polynomials) or, after
+// symplectify(), through a mixed-variable generating function F2(q,P) built from the map. The
+// truncated map is not exactly symplectic; the generating function form is, at the cost of a few
+// Newton iterations per turn. The canonical momenta are taken as p = (1+dp/p) x' (paraxial), and
+// dp/p is treated as a parameter: elements which change the energy are not supported.   
+//....................................................................................................
+
+class OneTurnMap {
+
+ public:
+
+  enum Status { ok = 0, lost = 1, unsupported = 2, singular = 3 };
+
+  OneTurnMap();
+
+  Status extract( std::vector<std::shared_ptr<Element>> const& line, double ms, double Enr, double tetaY,
+                  Coordinates const& v0, int order );
+
+  Status symplectify();                                       // builds the generating function  
+
+  int    track( Coordinates& v ) const;                       // one turn. Returns 0, or 1 if the evaluation fails 
+
+  int                order()      const { return order_;  }
+  bool               symplectic() const { return !gf_.empty(); }
+  int                failedElement() const { return failed_; } // element that stopped the last extraction, -1 if none 
+  Coordinates const& reference()  const { return v0_;     }
+  Tpsa const&        operator[](int i) const { return map_[i]; }
+
+ private:
+
+  void   pack( Tpsa const* f, int nf, std::vector<double>& coef ) const;   // compact coefficients, up to the map order 
+  void   monomials( double const* x, double* m ) const;
+  double dot( std::vector<double> const& coef, int i, double const* m ) const;
+
+  int                 order_;
+  int                 nmon_;
+  int                 failed_;
+  Coordinates         v0_;
+  std::vector<Tpsa>   map_;         // the map, in the tracking coordinates (x, x', y, y', s, dp/p)
+  std::vector<double> coef_;        // map_ coefficients [6][nmon_] 
+  std::vector<double> gf_;          // dF/dq_x, dF/dP_x, dF/dq_y, dF/dP_y and d2F/dq dP [8][nmon_]  
+  std::vector<int>    parent_;      // monomial recursion (see Tpsa_t::monomials)
+  std::vector<int>    var_;
+  double              p0_[2];       // canonical momenta and final momenta on the reference orbit
+  double              P0_[2];
+};
+
+#endif // ONETURNMAP_H
@@ -49,6 +49,8 @@
 
 
 #include <Beamline.h>        
+#include <ClosedOrbit.h>        
+#include <SliceRef.h>        
 #include <ControlDialog.h>        
 #include <SpaceChargeControlDialog.h>        
 #include <ExternalPlotDialog.h>
@@ -101,6 +103,9 @@ struct PlotSpec;
 struct LegoData;
 struct FitElem;
 struct FitStep;
+struct ErrorSpec;
+struct ErrorSeedSummary;
+struct ThinOptions;
 
 #if QT_VERSION < 0x050000
 class BoolMapper: public QObject {
@@ -134,7 +139,7 @@ enum WindowId {
   Size4Ch, Proj4Ch, Proj4TotCh, Phase4Ch, Disp4Ch, SizeSpCh, ProjSpTotCh, ProjSpCh, PhaseSpCh,
   BetaSpCh, SizeSpBCh, PhaseSpBCh, BetaSpBCh,
   TrackerIntensityPlt, TrackerEmittancePlt, TrackerCentroidPlt, TrackerMomentsPlt, TrackerCorrelationsPlt,
-  TrackerDistPlt, Tracker4DBetasPlt, TrackerDispPlt, Tracker4DEpsPlt, BetaLongCh, PoincarePlt, Chroma
+  TrackerDistPlt, Tracker4DBetasPlt, TrackerDispPlt, Tracker4DEpsPlt, BetaLongCh, PoincarePlt, Chroma, RdtCh
 }; 
 
 
@@ -283,6 +288,7 @@ class OptimMainWindow : public QMainWindow {
    int  cmdCloseLattice();
    void cmdTuneDiagram();  
    int  cmdCloseTraject();
+   void cmdCorrectOrbit();
    void cmdViewOrbit();
    void cmdViewOrbitNew();
    void cmdToolsShowExtern();
@@ -303,6 +309,7 @@ class OptimMainWindow : public QMainWindow {
    void cmdBetasNew();
    void cmdLBetas();
    void cmdIntegrals();
+   void cmdResonances();
    void cmdPhases();
    void cmdSizes();  
    void cmdViewMatrix();  
@@ -406,7 +413,7 @@ class OptimMainWindow : public QMainWindow {
      void   replaceExistingLine(QPlainTextEdit*   editor,  int   nline);
      int            getLineCmt(OptimEditor* editor,  char* buf,   int   L,  int nline);
      int    decodeXLine(char* str, resolve* v, int* ntp);
-     int    analyze(bool reprint, int i=1); 
+     int    analyze(bool reprint, int i=1, bool calcheader=true); 
      int    analyze2(Coordinates& v); 
      int    analyzeElement(OptimEditor* editor, int nline, char *buf, int nmtr, std::shared_ptr<Element>& Elmp);
   void   print_elm(Element const* el, char* buf);
@@ -421,13 +428,7 @@ class OptimMainWindow : public QMainWindow {
      Twiss          betasNew( Twiss const& vstart);
      void    setInitialBetas( Twiss& v);
 
-     void   integrStep(double dL, double gamma, double Hrt, double dEn2,
-	             Twiss const& v, Element& e, double& dgx,  double& dgy, double& dB2, double& nuxpr,
-	             double& nuypr, double& emxn, double& emyn);
-
-     void   integrStep(double dL, double gamma, double Hrt, double dEn2,
-	             Twiss4D const& v, Element& e, double& dg1,  double& dg2, double& dB2, double& nu1pr,
-		     double& nu2pr, double& em1n, double& em2n);
+     void   integrStep(double dL, double Hrt, Twiss const& v, Element& e, double& nuxpr, double& nuypr);
 
      void   typeBetas(OptimTextEditor* editor, Twiss& v, double alfa, double enr, int elem); 
      void   Phases (Twiss& v);
@@ -511,18 +512,44 @@ class OptimMainWindow : public QMainWindow {
     void     PrintFitParam (OptimTextEditor* editor, FitStep* fstep, Twiss vfin[], Twiss dv[], int npoint[], FitElem group[], int& ngr);
     void     PrintBetaParam (OptimTextEditor* editor, Twiss& v, Twiss& dv);
     double   FindError(Twiss   vfin[], Twiss dv[], int npoint[], FitStep* fstep);
-    void     addErr(double& err, Twiss const& v, Twiss const& vfin, Twiss const& dv);
+    int      FindResiduals(std::vector<std::shared_ptr<Element>> const& line, Twiss const vfin[], Twiss const dv[], int const npoint[],
+                           FitStep const* fstep, std::vector<double>& r, bool smooth) const;
+    std::vector<std::shared_ptr<Element>> clonedLine() const;
+    std::vector<std::shared_ptr<Element>> perturbedLine(std::vector<std::shared_ptr<Element>> const& base, FitElem const& group, double delta_d) const;
+    int      fitLeastSquares(OptimTextEditor* editor, Twiss vfin[], Twiss dv[], int npoint[], FitElem group[], int ngr, FitStep* fstep,
+                             double& Q0, char* msg);
     bool     GetGradient(Twiss vfin[], Twiss dv[], int npoint[], FitElem group[], int ngr, FitStep* fstep, double* G);
+    char const* GetGradientAD(Twiss vfin[], Twiss dv[], int npoint[], FitElem group[], int ngr, FitStep* fstep, double* G);
+    template <int N>
+    char const* FindErrorAD(Twiss vfin[], Twiss dv[], int npoint[], FitElem group[], int ngr, FitStep* fstep, double* G);
+    template <typename V>
+    void     initialLatticeFunctions(V& v) const;
     int      DoStep(FitElem group[], int ngr, double* dG, double a); // V7
     void     PrintGroupElement(OptimTextEditor* editor, FitElem *group, int ngr);
     void     RewriteElementList( std::vector<std::shared_ptr<Element> >& ElmL);
     void     RewriteElementListFit( std::vector<std::shared_ptr<Element> >& ElmL, FitElem group[], int ngr);
     void     saveElements();
-    int      analyzeCompress (FitElem group[], int ngr, int npoint[]);
+    int      analyzeCompress (FitElem group[], int ngr, int npoint[], bool keep_phase=false);
     int      analyzeWithoutCompress(FitElem group[], int ngr, int npoint[]);
 
     
-    int      TrackOffLine(char *InputPartPosFile, char *TrackResFile, bool MatchCase, char *filter, int nturn, char ring);
+    int      TrackOffLine(char *InputPartPosFile, char *TrackResFile, bool MatchCase, char *filter, int nturn, char ring, int ckpt_interval=0, bool resume=false, int map_order=0, bool symplectic=false, ThinOptions const* thin=0);
+
+    // ---------- Error studies -------------
+
+    int      ErrorStudyOffLine(char* ErrorSpecFile, char* SummaryFile, int nseeds, int nturn);
+    void     errorStudySeed(std::vector<ErrorSpec> const& specs, std::vector<double> const& btx0, std::vector<double> const& bty0,
+                            int nturn, ErrorSeedSummary& summary) const;
+    int      lineBetas(std::vector<std::shared_ptr<Element>> const& line, Twiss& v, RMatrix& tm,
+                       std::vector<double>& btx, std::vector<double>& bty) const;
+
+    // ---------- Off-momentum optics -------------
+
+    std::vector<std::shared_ptr<Element>> deterministicLine() const;
+    int      offMomentumMap(std::vector<std::shared_ptr<Element>> const& line, double dpp, Coordinates& co, RMatrix& tm) const;
+    int      offMomentumTunes(std::vector<double> const& dpp, std::vector<double>& nu1, std::vector<double>& nu2,
+                              std::vector<Twiss4D>* v=0) const;
+
     int      ViewMachine(char* filenm, FunctionDlgStruct* NStf, char* comment, bool ClsLat);
     double   ChangeGroupSetting(FitElem group[], double delta_d);
     bool     SetGradientStep(Twiss vfin[], Twiss dv[], int npoint[], FitElem group[], int ngr, FitStep* fstep); // V7
@@ -621,6 +648,7 @@ class OptimMainWindow : public QMainWindow {
      QAction*         trajectoryNewAct_;
      QAction*        typeTrajectoryAct_;
      QAction*       closeTrajectoryAct_;
+     QAction*          correctOrbitAct_;
      QAction*           tuneDiagramAct_;
      QAction*      showExternalFileAct_;
      QAction*          toolsControlAct_;
@@ -632,6 +660,7 @@ class OptimMainWindow : public QMainWindow {
      QAction*               phasesAct_;
      QAction*  functionsAtElementsAct_;
      QAction*            integralsAct_;
+     QAction*           resonancesAct_;
      QAction*               matrixAct_;
      QAction*      integrationStepAct_;
      QAction*            functionsAct_;
@@ -719,6 +748,20 @@ class OptimMainWindow : public QMainWindow {
 
      bool   use_fractional_tune_;
      bool   phase_advance_constraint_;
+     bool   ad_gradient_active_;       // true if the last fit gradient was obtained by forward-mode differentiation
+     char const* ad_fallback_;         // why the last fit gradient could not be obtained by forward-mode differentiation, if so 
+     ClosedOrbit closed_orbit_;        // nonlinear trajectory closure; keeps the one-turn Jacobian between calls 
+     SliceArena  slice_arena_;         // scratch element slices for the optics sweeps (see SliceRef)
+
+     struct FrozenSegments {           // compressed line of the last fit, reused by analyzeCompress() while the frozen elements are unchanged
+       std::vector<double>                   key;    // exact parameters of the frozen elements, energy and fit locations
+       std::vector<std::string>              names;  // element names and descriptions, same positions as the key
+       std::vector<std::shared_ptr<Element>> edict;  // compressed element dictionary
+       std::vector<int>                      source; // edict[k] is a copy of beamline_[source[k]], or a segment matrix (-1)
+       std::vector<int>                      layout; // compressed beamline, as indices into edict
+       std::vector<int>                      npoint; // constraint locations in the compressed beamline
+       int                                   nf;
+     } frozen_;
      
      double Ein; 
      double ms;
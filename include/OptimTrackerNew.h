@@ -46,6 +46,7 @@
 #include <vector>
 #include <memory>
 #include <map>
+#include <string>
 #include <cstdio>
 #include <ExtraScatterDialog.h>
 #include <ElmSelection.h>
@@ -65,6 +66,7 @@ class  TrackerPlot6;
 class  QwtPlotZoomer;
 class  QMdiSubWindow;
 class  QProgressDialog;;
+class  OptimTextEditor;
 
 struct Twiss;
 struct BeamMoments;
@@ -136,6 +138,10 @@ class OptimTrackerNew : public QMainWindow {
  
      int trackWake(Element const* ep, Bunch& v, int N, double Enr0, double ms, ExtData* p); // V7
 
+     bool particleMajorTracking(bool poincare) const;
+     int  trackParticleMajor(RMatrix_t<3> frame, Bunch& v, double gamma, OptimTextEditor* editor);
+     std::string checkpointName() const;
+
 
 
      QMenu*                 fileMenu;
@@ -200,6 +206,8 @@ class OptimTrackerNew : public QMainWindow {
      char     TrackFilter_[1024];
      bool     MatchCase_;
      int      TotalTurnsTracked_;
+     int      CheckpointInterval_;  // turns between checkpoints (0: none)
+     bool     Resume_;              // resume the next run from the last checkpoint
 
      int      dataspec_;   // type of data to be written to db
 
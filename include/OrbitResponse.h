@@ -0,0 +1,131 @@
+//  =================================================================
+//
+//  OrbitResponse.h
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+
+#ifndef ORBITRESPONSE_H
+#define ORBITRESPONSE_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <Coordinates.h>
+
+class Element;
+
+//....................................................................................................
+// Orbit response matrix and orbit correction.
+//
+// The response of the monitors (Instrument, 'I') to the correctors (TCorrector, 'K': field B [kG];
+// LCorrector, 'Z': energy kick [MeV], transfer lines only) is obtained from the element transfer 
+// matrices in a single pass through the line. With R_k the matrix from the start to the exit of 
+// element k, M the one-turn matrix and k_j the kick of corrector j (carried to its exit), the orbit 
+// at monitor i is    
+//
+//    line:  z_i = R_i R_j^-1 k_j                           (i > j, 0 otherwise) 
+//    ring:  z_i = R_i (I-M)^-1 R_j^-1 k_j   (i > j),   R_i M (I-M)^-1 R_j^-1 k_j   (i < j)   
+//
+// A corrector is a knob by element name: all the instances of a name in the line move together.
+// Monitors read x and y [cm] at their exit.
+//
+// The corrections dk minimize |b + A dk| for the readings b:     
+//   SVD      : truncated pseudo-inverse; singular values below param*s_max are dropped.    
+//   Tikhonov : damped pseudo-inverse s/(s^2 + l^2), with l = param*s_max.   
+//   Micado   : at most param correctors, added one at a time, each time the one that most reduces 
+//              the residual (least squares over the selected correctors).   
+// The SVD of A is computed on first use and kept for subsequent solves.
+//....................................................................................................
+
+class OrbitResponse {
+
+ public:
+
+  enum Method { SVD = 0, Tikhonov = 1, Micado = 2 };
+
+  struct Knob {
+    std::string      name;
+    char             type;   // 'K' or 'Z'
+    std::vector<int> elms;   // instances (positions in the line)
+  };
+
+  struct Reading {
+    int elm;                 // position in the line 
+    int plane;               // 0: x, 1: y   
+  };
+
+  using Selector = std::function<bool(Element const&)>;
+
+  OrbitResponse();
+
+  // returns 0, or 1 if the one-turn matrix (ring) or the matrix of a corrector position cannot be inverted 
+
+  int build( std::vector<std::shared_ptr<Element>> const& line, double ms, double Enr, double tetaY, bool ring,
+             Selector monitor, Selector corrector, bool xplane=true, bool yplane=true );
+
+  std::vector<double> readings( std::vector<Coordinates> const& orbit) const;   // orbit: at the exit of every element    
+
+  // corrections dk (one per knob); returns the no of singular values (SVD, Tikhonov) or correctors (Micado) used   
+
+  int    solve( std::vector<double> const& b, Method method, double param, std::vector<double>& dk) const;
+  double rms( std::vector<double> const& b, std::vector<double> const& dk) const;   // rms of b + A dk   
+
+  int    rows()    const { return m_; }
+  int    columns() const { return n_; }
+  double operator()( int i, int j) const { return a_[i*n_+j]; }
+
+  std::vector<Reading> const& monitors() const { return rows_;  }
+  std::vector<Knob>    const& knobs()    const { return knobs_; }
+  std::vector<double>  const& singularValues() const;   
+
+ private:
+
+  void decompose() const;  
+
+  int                  m_;
+  int                  n_;
+  std::vector<double>  a_;       // m x n, row major 
+  std::vector<Reading> rows_;
+  std::vector<Knob>    knobs_;
+
+  mutable bool                svd_;   
+  mutable std::vector<double> u_;     // m x r 
+  mutable std::vector<double> s_;     // r, in decreasing order  
+  mutable std::vector<double> v_;     // n x r  
+};
+
+#endif // ORBITRESPONSE_H
@@ -0,0 +1,137 @@
+//  =================================================================
+//
+//  RadiationIntegrals.h
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+#ifndef RADIATIONINTEGRALS_H
+#define RADIATIONINTEGRALS_H
+
+#include <algorithm>
+#include <cmath>
+
+class Twiss;
+
+//....................................................................................................
+// Synchrotron radiation integrals, element by element [cm units]  
+//
+//   I1  = int h_b D_b,   I2 = int h^2,   I3 = int |h|^3,   I5u = int |h|^3 H_u,  
+//   I4u = int D_u h_u (h^2 + 2k)  - sum_edges D_u h_u h tan(e)      (u = x, y)
+//
+// with h = B/Hr, k = G/Hr, h_x = h cos(tilt), h_y = h sin(tilt), D_b = D_x cos(tilt) + D_y sin(tilt) 
+// and H_u = gamma_u D_u^2 + 2 alpha_u D_u D_u' + beta_u D_u'^2.   
+//
+// For a uniform-field sector bend whose bending plane is x or y (tilt a multiple of 90 deg), D 
+// and H are integrated in closed form from the lattice functions at the entrance. Any other case
+// is integrated by adaptive Gauss-Legendre quadrature of a caller-supplied integrand (see integrate()).
+//....................................................................................................
+
+class RadiationIntegrals {
+
+ public:
+
+  struct Sums {
+    double I1, I2, I3, I4x, I4y, I5x, I5y;
+
+    Sums& operator+=( Sums const& o);
+    Sums  operator+ ( Sums const& o) const { Sums r(*this); return r += o; }
+    Sums  operator* ( double a)      const;
+    double norm() const;   // max |component|  
+  };
+
+  static bool planar( double tilt);                                              // tilt [rad]  
+
+  static Sums bend( double L, double h, double k, double tilt, Twiss const& v);  // closed form; planar tilt only 
+  static Sums edge( double h, double tane, double tilt, Twiss const& v);         // thin edge, I4 only    
+  static Sums local( double h, double k, double tilt, Twiss const& v);           // integrands at one point   
+
+  // int_0^L f(s) ds, by 8-point Gauss-Legendre on adaptively bisected intervals. T needs +, * double and norm().  
+
+  template <typename T, typename F>
+  static T integrate( F const& f, double L, double tol=1.0e-10, int maxdepth=16);
+
+ private:
+
+  template <typename T, typename F>
+  static T gauss( F const& f, double a, double b);
+
+  template <typename T, typename F>
+  static T adapt( F const& f, double a, double b, T const& whole, double tol, int depth);
+
+  static double const x_[4];   // Gauss-Legendre nodes (positive half) and weights on [-1,1]  
+  static double const w_[4];  
+};
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+template <typename T, typename F>
+T RadiationIntegrals::gauss( F const& f, double a, double b)
+{
+  double c = 0.5*(a+b);
+  double r = 0.5*(b-a);
+  T sum = (f(c - r*x_[0]) + f(c + r*x_[0]))*(r*w_[0]);
+  for (int i=1; i<4; ++i) {
+    sum = sum + (f(c - r*x_[i]) + f(c + r*x_[i]))*(r*w_[i]);
+  }
+  return sum;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+template <typename T, typename F>
+T RadiationIntegrals::adapt( F const& f, double a, double b, T const& whole, double tol, int depth)
+{
+  double c     = 0.5*(a+b);
+  T      left  = gauss<T>(f, a, c);
+  T      right = gauss<T>(f, c, b);
+  T      both  = left + right;
+
+  if (depth <= 0 || (both + whole*(-1.0)).norm() <= tol*std::max(both.norm(), 1.0e-300)) return both;
+
+  return adapt<T>(f, a, c, left, tol, depth-1) + adapt<T>(f, c, b, right, tol, depth-1);
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+template <typename T, typename F>
+T RadiationIntegrals::integrate( F const& f, double L, double tol, int maxdepth)
+{
+  return adapt<T>(f, 0.0, L, gauss<T>(f, 0.0, L), tol, maxdepth);
+}
+
+#endif // RADIATIONINTEGRALS_H
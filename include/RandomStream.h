@@ -0,0 +1,114 @@
+//  =================================================================
+//
+//  RandomStream.h
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+#ifndef RANDOMSTREAM_H
+#define RANDOMSTREAM_H
+
+#include <cmath>
+#include <cstdint>
+
+//....................................................................................................
+// Per-particle random stream for the stochastic elements.
+//
+// A RandomStream is a SplitMix64 generator whose starting state is a hash of (epoch, turn, element,
+// particle id). A particle therefore draws the same numbers on a given turn and element, whichever thread
+// tracks it and in whatever order, and there is no shared mutable state: tracking through foils and
+// scattering elements is bitwise reproducible for a given seed, independently of the no of threads.
+//
+// The epoch distinguishes successive tracking runs. It is drawn from GlobalState::generator
+// when tracking starts (reseed()), so that a run is reproducible when the seed is set, and it is saved
+// with the generator state in tracking checkpoints. 
+//....................................................................................................
+
+class RandomStream {
+
+ public:
+
+  typedef std::uint64_t result_type;     // UniformRandomBitGenerator: usable with the std distributions  
+
+  RandomStream( int n_turn, int n_elem, int pid )
+    : cached_(false)
+  {
+    state_ = mix( epoch_ + gamma_ );
+    state_ = mix( state_ ^ ( (std::uint64_t(std::uint32_t(n_turn)) << 32) | std::uint32_t(n_elem) ) );
+    state_ = mix( state_ ^ std::uint32_t(pid) );
+  }
+
+  result_type operator()() { return mix( state_ += gamma_ ); }
+
+  double uniform() { return ((*this)() >> 11) * 0x1.0p-53; }  // [0, 1)
+
+  double normal()                                              // N(0,1), Marsaglia polar method 
+  {
+    if (cached_) { cached_ = false; return z_; }
+    double u, v, s;
+    do {
+      u = 2.0*uniform() - 1.0;
+      v = 2.0*uniform() - 1.0;
+      s = u*u + v*v;
+    } while ( (s >= 1.0) || (s == 0.0) );
+    double f = std::sqrt(-2.0*std::log(s)/s);
+    z_ = v*f; cached_ = true;
+    return u*f;
+  }
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return ~result_type(0); }
+
+  static void         reseed();                                        // new epoch, drawn from GlobalState::generator
+  static void         reseed( result_type epoch ) { epoch_ = epoch; }
+  static result_type  epoch()                     { return epoch_; }
+
+ private:
+
+  static std::uint64_t mix( std::uint64_t z )
+  {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  static constexpr std::uint64_t gamma_ = 0x9e3779b97f4a7c15ULL;
+  static std::uint64_t           epoch_;
+
+  std::uint64_t state_;
+  double        z_;
+  bool          cached_;
+};
+
+#endif // RANDOMSTREAM_H
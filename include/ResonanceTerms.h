@@ -0,0 +1,130 @@
+//  =================================================================
+//
+//  ResonanceTerms.h
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+#ifndef RESONANCETERMS_H
+#define RESONANCETERMS_H
+
+#include <array>
+#include <complex>
+#include <vector>
+
+//....................................................................................................
+// Hamiltonian resonance driving terms of thin nonlinear kicks, from the linear (uncoupled) lattice
+// functions at the kicks.  
+//
+// The kick potential V (dx' = -dV/dx, dy' = -dV/dy) of each slice is expanded in the resonance basis 
+// 
+//    x = sqrt(betax)(hx+ + hx-)/2,  hx+- = sqrt(2Jx) exp(+-i phix),   (same for y) 
+//    
+// about the dispersion orbit, to 4th degree in the betatron amplitudes and 2nd order in dp/p, and 
+// is carried to the start of the line by the linear phase advances. A term  
+// 
+//    h_jklmp hx+^j hx-^k hy+^l hy-^m dp^p 
+//
+// of the single pass generator (thin kicks e^{:-V:}, concatenated with the Campbell-Baker-Hausdorff
+// formula) is first order in the strengths (h = - sum V), plus the second order (cross) terms 
+// 1/2 sum_{i<j} [V_i, V_j]. For a ring, the one-turn map is brought to normal form to second order: 
+// f_jklmp = h_jklmp/(1-exp(i 2pi [(j-k)Qx+(l-m)Qy])), the detuning with amplitude dQ/dJ and the 
+// chromaticities Q = Q0 + xi1 dp + xi2 dp^2.
+//
+// Kick potential: V = knl/(n+1)! Re[ ((x+iy) exp(-i tilt))^(n+1) ]/(1+dp), as in Multipole. 
+// For the elements of the linear lattice (quadrupoles, bend gradients), the normal quadrupole part 
+// at dp = 0 is already in the lattice functions and is left out. A bend contributes its second 
+// order dp/p kick (the first order is the dispersion). The curvature and edge focusing of bends 
+// is not included in the chromatic terms.   
+//....................................................................................................
+
+class ResonanceTerms {
+
+ public:
+
+  struct Kick {
+    double s;           // position [m] 
+    double btx;         // beta functions [m] 
+    double bty;
+    double mux;         // phase advances from the start [2pi]
+    double muy;
+    double dx;          // dispersion [m] 
+    double dy;
+    int    n;           // 1: quadrupole, 2: sextupole, 3: octupole, ...  
+    double knl;         // integrated normalized strength [m^-n]  
+    double tilt;        // [rad] 
+    double angle;       // bending angle [rad] 
+    bool   linear;      // the normal quadrupole part is in the linear lattice   
+  };
+
+  typedef std::array<int,5> Term;  // j k l m p 
+
+  ResonanceTerms();
+
+  void add( Kick const& kick);                    // in lattice order 
+  void close( double Qx, double Qy);              // one-turn normal form of a ring with tunes Qx, Qy 
+
+  std::complex<double> h( Term const& t) const;   // first + second order  
+  std::complex<double> h1( Term const& t) const;  // first order 
+  std::complex<double> f( Term const& t) const;   // after close()
+
+  double dQxdJx() const { return dqxx_; }         // after close()
+  double dQxdJy() const { return dqxy_; }         // = dQy/dJx
+  double dQydJy() const { return dqyy_; }
+  double xi1( int plane) const { return xi1_[plane]; }  // 0: x, 1: y 
+  double xi2( int plane) const { return xi2_[plane]; }
+
+  int    kicks()  const { return nkicks_; }
+
+  static constexpr int maxdeg = 4;   // betatron amplitudes  
+  static constexpr int maxdp  = 2;   // dp/p 
+
+ private:
+
+  typedef std::vector<std::complex<double>> Poly;
+
+  Poly   w_;       // sum of the potentials V_i, carried to the start 
+  Poly   h2_;      // 1/2 sum_{i<j} [V_i, V_j]  
+  Poly   f_;
+  double qx_;
+  double qy_;
+  double dqxx_;
+  double dqxy_;
+  double dqyy_;
+  double xi1_[2];
+  double xi2_[2];
+  int    nkicks_;
+};
+
+#endif // RESONANCETERMS_H
@@ -128,6 +128,19 @@ Class SCalculator
 			return  -  0 - number,  
                                   -1 - text string (result=1), 
                                    1 - when the last number was extracted
+
+	int assign(char const* name_var, double value, char* strerr);
+		Sets a scalar variable and re-evaluates only the statements run since the
+		last zeroCalc() that depend on it, directly or indirectly, in their original
+		order. 
+			return  -  number of errors (0 - no errors), 
+                                  -1 - the dependencies cannot be used (unknown variable, 
+                                       statement repeated by a loop, variable assigned 
+                                       more than once); the lines must be re-evaluated.
+
+        Expression lines are compiled once into a stack code in which the variables are
+        referred to by slot indices, and the code is cached by line text. Evaluation of a 
+        compiled line does not allocate. 
 -------------------------------------------------------------------------
 */
 
@@ -172,8 +185,31 @@ class SCalc {
   enum func_value{  sinx, cosx,   tanx, asinx, acosx, atanx, expx, logx,   sqrtx,
 	            absx, thetax, intx, factx, hrox,  signx, gaussx };
 
+  enum opcode {  PUSH_OP, LOAD_OP, LOADA_OP, DEFN_OP, DEFNA_OP, STORE_OP, STOREA_OP, 
+                 NEG_OP,  ADD_OP,  SUB_OP,   MUL_OP,  DIV_OP,   POW_OP,   CALL_OP,   POP_OP };
+
   static unsigned int const TBLSZ = 1024;             // hash table size (increased from 23 to 1024 at Oct.29.2005)
   static unsigned int const ARRAY_POINTER_LEN = 256;
+  static unsigned int const MAX_COMPILED = 4096;      // compiled lines cache size  
+
+  struct Instr {
+    opcode op;
+    int    arg;           // slot index or function number 
+    double val;           // constant  
+  };
+
+  struct Statement {      // one ';' separated expression   
+    std::vector<Instr>  code;
+    std::vector<int>    reads;      // slots read  
+    std::vector<int>    writes;     // slots assigned 
+    unsigned int        epoch = 0;  // last zeroCalc() epoch in which the statement was recorded
+  };
+
+  struct Program {        // one compiled line   
+    std::vector<Statement> stmts;
+    std::string            err;     // compilation error, reported once the preceding statements have run 
+    int                    depth = 0;
+  };
 
  public:
 
@@ -190,6 +226,7 @@ class SCalc {
 	int    FindValueInArray(char* name_var, int n, double* result);
         void   dumpVariables(std::vector<std::string> const& varlist = std::vector<std::string>(),
 			     std::string const& fname="", char mode='w') const;
+        int           assign(char const* var_name, double value, char* error);
 
  protected:
 
@@ -214,6 +251,18 @@ class SCalc {
 	Variable*    name_get_addr;
 	Variable     data_str_err;
 
+	std::unordered_map<std::string,Program> compiled_;  // compiled lines, by text 
+	std::unordered_map<std::string,int>     slotidx_;   // slot index, by variable name
+	std::vector<std::string>                slotname_;  
+	std::vector<Variable*>                  slotvar_;   // resolved lazily, reset by zeroCalc() 
+	std::vector<int>                        writer_;    // position in tape_ of the statement assigning the slot  
+	std::vector<char>                       dirty_;     
+	std::vector<Statement*>                 tape_;      // assignments run since zeroCalc(), in order
+	std::vector<double>                     stack_;     
+	std::string                             key_;       
+	unsigned int                            epoch_;
+	bool                                    graphok_;
+
  protected:
 	void Start();
 
@@ -223,10 +272,17 @@ class SCalc {
 
 	double Function(double e, func_value cur_func);
 
-	double prim();
-	double term();
-	double expr();
-	double power();
+	void   prim(Statement& st);
+	void   term(Statement& st);
+	void   expr(Statement& st);
+	void  power(Statement& st);
+	void  index(Statement& st, char const* text);
+
+	int          slot(char const* name);
+	void      compile(char const* buf, Program& prog);
+	int       execute(Program& prog, double* result, char const* format, char* result_str);
+	bool          run(Statement const& st, double& result);
+	void       record(Statement& st);
 };
 
 #endif //SCALCULATOR_H
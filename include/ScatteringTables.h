@@ -0,0 +1,82 @@
+//  =================================================================
+//
+//  ScatteringTables.h
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+#ifndef SCATTERINGTABLES_H
+#define SCATTERINGTABLES_H
+
+#include <memory>
+#include <Vavilov.h>
+#include <Moliere.h>
+
+//....................................................................................................
+// Process-wide cache of the foil scattering distributions.
+//
+// A Vavilov energy loss table takes an FFT and two spline fits to build; it only depends on the beam
+// gamma, the ionization potential and the mean energy loss, i.e. on the foil material, its thickness
+// and the beam energy. FoilNew::preTrack() is called for every foil on every pass; it now asks the cache
+// for its tables instead of rebuilding them. Entries are matched on the constructor parameters within a
+// relative tolerance (rtol), so that round-off in the energy bookkeeping between turns does not force a
+// rebuild. The tables are immutable once built and may be sampled concurrently from several threads.
+//
+// The cache holds at most capacity entries; the oldest one is dropped first (holders of a
+// shared_ptr keep theirs alive).
+//
+// The tables are not persisted to disk. With the cache, a table is built once per run for each
+// material, thickness and energy (one FFT of nfft points and two spline fits for Vavilov, a Romberg
+// setup for Moliere), while a file would have to carry and validate its key, the nfft and the GSL
+// spline state across versions. 
+//....................................................................................................
+
+class ScatteringTables {
+
+ public:
+
+  static std::shared_ptr<Vavilov const> vavilov( Vavilov::Parameters const& p);
+  static std::shared_ptr<Moliere const> moliere( Moliere::Parameters const& p);
+
+  static void clear();
+
+  static constexpr double rtol     = 1.0e-6;
+  static constexpr int    capacity = 16;
+
+ private:
+
+  ScatteringTables() = delete;
+};
+
+#endif // SCATTERINGTABLES_H
@@ -0,0 +1,117 @@
+//  =================================================================
+//
+//  SliceRef.h
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+#ifndef SLICEREF_H
+#define SLICEREF_H
+
+#include <memory>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+class Element;
+
+//....................................................................................................
+// Element slices for the optics sweeps, without cloning.
+//
+// The optics views sample the lattice functions inside an element by propagating ns times through
+// the matrix of one of its ns equal slices. A SliceRef supplies that slice. When ns == 1, or when the
+// element cannot be split (cavities, transfer matrices), the slice is the element itself. Otherwise it
+// is a scratch element of the same type taken from a SliceArena: the parameters of the element are
+// copied into it in place (Element::assign) and it is reduced to one slice (Element::slice). Element
+// types with data members of their own override assign() (Edge, GCavity, XferMatrix, FoilNew).
+// With force set, an element that cannot be split still gets a scratch copy, shortened to L/ns and
+// otherwise unchanged (the radiation integrals step explicitly through the cavities this way).
+//
+// The arena keeps its scratch elements; a slot is taken by a SliceRef and given back when the
+// SliceRef goes out of scope, so the arena is empty again at the end of every sweep. Once every element
+// type of the line has been seen, a sweep allocates nothing. SliceRefs taken from the same arena must be
+// released in reverse order (i.e. scoped), which is the case for the element loops.
+//....................................................................................................
+
+class SliceArena {
+
+ public:
+
+  SliceArena();
+ ~SliceArena();
+
+  SliceArena( SliceArena const&)            = delete;
+  SliceArena& operator=( SliceArena const&) = delete;
+
+  Element const* acquire( Element const& e, int ns); // one of the ns slices of e (length L/ns if e cannot be split) 
+  void           release( Element const* slice);     // give back a slice obtained from acquire()  
+
+ private:
+
+  struct Pool {
+    std::vector<std::unique_ptr<Element>> elms;
+    int                                   used = 0;
+  };
+
+  std::unordered_map<std::type_index, Pool> pools_; // one pool per element type 
+};
+
+//....................................................................................................
+
+class SliceRef {
+
+ public:
+
+  SliceRef( Element const& e, int ns, SliceArena& arena, bool force=false);
+ ~SliceRef();
+
+  SliceRef( SliceRef const&)            = delete;
+  SliceRef& operator=( SliceRef const&) = delete;
+
+  Element const* operator->() const { return e_; }
+  Element const& operator*()  const { return *e_; }
+  Element const* get()        const { return e_; }
+
+  int    slices()     const { return ns_; }
+  double length()     const;              // slice length 
+  int    edge( int j) const;              // edge flags of slice j (see Element::checkEdge)
+
+ private:
+
+  Element const* e_;
+  SliceArena*    arena_;                  // null when the slice is the element itself 
+  int            ns_;
+};
+
+#endif // SLICEREF_H
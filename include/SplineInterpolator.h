@@ -36,26 +36,71 @@
 //  =================================================================
 //
 
+
 #ifndef SPLINEINTERPOLATOR_H
 #define SPLINEINTERPOLATOR_H
 
 #include <vector>
 
+//..................................................................................................
+// Piecewise cubic interpolation. The coefficients of each interval are computed once; the interval
+// of x is found by bisection, or arithmetically (O(1)) when the abscissae are uniformly spaced.  
+// Outside [x0, xn-1] the first and last cubics are extrapolated (as splint() does).   
+//
+// Natural : natural cubic spline (y'' = 0 at the ends); same interpolant as spline()/splint(). 
+// Monotone: Steffen's monotone cubic (C1); no overshoot between the samples.  
+//..................................................................................................
+
 class SplineInterpolator {
 
 public:
 
-  SplineInterpolator(double const xv[], double const yv[], int n); 
+  enum Kind { Natural, Monotone };
+
+  SplineInterpolator(double const xv[], double const yv[], int n, Kind kind=Natural); 
+  SplineInterpolator(double x0, double dx, double const yv[], int n, Kind kind=Natural);  // uniform grid x0 + i*dx  
   SplineInterpolator(); // this should go away
 
   double operator()(double x)        const;
-  double operator()(double x, int n) const;
-  
+  double operator()(double x, int n) const;       // n = 0: y(x); n = 1: y'(x) 
+
+  void   evaluate(double const x[], double y[], int n) const;  // y[i] = y(x[i]), i = 0 ... n-1 
+
+  bool   uniform() const { return uniform_; }
+  int    size()    const { return x_.size(); }
+
 private:
+
+  void   init(double const yv[], Kind kind);
   
+  int    interval(double x) const  
+  { 
+    int k;
+    if (uniform_) {
+      double u = (x-x_[0])*idx_;
+      k = (u > 0.0) ? ((u < last_) ? int(u) : last_) : 0; 
+    }
+    else {
+      int klo = 0;
+      int khi = x_.size()-1;
+      while (khi-klo > 1) {
+        int j = (khi+klo) >> 1;
+        if (x_[j] > x) khi = j;
+        else klo = j;
+      }
+      k = klo;
+    }
+    return (k < last_) ? k : last_;
+  }
+
   std::vector<double> x_;  // independent variable
-  std::vector<double> y_;  // function  y(x)  
-  std::vector<double> y2_; // second derivative y''(x) 
+  std::vector<double> c0_; // y(x) = c0 + c1 t + c2 t^2 + c3 t^3,  t = x - x_[k] on [x_[k], x_[k+1]]  
+  std::vector<double> c1_;
+  std::vector<double> c2_;
+  std::vector<double> c3_;
+  double              idx_;     // 1/dx (uniform grid) 
+  int                 last_;    // index of the last interval 
+  bool                uniform_;
 };
 
 #endif // SPLINEINTERPOLATOR_H
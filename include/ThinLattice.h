@@ -0,0 +1,144 @@
+//  =================================================================
+//
+//  ThinLattice.h
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+
+
+#ifndef THINLATTICE_H
+#define THINLATTICE_H
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <Coordinates.h>
+
+class Element;
+
+//....................................................................................................
+// Slicing options for ThinLattice::make(). 
+//
+// teapot:  n kicks of equal strength, separated by drifts L/(2(n+1)), nL/(n^2-1), ..., L/(2(n+1)).
+//          (n = 1: a single kick at the center). The linear optics of a sliced quadrupole are
+//          closest to those of the thick element for this kick spacing. 
+// yoshida: n steps of the 4th order symmetric integrator (Ruth/Yoshida), 3 kicks per step. This 
+//          is the integrator used by Sextupole::trackOnce().  
+//
+// families: (name filter, number of slices) pairs; the filters follow the syntax of filterName()
+//           (wildcards, multiple filters separated by ';'). The first match applies; magnets that
+//           match no filter get nslices. 
+//....................................................................................................
+
+struct ThinOptions {
+
+  enum Scheme { teapot = 0, yoshida = 1 };
+
+  Scheme scheme  = teapot;
+  int    nslices = 4;
+  bool   rematch = true;       // restore the linear tunes of the thick lattice 
+  std::vector<std::pair<std::string,int>> families;   
+};
+
+//....................................................................................................
+// Thin-lens (kick-drift) representation of a lattice.
+//
+// Thick quadrupoles, sextupoles, bends and solenoids are sliced into drifts and thin kicks; thin 
+// elements (multipoles, edges, correctors) become single kicks, and consecutive drifts are merged. 
+// Every element of the thin lattice is the same operation: a drift followed by a kick 
+//
+//   w   = dx' + i dy' = -conj( sum_m b_m (x+iy)^m )/(1+dp/p) + F (x,y) + h dp/p/(1+dp/p)
+//   ds  = -h.(x,y) 
+//
+// where b_m are the (tilted) multipole coefficients, F is a 2x2 momentum independent focusing 
+// matrix (weak focusing of the bends, edges) and h = (hx,hy) is the bend angle. A solenoid kick
+// rotates (x,y) and (x',y') by rs/(1+dp/p) and focuses by ks/(1+dp/p)^2 in both planes. Tracking is 
+// a single loop with no branches on the element type. Drifts are paraxial (x += L x'); fringe fields,
+// apertures, and the exact dipole geometry are not represented.   
+//
+// Slicing shifts the linear tunes. With rematch set, the strengths of the quadrupole kicks 
+// (focusing and defocusing families) are scaled to restore the eigen-tunes of the thick lattice
+// (cos mu; Newton iteration). Elements which change the energy, solenoids with soft edges, and 
+// other elements without a thin kick representation are not supported.     
+//....................................................................................................
+
+class ThinLattice {
+
+ public:
+
+  enum Status { ok = 0, unsupported = 1, unmatched = 2 };
+
+  static int const max_order = 4;   // highest multipole order (decapole)
+
+  ThinLattice();
+
+  Status make( std::vector<std::shared_ptr<Element>> const& line, double ms, double Enr, double tetaY,
+               ThinOptions const& opt );
+
+  int    track( Coordinates& v ) const;         // one turn. Returns 0, or 1 if the particle is lost  
+
+  int    size()          const { return kicks_.size(); }
+  int    failedElement() const { return failed_; }      // element that stopped the last conversion, -1 if none 
+  double length()        const;
+  void   knobs( double k[2] ) const { k[0] = knob_[0]; k[1] = knob_[1]; } // quadrupole strength factors set by the rematch
+
+ private:
+
+  struct Kick {
+    double L;                    // drift upstream of the kick
+    double f[2][2];              // momentum independent linear kick
+    double hx, hy;               // bend angle
+    double rs, ks;               // solenoid rotation angle and focusing strength at the reference momentum 
+    double b[max_order+1][2];    // multipole coefficients (re, im) 
+  };
+
+  void   slice( Kick const& k, double L, int n, ThinOptions::Scheme scheme, int family );
+  void   addKick( Kick const& k, int family );
+  void   linearMatrix( double kf, double kd, double m[4][4] ) const; 
+  static void cosMu( double const m[4][4], double c[2] );  
+
+  std::vector<Kick> kicks_;
+  std::vector<int>  family_;    // 1: focusing, 2: defocusing quadrupole kick, 0: other  
+  double            drift_;     // drift downstream of the last kick 
+  double            phi_;       // rotation of the frame about the reference orbit [rad] 
+  double            ms_; 
+  double            p0_;
+  double            vp0_;
+  double            knob_[2];
+  int               failed_;
+};
+
+#endif // THINLATTICE_H
@@ -0,0 +1,523 @@
+//  =================================================================
+//
+//  Tpsa.h
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+
+#ifndef TPSA_H
+#define TPSA_H
+
+#include <array>
+#include <cmath>
+#include <map>
+#include <ostream>
+#include <vector>
+
+//.............................................................................
+// Truncated power series algebra (TPSA).
+//
+// A Tpsa_t<NO,NV> holds the Taylor coefficients, up to order NO, of a function
+// of NV variables about a reference point. Arithmetic and the elementary
+// functions below operate on the truncated series, so that evaluating an
+// expression (e.g. an element tracking kernel) with Tpsa_t arguments yields
+// the Taylor expansion of the result. This is the natural extension of
+// Dual_t<N>, which carries only the first order terms.
+//
+// Monomials are stored in graded order: the constant term first, then the NV
+// first order terms (x_0 at index 1, x_1 at index 2 ...), then the second
+// order terms etc. The truncation order can be lowered at run time with
+// Tpsa_t::order(n), n <= NO; the cost of the arithmetic scales with the
+// number of monomials up to the truncation order, not with NO.
+//
+// Comparisons act on the constant part, as they do for Dual_t.
+//.............................................................................
+
+template <int NO, int NV=6>
+class Tpsa_t {
+
+ public:
+
+  static constexpr int binomial( int n, int k) { return (k == 0) ? 1 : binomial(n-1, k-1)*n/k; }
+  static constexpr int nmax = binomial(NO+NV, NV);   // number of monomials of degree <= NO
+
+  using Exponents = std::array<unsigned char,NV>;
+
+  Tpsa_t()           : c_{} {}
+  Tpsa_t( double v ) : c_{} { c_[0] = v; }          // a constant
+
+  static Tpsa_t variable( double v, int i ) { Tpsa_t x(v); x.c_[1+i] = 1.0; return x; }
+
+  // truncation order
+
+  static int  order()       { return order_(); }
+  static void order(int n)  { order_() = (n < 1) ? 1 : (n > NO ? NO : n); }
+
+  // monomial tables
+
+  static int size()                 { return tables().off[order()+1]; }  // no of monomials up to the truncation order
+  static int size(int n)            { return tables().off[n+1];       }
+  static int degree(int k)          { return tables().deg[k];         }
+  static int exponent(int k, int v) { return tables().exps[k][v];     }
+  static int parent(int k)          { return tables().parent[k];      }  // monomial k = monomial parent(k) * x_var(k)
+  static int var(int k)             { return tables().var[k];         }
+  static int index( Exponents const& e );                                // -1 if the degree exceeds NO
+
+  // values of the monomials at the point x (deviations from the reference), up to the truncation order
+
+  static void monomials( double const* x, double* m );
+
+  double  value()            const { return c_[0]; }
+  double  operator[](int k)  const { return c_[k]; }
+  double& operator[](int k)        { return c_[k]; }
+
+  double  operator()( double const* x ) const;      // evaluate the polynomial at the point x
+  double  dot( double const* m ) const;             // same, given the monomial values m (see monomials())
+
+  Tpsa_t  deriv( int v ) const;                     // partial derivative w/r to x_v
+
+  // f(x) = sum_k f[k] (x-x0)^k, k=0 ... order(), where x0 is the constant part of x  
+
+  Tpsa_t  series( double const* f ) const;
+
+  // r[i] = f[i](g[0], g[1] ... g[NV-1]), i=0 ... nf-1  (composition of maps)
+
+  static void compose( Tpsa_t const* f, int nf, Tpsa_t const* g, Tpsa_t* r );
+
+  Tpsa_t& operator+=( Tpsa_t const& rhs) { int n = size(); for (int i=0; i<n; ++i) c_[i] += rhs.c_[i]; return *this; }
+  Tpsa_t& operator-=( Tpsa_t const& rhs) { int n = size(); for (int i=0; i<n; ++i) c_[i] -= rhs.c_[i]; return *this; }
+  Tpsa_t& operator*=( Tpsa_t const& rhs) { Tpsa_t r; mul(*this, rhs, r); return (*this = r); }
+  Tpsa_t& operator/=( Tpsa_t const& rhs);
+
+  Tpsa_t& operator+=( double rhs) { c_[0] += rhs; return *this; }
+  Tpsa_t& operator-=( double rhs) { c_[0] -= rhs; return *this; }
+  Tpsa_t& operator*=( double rhs) { int n = size(); for (int i=0; i<n; ++i) c_[i] *= rhs; return *this; }
+  Tpsa_t& operator/=( double rhs) { return (*this) *= (1.0/rhs); }
+
+  Tpsa_t  operator-() const { Tpsa_t r; int n = size(); for (int i=0; i<n; ++i) r.c_[i] = -c_[i]; return r; }
+
+ private:
+
+  struct Tables {
+    Tables();
+    std::array<int,NO+2>      off;      // off[d]: index of the first monomial of degree d
+    std::array<Exponents,nmax> exps;
+    std::array<int,nmax>      deg;
+    std::array<int,nmax>      parent;
+    std::array<int,nmax>      var;
+    std::array<int,nmax*NV>   down;     // index of monomial k / x_v, -1 if x_v does not divide k 
+    std::vector<int>          row;      // mul[row[i]+j] = index of the product of monomials i and j  
+    std::vector<int>          mul;      //                 (j < off[NO-deg[i]+1])  
+    std::map<Exponents,int>   lookup;
+  };
+
+  static Tables const& tables() { static Tables const t; return t; }
+  static int&          order_() { static thread_local int n = NO; return n; }
+
+  static void mul( Tpsa_t const& a, Tpsa_t const& b, Tpsa_t& r );
+
+  std::array<double,nmax> c_;
+};
+
+//.............................................................................
+
+template <int NO, int NV>
+Tpsa_t<NO,NV>::Tables::Tables()
+{
+  // graded order; within a degree, exponents in decreasing lexicographic order
+  // so that the first order monomials are x_0, x_1 ... x_{NV-1}  
+
+  int k = 0;
+
+  for (int d=0; d<=NO; ++d) {
+    off[d] = k;
+    std::array<int,NV> f{};
+    f[0] = d;
+    while (true) {
+      Exponents x;
+      for (int v=0; v<NV; ++v) x[v] = f[v];
+      exps[k] = x;
+      deg[k]  = d;
+      lookup[x] = k;
+      ++k;
+      // next exponent in decreasing lex order: move one unit from the rightmost
+      // nonzero entry (excluding the last) to its right neighbour, and gather the tail 
+      int v = NV-2;
+      while (v >= 0 && f[v] == 0) --v;
+      if (v < 0) break;
+      int tail = f[NV-1];
+      f[NV-1] = 0;
+      --f[v];
+      f[v+1] = 1 + tail;
+    }
+  }
+  off[NO+1] = k;
+
+  parent[0] = -1;
+  var[0]    = -1;
+
+  for (int k=0; k<nmax; ++k) {
+    for (int v=0; v<NV; ++v) {
+      down[k*NV+v] = -1;
+      if (exps[k][v] == 0) continue;
+      Exponents x = exps[k];
+      --x[v];
+      down[k*NV+v] = lookup[x];
+    }
+    if (k == 0) continue;
+    for (int v=0; v<NV; ++v) {
+      if (exps[k][v]) { parent[k] = down[k*NV+v]; var[k] = v; break; }
+    }
+  }
+
+  for (int i=0; i<nmax; ++i) {
+    row.push_back(mul.size());
+    int nj = off[NO-deg[i]+1];
+    for (int j=0; j<nj; ++j) {
+      Exponents x;
+      for (int v=0; v<NV; ++v) x[v] = exps[i][v] + exps[j][v];
+      mul.push_back(lookup[x]);
+    }
+  }
+}
+
+//.............................................................................
+
+template <int NO, int NV>
+int Tpsa_t<NO,NV>::index( Exponents const& e )
+{
+  auto const& lookup = tables().lookup;
+  auto it = lookup.find(e);
+  return (it == lookup.end()) ? -1 : it->second;
+}
+
+//.............................................................................
+
+template <int NO, int NV>
+void Tpsa_t<NO,NV>::monomials( double const* x, double* m )
+{
+  auto const& t = tables();
+  int n = size();
+  m[0] = 1.0;
+  for (int k=1; k<n; ++k) m[k] = m[t.parent[k]]*x[t.var[k]];
+}
+
+//.............................................................................
+
+template <int NO, int NV>
+double Tpsa_t<NO,NV>::dot( double const* m ) const
+{
+  double s = 0.0;
+  int n = size();
+  for (int k=0; k<n; ++k) s += c_[k]*m[k];
+  return s;
+}
+
+//.............................................................................
+
+template <int NO, int NV>
+double Tpsa_t<NO,NV>::operator()( double const* x ) const
+{
+  std::array<double,nmax> m;
+  monomials(x, m.data());
+  return dot(m.data());
+}
+
+//.............................................................................
+
+template <int NO, int NV>
+void Tpsa_t<NO,NV>::mul( Tpsa_t const& a, Tpsa_t const& b, Tpsa_t& r )
+{
+  // r must be zero on entry 
+
+  auto const& t = tables();
+  int n  = order();
+  int na = t.off[n+1];
+
+  for (int i=0; i<na; ++i) {
+    double ai = a.c_[i];
+    if (ai == 0.0) continue;
+    int        nj = t.off[n-t.deg[i]+1];
+    int const* m  = &t.mul[t.row[i]];
+    for (int j=0; j<nj; ++j) r.c_[m[j]] += ai*b.c_[j];
+  }
+}
+
+//.............................................................................
+
+template <int NO, int NV>
+Tpsa_t<NO,NV> Tpsa_t<NO,NV>::deriv( int v ) const
+{
+  auto const& t = tables();
+  Tpsa_t r;
+  int n = size();
+  for (int k=1; k<n; ++k) {
+    int j = t.down[k*NV+v];
+    if (j >= 0) r.c_[j] = t.exps[k][v]*c_[k];
+  }
+  return r;
+}
+
+//.............................................................................
+
+template <int NO, int NV>
+Tpsa_t<NO,NV> Tpsa_t<NO,NV>::series( double const* f ) const
+{
+  // Horner scheme in h = x - x0. Since h has no constant part, h^k vanishes
+  // beyond the truncation order and the series is exact to that order.   
+
+  Tpsa_t h(*this);
+  h.c_[0] = 0.0;
+
+  int n = order();
+  Tpsa_t r(f[n]);
+  for (int k=n-1; k>=0; --k) {
+    r *= h;
+    r += f[k];
+  }
+  return r;
+}
+
+//.............................................................................
+
+template <int NO, int NV>
+void Tpsa_t<NO,NV>::compose( Tpsa_t const* f, int nf, Tpsa_t const* g, Tpsa_t* r )
+{
+  // the monomials of g are built once, by the parent recursion, and shared by all the f[i]  
+
+  auto const& t = tables();
+  int n = size();
+
+  std::vector<Tpsa_t> m(n);
+  m[0] = Tpsa_t(1.0);
+  for (int k=1; k<n; ++k) {
+    m[k] = m[t.parent[k]];
+    m[k] *= g[t.var[k]];
+  }
+
+  for (int i=0; i<nf; ++i) {
+    Tpsa_t s;
+    for (int k=0; k<n; ++k) {
+      double c = f[i].c_[k];
+      if (c == 0.0) continue;
+      for (int j=0; j<n; ++j) s.c_[j] += c*m[k].c_[j];
+    }
+    r[i] = s;
+  }
+}
+
+//.............................................................................
+
+template <int NO, int NV>
+Tpsa_t<NO,NV>& Tpsa_t<NO,NV>::operator/=( Tpsa_t const& rhs)
+{
+  // 1/x = sum_k (-1)^k (x-x0)^k / x0^(k+1)
+
+  double f[NO+1];
+  double a = 1.0/rhs.c_[0];
+  f[0] = a;
+  for (int k=1; k<=NO; ++k) f[k] = -f[k-1]*a;
+  return (*this) *= rhs.series(f);
+}
+
+//.............................................................................
+
+template <int NO, int NV> inline Tpsa_t<NO,NV> operator+( Tpsa_t<NO,NV> lhs, Tpsa_t<NO,NV> const& rhs) { return lhs += rhs; }
+template <int NO, int NV> inline Tpsa_t<NO,NV> operator-( Tpsa_t<NO,NV> lhs, Tpsa_t<NO,NV> const& rhs) { return lhs -= rhs; }
+template <int NO, int NV> inline Tpsa_t<NO,NV> operator*( Tpsa_t<NO,NV> lhs, Tpsa_t<NO,NV> const& rhs) { return lhs *= rhs; }
+template <int NO, int NV> inline Tpsa_t<NO,NV> operator/( Tpsa_t<NO,NV> lhs, Tpsa_t<NO,NV> const& rhs) { return lhs /= rhs; }
+
+template <int NO, int NV> inline Tpsa_t<NO,NV> operator+( Tpsa_t<NO,NV> lhs, double rhs) { return lhs += rhs; }
+template <int NO, int NV> inline Tpsa_t<NO,NV> operator-( Tpsa_t<NO,NV> lhs, double rhs) { return lhs -= rhs; }
+template <int NO, int NV> inline Tpsa_t<NO,NV> operator*( Tpsa_t<NO,NV> lhs, double rhs) { return lhs *= rhs; }
+template <int NO, int NV> inline Tpsa_t<NO,NV> operator/( Tpsa_t<NO,NV> lhs, double rhs) { return lhs /= rhs; }
+
+template <int NO, int NV> inline Tpsa_t<NO,NV> operator+( double lhs, Tpsa_t<NO,NV> rhs) { return rhs += lhs; }
+template <int NO, int NV> inline Tpsa_t<NO,NV> operator-( double lhs, Tpsa_t<NO,NV> const& rhs) { return (-rhs) += lhs; }
+template <int NO, int NV> inline Tpsa_t<NO,NV> operator*( double lhs, Tpsa_t<NO,NV> rhs) { return rhs *= lhs; }
+template <int NO, int NV> inline Tpsa_t<NO,NV> operator/( double lhs, Tpsa_t<NO,NV> const& rhs) { return Tpsa_t<NO,NV>(lhs) /= rhs; }
+
+template <int NO, int NV> inline bool operator< ( Tpsa_t<NO,NV> const& lhs, Tpsa_t<NO,NV> const& rhs) { return lhs.value() <  rhs.value(); }
+template <int NO, int NV> inline bool operator> ( Tpsa_t<NO,NV> const& lhs, Tpsa_t<NO,NV> const& rhs) { return lhs.value() >  rhs.value(); }
+template <int NO, int NV> inline bool operator< ( Tpsa_t<NO,NV> const& lhs, double rhs) { return lhs.value() <  rhs; }
+template <int NO, int NV> inline bool operator> ( Tpsa_t<NO,NV> const& lhs, double rhs) { return lhs.value() >  rhs; }
+template <int NO, int NV> inline bool operator<=( Tpsa_t<NO,NV> const& lhs, double rhs) { return lhs.value() <= rhs; }
+template <int NO, int NV> inline bool operator>=( Tpsa_t<NO,NV> const& lhs, double rhs) { return lhs.value() >= rhs; }
+template <int NO, int NV> inline bool operator!=( Tpsa_t<NO,NV> const& lhs, double rhs) { return lhs.value() != rhs; }
+template <int NO, int NV> inline bool operator==( Tpsa_t<NO,NV> const& lhs, double rhs) { return lhs.value() == rhs; }
+
+//.............................................................................
+// elementary functions (found by ADL). Each one is the Taylor series of the
+// function about the constant part of its argument.
+//.............................................................................
+
+template <int NO, int NV>
+inline Tpsa_t<NO,NV> sqrt( Tpsa_t<NO,NV> const& x)
+{
+  // (x0+h)^a = sum_k binomial(a,k) x0^(a-k) h^k 
+  double f[NO+1];
+  double x0 = x.value();
+  f[0] = std::sqrt(x0);
+  for (int k=1; k<=NO; ++k) f[k] = f[k-1]*(0.5-(k-1))/(k*x0);
+  return x.series(f);
+}
+
+template <int NO, int NV>
+inline Tpsa_t<NO,NV> exp( Tpsa_t<NO,NV> const& x)
+{
+  double f[NO+1];
+  f[0] = std::exp(x.value());
+  for (int k=1; k<=NO; ++k) f[k] = f[k-1]/k;
+  return x.series(f);
+}
+
+template <int NO, int NV>
+inline Tpsa_t<NO,NV> log( Tpsa_t<NO,NV> const& x)
+{
+  double f[NO+1];
+  double x0 = x.value();
+  f[0] = std::log(x0);
+  double a = 1.0;
+  for (int k=1; k<=NO; ++k) { a /= -x0; f[k] = -a/k; }
+  return x.series(f);
+}
+
+template <int NO, int NV>
+inline Tpsa_t<NO,NV> sin( Tpsa_t<NO,NV> const& x)
+{
+  // sin(x0 + h) : the k-th derivative is sin(x0 + k pi/2) 
+  double f[NO+1];
+  double s = std::sin(x.value());
+  double c = std::cos(x.value());
+  double d[] = { s, c, -s, -c };
+  double kf  = 1.0;
+  for (int k=0; k<=NO; ++k) { if (k) kf *= k; f[k] = d[k%4]/kf; }
+  return x.series(f);
+}
+
+template <int NO, int NV>
+inline Tpsa_t<NO,NV> cos( Tpsa_t<NO,NV> const& x)
+{
+  double f[NO+1];
+  double s = std::sin(x.value());
+  double c = std::cos(x.value());
+  double d[] = { c, -s, -c, s };
+  double kf  = 1.0;
+  for (int k=0; k<=NO; ++k) { if (k) kf *= k; f[k] = d[k%4]/kf; }
+  return x.series(f);
+}
+
+template <int NO, int NV>
+inline Tpsa_t<NO,NV> sinh( Tpsa_t<NO,NV> const& x)
+{
+  double f[NO+1];
+  double s = std::sinh(x.value());
+  double c = std::cosh(x.value());
+  double kf  = 1.0;
+  for (int k=0; k<=NO; ++k) { if (k) kf *= k; f[k] = ((k%2) ? c : s)/kf; }
+  return x.series(f);
+}
+
+template <int NO, int NV>
+inline Tpsa_t<NO,NV> cosh( Tpsa_t<NO,NV> const& x)
+{
+  double f[NO+1];
+  double s = std::sinh(x.value());
+  double c = std::cosh(x.value());
+  double kf  = 1.0;
+  for (int k=0; k<=NO; ++k) { if (k) kf *= k; f[k] = ((k%2) ? s : c)/kf; }
+  return x.series(f);
+}
+
+template <int NO, int NV> inline Tpsa_t<NO,NV>  tan( Tpsa_t<NO,NV> const& x) { return sin(x)/cos(x); }
+template <int NO, int NV> inline Tpsa_t<NO,NV> fabs( Tpsa_t<NO,NV> const& x) { return x.value() < 0.0 ? -x : x; }
+template <int NO, int NV> inline Tpsa_t<NO,NV>  abs( Tpsa_t<NO,NV> const& x) { return fabs(x); }
+
+namespace tpsa_detail {
+
+  // theta0 + atan(u), for u without a constant part 
+
+  template <int NO, int NV>
+  inline Tpsa_t<NO,NV> atan_series( double theta0, Tpsa_t<NO,NV> const& u)
+  {
+    double f[NO+1];
+    f[0] = theta0;
+    for (int k=1; k<=NO; ++k) f[k] = (k%2) ? ((k%4 == 1) ? 1.0 : -1.0)/k : 0.0;
+    return u.series(f);
+  }
+}
+
+template <int NO, int NV>
+inline Tpsa_t<NO,NV> atan( Tpsa_t<NO,NV> const& x)
+{
+  // atan(x) = atan(x0) + atan( (x-x0)/(1 + x0 x) ) 
+  double x0 = x.value();
+  return tpsa_detail::atan_series( std::atan(x0), (x - x0)/(1.0 + x0*x));
+}
+
+template <int NO, int NV>
+inline Tpsa_t<NO,NV> atan2( Tpsa_t<NO,NV> const& y, Tpsa_t<NO,NV> const& x)
+{
+  // atan2(y,x) = atan2(y0,x0) + atan( (x0 y - y0 x)/(x0 x + y0 y) )
+  double x0 = x.value();
+  double y0 = y.value();
+  return tpsa_detail::atan_series( std::atan2(y0, x0), (x0*y - y0*x)/(x0*x + y0*y));
+}
+
+template <int NO, int NV> inline double primal( Tpsa_t<NO,NV> const& x) { return x.value(); }
+
+template <int NO, int NV>
+std::ostream& operator<<( std::ostream& os, Tpsa_t<NO,NV> const& x)
+{
+  int n = Tpsa_t<NO,NV>::size();
+  for (int k=0; k<n; ++k) {
+    if (x[k] == 0.0) continue;
+    os << x[k] << " [";
+    for (int v=0; v<NV; ++v) os << Tpsa_t<NO,NV>::exponent(k,v);
+    os << "]\n";
+  }
+  return os;
+}
+
+//.............................................................................
+// the map type used for one turn maps (see OneTurnMap.h). Maps of any order
+// up to TPSA_MAX_ORDER are obtained by lowering the truncation order.
+//.............................................................................
+
+int const TPSA_MAX_ORDER = 6;
+
+using Tpsa = Tpsa_t<TPSA_MAX_ORDER,6>;
+
+#endif // TPSA_H
@@ -0,0 +1,92 @@
+//  =================================================================
+//
+//  TrackCheckpoint.h
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+#ifndef TRACKCHECKPOINT_H
+#define TRACKCHECKPOINT_H
+
+#include <string>
+#include <future>
+#include <Bunch.h>
+#include <sqlite/connection.hpp>
+
+// A snapshot of a multi-turn tracking run taken at a turn boundary. The file (native byte order) holds 
+// the bunch, the number of completed turns, the energy, the state of the shared random generator 
+// (GlobalState::generator) and the epoch of the per-particle streams of the stochastic elements
+// (RandomStream). The moments table is saved next to it, in an 
+// sqlite database named <fname>.db (and the moments archive, if any, in <fname>.arch.db).  
+
+struct TrackCheckpoint {
+
+  int          turn = 0;     // no of completed turns
+  int          nelm = 0;     // no of elements in the beamline (consistency check on resume)
+  double       Enr  = 0.0;   // kinetic energy at the start of the next turn [MeV]
+  std::string  rng;          // serialized state of GlobalState::generator, followed by the RandomStream epoch 
+  Bunch        bunch;
+
+  void saveRng();             // captures the current state of GlobalState::generator and the RandomStream epoch 
+  void restoreRng() const;    // restores them
+
+  static int write(std::string const& fname, TrackCheckpoint const& cp);  // atomic (write + rename); returns 0 on success 
+  static int read(std::string const& fname,  TrackCheckpoint& cp);        // returns 0 on success
+
+  static int saveMoments(sqlite::connection& con, std::string const& dbname);          // flush + copy of the db; returns 0 on success
+  static int loadMoments(sqlite::connection& con, std::string const& dbname, int turn); // restores the saved rows with turn <= turn and the rollup blocks in progress; returns 0 on success  
+};
+
+// Writes checkpoints without pausing the tracking loop: the moments db is copied in the calling thread
+// (a short operation), while the bunch is written and both files renamed into place on a worker thread. 
+// At most one write is in flight; a new save() waits for the previous one to complete.
+
+class CheckpointWriter {
+
+ public:
+
+  CheckpointWriter(std::string const& fname, sqlite::connection* con);
+ ~CheckpointWriter();    // waits for the write in progress 
+
+  int  save(TrackCheckpoint&& cp);  // returns the status of the previous write  
+  int  wait();            // waits for the write in progress; returns its status (0 on success)
+
+ private:
+
+  std::string          fname_;
+  sqlite::connection*  con_;
+  std::future<int>     pending_;
+};
+
+#endif // TRACKCHECKPOINT_H
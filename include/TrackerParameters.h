@@ -52,6 +52,9 @@ struct TrackerParameters {
   bool IncrementTurns;
   bool FastTracking;
   bool PrintResults;
+
+  int  CheckpointInterval;  // turns between checkpoints (0 = no checkpoints)
+  bool Resume;              // resume from the last checkpoint 
   
   TrackerParameters();
   TrackerParameters(TrackerParameters const& o);
@@ -0,0 +1,183 @@
+//  =================================================================
+//
+//  TwissAD.h
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+
+#ifndef TWISSAD_H
+#define TWISSAD_H
+
+#include <cmath>
+#include <Constants.h>
+#include <RMatrix.h>
+#include <Twiss.h>
+#include <Dual.h>
+
+//.............................................................................................
+// Uncoupled lattice functions for a generic scalar type T.
+//
+// This is a lightweight counterpart of Twiss used by the optics fitter when the
+// gradient of the objective function is obtained by forward-mode differentiation
+// (T = Dual_t<N>). The propagation rules are the usual uncoupled ones; they agree
+// with Element::propagateLatticeFunctions() whenever the motion is uncoupled,
+// which is the only case where they are used.
+//.............................................................................................
+
+template <typename T>
+struct Twiss_t {
+
+  Twiss_t() : BtX(0.0), AlX(0.0), BtY(0.0), AlY(0.0), DsX(0.0), DsXp(0.0), DsY(0.0), DsYp(0.0), nuX(0.0), nuY(0.0) {}
+
+  explicit Twiss_t( Twiss const& v)
+    : BtX(v.BtX), AlX(v.AlX), BtY(v.BtY), AlY(v.AlY),
+      DsX(v.DsX), DsXp(v.DsXp), DsY(v.DsY), DsYp(v.DsYp), nuX(v.nuX), nuY(v.nuY) {}
+
+  T BtX;
+  T AlX; 
+  T BtY; 
+  T AlY; 
+
+  T DsX; 
+  T DsXp; 
+  T DsY; 
+  T DsYp; 
+
+  T nuX; 
+  T nuY;
+};
+
+namespace TwissAD {
+
+  //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+  template <typename T>
+  bool isCoupled( RMatrix_t<6,T> const& tm)
+  {
+    for (int i=0; i<2; ++i) {
+      for (int j=2; j<4; ++j) {
+        if ( primal(tm[i][j]) != 0.0 || primal(tm[j][i]) != 0.0 ) return true; 
+      }
+    }
+    return false;
+  }
+  
+  //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+  template <typename T>
+  void propagatePlane( T const& m00, T const& m01, T const& m10, T const& m11, T& bt, T& al, T& nu, double threshold)
+  {
+    using std::atan2;
+    
+    T gm  = (1.0 + al*al)/bt;
+
+    T btn = m00*m00*bt - 2.0*m00*m01*al + m01*m01*gm; 
+    T aln = -m00*m10*bt + (m00*m11 + m01*m10)*al - m01*m11*gm; 
+
+    T dnu = atan2( m01, m00*bt - m01*al ) / (2.0*Constants::PI);
+
+    if ( dnu < -threshold )  { dnu += 0.5; }   // same convention as Element::propagateLatticeFunctions() 
+
+    bt  = btn;
+    al  = aln;
+    nu += dnu;
+  }
+  
+  //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+  template <typename T>
+  void propagateLatticeFunctions( RMatrix_t<6,T> const& tm, Twiss_t<T>& v, double threshold)
+  {
+    // propagate uncoupled lattice functions through an element with matrix tm 
+
+    propagatePlane( tm[0][0], tm[0][1], tm[1][0], tm[1][1], v.BtX, v.AlX, v.nuX, threshold);
+    propagatePlane( tm[2][2], tm[2][3], tm[3][2], tm[3][3], v.BtY, v.AlY, v.nuY, threshold);
+
+    T dx  = tm[0][0]*v.DsX + tm[0][1]*v.DsXp + tm[0][5];
+    T dxp = tm[1][0]*v.DsX + tm[1][1]*v.DsXp + tm[1][5];
+    T dy  = tm[2][2]*v.DsY + tm[2][3]*v.DsYp + tm[2][5];
+    T dyp = tm[3][2]*v.DsY + tm[3][3]*v.DsYp + tm[3][5];
+
+    v.DsX  = dx;
+    v.DsXp = dxp;
+    v.DsY  = dy;
+    v.DsYp = dyp;
+  }
+
+  //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+  template <typename T>
+  bool periodicPlane( T const& m00, T const& m01, T const& m10, T const& m11, T const& m05, T const& m15, 
+                      T& bt, T& al, T& ds, T& dsp)
+  {
+    // periodic solution for a one-turn 2x2 block. Returns true if the motion is unstable.
+
+    using std::sqrt;
+
+    T cs = 0.5*(m00 + m11);
+    if ( std::fabs(primal(cs)) >= 1.0 ) return true;
+
+    T sn = sqrt(1.0 - cs*cs);
+    if ( primal(m01) < 0.0 ) sn = -sn;
+
+    bt = m01/sn;
+    al = (m00 - m11)/(2.0*sn);
+
+    // (I-M) D = M[.][5]
+    
+    T det = (1.0-m00)*(1.0-m11) - m01*m10;
+    ds  = ( (1.0-m11)*m05 + m01*m15 )/det;
+    dsp = ( m10*m05 + (1.0-m00)*m15 )/det;
+
+    return false;
+  }
+
+  //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+  template <typename T>
+  int periodicSolution( RMatrix_t<6,T> const& tm, Twiss_t<T>& v)
+  {
+    // Periodic uncoupled lattice functions; same return convention as find_tunes():
+    // 0: ok, 1: cannot close for X, 2: cannot close for Y 3: cannot close for X&Y 
+    
+    int ret = 0;
+    if (periodicPlane( tm[0][0], tm[0][1], tm[1][0], tm[1][1], tm[0][5], tm[1][5], v.BtX, v.AlX, v.DsX, v.DsXp)) ret |= 1;
+    if (periodicPlane( tm[2][2], tm[2][3], tm[3][2], tm[3][3], tm[2][5], tm[3][5], v.BtY, v.AlY, v.DsY, v.DsYp)) ret |= 2;
+    return ret;
+  }
+  
+} // namespace TwissAD
+
+#endif // TWISSAD_H
@@ -44,11 +44,14 @@
 #include <gsl/gsl_fft_halfcomplex.h>
 #include <gsl/gsl_fft_real.h>
 #include <gsl/gsl_spline.h>
+#include <SplineInterpolator.h>
 #include <vector>
 
 #ifndef VAVILOV_H
 #define VAVILOV_H
 
+class RandomStream;
+
 class Vavilov {
 
  public:
@@ -60,11 +63,12 @@ class Vavilov {
   };
   
   Vavilov(Parameters const&p );
-  Vavilov(Vavilov const& o);
+  Vavilov(Vavilov const& o) = delete;   // owns the gsl splines; share through std::shared_ptr<Vavilov const>
   // Vavilov();
  ~Vavilov();
 
   double             operator()() const;   // random generator 
+  double             operator()(RandomStream& rng) const;   // draws from a per-particle stream 
 
   double          pdf(double eps) const;
   double          cdf(double eps) const;
@@ -104,12 +108,14 @@ private:
   double*                               ya_;             // pdf dependent   variable samples
   double*                               invcdfxa_;       // inverse cdf independent variable samples 
   double*                               invcdfya_;       // inverse cdf dependent   variable samples
-  gsl_interp_accel*                     acc_;            // spline accelerator object for pdf  
-  gsl_interp_accel*                     invcdfacc_;      // spline accelerator object for inverse cdf
+  double                                pmax_;           // cdf(epsmax()), upper bound of the sampled probability
+  SplineInterpolator                    qtbl_;           // inverse cdf on a uniform grid in probability (spacing dq_)
+  double                                dq_;
+
+  // NOTE: the splines are evaluated without a gsl_interp_accel; the accelerator caches the last
+  //       interval and would make concurrent evaluation on a shared instance unsafe.
 
-  static std::random_device                     dev_;   // random device to initialize seed
-  static std::mt19937                           rng_;   // rng_(dev());    
-  static std::uniform_real_distribution<double> dist_;  // dist_(0.0, 1.0) distribution in range [0.0, 1.0]
+  static std::mt19937&                          rng_;   // shared engine (GlobalState::generator)
 
 
 };
@@ -218,7 +218,7 @@ int OptimMainWindow::analyzeElement(OptimEditor* editor, int nline, char *buf, i
 
 #define NBB_NAME 32
 
-int OptimMainWindow::analyze(bool Reprint, int NmbTurn)
+int OptimMainWindow::analyze(bool Reprint, int NmbTurn, bool CalcHeader)
 {
 
  auto& IncludeMode      = appstate.IncludeMode;
@@ -269,11 +269,14 @@ int OptimMainWindow::analyze(bool Reprint, int NmbTurn)
  // Parse math header 
  
  IncludeMode = false;
- calc_.zeroCalc();
- sprintf(buf, "$_turn=%d", NmbTurn);
- calc_.calcLine(buf, &result, "%12.9lg", str_res, buf1);
+ if(CalcHeader){
+   calc_.zeroCalc();
+   sprintf(buf, "$_turn=%d", NmbTurn);
+   calc_.calcLine(buf, &result, "%12.9lg", str_res, buf1);
+ }
+ else nline = lineOptiM;  // the header variables are current (see DecInc())
  
- while(true){
+ while(CalcHeader){
    nline = getLineCalc(editor, buf, LSTR, nline);
 
    if(nline<0){
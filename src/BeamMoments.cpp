@@ -41,10 +41,12 @@
 #include <Twiss.h>
 #include <RMatrix.h>
 #include <BeamMoments.h>
+#include <MomentsStore.h>
 #include <Coordinates.h>
 #include <Bunch.h>
 #include <spdlog/spdlog.h>
 #include <algorithm>
+#include <limits>
 #include <vector>
 #include <variant>
 #include <sqlite/query.hpp>
@@ -78,6 +80,53 @@ std::ostream& operator<<( std::ostream& os, BeamMoments const& m)
 // ||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 // ||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
+MomentSums::MomentSums()
+  : n(0), nlost(0)
+{
+  for (int i=0; i<6; ++i) {
+    mu[i]   = 0.0;
+    umin[i] =  std::numeric_limits<double>::infinity();
+    umax[i] = -std::numeric_limits<double>::infinity();
+    for (int j=0; j<6; ++j) smtx[i][j] = 0.0;
+  }
+}
+
+// ||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+// ||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void MomentSums::add( Coordinates const& p)
+{
+  ++n;
+  if (p.lost != 0) { 
+    ++nlost;
+    return;
+  } 
+  for (int i=0; i<6; ++i) {
+    mu[i]  += p[i];
+    umin[i] = std::min(umin[i], p[i]);
+    umax[i] = std::max(umax[i], p[i]);
+    for (int j=0; j<=i; ++j) smtx[i][j] += p[i]*p[j];  
+  }
+}
+
+// ||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+// ||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void MomentSums::merge( MomentSums const& o)
+{
+  n     += o.n;
+  nlost += o.nlost;
+  for (int i=0; i<6; ++i) {
+    mu[i]  += o.mu[i];
+    umin[i] = std::min(umin[i], o.umin[i]);
+    umax[i] = std::max(umax[i], o.umax[i]);
+    for (int j=0; j<=i; ++j) smtx[i][j] += o.smtx[i][j];  
+  }
+}
+
+// ||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+// ||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
 BeamMoments::BeamMoments()
 {}
 
@@ -87,12 +136,6 @@ BeamMoments::BeamMoments()
 BeamMoments::BeamMoments(double gamma, Bunch const& v, int n, bool parallel_tracking)
 {
 
-  static const std::complex<double> I(0.0,1.0); 
-  static double const pi = 4*atan(1.0);
-
-  static const RMatrix_t<4> U('J');                        // symplectic matrix
-  static const RMatrix_t<4,std::complex<double>> Uc('J');  // complex symplectic matrix
-
   double bg = sqrt(gamma*gamma - 1.0); // beta*gamma
   gma = gamma;
   bta = bg/gamma;
@@ -111,6 +154,36 @@ BeamMoments::BeamMoments(double gamma, Bunch const& v, int n, bool parallel_trac
     compute_moments(v, mu, sigma_mtx, sigma4_mtx);
   }
   
+  compute_eigenmodes(sigma4_mtx);
+}
+
+// ||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+// ||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+BeamMoments::BeamMoments(double gamma, MomentSums const& sums)
+{
+  double bg = sqrt(gamma*gamma - 1.0); // beta*gamma
+  gma = gamma;
+  bta = bg/gamma;
+
+  double mu[6]; // centroids
+
+  RMatrix_t<4> sigma4_mtx;
+  compute_moments_sums(sums, mu, cov, sigma4_mtx);
+  compute_eigenmodes(sigma4_mtx);
+}
+
+// ||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+// ||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void BeamMoments::compute_eigenmodes( RMatrix_t<4,double> const& sigma4_mtx)
+{
+  static const std::complex<double> I(0.0,1.0); 
+  static double const pi = 4*atan(1.0);
+
+  static const RMatrix_t<4> U('J');                        // symplectic matrix
+  static const RMatrix_t<4,std::complex<double>> Uc('J');  // complex symplectic matrix
+
   // compute eigenvectors, eigenvalues and eigen-emittances ... 
   
   std::complex<double>     ev[4][4];
@@ -214,10 +287,39 @@ BeamMoments::BeamMoments(double gamma, Bunch const& v, int n, bool parallel_trac
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
+std::vector<std::string> const& BeamMoments::dbScalarColumns()
+{
+  static std::vector<std::string> names;
+
+  if (names.empty()) {
+    for (int i=0; i<6; ++i) {
+      for (int j=0; j<=i; ++j) names.push_back(dbCovColumn(i,j));
+    }
+    for (auto prefix : {"avg", "min", "max"}) {
+      for (int i=0; i<6; ++i) names.push_back(prefix + std::to_string(i));
+    }
+  }
+  return names;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+std::string BeamMoments::dbCovColumn(int i, int j)
+{
+  if (j>i) std::swap(i,j);
+  return "cov" + std::to_string(i) + std::to_string(j);
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
 void BeamMoments::init_moments_table( sqlite::connection& con)
 {
+  // the table is recreated rather than emptied, so that a persistent moments_db written
+  // with an older layout does not break the inserts.  
 
-  std::string cmd = "CREATE TABLE IF NOT EXISTS Moments ("
+  std::string cmd = "CREATE TABLE Moments ("
     "turn       INTEGER NOT NULL ,"
     "eidx       INTEGER NOT NULL ,"
     "pathlen    REAL NOT NULL, "
@@ -231,11 +333,17 @@ void BeamMoments::init_moments_table( sqlite::connection& con)
     "eps1       REAL NOT NULL, "
     "eps2       REAL NOT NULL, "
     "eps3       REAL NOT NULL, "
-    "nlost      INTEGER NOT NULL, "
-    "PRIMARY KEY (turn ASC, eidx ASC));";
+    "nlost      INTEGER NOT NULL, ";
+
+  for (auto const& name : dbScalarColumns()) cmd += name + " REAL, ";
+  cmd += "PRIMARY KEY (turn ASC, eidx ASC));";
 
+  dbFlush(con);
+  sqlite::execute(con, "DROP TABLE IF EXISTS main.Moments;", true);
   sqlite::execute(con, cmd, true);
-  sqlite::execute(con, R"(DELETE FROM Moments;)", true);
+  sqlite::execute(con, "CREATE INDEX MomentsEidx ON Moments (eidx, turn);", true);
+
+  MomentsStore::init(con);
 }
 
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
@@ -245,11 +353,12 @@ void BeamMoments::compute_moments_parallel( Bunch const& v, double* mutmp, SymMa
 
   double mu[] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};   
 
-  nlost = 0;
+  int nlost = 0;
 
   double smtx[6][6];
   for (int i=0; i<6; ++i) {
-    umin[i] = umax[i] = 0.0;
+    umin[i] =  std::numeric_limits<double>::infinity();
+    umax[i] = -std::numeric_limits<double>::infinity();
     for (int j=0; j<6; ++j) {
       smtx[i][j] = 0.0;
     }
@@ -276,13 +385,50 @@ void BeamMoments::compute_moments_parallel( Bunch const& v, double* mutmp, SymMa
     }
   } // loop over particles
 
+  MomentSums sums;
+  sums.n     = v.size();
+  sums.nlost = nlost;
   for (int i=0; i<6; ++i) {
-     mu[i] /= (v.size()-nlost);
+    sums.mu[i]   = mu[i];
+    sums.umin[i] = umin[i];
+    sums.umax[i] = umax[i];
+    for (int j=0; j<=i; ++j) {
+      sums.smtx[i][j] = smtx[i][j];
+    }
+  }
+
+  compute_moments_sums(sums, mutmp, sigma_mtx, sigma4_mtx);
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void BeamMoments::compute_moments_sums( MomentSums const& sums, double* mu, SymMatrix_t<6,double>& sigma_mtx, RMatrix_t<4,double>& sigma4_mtx )
+{
+  nlost = sums.nlost;
+  intensity = (sums.n > 0) ? 1.0 - double(nlost)/double(sums.n) : 0.0;
+
+  int nlive = sums.n - nlost;
+
+  if (nlive <= 0) {  // no particle left 
+    for (int i=0; i<6; ++i) {
+      mu[i] = uavg[i] = umin[i] = umax[i] = 0.0;
+      for (int j=0; j<=i; ++j) sigma_mtx[i][j] = 0.0;
+    }
+    for (int i=0; i<4; ++i) {
+      for (int j=0; j<4; ++j) sigma4_mtx[i][j] = 0.0;
+    }
+    return;
+  }
+  
+  for (int i=0; i<6; ++i) {
+     mu[i]   = sums.mu[i]/nlive;
+     umin[i] = sums.umin[i];
+     umax[i] = sums.umax[i];
   }
   for (int i=0; i<6; ++i) {
-    mutmp[i] = mu[i];
     for (int j=0; j<=i; ++j) {
-      sigma_mtx[i][j] = smtx[i][j]/(v.size()-nlost);
+      sigma_mtx[i][j] = sums.smtx[i][j]/nlive;
       sigma_mtx[i][j] -= mu[i]*mu[j];
     }
   }
@@ -305,8 +451,7 @@ void BeamMoments::compute_moments_parallel( Bunch const& v, double* mutmp, SymMa
   if ( sdpp > 0.0) {  
     for (int i=0; i<4; ++i) {
       for (int j=0; j<4; ++j) {
-            sigma_mtx[i][j]  -= (sigma_mtx[i][5]*sigma_mtx[j][5])/sdpp;   
-	    sigma4_mtx[i][j]  -= (sigma_mtx[i][5]*sigma_mtx[j][5])/sdpp;   // THIS IS DONE SO THAT sigma4_mtx can be used to compute eigenvectors.  
+	    sigma4_mtx[i][j]  -= (sigma_mtx[i][5]*sigma_mtx[j][5])/sdpp;   // as in compute_moments(): sigma4_mtx is used to compute eigenvectors.  
       }
     }
   }
@@ -384,10 +529,13 @@ void BeamMoments::compute_moments( Bunch const& v, double* mu, SymMatrix_t<6,dou
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
+namespace {
+  bool transaction = false;   // true while dbWrite holds an open transaction 
+}
+
 void BeamMoments::dbWrite(sqlite::connection& con, int turn, int eidx, int nturns)
 {
 
-  static bool transaction = false; 
   // serialize the vector into a binary blob ... 
 
   int const cvsiz = (6*(6+1))/2;
@@ -445,8 +593,15 @@ void BeamMoments::dbWrite(sqlite::connection& con, int turn, int eidx, int nturn
     sqlite::execute(con, "BEGIN TRANSACTION;", true);
   }
   
-  static std::string sql( "INSERT INTO Moments "
-	  	   "(turn, eidx, pathlen, umin, umax, uavg, covariance, mode1,  mode2, mode3, eps1, eps2, eps3, nlost) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?); " );
+  static std::string sql = [] () {
+    std::string cols = "turn, eidx, pathlen, umin, umax, uavg, covariance, mode1,  mode2, mode3, eps1, eps2, eps3, nlost";
+    std::string vals = "?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?";
+    for (auto const& name : dbScalarColumns()) {
+      cols += ", " + name;
+      vals += ", ?";
+    }
+    return "INSERT INTO Moments (" + cols + ") VALUES (" + vals + ");";
+  }();
   
   static sqlite::command insert_moments(con, sql);
 
@@ -454,8 +609,16 @@ void BeamMoments::dbWrite(sqlite::connection& con, int turn, int eidx, int nturn
   insert_moments % turn % eidx % s % umin_blob % umax_blob % uavg_blob
                                    % covariance_blob % mode1_blob % mode2_blob % mode3_blob
                                    % eps[0] % eps[1] % eps[2] % nlost; 
+
+  double const* pcov = &cov[0][0];
+  for (int i=0; i<cvsiz; ++i) insert_moments % pcov[i];
+  for (int i=0; i<6; ++i)     insert_moments % uavg[i];
+  for (int i=0; i<6; ++i)     insert_moments % umin[i];
+  for (int i=0; i<6; ++i)     insert_moments % umax[i];
   insert_moments.emit();
 
+  MomentsStore::record(con, *this, turn, eidx);
+
   
   if (transaction && ((turn%20 == 0) || (turn == nturns))) {
     sqlite::execute(con, "END TRANSACTION;", true);
@@ -469,6 +632,16 @@ void BeamMoments::dbWrite(sqlite::connection& con, int turn, int eidx, int nturn
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
+void BeamMoments::dbFlush(sqlite::connection& con)
+{
+  if (!transaction) return;
+  sqlite::execute(con, "END TRANSACTION;", true);
+  transaction = false;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
 void BeamMoments::dbRead(sqlite::connection& con, std::string const& query)
 {
   sqlite::query q(con, query);
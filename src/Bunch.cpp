@@ -37,25 +37,51 @@
 //
 
 #include <Bunch.h>
+#include <algorithm>
 
 
 Bunch::Bunch()
+  : active_(0)
 {}
 
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-std::vector<int>& Bunch::lossProfile()
+Bunch::Bunch(std::initializer_list<Coordinates> lst)
+  : particles_(lst), active_(lst.size())
+{}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int Bunch::compact()
 {
-  
-  //  for ( Coordinates const& c: lost_particles_) { // loop over n particles (Coordinates)
-  //  ++loss_profile_[c.nelem];   
-  //}
+  // stable partition of the active range: survivors first, then the particles lost since the last call
+
+  auto first = particles_.begin();
+  auto last  = particles_.begin() + active_;
+
+  auto it = std::stable_partition(first, last, [](Coordinates const& p) { return p.lost == 0; } );
 
-  for ( auto const& p: particles_) { // loop over all particles (Coordinates)
-    if (p.lost !=0) ++loss_profile_[p.nelem];   
+  int nremoved = last - it;
+  if (nremoved == 0) return 0;
+
+  for (auto p = it; p != last; ++p) {
+    if (p->nelem >= int(loss_profile_.size())) loss_profile_.resize(p->nelem+1, 0);
+    ++loss_profile_[p->nelem];
+    lost_particles_.push_back(*p);
   }
-  
+
+  active_ -= nremoved;
+  return nremoved;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+std::vector<int>& Bunch::lossProfile()
+{
+  compact();
   return loss_profile_;
 }
 
@@ -66,11 +92,9 @@ int   Bunch::nlost() const
 {
   // returns the number of lost particles
   
-  // return lost_particles_.size();
-
-  int nlost;
-  for ( auto const& p: particles_) { // loop over all particles (Coordinates)
-    if (p.lost ==0) ++nlost;
+  int nlost = lost_particles_.size();
+  for (int i=0; i<active_; ++i) {
+    if (particles_[i].lost != 0) ++nlost;
   }
   
   return nlost;
@@ -85,3 +109,77 @@ int  Bunch::size()     const
    return particles_.size();
 }
 
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+namespace {
+
+  // Coordinates are written field by field so that the format does not depend on struct padding
+
+  bool writeParticles(FILE* fp, std::vector<Coordinates> const& v)
+  {
+    unsigned int n = v.size();
+    if (fwrite(&n, sizeof(n), 1, fp) != 1) return false;
+    for (auto const& p : v) {
+      if ( fwrite(p.c.data(), sizeof(double), 6, fp) != 6 ||
+	   fwrite(&p.lost,    sizeof(p.lost),   1, fp) != 1 ||
+	   fwrite(&p.pid,     sizeof(p.pid),    1, fp) != 1 ||
+	   fwrite(&p.nelem,   sizeof(p.nelem),  1, fp) != 1 ||
+	   fwrite(&p.npass,   sizeof(p.npass),  1, fp) != 1 ||
+	   fwrite(&p.weight,  sizeof(p.weight), 1, fp) != 1 ) return false;
+    }
+    return true;
+  }
+
+  bool readParticles(FILE* fp, std::vector<Coordinates>& v)
+  {
+    unsigned int n = 0;
+    if (fread(&n, sizeof(n), 1, fp) != 1) return false;
+    v.resize(n);
+    for (auto& p : v) {
+      if ( fread(p.c.data(), sizeof(double), 6, fp) != 6 ||
+	   fread(&p.lost,    sizeof(p.lost),   1, fp) != 1 ||
+	   fread(&p.pid,     sizeof(p.pid),    1, fp) != 1 ||
+	   fread(&p.nelem,   sizeof(p.nelem),  1, fp) != 1 ||
+	   fread(&p.npass,   sizeof(p.npass),  1, fp) != 1 ||
+	   fread(&p.weight,  sizeof(p.weight), 1, fp) != 1 ) return false;
+    }
+    return true;
+  }
+
+} // namespace
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int Bunch::write(FILE* fp) const
+{
+  unsigned int nprof = loss_profile_.size();
+
+  if ( !writeParticles(fp, particles_)      ||
+       !writeParticles(fp, lost_particles_) ||
+       fwrite(&active_, sizeof(active_), 1, fp) != 1 ||
+       fwrite(&nprof,   sizeof(nprof),   1, fp) != 1 ||
+       fwrite(loss_profile_.data(), sizeof(int), nprof, fp) != nprof ) return 1;
+
+  return 0;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int Bunch::read(FILE* fp)
+{
+  unsigned int nprof = 0;
+
+  if ( !readParticles(fp, particles_)      ||
+       !readParticles(fp, lost_particles_) ||
+       fread(&active_, sizeof(active_), 1, fp) != 1 ||
+       fread(&nprof,   sizeof(nprof),   1, fp) != 1 ) return 1;
+
+  loss_profile_.resize(nprof);
+  if ( fread(loss_profile_.data(), sizeof(int), nprof, fp) != nprof ) return 1;
+
+  if (active_ < 0 || active_ > (int) particles_.size() ) return 1;
+  return 0;
+}
@@ -43,6 +43,8 @@
 #include <limits>
 #include <TrackParam.h>
 #include <Coordinates.h>
+#include <ElementMatrices.h>
+#include <Tpsa.h>
 
 using Constants::PI;
 using Constants::C_DERV1;
@@ -107,98 +109,10 @@ RMatrix CFBend::rmatrix(double& alfap, double& energy, double ms, double& tetaY,
   double gamma1 = 1.0 + energy/ms;
 
   RMatrix mi;
-  mi.toUnity();
-
-  double fi;    // phase advance 
-  // alfap = 0.0; 
-  double ks;
-
+  ElementMatrices::cfbend<double>(mi, L_, B, G, hr, gamma1);
 
-  // zero field and zero gradient -- behaves as a drift 
- 
   if( fabs(B) < 100.0*std::numeric_limits<double>::epsilon() &&
-      fabs(G) < 100.0*std::numeric_limits<double>::epsilon() ) {
-
-      mi[0][1] = L_;
-      mi[2][3] = L_;
-      mi[4][5] = L_/(gamma1*gamma1);
-
-      return mi;
-  }	
-
-  // vertical motion
-
-  double ky2  = -(G/hr);
-  
-  if( fabs(ky2) < 100.0 *std::numeric_limits<double>::epsilon()) { // no ver focusing
-      mi[2][3] = L_;
-  }
-  else if (ky2 >= 0.0) { // G > 0  vertical defocusing 
-    ks  = sqrt(ky2);
-    fi = L_*ks;
-    mi[2][2] =  mi[3][3] = cos(fi);
-    mi[2][3] =  (fabs(ks) < 1.0e-12 ? L_ : sin(fi)/ks);
-    mi[3][2] = -ks*ks * mi[2][3];
-  }
-  else {
-     ks  = sqrt( -ky2 );
-     fi = L_*ks;
-     mi[2][2] =  mi[3][3] = cosh(fi);
-     mi[2][3] =  (fabs(ks) < 1.0e-12 ? L_ : sinh(fi)/ks);
-     mi[3][2] =  ks*ks * mi[2][3];
-  }
-    
-  // horizontal motion
-
-  double ri = B / hr; // inverse curvature radius
-  double kx2  = (G/hr) +  ri*ri;
-
-  // *** some bending but no net hor focusing (note that this includes bending contribution)
-  if (fabs(kx2) < 100.0 * std::numeric_limits<double>::epsilon() )  {
-    mi[0][1] = L_;
-
-    // longitudinal 
-
-    mi[0][5] = 0.5 * L_ * L_ * ri;
-    mi[4][1] = -mi[0][5];
-
-    mi[1][5] = L_ * ri;
-    mi[4][0] = -mi[1][5];
-
-    mi[4][5] = mi[1][5] * mi[1][5] * L_ /6.;
-    mi[4][5] = L_/(gamma1*gamma1) -mi[4][5];
-
-  }
-
-  else {
-
-    if (kx2 >= 0.0) {  // G>0 ==> hor focusing
-      ks  = sqrt(kx2);
-      fi  = L_ * ks;
-      mi[0][0] =  mi[1][1] = cos(fi);
-      mi[0][1] = (fabs(ks) < 1.0e-12 ? L_ : sin(fi)/ks);
-      mi[1][0] = -ks*ks*mi[0][1];
-    }
-    else {
-      ks = sqrt(-kx2);
-      fi = L_ * ks;
-      mi[0][0] = mi[1][1] = cosh(fi);
-      mi[0][1] = (fabs(ks) < 1.0e-12 ? L_: sinh(fi)/ks);
-      mi[1][0] = ks*ks*mi[0][1];
-    }
-
-    // longitudinal motion
-    //---------------------
-  
-    mi[0][5] =   (ri/kx2) * (1.0 - mi[0][0]);
-    mi[1][5] =   ri*mi[0][1];
-
-    mi[4][0] =  -mi[1][5];
-    mi[4][1] =  -mi[0][5];
-    mi[4][5] =  L_*(ri*ri)/kx2* ( 1.0- mi[0][1]/L_ );
-    mi[4][5] =  L_/(gamma1*gamma1) - mi[4][5];
-  }
-
+      fabs(G) < 100.0*std::numeric_limits<double>::epsilon() ) return mi; // drift 
 
   if( (T_ != 0) || (tetaY != 0) ) {  // alfa[deg], fi[rad], tetaY[deg]
 
@@ -437,9 +351,6 @@ int CFBend::trackOnce( double ms, double& Enr0, int n_elem, int n_turn, TrackPar
   int status = 0; 
   if ( (status = backwardTest(prm, n_elem, n_turn, v)) ) return status;
 
-  double p = prm.p0*(1.0+v[5]);  // p = p0 (1 + dp/p)  
-  double Hr = p/C_DERV1; // brho  =  p/ec   p is in MeV/c   
-
   if( fabs(B) < std::numeric_limits<double>::epsilon() )  { // no bending, just a quadrupole 
     std::unique_ptr<Quadrupole> q(new Quadrupole("qdummy") );
     q->length(L_);
@@ -447,14 +358,6 @@ int CFBend::trackOnce( double ms, double& Enr0, int n_elem, int n_turn, TrackPar
     return q->trackOnce( ms, Enr0, n_elem, n_turn, prm, m1, v);
   }
 
-  // upstream rotation of the coordinate system about the propagation axis 
-
-  double x  = prm.cb1*v[0] - prm.sb1*v[2];
-  double y  = prm.sb1*v[0] + prm.cb1*v[2];
-  double xp = prm.cb1*v[1] - prm.sb1*v[3];
-  double yp = prm.sb1*v[1] + prm.cb1*v[3];
- 
- 
  // THIS CODE NEEDS SOME WORK ... IT IS LIKELY BROKEN  !!!!
  //........................................................................................................
 
@@ -466,31 +369,102 @@ int CFBend::trackOnce( double ms, double& Enr0, int n_elem, int n_turn, TrackPar
   else { 
     
     if( fabs(G) < 10*std::numeric_limits<double>::epsilon() ) {    // an ideal dipole with zero gradient
-   
-     double R  = prm.R0*(1.+v[5])*cos(yp);
-     double s  = sin(xp);
-     double c  = cos(xp);
-
-     double xc = R*s;
-     double yc = (prm.R0 + x) - R*c;
-     double sc = xc*prm.cfi-yc*prm.sfi;
 
-     double Rtilda = R*R-sc*sc;
-
-     if(Rtilda < 0.0) {
+     if (!dipole(ms, prm, v.c.data())) {
        v.lost  = 2;
        v.nelem = n_elem+1;
        v.npass = n_turn;
        goto done;
      }
+  }
+
+   else {          // combined functions dipole
+     v.c = m1*v.c;
+   }
+ } // if (envoverride) 
+
+ // .....................................................................................
+    
+   tiltKick(prm, v.c.data());
+
+ done:
+
+   if ( (status = transAmpTest(prm, n_elem, n_turn, v)) ) return status;
+
+   return 0;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int CFBend::trackMap( double ms, double& Enr0, int n_elem, TrackParam& prm,
+		      RMatrix const& m1, Tpsa* u) const
+{
+  // same code paths as trackOnce(), with Tpsa coordinates. 
+
+  if( fabs(B) < std::numeric_limits<double>::epsilon() )  { // no bending, just a quadrupole 
+    Quadrupole q("qdummy");
+    q.length(L_);
+    q.G = G;
+    q.transport(ms, prm, u);
+    return 0;
+  }
+
+  if ( !std::getenv("OPTIMX_CFBEND_TRACK_WITH_MATRIX") && 
+       (fabs(G) < 10*std::numeric_limits<double>::epsilon()) ) {
+    if (!dipole(ms, prm, u)) return 1;
+  }
+  else {
+    Element::trackMap(ms, Enr0, n_elem, prm, m1, u);
+  }
+
+  tiltKick(prm, u);
+
+  return 0;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+template <typename T>
+bool CFBend::dipole( double ms, TrackParam const& prm, T* v) const
+{
+  // ideal dipole (zero gradient), exact geometry. T is double (tracking) or Tpsa (map extraction).
+  // Returns false if the particle does not exit through the downstream face. 
+
+  using std::sin;
+  using std::cos;
+  using std::sqrt;
+  using std::atan;
+
+  T p = prm.p0*(1.0+v[5]);  // p = p0 (1 + dp/p)  
+
+  // upstream rotation of the coordinate system about the propagation axis 
+
+  T x  = prm.cb1*v[0] - prm.sb1*v[2];
+  T y  = prm.sb1*v[0] + prm.cb1*v[2];
+  T xp = prm.cb1*v[1] - prm.sb1*v[3];
+  T yp = prm.sb1*v[1] + prm.cb1*v[3];
+ 
+     T R  = prm.R0*(1.+v[5])*cos(yp);
+     T s  = sin(xp);
+     T c  = cos(xp);
+
+     T xc = R*s;
+     T yc = (prm.R0 + x) - R*c;
+     T sc = xc*prm.cfi-yc*prm.sfi;
+
+     T Rtilda = R*R-sc*sc;
+
+     if(Rtilda < 0.0) return false;
 
      Rtilda = prm.sgn*sqrt(Rtilda) + xc*prm.sfi +yc*prm.cfi;
-     double xf     =  Rtilda -prm.R0;
-     double xpf    =  prm.phi - atan((Rtilda*prm.sfi-xc)/(Rtilda*prm.cfi-yc));
+     T xf     =  Rtilda -prm.R0;
+     T xpf    =  prm.phi - atan((Rtilda*prm.sfi-xc)/(Rtilda*prm.cfi-yc));
 
-     double Lloc   =  R*(prm.phi + xp - xpf); // Local L_ 
+     T Lloc   =  R*(prm.phi + xp - xpf); // Local L_ 
 
-     double  yf     =  y + Lloc*sin(yp);
+     T yf     =  y + Lloc*sin(yp);
          //  ypf is unchanged.   
 
 
@@ -502,19 +476,23 @@ int CFBend::trackOnce( double ms, double& Enr0, int n_elem, int n_turn, TrackPar
      v[3]  = prm.sb2*xpf + prm.cb2*yp;  // yp
 
      // This cannot be right. It fails to account for the change in path length
-     double vp    = C_CGS*p/sqrt(p*p+ms*ms)*cos(yp);
+     T vp    = C_CGS*p/sqrt(p*p+ms*ms)*cos(yp);
      // v[4] += (vp/prm.vp0 - 1.0 )*Lloc;
      // probably should be  ??? 
      v[4] += (vp/prm.vp0 - 1.0 )*L_ - (Lloc-L_); // [(dv/v) - dL_/L_ ] * L_  = dv/v*L_ - dL_ 
-  }
 
-   else {          // combined functions dipole
-     v.c = m1*v.c;
-   }
- } // if (envoverride) 
+  return true;
+}
 
- // .....................................................................................
-    
+template bool CFBend::dipole( double ms, TrackParam const& prm, double* v) const;
+template bool CFBend::dipole( double ms, TrackParam const& prm, Tpsa*   v) const;
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+template <typename T>
+void CFBend::tiltKick( TrackParam const& prm, T* v) const
+{
    if (TiltErr_ != 0.0) {  // simple formulas to describe the kick due to dipole tilt
 
      double c = -cos(T_/180.*PI)*PI*TiltErr_/180.*L_/prm.R0;
@@ -526,13 +504,21 @@ int CFBend::trackOnce( double ms, double& Enr0, int n_elem, int n_turn, TrackPar
      v[3] += c;
    }
 
- done:
+   if (FieldErr_ != 0.0) {  // the field error deflects in the bend plane; the reference orbit is unchanged 
 
-   if ( (status = transAmpTest(prm, n_elem, n_turn, v)) ) return status;
+     double c = -cos(T_/180.*PI)*FieldErr_*L_/prm.R0;
+     double s = -sin(T_/180.*PI)*FieldErr_*L_/prm.R0;
 
-   return 0;
+     v[0] += 0.5*L_*c;
+     v[1] += c;
+     v[2] += 0.5*L_*s;
+     v[3] += s;
+   }
 }
 
+template void CFBend::tiltKick( TrackParam const& prm, double* v) const;
+template void CFBend::tiltKick( TrackParam const& prm, Tpsa*   v) const;
+
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
@@ -555,6 +555,17 @@ int CFBend::trackOnce( double ms, double& Enr0, int n_elem, int n_turn, TrackPar
      v[3] += c;
    }
 
+   if (FieldErr_ != 0.0) {  // see CFBend::tiltKick 
+
+     double c = -cos(T_/180.*PI)*FieldErr_*L_/prm.R0;
+     double s = -sin(T_/180.*PI)*FieldErr_*L_/prm.R0;
+
+     v[0] += 0.5*L_*c;
+     v[1] += c;
+     v[2] += 0.5*L_*s;
+     v[3] += s;
+   }
+
  done:
 
    if (status = transAmpTest(prm, n_elem, n_turn, v, loss)) return status;
@@ -0,0 +1,213 @@
+//  =================================================================
+//
+//  ClosedOrbit.cpp
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+#include <ClosedOrbit.h>
+#include <Element.h>
+#include <TrackParam.h>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+ClosedOrbit::ClosedOrbit()
+  : valid_(false), reuse_(true), dim_(4), maxiters_(50), tol_(1.0e-10), niters_(0), njac_(0)
+{
+  jac_.toUnity();
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int ClosedOrbit::track( std::vector<std::shared_ptr<Element>> const& line, double ms, double Enr, double tetaY,
+                        Coordinates& v, int turn, RMatrix* jac, std::vector<Coordinates>* record )
+{
+  RMatrix me;
+  TrackParam prm;
+
+  if (record) record->resize(line.size());
+
+  for (int i=0; i<int(line.size()); ++i) {
+
+    auto const& ep = line[i];
+    double EnrNew = Enr;
+
+    ep->preTrack(ms, Enr, tetaY, i, prm, me);
+
+    int status = jac ? ep->trackTangent(ms, EnrNew, i, turn, prm, me, v, *jac)
+                     : ep->trackOnce   (ms, EnrNew, i, turn, prm, me, v);
+    if (status) return i+1;
+
+    ep->rmatrix(Enr, ms, tetaY, 0.0, 3);  // advance energy and frame angle along the reference orbit 
+
+    if (record) (*record)[i] = v;
+  }
+  return 0;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int ClosedOrbit::jacobian( std::vector<std::shared_ptr<Element>> const& line, double ms, double Enr, double tetaY,
+                           Coordinates const& v, RMatrix& m, double h )
+{
+  int status = 0;
+
+  for (int j=0; j<6; ++j) {
+
+    Coordinates vp = v;
+    Coordinates vm = v;
+    vp[j] += h;
+    vm[j] -= h;
+
+    if ( (status = track(line, ms, Enr, tetaY, vp)) ) return status;
+    if ( (status = track(line, ms, Enr, tetaY, vm)) ) return status;
+
+    for (int i=0; i<6; ++i) m[i][j] = (vp[i] - vm[i])/(2.0*h);
+  }
+  return 0;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+ClosedOrbit::Status ClosedOrbit::operator()( std::vector<std::shared_ptr<Element>> const& line, double ms, double Enr, double tetaY,
+                                             Coordinates& v, int dim )
+{
+  // On success, v is the fixed point and map() the Jacobian of the one-turn map about it.
+  // On failure, v is unchanged.  
+
+  njac_ = 0;
+  
+  if (dim != dim_) { 
+    valid_ = false;
+    dim_   = dim;
+  }
+  
+  Coordinates x = v;
+  double errp = std::numeric_limits<double>::max();
+
+  for (niters_=1; niters_<=maxiters_; ++niters_) {
+
+    bool fresh = !(valid_ && reuse_);
+    
+    Coordinates u = x;
+    RMatrix jac;
+    jac.toUnity();
+
+    if ( track(line, ms, Enr, tetaY, u, 0, fresh ? &jac : 0) ) {
+      if (fresh) return lost;
+      valid_ = false;   // the cached Jacobian led us astray; start over with a fresh one 
+      x      = v;
+      errp   = std::numeric_limits<double>::max();
+      continue;
+    }
+
+    if (fresh) {
+      jac_   = jac;
+      valid_ = true;
+      ++njac_;
+    }
+    
+    double d[6]; 
+    double err = 0.0;
+    double sum = 0.0;
+    for (int i=0; i<dim_; ++i) {
+      d[i] = u[i] - x[i];
+      err += std::fabs(d[i]);
+      sum += std::fabs(x[i]);
+    }
+
+    if ( err <= tol_*(sum + 1.0e-3) ) {
+      if (!fresh) {  // the cached Jacobian belongs to an earlier iterate; map() is about the closed orbit 
+        u = x;
+        jac.toUnity();
+        if ( track(line, ms, Enr, tetaY, u, 0, &jac) ) return lost;
+        jac_ = jac;
+        ++njac_;
+      }
+      v = x;
+      return converged;
+    }
+
+    if ( !fresh && (err > 0.25*errp) ) {  // slow (linear) convergence: refresh the Jacobian at x 
+      valid_ = false;
+      continue;
+    }
+
+    // Newton step: solve (I - J) dx = u - x  
+
+    double dx[6];
+
+    try {
+      if (dim_ == 4) { 
+        RMatrix_t<4,double> a;
+        for (int i=0; i<4; ++i) {
+          for (int j=0; j<4; ++j) a[i][j] = (i==j ? 1.0 : 0.0) - jac_[i][j];
+        }
+        a = a.inverse();
+        for (int i=0; i<4; ++i) {
+          dx[i] = 0.0;
+          for (int j=0; j<4; ++j) dx[i] += a[i][j]*d[j];
+        }
+      }
+      else {
+        RMatrix a;
+        for (int i=0; i<6; ++i) {
+          for (int j=0; j<6; ++j) a[i][j] = (i==j ? 1.0 : 0.0) - jac_[i][j];
+        }
+        a = a.inverse();
+        for (int i=0; i<6; ++i) {
+          dx[i] = 0.0;
+          for (int j=0; j<6; ++j) dx[i] += a[i][j]*d[j];
+        }
+      }
+    }
+    catch (std::exception const&) {
+      if (fresh) return singular;
+      valid_ = false;
+      continue;
+    }
+
+    for (int i=0; i<dim_; ++i) x[i] += dx[i];
+    errp = err;
+  }
+
+  return maxiters;
+}
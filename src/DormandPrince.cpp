@@ -0,0 +1,279 @@
+//  =================================================================
+//
+//  DormandPrince.cpp
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+
+#include <DormandPrince.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+namespace {
+
+  // Dormand-Prince 5(4) tableau (Hairer, Norsett & Wanner, Solving ODE I, DOPRI5)
+
+  const double c2 = 1.0/5,  c3 = 3.0/10, c4 = 4.0/5,  c5 = 8.0/9;
+
+  const double a21 = 1.0/5;
+  const double a31 = 3.0/40,        a32 = 9.0/40;
+  const double a41 = 44.0/45,       a42 = -56.0/15,       a43 = 32.0/9;
+  const double a51 = 19372.0/6561,  a52 = -25360.0/2187,  a53 = 64448.0/6561,  a54 = -212.0/729;
+  const double a61 = 9017.0/3168,   a62 = -355.0/33,      a63 = 46732.0/5247,  a64 = 49.0/176,    a65 = -5103.0/18656;
+  const double a71 = 35.0/384,      a73 = 500.0/1113,     a74 = 125.0/192,     a75 = -2187.0/6784, a76 = 11.0/84;
+
+  // error estimate: 5th order - 4th order weights  
+
+  const double e1 = 71.0/57600,     e3 = -71.0/16695,     e4 = 71.0/1920,      e5 = -17253.0/339200;
+  const double e6 = 22.0/525,       e7 = -1.0/40;
+
+  // dense output 
+
+  const double d1 = -12715105075.0/11282082432,  d3 = 87487479700.0/32700410799,  d4 = -10690763975.0/1880347072;
+  const double d5 = 701980252875.0/199316789632, d6 = -1453857185.0/822651844,    d7 = 69997945.0/29380423;
+
+  const double safety = 0.9;   // step size control
+  const double facmin = 0.2;
+  const double facmax = 5.0;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+DormandPrince::DormandPrince()
+  : tol_(), nvar_(0), nfev_(0)
+{}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+DormandPrince::DormandPrince( Tolerance const& tol)
+  : tol_(tol), nvar_(0), nfev_(0)
+{}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void DormandPrince::resize( int nvar)
+{
+  nvar_ = nvar;
+  k_.resize(7*nvar);
+  ytmp_.resize(nvar);
+  ynew_.resize(nvar);
+  cont_.clear();
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+INTEGRERR DormandPrince::step( double x, double h, double const y[], Derivs derivs, ODEparam* p)
+{
+  int n = nvar_;
+  double* k1 = &k_[0];   double* k2 = k1+n;  double* k3 = k2+n;  double* k4 = k3+n;
+  double* k5 = k4+n;     double* k6 = k5+n;  double* k7 = k6+n;
+  double* yt = &ytmp_[0];
+  INTEGRERR ret;
+
+  for (int i=0; i<n; ++i) yt[i] = y[i] + h*a21*k1[i];
+  if ( (ret = derivs(x+c2*h, yt, k2, p)) ) return ret;
+
+  for (int i=0; i<n; ++i) yt[i] = y[i] + h*(a31*k1[i] + a32*k2[i]);
+  if ( (ret = derivs(x+c3*h, yt, k3, p)) ) return ret;
+
+  for (int i=0; i<n; ++i) yt[i] = y[i] + h*(a41*k1[i] + a42*k2[i] + a43*k3[i]);
+  if ( (ret = derivs(x+c4*h, yt, k4, p)) ) return ret;
+
+  for (int i=0; i<n; ++i) yt[i] = y[i] + h*(a51*k1[i] + a52*k2[i] + a53*k3[i] + a54*k4[i]);
+  if ( (ret = derivs(x+c5*h, yt, k5, p)) ) return ret;
+
+  for (int i=0; i<n; ++i) yt[i] = y[i] + h*(a61*k1[i] + a62*k2[i] + a63*k3[i] + a64*k4[i] + a65*k5[i]);
+  if ( (ret = derivs(x+h, yt, k6, p)) ) return ret;
+
+  for (int i=0; i<n; ++i) ynew_[i] = y[i] + h*(a71*k1[i] + a73*k3[i] + a74*k4[i] + a75*k5[i] + a76*k6[i]);
+  if ( (ret = derivs(x+h, &ynew_[0], k7, p)) ) return ret;
+
+  nfev_ += 6;
+  return NO_ERR;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+double DormandPrince::error( double h, double const y[]) const
+{
+  // rms of the scaled error estimate of the last step  
+
+  int n = nvar_;
+  double const* k1 = &k_[0];   double const* k3 = k1+2*n;  double const* k4 = k3+n;
+  double const* k5 = k4+n;     double const* k6 = k5+n;    double const* k7 = k6+n;
+
+  double err = 0.0;
+  for (int i=0; i<n; ++i) {
+    double sk = tol_.atol + tol_.rtol*std::max(std::abs(y[i]), std::abs(ynew_[i]));
+    double ei = h*(e1*k1[i] + e3*k3[i] + e4*k4[i] + e5*k5[i] + e6*k6[i] + e7*k7[i])/sk;
+    err += ei*ei;
+  }
+  return std::sqrt(err/n);
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void DormandPrince::keep( double h, double const y[])
+{
+  int n = nvar_;
+  double const* k1 = &k_[0];   double const* k3 = k1+2*n;  double const* k4 = k3+n;
+  double const* k5 = k4+n;     double const* k6 = k5+n;    double const* k7 = k6+n;
+
+  for (int i=0; i<n; ++i) {
+    double ydiff = ynew_[i] - y[i];
+    double bspl  = h*k1[i] - ydiff;
+    cont_.push_back(y[i]);
+    cont_.push_back(ydiff);
+    cont_.push_back(bspl);
+    cont_.push_back(ydiff - h*k7[i] - bspl);
+    cont_.push_back(h*(d1*k1[i] + d3*k3[i] + d4*k4[i] + d5*k5[i] + d6*k6[i] + d7*k7[i]));
+  }
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+INTEGRERR DormandPrince::integrate( double x1, double x2, int nvar, double ystart[], Derivs derivs, ODEparam* p)
+{
+  resize(nvar);
+  mesh_.clear();
+  mesh_.push_back(x1);
+
+  std::vector<double> y(ystart, ystart+nvar);
+
+  INTEGRERR ret;
+  if ( (ret = derivs(x1, &y[0], &k_[0], p)) ) return ret;
+  ++nfev_;
+
+  double dir      = (x2 < x1) ? -1.0 : 1.0;
+  double h        = 0.01*(x2-x1);   // the first steps adjust it 
+  double x        = x1;
+  bool   rejected = false;
+
+  for (int nstep=0; (x2-x)*dir > 0.0; ++nstep) {
+
+    if (nstep >= tol_.maxsteps) return TOO_MANY_STEPS;
+
+    bool last = ( (x+h-x2)*dir >= 0.0 );
+    if (last) h = x2-x;
+    if ( std::abs(h) <= 10.0*std::numeric_limits<double>::epsilon()*std::abs(x) ) return SMALL_STEP;
+
+    if ( (ret = step(x, h, &y[0], derivs, p)) ) return ret;
+
+    double err = error(h, &y[0]);
+    double fac = (err > 0.0) ? safety*std::pow(err, -0.2) : facmax;
+
+    if (err <= 1.0) {
+      keep(h, &y[0]);
+      x = last ? x2 : x+h;
+      mesh_.push_back(x);
+      std::copy(ynew_.begin(), ynew_.end(), y.begin());
+      std::copy(k_.begin()+6*nvar, k_.end(), k_.begin());  // FSAL 
+      h *= std::min( rejected ? 1.0 : facmax, std::max(facmin, fac));
+      rejected = false;
+    }
+    else {
+      h *= std::max(facmin, fac);
+      rejected = true;
+    }
+  }
+
+  std::copy(y.begin(), y.end(), ystart);
+  return NO_ERR;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+INTEGRERR DormandPrince::replay( int nvar, double ystart[], Derivs derivs, ODEparam* p)
+{
+  if (mesh_.empty()) return TOO_MANY_STEPS; // no mesh 
+
+  resize(nvar);
+
+  std::vector<double> y(ystart, ystart+nvar);
+
+  INTEGRERR ret;
+  if ( (ret = derivs(mesh_[0], &y[0], &k_[0], p)) ) return ret;
+  ++nfev_;
+
+  for (int j=0; j<steps(); ++j) {
+    double h = mesh_[j+1] - mesh_[j];
+    if ( (ret = step(mesh_[j], h, &y[0], derivs, p)) ) return ret;
+    keep(h, &y[0]);
+    std::copy(ynew_.begin(), ynew_.end(), y.begin());
+    std::copy(k_.begin()+6*nvar, k_.end(), k_.begin());  
+  }
+
+  std::copy(y.begin(), y.end(), ystart);
+  return NO_ERR;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+bool DormandPrince::dense( double x, double y[]) const
+{
+  int ns = cont_.size()/(5*std::max(nvar_,1));
+  if ( ns == 0 ) return false;
+
+  double lo = std::min(mesh_.front(), mesh_[ns]);
+  double hi = std::max(mesh_.front(), mesh_[ns]);
+  if ( (x < lo) || (x > hi) ) return false;
+
+  // step j such that x is in [mesh_[j], mesh_[j+1]] 
+
+  int j = 0;
+  if (mesh_[ns] > mesh_[0]) j = std::upper_bound(mesh_.begin(), mesh_.begin()+ns+1, x) - mesh_.begin() - 1;
+  else                      j = std::upper_bound(mesh_.begin(), mesh_.begin()+ns+1, x, std::greater<double>()) - mesh_.begin() - 1;
+  j = std::min(std::max(j, 0), ns-1);
+
+  double theta  = (x - mesh_[j])/(mesh_[j+1] - mesh_[j]);
+  double theta1 = 1.0 - theta;
+
+  double const* r = &cont_[5*nvar_*j];
+  for (int i=0; i<nvar_; ++i, r += 5) {
+    y[i] = r[0] + theta*(r[1] + theta1*(r[2] + theta*(r[3] + theta1*r[4])));
+  }
+  return true;
+}
@@ -40,6 +40,8 @@
 #include <Constants.h>
 #include <TrackParam.h>
 #include <Coordinates.h>
+#include <Tpsa.h>
+#include <cmath>
 
 using Constants::C_CGS;
 using Constants::C_DERV1;
@@ -106,13 +108,7 @@ int Drift::trackOnce( double ms,   double& Enr0, int n_elem, int n_turn, TrackPa
   int status = 0; 
   if (status = backwardTest(prm, n_elem, n_turn, v )) return status;
 
-  double p = prm.p0*(1.0+v[5]);  // p = p0 (1 + dp/p)  
-  
-  v[0] += L_*tan(v[1]);
-  v[2] += L_*tan(v[3]);
-
-  double vp  = C_CGS*p/sqrt( p*p*(1.0 + v[1]*v[1] + v[3]*v[3]) + ms*ms );  // velocity
-  v[4] += (vp - prm.vp0) * L_ / prm.vp0;
+  transport(L_, ms, prm, v.c.data());
 
  done:	
 
@@ -124,6 +120,39 @@ int Drift::trackOnce( double ms,   double& Enr0, int n_elem, int n_turn, TrackPa
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
+template <typename T> 
+void Drift::transport( double L, double ms, TrackParam const& prm, T* v) 
+{
+  // shared by the other field free elements (instrument, longitudinal corrector) 
+
+  using std::tan;
+  using std::sqrt;
+
+  T p = prm.p0*(1.0+v[5]);  // p = p0 (1 + dp/p)  
+  
+  v[0] += L*tan(v[1]);
+  v[2] += L*tan(v[3]);
+
+  T vp  = C_CGS*p/sqrt( p*p*(1.0 + v[1]*v[1] + v[3]*v[3]) + ms*ms );  // velocity
+  v[4] += (vp - prm.vp0) * L / prm.vp0;
+}
+
+template void Drift::transport( double L, double ms, TrackParam const& prm, double* v);
+template void Drift::transport( double L, double ms, TrackParam const& prm, Tpsa*   v);
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int Drift::trackMap( double ms, double& Enr0, int n_elem, TrackParam& prm,
+		     RMatrix const& m1, Tpsa* u) const
+{
+  transport(L_, ms, prm, u);
+  return 0;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
 RMatrix Drift::rmatrixsc(double& alfap, double& energy, double ms, double current, BeamSize& bs,double& tetaY, double dalfa, int st ) const
 {
 
@@ -72,12 +72,10 @@ void EAcc::toString(char* buf) const
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-EAcc* EAcc::split( int nslices) const
+void EAcc::slice(int nslices)
 {
-  EAcc* e = this->clone();
-  e->L_ /= nslices;
-  e->B /= nslices;
-  return e;
+  L_ /= nslices;
+  B  /= nslices;
 }
 
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
@@ -63,6 +63,16 @@ Edge::Edge(Edge const& o) // 'G'
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
+void Edge::assign(Element const& o)
+{
+  Element::assign(o);
+  isupstream   = static_cast<Edge const&>(o).isupstream;
+  bendGradient = static_cast<Edge const&>(o).bendGradient;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
 RMatrix Edge::rmatrix(double& alfap, double& energy, double ms, double& tetaY, double dalfa, int st) const
 {
   double P      = sqrt(energy * (energy + 2. * ms));
@@ -44,6 +44,7 @@
 
 #include <Channel.h>
 #include <Beamline.h>
+#include <Bunch.h>
 #include <Twiss.h>
 #include <TrackParam.h>
 #include <Element.h>
@@ -54,8 +55,10 @@
 #include <Constants.h>
 #include <Coordinates.h>
 #include <RMatrix.h>
+#include <ElementMatrices.h>
 #include <OptimMessages.h>
 #include <Globals.h>
+#include <Tpsa.h>
 
 using std::acosh;
 
@@ -85,6 +88,7 @@ Element::Element(char const* nm, char const* fnm)
     ofsX_(0.0),
     ofsY_(0.0),
     TiltErr_(0.0),
+    FieldErr_(0.0),
     slices_(1)
 {}
 
@@ -106,6 +110,7 @@ Element::Element()
   ofsX_(0.0),
   ofsY_(0.0),
   TiltErr_(0.0),
+  FieldErr_(0.0),
   slices_(1)
 {}
 
@@ -127,6 +132,7 @@ Element::Element( Element const& o)
   ofsX_(o.ofsX_),
   ofsY_(o.ofsY_),
   TiltErr_(o.TiltErr_),
+  FieldErr_(o.FieldErr_),
   slices_(o.slices_)
 {}  
 
@@ -162,6 +168,7 @@ void Element::swap( Element& e1, Element& e2)
   swap(	e1.ofsX_,      e2.ofsX_);
   swap(	e1.ofsY_,      e2.ofsY_);
   swap(	e1.TiltErr_,   e2.TiltErr_);
+  swap(	e1.FieldErr_,  e2.FieldErr_);
   swap(	e1.slices_,    e2.slices_);
 }
 
@@ -276,6 +283,32 @@ double Element::tiltErr() const
   return TiltErr_;
 }
 
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+double Element::tiltErr(double value) 
+{
+  TiltErr_ = value;
+  return TiltErr_;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+double Element::fieldErr() const
+{
+  return FieldErr_;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+double Element::fieldErr(double value) 
+{
+  FieldErr_ = value;
+  return FieldErr_;
+}
+
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 double Element::tilt(double value) 
@@ -532,14 +565,47 @@ Element* Element::makeElement( char const* nm, char const* fnm)
 Element* Element::split(int nslices) const
 {
   Element* e = this->clone();
-  e->L_ /= nslices;
-  e->slices_  = nslices;
+  if (splittable()) e->slice(nslices);
   return e;
 }
 
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
+void Element::slice(int nslices)
+{
+  L_     /= nslices;
+  slices_ = nslices;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void Element::assign(Element const& o)
+{
+  // Same members as the copy constructor. Unlike operator=, the strings 
+  // are assigned in place: no allocation once their capacity is sufficient. 
+
+  name_.assign(o.name_);
+  fullname_.assign(o.fullname_);
+  L_       = o.L_;
+  B        = o.B;
+  G        = o.G;
+  S        = o.S;
+  T_       = o.T_;
+  A        = o.A;
+  N        = o.N;
+  plane_   = o.plane_;
+  ofsX_    = o.ofsX_;
+  ofsY_    = o.ofsY_;
+  TiltErr_  = o.TiltErr_;
+  FieldErr_ = o.FieldErr_;
+  slices_  = o.slices_;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
 RMatrix Element::rmatrix(double& alfap, double& energy, double ms, double& tetaY, double dalfa, int st) const
 {
   double P      = sqrt(energy *(energy + 2.0 * ms));
@@ -548,11 +614,7 @@ RMatrix Element::rmatrix(double& alfap, double& energy, double ms, double& tetaY
   double gamma1 = 1.0 + energy/ms;
 
   RMatrix mi;
-  mi.toUnity();
-  
-  mi[0][1] = mi[2][3] = L_;
-  mi[4][5] = L_/(gamma1*gamma1);
-
+  ElementMatrices::drift<double>(mi, L_, gamma1);
   return mi;
 }
 
@@ -701,6 +763,82 @@ int Element::trackOnce( double ms,   double& Enr0, int n_elem, int n_turn, Track
 //|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
+int Element::trackBunch( double ms, double Enr0, int n_elem, int n_turn, TrackParam& prm,
+		         RMatrix const& m1, Bunch& v, int N, bool parallel) const
+{
+  // Tracks the particles [0,N) of v that are not lost, one at a time. The stochastic elements
+  // draw from a per-particle RandomStream in trackOnce(), so the result does not depend on the
+  // no of threads. An element may override this to process the bunch in batches (see FoilNew).
+
+  #pragma omp parallel for if(parallel)
+  for (int j=0; j<N; ++j) {
+    if (v[j].lost != 0 ) continue; 
+    double enr = Enr0;
+    trackOnce(ms, enr, n_elem, n_turn, prm, m1, v[j]);
+  }
+  return 0;
+}
+
+//|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int Element::trackTangent( double ms,   double& Enr0, int n_elem, int n_turn, TrackParam& prm,
+		           RMatrix const& m1, Coordinates& v, RMatrix& jac) const
+{
+  // Tracks v through the element and updates jac, the tangent map (Jacobian) of the
+  // tracking map from an upstream reference point, so that jac -> M jac where M is
+  // the Jacobian of the element map at the incoming coordinates.
+  // The default uses the transfer matrix m1. This is exact for elements tracked with a linear
+  // map; otherwise, it is the linearization about the reference orbit, which is adequate 
+  // when the nonlinearity is weak (fringe fields, chromatic terms). Sextupoles and multipoles,
+  // whose map is dominated by the nonlinear kick, override this function.  
+
+  int status = trackOnce(ms, Enr0, n_elem, n_turn, prm, m1, v);
+  jac = m1*jac;
+  return status; 
+}
+
+//|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int Element::trackMap( double ms, double& Enr0, int n_elem, TrackParam& prm,
+		       RMatrix const& m1, Tpsa* u) const
+{
+  // Propagates the truncated power series map u[6] through the element. Returns 0 on success, 
+  // 1 if the reference particle is lost and 2 if the element cannot be represented by a map.   
+  // The default uses the transfer matrix m1, the same as trackTangent(). Elements that change
+  // the reference energy (cavities, accelerating sections) and stochastic or collective elements
+  // are rejected.  
+
+  switch (etype()) {
+    case 'A': 
+    case 'W': 
+    case 'E':  // energy change 
+    case 'T': 
+    case 'U': 
+    case 'V': 
+    case 'J':  // scattering  
+    case '_': 
+    case 'Y':  // collective 
+      return 2;
+    default:
+      break;
+  }
+
+  Tpsa w[6];
+  for (int i=0; i<6; ++i) {
+    for (int j=0; j<6; ++j) { 
+      if (m1[i][j] != 0.0) w[i] += m1[i][j]*u[j];
+    }
+  }
+  std::copy(&w[0], &w[6], u); 
+
+  return 0; 
+}
+
+//|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
 int Element::track( double ms, double& Enr,  Coordinates& v, double& tetaY ) const
 
 {
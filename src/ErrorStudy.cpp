@@ -0,0 +1,436 @@
+//  =================================================================
+//
+//  ErrorStudy.cpp
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+#include <ErrorStudy.h>
+#include <ClosedOrbit.h>
+#include <OptimMainWindow.h>
+#include <OptimMessages.h>
+#include <OptimCalc.h>
+#include <Element.h>
+#include <RMatrix.h>
+#include <Twiss.h>
+#include <Utility.h>
+#include <Globals.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#undef emit
+#include <sqlite/execute.hpp>
+#include <sqlite/command.hpp>
+#include <sqlite3.h>
+
+#define LSTR 1024
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int ErrorSpec::read( char const* fname, std::vector<ErrorSpec>& specs, char* msg)
+{
+  specs.clear();
+
+  FILE* fp = fopen(fname, "r");
+  if (!fp) {
+    sprintf(msg, "Cannot open error specification file %s", fname);
+    return 1;
+  }
+  std::shared_ptr<FILE> sfp(fp, std::fclose);
+
+  char buf[LSTR+1];
+  char filter[256];
+  char kind[16];
+  char mc[16];
+  
+  int nline = 0;
+  while (fgets(buf, LSTR, fp)) {
+
+    ++nline;
+    char* p = buf;
+    while (isspace(*p)) ++p;
+    if ( (*p == '#') || (*p == 0) ) continue;
+
+    ErrorSpec spec;
+    mc[0] = 'Y';
+    int k = sscanf(p, "%255s %15s %lf %lf %15s", filter, kind, &spec.sigma, &spec.cut, mc);
+    if (k < 3) {
+      sprintf(msg, "%s, line %d: expected <filter> <kind> <sigma> [cut] [MatchCase]", fname, nline);
+      return 1;
+    }
+
+    switch (toupper(kind[0])) {
+      case 'X':
+      case 'Y':
+      case 'R':
+      case 'B':
+      case 'G':
+        spec.kind = ErrorSpec::Kind(toupper(kind[0]));
+        break;
+      default:
+        sprintf(msg, "%s, line %d: unknown error kind %s (should be X, Y, R, B or G)", fname, nline, kind);
+        return 1;
+    }
+
+    spec.filter     = filter;
+    spec.match_case = (toupper(mc[0]) != 'N');
+    specs.push_back(spec);
+  }
+
+  if (specs.empty()) {
+    sprintf(msg, "File %s does not specify any error", fname);
+    return 1;
+  }
+  return 0;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+bool ErrorSpec::matches( Element const& e) const
+{
+  return Utility::filterName(e.fullName(), filter.c_str(), match_case);
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void ErrorSpec::apply( Element& e, std::mt19937& gen) const
+{
+  std::normal_distribution<double> gauss(0.0, 1.0);
+
+  double z = gauss(gen);
+  while ( (cut > 0.0) && (std::fabs(z) > cut) ) z = gauss(gen);  
+
+  double err = sigma*z;
+
+  switch (kind) {
+    case OffsetX:
+      e.offsX(e.offsX() + err);
+      break;
+    case OffsetY:
+      e.offsY(e.offsY() + err);
+      break;
+    case Roll:
+      if (e.etype() == 'B' || e.etype() == 'D') e.tiltErr(e.tiltErr() + err); // the tilt of a bend defines the reference orbit 
+      else                                      e.tilt(e.tilt() + err);
+      break;
+    case Field:
+      if (e.etype() == 'B' || e.etype() == 'D') e.fieldErr(e.fieldErr() + err); // a dipole kick; the field of a bend defines the reference orbit 
+      else                                      e.B *= (1.0 + err);
+      break;
+    case Gradient:
+      e.G *= (1.0 + err);
+      break;
+  }
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void ErrorSeedSummary::init_table( sqlite::connection& con)
+{
+  std::string cmd = "CREATE TABLE IF NOT EXISTS ErrorStudy ("
+    "seed       INTEGER PRIMARY KEY, "
+    "status     INTEGER NOT NULL, "
+    "nux        REAL NOT NULL, "
+    "nuy        REAL NOT NULL, "
+    "xrms       REAL NOT NULL, "
+    "yrms       REAL NOT NULL, "
+    "xmax       REAL NOT NULL, "
+    "ymax       REAL NOT NULL, "
+    "bbxrms     REAL NOT NULL, "
+    "bbyrms     REAL NOT NULL, "
+    "bbxmax     REAL NOT NULL, "
+    "bbymax     REAL NOT NULL, "
+    "turns      INTEGER NOT NULL);";
+
+  sqlite::execute(con, cmd, true);
+  sqlite::execute(con, R"(DELETE FROM ErrorStudy;)", true);
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void ErrorSeedSummary::dbWrite( sqlite::connection& con) const
+{
+  sqlite::command insert_summary(con, "INSERT INTO ErrorStudy "
+                                 "(seed, status, nux, nuy, xrms, yrms, xmax, ymax, bbxrms, bbyrms, bbxmax, bbymax, turns) "
+                                 "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);");
+
+  insert_summary % seed % status % nux % nuy % xrms % yrms % xmax % ymax
+                 % bbxrms % bbyrms % bbxmax % bbymax % turns;
+  insert_summary.emit();
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int OptimMainWindow::lineBetas( std::vector<std::shared_ptr<Element>> const& line, Twiss& v, RMatrix& tm,
+                                std::vector<double>& btx, std::vector<double>& bty) const
+{
+  // periodic lattice functions at the exit of every element of line. On return, v holds the 
+  // lattice functions at the line exit, with the tunes, and tm the one-turn matrix. 
+  // Returns 0 on success, or the find_tunes() error code. The line is not modified.
+
+  RMatrix me;
+  std::complex<double> ev[4][4];
+  double alfa;
+
+  double tetaY = tetaYo0_;
+  double Enr   = Ein;
+
+  tm.toUnity();
+  for (auto const& ep : line) { me = ep->rmatrix(Enr, ms, tetaY, 0.0, 3); tm = me*tm; }
+
+  RMatrix m = tm;
+  int irt = find_tunes(m, Length_, v, &alfa);
+  if (irt) return irt;
+
+  v.nuX = v.nuY = 0.0;
+  v.eigenvectors(ev);
+
+  tetaY = tetaYo0_;
+  Enr   = Ein;
+
+  btx.resize(line.size());
+  bty.resize(line.size());
+
+  for (int i=0; i<int(line.size()); ++i) {
+    auto const& ep = line[i];
+    me = ep->rmatrix(Enr, ms, tetaY, 0.0, 3);
+    ep->propagateLatticeFunctions(me, v, ev);
+    btx[i] = v.BtX;
+    bty[i] = v.BtY;
+  }
+  return 0;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void OptimMainWindow::errorStudySeed( std::vector<ErrorSpec> const& specs, std::vector<double> const& btx0,
+                                      std::vector<double> const& bty0, int nturn, ErrorSeedSummary& summary) const
+{
+  //-------------------------------------------------------------------------------------------
+  // One seed of an error study. The errors are applied to a private copy of the analyzed
+  // beamline; the same seed always produces the same errors. This function may be called
+  // concurrently for distinct seeds. 
+  //-------------------------------------------------------------------------------------------
+
+  std::mt19937 gen(summary.seed);
+
+  std::vector<std::shared_ptr<Element>> line(nelm_);
+
+  for (int i=0; i<nelm_; ++i) {
+    line[i] = std::shared_ptr<Element>(beamline_[i]->clone());
+    for (auto const& spec : specs) {
+      if (spec.matches(*line[i])) spec.apply(*line[i], gen);
+    }
+  }
+
+  Twiss v;
+  RMatrix tm;
+  std::vector<double> btx;
+  std::vector<double> bty;
+
+  if ( (summary.status = lineBetas(line, v, tm, btx, bty)) ) return;
+
+  summary.nux = v.nuX;
+  summary.nuy = v.nuY;
+
+  for (int i=0; i<nelm_; ++i) {
+    double bbx = (btx0[i] > 0.0) ? (btx[i] - btx0[i])/btx0[i] : 0.0;
+    double bby = (bty0[i] > 0.0) ? (bty[i] - bty0[i])/bty0[i] : 0.0;
+    summary.bbxrms += bbx*bbx;
+    summary.bbyrms += bby*bby;
+    summary.bbxmax = std::max(summary.bbxmax, std::fabs(bbx));
+    summary.bbymax = std::max(summary.bbymax, std::fabs(bby));
+  }
+
+  Coordinates co;
+  for (int i=0; i<6; ++i) co[i] = 0.0;
+
+  ClosedOrbit closure;
+  closure.maxIterations(Ncvg);
+  closure.tolerance(CvgErr);
+
+  std::vector<Coordinates> orbit;
+  if ( closure(line, ms, Ein, tetaYo0_, co) || ClosedOrbit::track(line, ms, Ein, tetaYo0_, co, 0, 0, &orbit) ) {
+    summary.status = ErrorSeedSummary::noclosure;
+    return;
+  }
+
+  for (auto const& u : orbit) {
+    summary.xrms += u[0]*u[0];
+    summary.yrms += u[2]*u[2];
+    summary.xmax = std::max(summary.xmax, std::fabs(u[0]));
+    summary.ymax = std::max(summary.ymax, std::fabs(u[2]));
+  }
+
+  if (nelm_ > 0) { 
+    summary.bbxrms = sqrt(summary.bbxrms/nelm_);
+    summary.bbyrms = sqrt(summary.bbyrms/nelm_);
+    summary.xrms   = sqrt(summary.xrms/nelm_);
+    summary.yrms   = sqrt(summary.yrms/nelm_);
+  }
+
+  // optional tracking: a probe particle, launched one rms beam size away from the closed orbit  
+
+  if (nturn <= 0) return;
+
+  Coordinates probe = co;
+  probe[0] += sqrt(std::max(ex_, 0.0)*v.BtX);
+  probe[2] += sqrt(std::max(ey_, 0.0)*v.BtY);
+
+  for (summary.turns=0; summary.turns<nturn; ++summary.turns) {
+    if (ClosedOrbit::track(line, ms, Ein, tetaYo0_, probe, summary.turns+1)) break;
+  }
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int OptimMainWindow::ErrorStudyOffLine( char* ErrorSpecFile, char* SummaryFile, int nseeds, int nturn)
+{
+  //-------------------------------------------------------------------------------------------
+  // Monte-Carlo error study. For each seed, random errors are applied to a copy of the
+  // beamline and the closed orbit, beta-beat and tunes are computed (and, optionally, the
+  // survival of a probe particle over nturn turns). Seeds are processed in parallel; the
+  // per-seed summaries are committed to the ErrorStudy table of the moments database
+  // as they become available and a statistical summary is written to SummaryFile.  
+  //-------------------------------------------------------------------------------------------
+
+  auto con = Globals::preferences().con;
+
+  char buf[LSTR+1];
+  char const* cher[3] = { "X" , "Y" , "X&Y"};
+
+  std::vector<ErrorSpec> specs;
+  if (ErrorSpec::read(ErrorSpecFile, specs, buf)) {
+    OptimMessageBox::warning(this, "Error Study", buf, QMessageBox::Ok);
+    return 1;
+  }
+
+  FILE* fpw = fopen(SummaryFile, "w");
+  if (!fpw) {
+    sprintf(buf, "Cannot open file %s to write error study results", SummaryFile);
+    OptimMessageBox::warning(this, "Error Study", buf, QMessageBox::Ok);
+    return 1;
+  }
+  std::shared_ptr<FILE> sfpw(fpw, std::fclose);
+
+  if (analyzed_) { if (analyze(false,1)) return 1; } else { if (analyze(true,1)) return 1; }
+
+  // nominal lattice 
+
+  Twiss v0;
+  RMatrix tm;
+  std::vector<double> btx0;
+  std::vector<double> bty0;
+
+  int irt = lineBetas(beamline_.beamline_, v0, tm, btx0, bty0);
+  if (irt) {
+    strcpy(buf, "Cannot close for ");
+    strcat(buf, cher[irt-1]);
+    OptimMessageBox::warning(this, "Error Study", buf, QMessageBox::Ok);
+    return 1;
+  }
+
+  unsigned int seed0 = Globals::preferences().rng_seed;
+  bool parallel      = Globals::preferences().parallel_tracking;
+
+  std::vector<ErrorSeedSummary> summaries(nseeds);
+
+  ErrorSeedSummary::init_table(*con); // each summary is committed on its own, as soon as its seed is done 
+
+#pragma omp parallel for schedule(dynamic) if(parallel)
+  for (int k=0; k<nseeds; ++k) {
+
+    auto& summary = summaries[k];
+    summary.seed  = seed0 + k;
+
+    try {
+      errorStudySeed(specs, btx0, bty0, nturn, summary);
+    }
+    catch (std::exception const&) {
+      summary.status = ErrorSeedSummary::noclosure;
+    }
+
+#pragma omp critical (error_study_db)
+    summary.dbWrite(*con);
+  }
+
+  // statistics over the seeds for which the lattice could be closed 
+
+  double avg[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+  double rms[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+  int    nok    = 0;
+
+  fprintf(fpw, "# Error study: %d seeds, first seed %u, %d turns\n", nseeds, seed0, nturn);
+  fprintf(fpw, "# nominal tunes: nux = %.6f  nuy = %.6f\n", v0.nuX, v0.nuY);
+  fprintf(fpw, "#seed \tstatus \tnux \tnuy \tXrms[cm] \tYrms[cm] \tXmax[cm] \tYmax[cm] \tdBx/Bx_rms \tdBy/By_rms \tdBx/Bx_max \tdBy/By_max \tturns\n");
+
+  for (auto const& s : summaries) {
+    fprintf(fpw, "%d \t%d \t%.6f \t%.6f \t%e \t%e \t%e \t%e \t%e \t%e \t%e \t%e \t%d\n",
+            s.seed, s.status, s.nux, s.nuy, s.xrms, s.yrms, s.xmax, s.ymax, s.bbxrms, s.bbyrms, s.bbxmax, s.bbymax, s.turns);
+    if (s.status) continue;
+    double val[6] = { s.nux, s.nuy, s.xrms, s.yrms, s.bbxrms, s.bbyrms };
+    for (int i=0; i<6; ++i) { avg[i] += val[i]; rms[i] += val[i]*val[i]; }
+    ++nok;
+  }
+
+  if (nok > 0) {
+    for (int i=0; i<6; ++i) {
+      avg[i] /= nok;
+      rms[i]  = sqrt(std::max(0.0, rms[i]/nok - avg[i]*avg[i]));
+    }
+  }
+
+  fprintf(fpw, "# %d of %d seeds closed\n", nok, nseeds);
+  fprintf(fpw, "# mean: nux = %.6f  nuy = %.6f  Xrms[cm] = %e  Yrms[cm] = %e  dBx/Bx_rms = %e  dBy/By_rms = %e\n",
+          avg[0], avg[1], avg[2], avg[3], avg[4], avg[5]);
+  fprintf(fpw, "# std:  nux = %.6f  nuy = %.6f  Xrms[cm] = %e  Yrms[cm] = %e  dBx/Bx_rms = %e  dBy/By_rms = %e\n",
+          rms[0], rms[1], rms[2], rms[3], rms[4], rms[5]);
+
+  return 0;
+}
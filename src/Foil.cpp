@@ -43,7 +43,7 @@
 #include <Moliere.h>
 #include <Constants.h>
 #include <Coordinates.h>
-#include <random>
+#include <RandomStream.h>
 #include <chrono>
 #include <map>
 
@@ -54,11 +54,6 @@ static const double mp = Constants::MP_MEV*1.0e6;    // proton rest mass [eV]
 
 
 namespace {
-  std::random_device rd;  //Will be used to obtain a seed for the random number engine
-  std::mt19937 gen(rd() );
-  std::normal_distribution<double>       normal(0.0,1.0);  // normal distribution mean=0.0, sigma=1.0
-  std::uniform_real_distribution<double> uniform(0.0,1.0);  // uniform distribution mean=0.0, sigma=1.0
-
   struct Material {
     std::string name; 
     double rho; //  [g/cm**3] density  
@@ -263,11 +258,13 @@ int  Foil::trackOnce( double ms,   double& Enr0,    int n_elem, int n_turn, Trac
   double bta =  bg/gma;  
   double p   =  bg*ms; // momentum, MeV/c
 
+  RandomStream rng(n_turn, n_elem, v.pid);  // per-particle stream: reproducible in parallel and on resume  
+
   //................................................
   // transverse small angle (multiple scattering) contribution
   //................................................
 
-  Moliere::Fluctuation mfluct = (*moliere_)();
+  Moliere::Fluctuation mfluct = (*moliere_)(rng);
   
   v[0] += mfluct.x; 
   v[2] += mfluct.y; 
@@ -287,7 +284,7 @@ int  Foil::trackOnce( double ms,   double& Enr0,    int n_elem, int n_turn, Trac
   //std::cerr <<  " dE_  = " << dE_  << std::endl; 
   //std::cerr <<  " Enr0 = " << Enr0 << std::endl; 
 
-  double dEv  =   dE_* ((*vavilov_)());
+  double dEv  =   dE_* ((*vavilov_)(rng));
   //std::cout <<   "vavilov dEv = " << dEv  << std::endl;
 
   v[5] -=   ( ((dE_ + dEv)*1.0e-6)/Enr0 ); //  avg loss + Vavilov fluctuation 
@@ -301,7 +298,7 @@ int  Foil::trackOnce( double ms,   double& Enr0,    int n_elem, int n_turn, Trac
   //std::cerr <<  " ms  = " << ms  << std::endl; 
 
   double dtheta  = (me/(ms*1.0e6)) * sqrt(4*dE_*(dEv/tmax))*(1.0-(dEv/tmax)); // dE_, tmax in [eV]
-  double alpha   = 2*pi*uniform(gen); 
+  double alpha   = 2*pi*rng.uniform(); 
   double dxp     = dtheta*sin(alpha);
   double dyp     = dtheta*cos(alpha);
 
@@ -164,6 +164,9 @@
 #include <Landau.h>
 #include <Vavilov.h>
 #include <Moliere.h>
+#include <ScatteringTables.h>
+#include <RandomStream.h>
+#include <Bunch.h>
 #include <Constants.h>
 #include <Coordinates.h>
 #include <fmt/format.h>
@@ -184,10 +187,6 @@ static const double mp  = Constants::MP_MEV*1.0e6;    // proton rest mass [eV]
 static const double Atheta = 13.6;                    // [MeV] const used in PDB formula for rms scattering angle 
 
 namespace {
-  std::random_device rd;  //Will be used to obtain a seed for the random number engine
-  std::mt19937 gen(rd() );
-  std::normal_distribution<double>       normal(0.0,1.0);  // normal distribution mean=0.0, sigma=1.0
-  std::uniform_real_distribution<double> uniform(0.0,1.0);  // uniform distribution mean=0.0, sigma=1.0
 
   struct Material {
     int    Z;   //  Atomic no
@@ -264,14 +263,16 @@ FoilNew::FoilNew( char const* nm, char const* fnm)
 
 FoilNew::FoilNew( FoilNew const& o)
   : Element(o),
+  A_(o.A_),
+  Z_(o.Z_),
+  X0_(o.X0_),
   rho_(o.rho_),
+  na_(o.na_),
   dm_(o.dm_),
   s_(o.s_),
-  A_(o.A_),
-  Z_(o.Z_),
   Theta0_(o.Theta0_),
-  na_(o.na_),
-  X0_(o.X0_),
+  Atheta_(o.Atheta_),
+  a0_(o.a0_),
   I0_(o.I0_),
   dE_(o.dE_),
   vavilov_(o.vavilov_),
@@ -300,6 +301,8 @@ FoilNew& FoilNew::operator= (FoilNew const& rhs)
   A_   = rhs.A_;
   Z_   = rhs.Z_;
   Theta0_ = rhs.Theta0_;
+  Atheta_ = rhs.Atheta_;
+  a0_ = rhs.a0_;
   na_ = rhs.na_;
   X0_ = rhs.X0_;
 
@@ -313,6 +316,35 @@ FoilNew& FoilNew::operator= (FoilNew const& rhs)
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
+void FoilNew::assign(Element const& o)
+{
+  // same members as the copy constructor; used by SliceArena  
+
+  Element::assign(o);
+
+  FoilNew const& rhs = static_cast<FoilNew const&>(o);
+
+  rho_    = rhs.rho_;
+  dm_     = rhs.dm_;
+  s_      = rhs.s_;
+  A_      = rhs.A_;
+  Z_      = rhs.Z_;
+  Theta0_ = rhs.Theta0_;
+  Atheta_ = rhs.Atheta_;
+  a0_     = rhs.a0_;
+  na_     = rhs.na_;
+  X0_     = rhs.X0_;
+  I0_     = rhs.I0_;
+  dE_     = rhs.dE_;
+
+  vavilov_ = rhs.vavilov_;
+  moliere_ = rhs.moliere_;
+  landau_  = rhs.landau_;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
 FoilNew::~FoilNew()
 {
   std::cerr << "FoilNew::~FoilNew()" << std::endl;
@@ -340,7 +372,7 @@ void FoilNew::initialize( double ms, double gma)
   vparms.I0     = I0_;                      // 120.0;                    // ionization energy for C 
   vparms.nfft   = 8192*4;                   // number of FFT points used to sample the pdf.  
 
-  vavilov_ = std::make_unique<Vavilov>(vparms);  // anay existing vavilov_ object will be destroyed
+  vavilov_ = ScatteringTables::vavilov(vparms);  // built once, shared by every foil and turn with the same parameters
     
   Moliere::Parameters mparms;
 
@@ -357,9 +389,7 @@ void FoilNew::initialize( double ms, double gma)
   mparms.theta0  = Atheta/(bta*p)*sqrt(dm_/X0_)*(1.0+0.038*log(dm_/(bta*bta*X0_))); // scattering angle  
   mparms.Lc      = (mparms.theta0*mparms.theta0)/(s_*Dp);                           // Lc: "scattering logarithm"  
 
-  std::cout << "theta0 = " << mparms.theta0 << std::endl;
-  std::cout << "Lc     = " << mparms.Lc  << std::endl;
-  moliere_ = std::make_shared<Moliere>(mparms);
+  moliere_ = ScatteringTables::moliere(mparms);
 }
 
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
@@ -374,42 +404,47 @@ void  FoilNew::preTrack( RMatrix_t<3>& frame, double ms,    double Enr0, int n_e
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-int  FoilNew::trackOnce( double ms,   double& Enr0,    int n_elem, int n_turn, TrackParam& prm, RMatrix const& m1, Coordinates& v ) const
-{  
-  //.............................................
-  // ms:   particle rest mass         [ MeV/c*2]
-  // Enr0: reference kinetic energy   [ MeV/c*2] 
-  // v:    6D Coordinate vector
-  //.............................................
-  
+FoilNew::Draw FoilNew::draw( RandomStream& rng) const
+{
+  Draw d;
+
+  Moliere::Fluctuation mfluct = (*moliere_)(rng);
+
+  d.x     = mfluct.x;
+  d.y     = mfluct.y;
+  d.xp    = mfluct.xp;
+  d.yp    = mfluct.yp;
+  d.dEv   = dE_* ((*vavilov_)(rng));
+  d.alpha = 2*pi*rng.uniform(); 
+
+  return d;
+}
 
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void FoilNew::kick( Draw const& d, double ms, double Enr0, Coordinates& v) const
+{
   // technically, energy is particle dependent.
   // for this element we assume that reference energy = particle energy 
 
   double gma =  1.0+Enr0/ms;
-  double bg  =  sqrt(gma*gma - 1.0);
-  double bta =  bg/gma;  
-  double p   =  bg*ms; // momentum, MeV/c
 
   //................................................
   // transverse small angle (multiple scattering) contribution
   //................................................
 
-  Moliere::Fluctuation mfluct = (*moliere_)();
-  
-  v[0] += mfluct.x; 
-  v[2] += mfluct.y; 
+  v[0] += d.x; 
+  v[2] += d.y; 
 
-  v[1] +=  mfluct.xp;
-  v[3] +=  mfluct.yp;
+  v[1] +=  d.xp;
+  v[3] +=  d.yp;
   
   //................................................
   // Vavilov energy loss(multiple scattering)  contribution
   //................................................
   
-  double dEv  =   dE_* ((*vavilov_)());
-
-  v[5] -=   ( ((dE_ + dEv)*1.0e-6)/Enr0 ); //  avg loss + Vavilov fluctuation 
+  v[5] -=   ( ((dE_ + d.dEv)*1.0e-6)/Enr0 ); //  avg loss + Vavilov fluctuation 
 
   //................................................
   // Transverse scattering correlated with longitudinal loss
@@ -417,18 +452,27 @@ int  FoilNew::trackOnce( double ms,   double& Enr0,    int n_elem, int n_turn, T
 
   double tmax   = Tmax(gma);
 
-  //std::cerr <<  " ms  = " << ms  << std::endl; 
-
-  double dtheta  = (me/(ms*1.0e6)) * sqrt(4*dE_*(dEv/tmax))*(1.0-(dEv/tmax)); // dE_, tmax in [eV]
-  double alpha   = 2*pi*uniform(gen); 
-  double dxp     = dtheta*sin(alpha);
-  double dyp     = dtheta*cos(alpha);
+  double dtheta  = (me/(ms*1.0e6)) * sqrt(4*dE_*(d.dEv/tmax))*(1.0-(d.dEv/tmax)); // dE_, tmax in [eV]
+  double dxp     = dtheta*sin(d.alpha);
+  double dyp     = dtheta*cos(d.alpha);
 
   v[1] +=  dxp;
   v[3] +=  dyp;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int  FoilNew::trackOnce( double ms,   double& Enr0,    int n_elem, int n_turn, TrackParam& prm, RMatrix const& m1, Coordinates& v ) const
+{  
+  //.............................................
+  // ms:   particle rest mass         [ MeV/c*2]
+  // Enr0: reference kinetic energy   [ MeV/c*2] 
+  // v:    6D Coordinate vector
+  //.............................................
 
-  //std::cerr <<  "single scattering dxp    = " <<  dxp << std::endl;
-  //std::cerr <<  "single scattering dyp    = " <<  dyp << std::endl;
+  RandomStream rng(n_turn, n_elem, v.pid);
+  kick( draw(rng), ms, Enr0, v);
 
   return 0; // all good
 }
@@ -436,6 +480,34 @@ int  FoilNew::trackOnce( double ms,   double& Enr0,    int n_elem, int n_turn, T
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
+int FoilNew::trackBunch( double ms, double Enr0, int n_elem, int n_turn, TrackParam& prm,
+                         RMatrix const& m1, Bunch& v, int N, bool parallel) const
+{
+  // The random part of the kicks (spline lookups, logs and square roots) is drawn for the whole
+  // bunch first, each particle from its own stream, and applied in a second pass over contiguous
+  // storage. The numbers are those of trackOnce(), whatever the no of threads.
+
+  std::vector<Draw> draws(N);  // shared by the workers (a thread_local would be a different, empty, vector in each) 
+
+  #pragma omp parallel for if(parallel)
+  for (int j=0; j<N; ++j) {
+    if (v[j].lost != 0) continue; 
+    RandomStream rng(n_turn, n_elem, v[j].pid);
+    draws[j] = draw(rng);
+  }
+
+  #pragma omp parallel for if(parallel)
+  for (int j=0; j<N; ++j) {
+    if (v[j].lost != 0) continue; 
+    kick(draws[j], ms, Enr0, v[j]);
+  }
+
+  return 0;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
 void FoilNew::toString( char* buf) const
 { /*** FIX ME ***/}
 
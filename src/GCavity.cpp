@@ -42,11 +42,14 @@
 #include <Element.h>
 #include <Beamline.h>
 #include <Cavity.h>
+#include <DormandPrince.h>
 #include <Constants.h>
 #include <RMatrix.h>
 #include <TrackParam.h>
 #include <OptimMessages.h>
 #include <Coordinates.h>
+#include <array>
+#include <mutex>
 
 
 using std::acosh;
@@ -56,8 +59,52 @@ using Constants::C_DERV1;
 using Constants::C_DERV3;
 using Constants::C_CGS;
 
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+struct GCavity::MeshCache {
+
+  // Integration meshes of the last few (energy, setting) pairs. Shared by the clones of a cavity;
+  // rmatrix() may be called concurrently.  
+
+  typedef std::array<double,7> Key;  // energy, ms, G, S, T, rtol, atol 
+
+  bool find( Key const& key, DormandPrince& dp)
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (auto const& e : entries) {
+      if (e.first == key) { dp.setMesh(e.second); return true; }
+    }
+    return false;
+  }
+
+  void insert( Key const& key, std::vector<double> const& mesh)
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (entries.size() >= 16) entries.erase(entries.begin());
+    entries.emplace_back(key, mesh);
+  }
+
+  std::mutex                                        mtx;
+  std::vector<std::pair<Key, std::vector<double>>>  entries;
+};
+
+namespace {
+
+  // integration along the mesh of dp, or with n fixed rk3 steps  
+
+  INTEGRERR integrate( double x1, double x2, int nvar, double y[], DormandPrince::Derivs derivs, ODEparam* p, int n, DormandPrince* dp)
+  {
+    if (dp) return dp->replay(nvar, y, derivs, p);
+
+    int nstep;
+    return odeintfs(x1, x2, nvar, y, n, &nstep, 0, 0, 0, derivs, p);
+  }
+}
+
 GCavity::GCavity(const char* nm, char const* fnm)
-  : Element(nm,fnm), ext_dat_(0) {} //  fieldtbl_(0) {}
+  : Element(nm,fnm), ext_dat_(0), rtol_(DormandPrince::Tolerance().rtol), atol_(DormandPrince::Tolerance().atol),
+    meshes_(std::make_shared<MeshCache>()) {} //  fieldtbl_(0) {}
 
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
@@ -66,14 +113,36 @@ GCavity::GCavity(GCavity const& o)
   : Element(o),
     ext_dat_(o.ext_dat_),
     NStep_(o.NStep_),
-    e_(&o.ext_dat_->x[0],
-       &o.ext_dat_->y[0],
-       ext_dat_->n ) 
+    rtol_(o.rtol_),
+    atol_(o.atol_),
+    e_(o.e_),
+    meshes_(o.meshes_)
 {}
 
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
+void GCavity::assign(Element const& o)
+{
+  Element::assign(o);
+
+  GCavity const& rhs = static_cast<GCavity const&>(o);
+  ext_dat_ = rhs.ext_dat_;
+  NStep_   = rhs.NStep_;
+  rtol_    = rhs.rtol_;
+  atol_    = rhs.atol_;
+  e_       = rhs.e_;
+  ampl_    = rhs.ampl_;
+  ms_      = rhs.ms_;
+  wavelen_ = rhs.wavelen_;
+  phase_   = rhs.phase_;
+  phase0_  = rhs.phase0_;
+  meshes_  = rhs.meshes_;   // the meshes belong to the field table and the setting 
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
 void GCavity::toString(char* buf) const
 {
   //***FIXME***
@@ -85,20 +154,17 @@ void GCavity::toString(char* buf) const
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-GCavity* GCavity::split(int nslices) const // return a sliced element
+RMatrix GCavity::rmatrix(double& alfap, double& energy, double ms, double& tetaY, double dalfa, int st) const
 {
-  // GCavity cannot be split so we return a cloned element. 
-  return this->clone();
+  alfap = 0.0;
+  return fieldMatrix(energy, ms);
 }
 
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-RMatrix GCavity::rmatrix(double& alfap, double& energy, double ms, double& tetaY, double dalfa, int st) const
+RMatrix GCavity::fieldMatrix(double& energy, double ms) const
 {
-
-  alfap = 0.0;
-  
   double P      = sqrt(energy * (energy + 2. * ms));
   double hr     = P/C_DERV1;
   double bt     = P/(energy+ms);
@@ -119,14 +185,36 @@ RMatrix GCavity::rmatrix(double& alfap, double& energy, double ms, double& tetaY
 
   p.fieldtbl = ext_dat_; // &ext_dat[N];
 
+  SplineInterpolator tbl;  // e_ is out of date if the table was read after setParameters()  
+  p.field = &e_;
+  if (e_.size() != ext_dat_->n) { 
+    tbl     = SplineInterpolator(&ext_dat_->x[0], &ext_dat_->y[0], ext_dat_->n);
+    p.field = &tbl;
+  }
+
   p.ms      = ms;
   p.wavelen = T_; 
+
+  // adaptive integration: a mesh is computed for the first pass at a given energy and setting, and 
+  // every integration of this and later passes follows it. rtol_ <= 0: fixed step rk3 scheme.  
+
+  DormandPrince::Tolerance tol;
+  tol.rtol = rtol_;
+  tol.atol = atol_;
+
+  DormandPrince  dp(tol);
+  DormandPrince* pdp  = (rtol_ > 0.0) ? &dp : 0;
+  MeshCache::Key key  = {{ energy, ms, G, S, T_, rtol_, atol_ }};
+  bool           miss = pdp && !meshes_->find(key, dp);
+
   nstep     = (*NStep_)*(1.0 + 4*sqrt( G / energy )); // CtSt_.NStep 
-  err       = get_cav_phase(energy, G, &p, nstep);
+  err       = get_cav_phase(energy, G, &p, nstep, pdp);
   p.phase   = S*PI/180.;
 
   double En2;
-  err     = get_matrix(&p, energy, &En2, mi, nstep);
+  if (!err) err = get_matrix(&p, energy, &En2, mi, nstep, pdp);
+
+  if (!err && miss) meshes_->insert(key, dp.mesh());
 
   if(err){ 
 	// ***FIXME***  OptimWarningMessage(this, "Runtime err. for ODE integr. in cavity", intgrerr[err], QMessageBox::Ok); 
@@ -192,6 +280,9 @@ void GCavity::setParameters( int np, double dat[], ... )
    
   ext_dat_ = (va_arg(args, ExtData const*));  //  &ext_dat_[N];
   NStep_   = (va_arg(args, int*          ));  //  CtSt_.NStep    
+  meshes_  = std::make_shared<MeshCache>();    // the field table may have changed 
+
+  if (ext_dat_ && ext_dat_->n > 1) e_ = SplineInterpolator(&ext_dat_->x[0], &ext_dat_->y[0], ext_dat_->n);
 
   
   // *** FIXME *** ext_dat_ and NStep_ are connected to external stuff in
@@ -224,6 +315,9 @@ void GCavity::setParameters( int np, std::vector<double> const& dat, ... )
    
   ext_dat_ = (va_arg(args, ExtData const*));  //  &ext_dat_[N];
   NStep_   = (va_arg(args, int*          ));  //  CtSt_.NStep    
+  meshes_  = std::make_shared<MeshCache>();    // the field table may have changed 
+
+  if (ext_dat_ && ext_dat_->n > 1) e_ = SplineInterpolator(&ext_dat_->x[0], &ext_dat_->y[0], ext_dat_->n);
 
   
   // *** FIXME *** ext_dat_ and NStep_ are connected to external stuff in
@@ -234,22 +328,18 @@ void GCavity::setParameters( int np, std::vector<double> const& dat, ... )
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-INTEGRERR GCavity::get_energy(ODEparam *p, double Enr1, double *Enr2, int n)
+INTEGRERR GCavity::get_energy(ODEparam *p, double Enr1, double *Enr2, int n, DormandPrince* dp)
 {
 
-  double*  xp = 0;
-  double** yp = 0;
   double ystart[2];
 
-  int nstep;
-
   double x1 = p->fieldtbl->x[0];
   double x2 = p->fieldtbl->x[p->fieldtbl->n-1];
 
   ystart[0] = 0.0;
   ystart[1] = sqrt(Enr1*(Enr1+2.0*p->ms));
 
-  INTEGRERR err = odeintfs(x1, x2, 2,ystart, n, &nstep, 0, xp, yp, LongitEquations, p);
+  INTEGRERR err = integrate(x1, x2, 2, ystart, LongitEquations, p, n, dp);
 
   *Enr2     =  sqrt(p->ms*p->ms +ystart[1]*ystart[1]) - p->ms;
 
@@ -261,7 +351,7 @@ INTEGRERR GCavity::get_energy(ODEparam *p, double Enr1, double *Enr2, int n)
 
 #define FUDGE 6.
 
-INTEGRERR GCavity::get_cav_phase(double En1, double dEn, ODEparam *p, int m)
+INTEGRERR GCavity::get_cav_phase(double En1, double dEn, ODEparam *p, int m, DormandPrince* dp)
 {
   INTEGRERR err;
   double fi0, En2, dfi, Ep, Em, a, deltafi;
@@ -279,9 +369,7 @@ INTEGRERR GCavity::get_cav_phase(double En1, double dEn, ODEparam *p, int m)
  
   for ( int i=0; i <=p->fieldtbl->n; ++i) {
      x = p->fieldtbl->x[0] + len*i/p->fieldtbl->n;
-     if(splint(&p->fieldtbl->x[0], &p->fieldtbl->y[0], &p->fieldtbl->v[0], p->fieldtbl->n, x, &e)) {
-        return SPLINE_ERR;
-     }
+     e   = (*p->field)(x);
      fi  = k*len*i/p->fieldtbl->n/beta;
      ac += e*cos(fi);      
      as += e*sin(fi);
@@ -298,15 +386,26 @@ INTEGRERR GCavity::get_cav_phase(double En1, double dEn, ODEparam *p, int m)
   p->phase0 = fi0;   // it will keep the phase for the on-crest acceleration
   n         = m/8;
 
-  err = get_energy(p, En1, &En2, n);  if(err)return err;
+  if (dp && dp->mesh().empty()) {
+
+    // adaptive mesh, from the transverse equations (which include the longitudinal ones) 
+    // on the estimated on-crest trajectory   
+
+    double p_in     = sqrt(En1*(En1+2.0*p->ms));
+    double ystart[] = {0.0, p_in, 1.0, 0.0};
+    err = dp->integrate(p->fieldtbl->x[0], p->fieldtbl->x[p->fieldtbl->n-1], 4, ystart, TransvEquations, p);
+    if (err) return err;
+  }
+
+  err = get_energy(p, En1, &En2, n, dp);  if(err)return err;
 
   i         = 0;     // Integration at first stage of phase determination
   do{
       p->phase0 = fi0+dfi;
-      err       = get_energy(p, En1, &Ep, n);  if(err)return err;
+      err       = get_energy(p, En1, &Ep, n, dp);  if(err)return err;
 
       p->phase0 = fi0-dfi;
-      err       = get_energy(p, En1, &Em, n);  if(err)return err;
+      err       = get_energy(p, En1, &Em, n, dp);  if(err)return err;
 
       a         = 2.*En2-Ep-Em;
       
@@ -323,7 +422,7 @@ INTEGRERR GCavity::get_cav_phase(double En1, double dEn, ODEparam *p, int m)
 	fi0 += 0.5*copysign(dfi,Ep-Em);
       }
       p->phase0 = fi0;
-      err       = get_energy(p, En1, &En2, n);  if (err!=0) return err;
+      err       = get_energy(p, En1, &En2, n, dp);  if (err!=0) return err;
 
       if(i++ > 50) return No_Conv_Phase;
 
@@ -332,17 +431,17 @@ INTEGRERR GCavity::get_cav_phase(double En1, double dEn, ODEparam *p, int m)
    for(int j=1; j>=0; --j){
 
       n    =  m/(1.+7.*j); //Integration at first stage of phase determination
-      err  =  get_energy(p, En1, &En2, n);  if(err)return err;
+      err  =  get_energy(p, En1, &En2, n, dp);  if(err)return err;
 
       do {
 	p->ampl   = p->ampl*dEn/(En2-En1);
-	err       = get_energy(p, En1, &En2, n);  if(err)return err;
+	err       = get_energy(p, En1, &En2, n, dp);  if(err)return err;
 
 	p->phase0 = fi0+dfi;
-	err       = get_energy(p, En1, &Ep, n);  if(err)return err;
+	err       = get_energy(p, En1, &Ep, n, dp);  if(err)return err;
 
 	p->phase0 = fi0-dfi;
-        err       = get_energy(p, En1, &Em, n);  if(err)return err;
+        err       = get_energy(p, En1, &Em, n, dp);  if(err)return err;
 
 	a         = 2.0*En2-Ep-Em;
 
@@ -359,7 +458,7 @@ INTEGRERR GCavity::get_cav_phase(double En1, double dEn, ODEparam *p, int m)
 	  fi0 += 0.5*copysign(dfi,Ep-Em);
 	}
 	p->phase0 = fi0;
-	err       = get_energy(p, En1, &En2, n);  if(err)return err;
+	err       = get_energy(p, En1, &En2, n, dp);  if(err)return err;
 
 	if(i++ > 50) return No_Conv_Phase;
       } while(fabs(deltafi)>1.e-7);
@@ -368,7 +467,7 @@ INTEGRERR GCavity::get_cav_phase(double En1, double dEn, ODEparam *p, int m)
     }
 
    if(fabs((En2-En1)/dEn) >1.e-8){
-      err = get_energy(p, En1, &En2, n);  
+      err = get_energy(p, En1, &En2, n, dp);  
       if( err )return err;
       p->ampl=p->ampl*dEn/(En2-En1);
     }
@@ -378,14 +477,10 @@ INTEGRERR GCavity::get_cav_phase(double En1, double dEn, ODEparam *p, int m)
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-INTEGRERR GCavity::get_matrix(ODEparam *p, double Enr1, double *Enr2, RMatrix& m, int n)
+INTEGRERR GCavity::get_matrix(ODEparam *p, double Enr1, double *Enr2, RMatrix& m, int n, DormandPrince* dp)
 {
   INTEGRERR err;
-  double  *xp  = 0;
-  double  **yp = 0;
   double  ylong[2];
-
-  int nstep, i;
   
   m.toZero();
 
@@ -398,7 +493,7 @@ INTEGRERR GCavity::get_matrix(ODEparam *p, double Enr1, double *Enr2, RMatrix& m
 
   double ystart[]= {0.0,  p_in, 1.0, 0.0};
   
-  if ( (err=odeintfs(x1, x2, 4,ystart, n, &nstep, 0, xp, yp, TransvEquations, p)) ) return err;
+  if ( (err=integrate(x1, x2, 4, ystart, TransvEquations, p, n, dp)) ) return err;
 
   m[0][0] = m[2][2] = ystart[2];
   m[1][0] = m[3][2] = ystart[3]/ystart[1];
@@ -409,7 +504,7 @@ INTEGRERR GCavity::get_matrix(ODEparam *p, double Enr1, double *Enr2, RMatrix& m
   ystart[2] = 0;
   ystart[3] = 0.001*p_in;
 
-  if ( ((err=odeintfs(x1, x2, 4,ystart, n, &nstep, 0, xp, yp, TransvEquations, p))) ) return err;
+  if ( ((err=integrate(x1, x2, 4, ystart, TransvEquations, p, n, dp))) ) return err;
  
   m[0][1] = m[2][3] = ystart[2]*1000.;
   m[1][1] = m[3][3] = ystart[3]/ystart[1]*1000.;
@@ -422,7 +517,7 @@ INTEGRERR GCavity::get_matrix(ODEparam *p, double Enr1, double *Enr2, RMatrix& m
   ylong[0]       = delta_t;
   ylong[1]       = p_in;
 
-  if ( (err=odeintfs(x1, x2, 2, ylong, n, &nstep, 0, xp, yp, LongitEquations, p)) ) return err;
+  if ( (err=integrate(x1, x2, 2, ylong, LongitEquations, p, n, dp)) ) return err;
  
   m[4][4] =  beta2*(ylong[0]-ystart[0])/(beta1*delta_t);    
   m[5][4] = -(ylong[1]-ystart[1])/ystart[1]/(beta1*delta_t);
@@ -431,7 +526,7 @@ INTEGRERR GCavity::get_matrix(ODEparam *p, double Enr1, double *Enr2, RMatrix& m
   ylong[0] = 0.0;
   ylong[1] = p_in*1.001;
 
-  if ( (err = odeintfs(x1, x2, 2, ylong, n, &nstep, 0, xp, yp, LongitEquations, p)) ) return err; 
+  if ( (err = integrate(x1, x2, 2, ylong, LongitEquations, p, n, dp)) ) return err; 
 
   m[4][5] = -1000.*beta2*(ylong[0]-ystart[0]);
   m[5][5] =  1000.*(ylong[1]-ystart[1])/ystart[1];
@@ -445,11 +540,7 @@ INTEGRERR GCavity::get_matrix(ODEparam *p, double Enr1, double *Enr2, RMatrix& m
 INTEGRERR GCavity::LongitEquations(double x, double *y, double *dy, ODEparam *p)
 {
 
-  double e;
-  
-  if(splint( &p->fieldtbl->x[0], &p->fieldtbl->y[0], &p->fieldtbl->v[0], p->fieldtbl->n, x, &e)) {
-    return SPLINE_ERR;
-  }
+  double e = (*p->field)(x);
  
   double beta  = y[1]/sqrt(p->ms*p->ms+y[1]*y[1]);
   dy[0] = 1.0/beta;
@@ -466,14 +557,10 @@ INTEGRERR GCavity::LongitEquations(double x, double *y, double *dy, ODEparam *p)
 INTEGRERR GCavity::TransvEquations(double x, double *y, double *dy, ODEparam *p)
 {
 
-  double e, et, k, s, beta, cs, si;
+  double k, s, beta, cs, si;
    
-  if(splint( &p->fieldtbl->x[0], &p->fieldtbl->y[0], &p->fieldtbl->v[0], p->fieldtbl->n, x, &e)) {
-     return SPLINE_ERR;
-  }
-  if(dsplint( &p->fieldtbl->x[0], &p->fieldtbl->y[0], &p->fieldtbl->v[0], p->fieldtbl->n, x, &et)) {
-     return SPLINE_ERR;
-  }
+  double e  = (*p->field)(x);     // field and its derivative; O(1) on a uniform table  
+  double et = (*p->field)(x,1);
   
   k     = 2.0*PI/p->wavelen;
   s     = k*y[0]+p->phase-p->phase0;
@@ -76,73 +76,7 @@ Beamline* GCavity::splitnew(int nslices) const  // return a sliced element as a
 
 RMatrix   GCavity::rmatrix( RMatrix_t<3>& frame, double& energy, double ms, int st) const
 {   
-
-  double P      = sqrt(energy * (energy + 2. * ms));
-  double hr     = P/C_DERV1;
-  double bt     = P/(energy+ms);
-  double gamma1 = 1. + energy/ms;
-  double s;
-  double c;
-  
-  RMatrix mi;
-  mi.toUnity();
-
-  ODEparam p;
-  int err, nstep;
-
-  if(fabs(G)<1.e-18){
-    mi[0][1] = mi[2][3] = this->L_;
-    return mi;
-  }
-
-  p.fieldtbl = ext_dat_; // &ext_dat[N];
-
-  p.ms      = ms;
-  p.wavelen = T_; 
-  nstep     = (*NStep_)*(1.0 + 4*sqrt( G / energy )); // CtSt_.NStep 
-  err       = get_cav_phase(energy, G, &p, nstep);
-  p.phase   = S*PI/180.;
-
-  double En2;
-  err     = get_matrix(&p, energy, &En2, mi, nstep);
-
-  if(err){ 
-	// ***FIXME***  OptimWarningMessage(this, "Runtime err. for ODE integr. in cavity", intgrerr[err], QMessageBox::Ok); 
-    return mi;
-  }
-
-  s = sqrt(sqrt((En2*En2+2.*En2*ms)/(energy * energy + 2. * energy*ms))); // sqrt(p2/p1)
-
-  mi[0][0] *= s;  // coupling terms are not scaled ???? 
-  mi[0][1] *= s;
-  mi[1][1] *= s;
-  mi[1][0] *= s;
-
-  mi[2][2] *= s;
-  mi[2][3] *= s;
-  mi[3][3] *= s;
-  mi[3][2] *= s;
-
-  mi[4][4] *= s;
-  mi[4][5] *= s;
-  mi[5][5] *= s;
-  mi[5][4] *= s;
-
-  s = mi[0][0]*mi[1][1] - mi[0][1]*mi[1][0] - 1.0;  
-  c = mi[4][4]*mi[5][5] - mi[4][5]*mi[5][4] - 1.0;
-
-  // **FIXME*** if( (fabs(s)>CtSt_.Accuracy)||(fabs(c)>CtSt_.AccuracyL)){
-  // **FIXME**  sprintf(buf,"Poor accuracy(transverse %e and longitudinal %e of required %e and %e).Correct parameters in View/Control menu",
-  //            fabs(s), fabs(c), CtSt_.Accuracy, CtSt_.AccuracyL);
-  // *** FIXME *** OptimWarningMessage(this, "Runtime err. for ODE integr. in cavity ", buf, QMessageBox::Ok);
-  //};
-
-  if(fabs(mi[0][1]) > 1.0e-10)   mi[1][0] = mi[3][2] = (mi[0][0]*mi[1][1]-1.0)/mi[0][1]; 
-  if(fabs(mi[4][5]) > 1.0e-10)   mi[5][4] = (mi[4][4]*mi[5][5]-1.)/mi[4][5];
-
-  energy = En2;  
-
-  return mi;
+  return fieldMatrix(energy, ms);
 }
 
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
@@ -108,6 +108,8 @@ OptimPreferences& preferences()
      first_call = false;
 
      prefer.moments_db                   = ":memory:"; // "./moments.db";  
+     prefer.moments_archive              = "";         // temporary file, deleted on exit
+     prefer.moments_window               = 10000;
      prefer.con                          = 0; 
 
   }
@@ -44,11 +44,13 @@
 #include <Constants.h>   
 #include <Element.h>   
 #include <ImportMadXDialog.h>   
+#include <MadXTfs.h>   
 #include <Utility.h>  
 #include <OptimMessages.h>
 
 #include <QMdiArea>
 #include <QMdiSubWindow>
+#include <QFile>
 #include <QFileDialog>
 #include <QDateTime>
 
@@ -64,7 +66,6 @@
 #include <vector>
 #include <cctype>
 
-double const pi = 4*atan(1.0);
 
 //---------------------------------
 // all valid madx twiss table keywords
@@ -369,425 +370,6 @@ namespace MadX {
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-void trim( std::string& s)
-{
-  auto pos1 = s.find_first_not_of("\" ");
-  auto pos2 = s.find_last_not_of("\" ");
-
-  if (pos1 == std::string::npos ) return; // an empty string 
-
-  s = s.substr(pos1, pos2-pos1+1); 
-
-}
-
-//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
-//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
-
-void make_element( std::vector<std::string>& beamline, std::unordered_map<std::string, std::string>& element_dict,
-		   std::string& elabel, std::string& etype,
-		   std::unordered_map<std::string, double>& attributes, double brho)
-{
-  // ***WARNING***: brho in the arg above is expressed in T-m
-  // 1 T-m = 10 kG * 100 cm m = 1000 kG-cm 
-  // attributes[] are from MADX and they are expressed in MKS
-  // in MADX, the multipole coefficients are normalized w/r to brho. 
-  // in optim, the multipole coefficients are integrated field and field derivatives w/o normalization  
-
-  std::stringstream ss;
-
-  double  length   =   attributes["L"]*100;  // length in cm
-  double  leps     =   1.0e-4;              //  length in cm of "a thin element" (0 length in MADX) 
-  double  b        =  (attributes["ANGLE"]*brho)/attributes["L"]*10.0; // in kG
-  double  k0l      =   attributes["K0L"]  * brho * 1000.0;     // k0l is in kG-cm in OptiM and (K0L*brho) is in  T-m in MADX;  1 T-m = 10 kG * 100 cm = 1000 kG-cm
-  double  k0sl     =   attributes["K0SL"] * brho * 1000.0;
-  double  k1l      =   attributes["K1L"]  * brho * 10.0;       //  k1l is in kG in OptiM;  (K1L*brho) is in T in MADX;  1 T = 10 kG
-  double  k1sl     =   attributes["K1SL"] * brho * 10.0;
-  double  k2l      =   attributes["K2L"]  * brho * 10.0*10.0;  //  k2l is in kG/cm in OptiM;  (K2L*brho) is in T/m in MADX;  1 T = 10 kG
-  double  k2sl     =   attributes["K2SL"] * brho * 10.0*10.0;
-  double  lrad     =   attributes["LRAD"];
-  double  anglerad =   attributes["ANGLE"];  // bend angle in rad. 
-  double  angle    =   anglerad*180.0/pi;    // bend angle in deg 
-  double tilt      =   attributes["TILT"] * 180.0/pi;  // in degrees
-  double e1        =   attributes["E1"];        // in rd;  optimx angle convention is reverse of MADX ecause +ve rotation direction in OptimX is inverse of MADX  
-  double e2        =   attributes["E2"];        // in rd
-  double hgap      =   attributes["HGAP"]*100;  // half-gap in cm 
-  double fint      =   attributes["FINT"];
-  double fintx     =   attributes["FINTX"];
-  fintx            =   (fintx == 0.0) ? fint : fintx; // MADX manual says that if FINTX is undefined, FINTX=FINT (undefined FINTX is FINITX=0.0)  
-  double ksi       =   attributes["KSI"];
-     
-  if (etype == "QUADRUPOLE") {
-    if ( element_dict.find(elabel) == element_dict.end() )  {
-
-      // K1L and K1SL may both be defined. If so, we find the
-      // rotation angle for a normal quadrupole that provides
-      // both multipole coefficients in the right proportion.
-      // The normal quadrupole strength
-      // K1L is then adjusted so that K1L(new) = K1L(old)/cos(tilt). 
-      // Only K1L(new) is used thereafter.
-      
-      if ( (fabs(k1sl) > 1.0e-10) && fabs(k1l) < 1.0e-10) {
-        k1l  =  k1sl;
-	tilt = -45.0;
-      }
-      else if ( (fabs(k1sl) > 1.0e-10 && fabs(k1l) > 1.0e-10) ) {
-	tilt = 0.5*atan2(k1sl,k1l); 
-	k1l   /=  cos(tilt); 
-	tilt  *= -(180.0/pi); 
-      }
-      if (fabs(length) < leps) {
-        ss << " L[cm]="    << leps; // in cm 
-        ss << " G[kG/cm]=" <<  k1l/leps;  // K1*brho is in [T/m] = [10 kG / 100 cm] 
-        ss << " Tilt[deg]=" << tilt;
-      }
-      else {
-        ss << " L[cm]="     << length;     // in cm 
-        ss << " G[kG/cm]="  << k1l/length; // in kG/cm 
-        ss << " Tilt[deg]=" << tilt;
-      }	
-      element_dict.insert( { "q"+elabel, ss.str() } );
-    }
-    beamline.push_back( "q"+elabel); 
-  }
-  else if (etype == "DRIFT") {
-    if ( element_dict.find(elabel) == element_dict.end() )  {
-      ss << " L[cm]=" << length;
-      element_dict.insert( { "o"+elabel, ss.str() } );
-    }
-    beamline.push_back( "o"+elabel); 
-  }
-    else if (etype == "MONITOR") {
-    if ( element_dict.find(elabel) == element_dict.end() )  {
-      ss << " L[cm]=" << length;
-      element_dict.insert( { "o"+elabel, ss.str() } );
-    }
-    beamline.push_back( "o"+elabel); 
-  }
-  else if (etype == "HMONITOR") {
-    if ( element_dict.find(elabel) == element_dict.end() )  {
-      ss << " L[cm]=" << length;
-      element_dict.insert( { "o"+elabel, ss.str() } );
-    }
-    beamline.push_back( "o"+elabel); 
-  }
-  else if (etype == "VMONITOR") {
-    if ( element_dict.find(elabel) == element_dict.end() )  {
-      ss << " L[cm]=" << length;
-      element_dict.insert( { "o"+elabel, ss.str() } );
-    }
-    beamline.push_back( "o"+elabel); 
-  }
-  else if (etype == "YROTATION") {
-    if ( element_dict.find(elabel) == element_dict.end() )  {
-      ss << " L[cm]=" << length;
-      element_dict.insert( { "o"+elabel, ss.str() } );
-    }
-    beamline.push_back( "o"+elabel); 
-  }
-  else if (etype == "PLACEHOLDER") {
-    if ( element_dict.find(elabel) == element_dict.end() )  {
-      ss << " L[cm]=" << length;
-      element_dict.insert( { "i"+elabel, ss.str() } );
-    }
-    beamline.push_back( "i"+elabel); 
-  }
-  else if (etype == "INSTRUMENT") {
-    if ( element_dict.find(elabel) == element_dict.end() )  {
-      ss << " L[cm]=" << length;
-      element_dict.insert( { "i"+elabel, ss.str() } );
-    }
-    beamline.push_back( "i"+elabel); 
-  }
-  else if (etype == "SBEND") {
-     std::string mnemonic = "d"; // dipole 
-     double g =  k1l/length;
-     if ( element_dict.find(elabel) == element_dict.end() )  {
-       ss << " L[cm]=" << length;          
-       ss << " B[kG]=" << b; 
-       if ( fabs(k1l) > 0.0) {
-	 ss << " G[kG/cm]=" << g;
-	 mnemonic = "b"; // cf bend
-       }	   
-       ss << " Tilt[deg]=" << tilt; 
-       std::string s = ss.str(); 
-
-       double angleu =  e1;
-       double angled =  e2;
-
-       double  gap     = 2*hgap;
-       double  cn      = cos(angleu);
-       double  sn      = sin(angleu);
-       double  efflen  = fint*gap*(1.0+sn*sn)/(cn*cn*cn);   // upstream   edge effective length
-
-       ss.str("");
-       ss << " B[kG]=" << b;
-       ss << " Angle[deg]=" << angleu*180.0/pi;
-       ss << " EffLen[cm]=" << efflen;
-       ss << " T[deg]=" << tilt;
-       auto su = ss.str();
-
-       cn     = cos(angled);
-       sn     = sin(angled);
-       double efflenx = fintx*gap*(1.0+sn*sn)/(cn*cn*cn);    // downstream edge effective length
-
-       ss.str("");
-       ss << " B[kG]=" << b;
-       ss << " Angle[deg]=" << angled*180.0/pi;
-       ss << " EffLen[cm]=" << efflenx;
-       ss << " T[deg]=" << tilt;
-       auto sd = ss.str();
-       
-       element_dict.insert( { "gu"+ elabel, su } );
-       element_dict.insert( { mnemonic + elabel, s } );
-       element_dict.insert( { "gd"+ elabel, sd } );
-     }
-
-     beamline.push_back( "gu"+elabel); // upstream   edge 
-     beamline.push_back( mnemonic + elabel); 
-     beamline.push_back( "gd"+elabel); // downstream edge
-  }
-  else if (etype == "RBEND") {
-
-     std::string mnemonic = "d"; // dipole 
-
-     if ( element_dict.find(elabel) == element_dict.end() )  {
-
-       ss << " L[cm]=" << length;           
-       ss << " B[kG]=" << b; 
-       double g =  k1l/length;
-       if ( fabs(g) > 0.0) {
-	 ss << " G[kG/cm]=" << g;
-	 mnemonic = "b"; // cf bend
-       }
-       ss << " Tilt[deg]=" << tilt;  
-       auto s = ss.str();
-
-       double angleu =  e1 + fabs(anglerad)/2; 
-       double angled =  e2 + fabs(anglerad)/2;
-
-       double gap    = 2*hgap;
-       double cn     = cos(angleu);
-       double sn     = sin(angleu);
-       double efflen = fint*gap*(1.0+sn*sn)/(cn*cn*cn);       // upstream edge effective length
-
-       ss.str("");
-       ss << " B[kG]=" << b;
-       ss << " Angle[deg]=" << angleu*180.0/pi;
-       ss << " EffLen[cm]=" << efflen;
-       ss << " T[deg]="     << tilt;
-       auto su = ss.str();
-
-       cn     = cos(angled);
-       sn     = sin(angled);
-       double efflenx = fintx*gap*(1.0+sn*sn)/(cn*cn*cn);       // downstream edge effective length
- 
-       ss.str("");
-       ss << " B[kG]=" << b;
-       ss << " Angle[deg]=" << angled*180.0/pi;
-       ss << " EffLen[cm]=" << efflenx;
-       ss << " T[deg]=" << tilt;
-       auto sd = ss.str();
-
-       element_dict.insert( { "gu"+ elabel, su } );
-       element_dict.insert( { mnemonic + elabel, s  } );
-       element_dict.insert( { "gd"+ elabel, sd } );
-     }    
-
-     beamline.push_back( "gu"+ elabel); // upstream   edge 
-     beamline.push_back( mnemonic + elabel); 
-     beamline.push_back( "gd"+ elabel); // downstream edge
-  }
-  else if (etype == "MULTIPOLE") {
-     // we care only about 0th and first order for now ... 
-     bool has_k0 = (fabs(k0l)  > 0.0 ) ;        
-     bool has_k1 = (fabs(k1l)  > 0.0 ) ;        
-     bool has_k0s = (fabs(k0sl)  > 0.0 ) ;        
-     bool has_k1s = (fabs(k1sl)  > 0.0 ) ;        
-     //if (  has_k0s ) std::cout << elabel << "  found skew 0" << std::endl;  
-     //if (  has_k1s ) std::cout << elabel << "  found skew 1" << std::endl;  
-
-     if (has_k0) {  
-       if ( element_dict.find(elabel+"_0") == element_dict.end() )  {
-         ss  << " m="             <<  0;          
-         ss  << " S[kG/cm^(m-1)=" <<  k0l;
-         ss  << " Tilt[deg]="     <<  tilt; 
-         element_dict.insert( { "m"+elabel+"_0", ss.str() } );
-	 ss.str("");
-       }
-       beamline.push_back( "m"+elabel+"_0"); 
-     }
-     if (has_k1) {
-       if ( element_dict.find(elabel+"_1") == element_dict.end() )  {
-         ss  << " m="             <<    1;          
-         ss  << " S[kG/cm^(m-1)=" <<  k1l;
-         ss  << " Tilt[deg]="     << tilt; 
-         element_dict.insert( { "m"+elabel+"_1", ss.str() } );
-	 ss.str("");
-       }
-       beamline.push_back( "m"+elabel+"_1"); 
-     }
-  }
-  else if (etype == "SEXTUPOLE") {
-    if ( element_dict.find(elabel) == element_dict.end() )  {
-      if ( (fabs(k2sl) > 0.0) && (fabs(k2l) < 1.0e-10) ) {
-  	  tilt = -30.0;
-      }
-      else if ( (fabs(k2sl) > 1.0e-10 && fabs(k2l) > 1.0e-10)) {
-	tilt = (1.0/3.0)*atan2(k2sl,k2l); 
-	k2l   /=  cos(tilt); 
-	tilt  *= -(180.0/pi); 
-      }
-
-      if (fabs(length) < leps) {
-         ss << " L[cm]="       << leps;          
-         ss << " S[kG/cm/cm]=" << k2l/leps;  // [kG/cm**2] 
-         ss << " Tilt[deg]="   << tilt; 
-      }
-      else {
-          ss << " L[cm]="        << length;       // in cm 
-          ss << " G[kG/cm/cm]="  << k2l/length;  // [kG/cm**2] 
-          ss << " Tilt[deg]="    << tilt;
-      }
-      element_dict.insert( { "s" + elabel, ss.str() } );
-    }
-    beamline.push_back( "s" + elabel); 
-  }
-  else if (etype == "KICKER") {
-    if ( element_dict.find(elabel) == element_dict.end() )  {
-      double hkick = attributes["HKICK"];
-      double vkick = attributes["VKICK"];
-      //if (fabs(hkick) > 0.0 || fabs(vkick)>0.0) std::cout << elabel << " KICKER has finite kick " << std::endl;  
-      ss << " L[cm]="       << length;
-      if ( fabs(length) < 1.0e-6 ) length = 1.0e-6;
-      double  tmp = sqrt((hkick*hkick)+(vkick*vkick))*(brho/length)*1000.0;           
-      ss << " B[kg]="       << tmp;
-      double  ltilt = (fabs(hkick) > 1.0e-12 ) ? atan2(vkick,hkick) : pi/2;     
-      ss << " Tilt="        << tilt + ltilt*180/pi;          
-    }
-    element_dict.insert( { "k"+elabel, ss.str() } );
-    beamline.push_back( "k"+elabel); 
-  }
-  else if (etype == "HKICKER") {
-    if ( element_dict.find(elabel) == element_dict.end() )  {
-      double hkick = attributes["HKICK"];
-      //if (fabs(hkick) > 0.0 ) std::cout << elabel << " HKICKER has finite kick " << std::endl;  
-      ss << " L[cm]="       << length;          
-      if ( fabs(length) < 1.0e-6 ) length = 1.0e-6;
-      double  tmp = hkick*(brho/length)*1000.0;           
-      ss << " B[kG]="       << tmp;          
-      ss << " Tilt="        << 0.0 + tilt;          
-    }
-   element_dict.insert( { "k"+elabel, ss.str() } );
-   beamline.push_back( "k"+elabel); 
-  }
-  else if (etype == "VKICKER") {
-    if ( element_dict.find(elabel) == element_dict.end() )  {
-     double vkick = attributes["VKICK"];
-     //if (fabs(vkick) > 0.0 ) std::cout << elabel << " VKICKER has finite kick " << std::endl;  
-     ss << " L[cm]="       << length;          
-     if ( fabs(length) < 1.0e-6 ) length = 1.0e-6;
-     double  tmp = vkick*(brho/length)*1000.0;           
-     ss << " B[kG]="       << tmp;  // brho: T-m to kG-cm
-     ss << " Tilt[deg]="   << 90.0 + tilt; 
-     element_dict.insert( { "k"+elabel, ss.str() } );
-    }
-    beamline.push_back( "k"+elabel); 
-  }
-  else if (etype == "DIPEDGE") {
-    if ( element_dict.find(elabel) == element_dict.end() )  {
-
-     double edgeang    = e1;
-     double hgap       = attributes["HGAP"]*100.0; // half-gap   
-     double oneoverrho = attributes["H1"]*0.01;  // 1/rho    
-     double cn         = cos(edgeang);
-     double sn         = sin(edgeang);
-     double efflen     = fint*2*hgap*(1.0+sn*sn)/(cn*cn*cn);  // edge effective length
-
-     ss << " B[kG]="       << (brho*1000.0*oneoverrho);  //  brho*1/rho = B;  brho: T-m to kG-cm
-     ss << " Angle[deg]="  << edgeang*180/pi;
-     ss << " L[cm]="       << efflen;          
-     ss << " Tilt[deg]="   << tilt; 
-     element_dict.insert( { "g"+elabel, ss.str() } );
-    }
-    beamline.push_back( "g"+elabel); 
-  }
-  else if (etype == "SOLENOID") {
-    if ( element_dict.find(elabel) == element_dict.end() )  {
-      if (fabs(length) < 1.0e-6) { // pseudo-solenoid ( focusing only) 
-	 ss << " L[cm]="       << 0.0;          
-         ss << " B[kG]="       << ksi*brho*1000.0;   // brho : T-m to kG-cm
-         ss << " a[cm]="       << 0.0; 
-         element_dict.insert( { "cc"+elabel, ss.str() } );
-      }
-      else {  
-         ss << " L[cm]="       << length;          
-         ss << " B[kG]="       << ksi*brho*1000.0/length; // brho : T-m to kG-cm
-         ss << " a[cm]="       << 0.0;
-         element_dict.insert( { "c"+elabel, ss.str() } );
-      }
-    }
-    (fabs(length) < 1.0e-6) ? beamline.push_back( "cc"+elabel) :  beamline.push_back( "c"+elabel); 
-  }
-  else if (etype == "MARKER") {
-    // we skip markers
-    //std::cout << "MARKER: " << elabel << std::endl;
-  }
-  else {
-     if (etype == "MARKER") {std::cout << "MARKER (converted to drift):  " << elabel << std::endl;}
-     if ( element_dict.find(elabel) == element_dict.end() )  {
-        ss << " L[cm]="       << length;    
-        element_dict.insert( { "o"+elabel, ss.str() } );
-       }
-      beamline.push_back( "o"+elabel); 
- }
-}
-
-//|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
-//|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
-
-std::string get_token( std::ifstream& ifs)
-{
-  char c;  
-  std::stringstream ss;
-
-  bool quoting = false;
-  
-  ss.str("");
-   
-   while ( true ) {
-      ifs.get(c);
-      if ( !ifs.good() ) break;
-      if ( (c == ' ' ) || (c == '\n') || (c == '\t') || (c == '\r') ) continue;
-      ss << c;
-      if (c == '\"') quoting = true;
-      break;
-   }
-
-   while ( true ) {
-      ifs.get(c);
-      if ( !ifs.good() ) break;
-
-      if ( quoting) {
-        if (c == '\"') quoting = false; 
-	ss << c;
-	continue;
-      }
-
-      if ( (c != ' ' ) && (c != '\n') && (c != '\t') && (c != '\r') )  {
-	ss << c;
-	continue;
-      }
-            
-      break;
-   }
-
-   return ss.str();
-  }
-
-
-//|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
-//|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
-
 void OptimMainWindow::cmdImportMadX()
 { 
 
@@ -797,89 +379,46 @@ void OptimMainWindow::cmdImportMadX()
   using namespace MadX;
   
   char fname1[255];
-  strcpy(fname1, QFileDialog::getOpenFileName( ).toUtf8().data()); 
+  // a TFS twiss table ("twiss, file=..."), not a MAD-X sequence file; see MadXTfs.h   
+
+  strcpy(fname1, QFileDialog::getOpenFileName(this, "Import MADX TFS (twiss) table", "", "TFS tables (*.tfs);;All files (*)").toUtf8().data()); 
   if (!fname1[0]) return; 
   
-  auto del = [](FILE* p) { (p ? fclose(p) : 0);};  
-  std::unique_ptr<FILE, decltype(del)>  fp1 (fopen(fname1,"r"), del);
-  
-  if( !fp1 ){
+  QFile file(fname1);
+  if ( !file.open(QIODevice::ReadOnly) ) {
     OptimMessageBox::warning(this,  "Error opening file - ", fname1, QMessageBox::Ok);
     return;
   }
 
-  std::ifstream ifs( fname1 );
-
-  //--------------------------------------------------------------
-  // look for particle constants
-  //---------------------------------------------------------------
-
-  while ( true ) {
-
-    std::string token =  get_token(ifs);
-    if ( !ifs.good() ) break;
-
-    if ( token == "@" ) {
-       token = get_token(ifs);
-       if (token ==  "MASS" ) {
-	 get_token(ifs); // skip format spec
-	 token = get_token(ifs);
-	 mass = std::stod(token);
-       }
-       else if ( (token ==  "ENERGY") ) {
-	 get_token(ifs); // skip format spec
-	 token = get_token(ifs);
-	 etot = std::stod(token);
-       }
-       else if ( (token ==  "PC")     ) {
-	 get_token(ifs); // skip format spec
-	 token = get_token(ifs);
-	 pc = std::stod(token);
-       }
-       else if ( (token ==  "GAMMA")  ) {
-	 get_token(ifs); // skip format spec
-	 token = get_token(ifs); 
-	 gma = std::stod(token);
-       }
-       else if ( (token ==  "TITLE")  ) {
-	 get_token(ifs); // skip format spec
-	 token = get_token(ifs); 
-	 trim(token);
-	 title = token;
-       }
-       else if ( (token ==  "ORIGIN")  ) {
-	 get_token(ifs); // skip format spec
-	 token = get_token(ifs); 
-	 trim(token);
-	 origin = token;
-       }
-       else if ( (token ==  "DATE")  ) {
-	 get_token(ifs); // skip format spec
-	 token = get_token(ifs); 
-	 trim(token);
-	 sdate = token;
-       }
-       else if ( (token ==  "TIME")  ) {
-	 get_token(ifs); // skip format spec
-	 token = get_token(ifs); 
-	 trim(token);
-	 MadX::stime = token;
-       }
-       else if ( (token ==  "SEQUENCE")  ) {
-	 get_token(ifs); // skip format spec
-	 token = get_token(ifs); 
-	 trim(token);
-	 MadX::sequence = token;
-       }
-       
-      //--------------------------------------------------------------
-      // look for the attribute keywords specification (starts with *)
-      //---------------------------------------------------------------
-    }
+  // the table is lexed in place in the mapped file; read it instead when the file cannot be mapped 
+
+  QByteArray  contents;
+  qint64      size  = file.size();
+  char const* begin = reinterpret_cast<char const*>( size ? file.map(0, size) : 0 );
+  if (!begin) {
+    contents = file.readAll();
+    begin    = contents.constData();
+    size     = contents.size();
+  }
+  char const* end = begin + size;
 
-    if ( token == "*" )  break;
+  MadX::Tfs tfs;
+  std::string err;
+  if ( int line = tfs.parse(begin, end, err) ) {
+    OptimMessageBox::warning(this, "MADX Import Error", QString::asprintf("%s, line %d: %s", fname1, line, err.c_str()).toUtf8().data(), QMessageBox::Ok);
+    return;
   }
 
+  mass            = tfs.param("MASS");
+  etot            = tfs.param("ENERGY");
+  pc              = tfs.param("PC");
+  gma             = tfs.param("GAMMA");
+  title           = tfs.text("TITLE");
+  origin          = tfs.text("ORIGIN");
+  sdate           = tfs.text("DATE");
+  MadX::stime     = tfs.text("TIME");
+  MadX::sequence  = tfs.text("SEQUENCE");
+
   double brho = (pc*1.0e9)/(2.99792458e8);  // pc is in GeV/c Brho is in T-m
 
   static ImportMadXDialog* dialog = 0;
@@ -902,86 +441,28 @@ void OptimMainWindow::cmdImportMadX()
 
   std::ofstream ofs( dialog->data_.filenameto.toUtf8().data());
 
-  //-----------------------------------------------------------
-  // count the number of keywords (columns) in the TFS table
-  //-----------------------------------------------------------
-
-  std::vector<std::string> keywords;
-
-  // get all the columns names ...  
-
-  int icol = 0;
-  while ( ifs.good() ) {
-    std::string token =  get_token(ifs);
-    ++icol;
-    if ( token == "$" ) break;
-    keywords.push_back(token);
-  }
-
-  int nk = keywords.size();
-  
-  // skip all the corresponding column format information 
-
-  for  ( int i=0; i<nk; ++i ) {
-    std::string token =  get_token(ifs);
-  }
-
-  std::unordered_map<std::string, double> attributes;
+  beamline.reserve( 3*tfs.rows.size() / 2 );
+  element_dict.reserve( tfs.rows.size() );
 
   // main loop over all elements ...
   
-  while ( true ) {
-
-    attributes.clear();
-
-    // The first two attributes must be the element label and the element type
-    // They cannot be omitted (i.e. they need to be SELECTED) from the TFS file. 
-    // Note that to be very general, we should not assume anything about the
-    // data type of the columns. This would require using something like
-    // boost::any to store the attribute value.
-
-    std::string elabel = get_token(ifs);
-    trim(elabel);
-
-    std::string etype = get_token(ifs);
-    if (etype == "\"\"") continue;
-    trim(etype);
-
-    if (!ifs.good() ) break;
-    
-    // we assume that all data are real numbers. This is almost true. The
-    // column labeled "PARENT" is an exception. It is not needed by the translator,
-    // so we set its "value" to 0.0. This is a kludge. 
-    
-    for (int i = 2; i < nk; ++i ) { 
-      auto s =  get_token(ifs);
-      if ( keywords[i] == "PARENT")  {
-	attributes.insert( {keywords[i],  0.0} );  // FIXME - this is a kludge. 
-      }
-      else if ( keywords[i] == "COMMENTS") {
-	attributes.insert( {keywords[i],  0.0} );  // FIXME - this is a kludge. 
-      }
-      else {
-	attributes.insert( {keywords[i],  std::stod(s)} );
-      }
-    }  
+  for (auto const& row : tfs.rows) {
 
     // find the start of the line marker and set the initial lattice functions.
     
-    if ( ( elabel.rfind("$START") != std::string::npos) &&
-	 ( etype == "MARKER") ) {
-
-       bx  = attributes["BETX"]*100; // MADX [m] to OptiMX [cm] 
-       by  = attributes["BETY"]*100; // MADX [m] to OptiMX [cm] 
-       ax  = attributes["ALFX"];     // dimensionless
-       ay  = attributes["ALFY"];     // dimensionless
-       dx  = attributes["DX"]*100;   // MADX [m] to OptiMX [cm] 
-       dxp = attributes["DPX"];      // dpx is dimensionless
-       dy  = attributes["DY"]*100;   // MADX [m] to OptiMX [cm] 
-       dyp = attributes["DPY"];      // dpy is dimensionless
+    if ( ( row.label.rfind("$START") != std::string_view::npos) &&
+	 ( row.type == "MARKER") ) {
+
+       bx  = row.a.BETX*100; // MADX [m] to OptiMX [cm] 
+       by  = row.a.BETY*100; // MADX [m] to OptiMX [cm] 
+       ax  = row.a.ALFX;     // dimensionless
+       ay  = row.a.ALFY;     // dimensionless
+       dx  = row.a.DX*100;   // MADX [m] to OptiMX [cm] 
+       dxp = row.a.DPX;      // dpx is dimensionless
+       dy  = row.a.DY*100;   // MADX [m] to OptiMX [cm] 
+       dyp = row.a.DPY;      // dpy is dimensionless
     }
-    make_element( beamline, element_dict, elabel, etype, attributes, brho);
-     
+    MadX::make_element( beamline, element_dict, row, brho);
   }
 
   output_header( editor, ofs     );
@@ -994,7 +475,6 @@ void OptimMainWindow::cmdImportMadX()
   editor->document()->setModified(false);
 
   ofs.close();
-  ifs.close();
 }
 
 //|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
@@ -40,6 +40,7 @@
 #include <Constants.h>
 #include <TrackParam.h>
 #include <Coordinates.h>
+#include <Tpsa.h>
 
 using Constants::C_CGS;
 using Constants::C_DERV1;
@@ -107,13 +108,8 @@ int Instrument::trackOnce( double ms,   double& Enr0, int n_elem, int n_turn, Tr
 {
   int status = 0; 
   if (status = backwardTest(prm, n_elem, n_turn, v)) return status;
-  double p = prm.p0*(1.0+v[5]);  // p = p0 (1 + dp/p)
- 
-  v[0] += L_*tan(v[1]);
-  v[2] += L_*tan(v[3]);
 
-  double vp  = C_CGS*p/sqrt( p*p*(1.0 + v[1]*v[1] + v[3]*v[3]) + ms*ms );  // velocity
-  v[4] += (vp - prm.vp0) * L_ / prm.vp0;
+  Drift::transport(L_, ms, prm, v.c.data());
 
  done:	
 
@@ -125,6 +121,16 @@ int Instrument::trackOnce( double ms,   double& Enr0, int n_elem, int n_turn, Tr
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
+int Instrument::trackMap( double ms, double& Enr0, int n_elem, TrackParam& prm,
+		          RMatrix const& m1, Tpsa* u) const
+{
+  Drift::transport(L_, ms, prm, u);
+  return 0;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
 RMatrix Instrument::rmatrixsc(double& alfap, double& energy, double ms, double current, BeamSize& bs,double& tetaY, double dalfa, int st ) const
 {
 
@@ -42,6 +42,7 @@
 #include <Element.h>
 #include <Globals.h>
 #include <RMatrix.h>
+#include <RadiationIntegrals.h>
 #include <Twiss.h>
 #include <fmt/format.h>
 #include <OptimMainWindow.h>
@@ -49,6 +50,9 @@
 #include <OptimMessages.h>
 #include <QGuiApplication>
 
+#include <algorithm>
+#include <memory>
+
 using Constants::PI;
 using Constants::KVSR;
 using Constants::KE;
@@ -56,22 +60,14 @@ using Constants::C_DERV1;
 
 //......................................................................................
 
-void OptimMainWindow::integrStep(double dL, double gamma, double Hrt, double dEn2,
-				 Twiss const& v, Element& e, double& dgx,  double& dgy, double& dB2, double& nuxpr,
-	double& nuypr, double& emxn, double& emyn)
+void OptimMainWindow::integrStep(double dL, double Hrt, Twiss const& v, Element& e, double& nuxpr, double& nuypr)
 {
 
-  // integral quantities through an element 
-  // NOTHING HAPPENS IN THE CFEBEND ??? This is probably WRONG !!!!
+  // chromaticity contributions through an element; the radiation integrals are computed 
+  // element by element in cmdIntegrals (see RadiationIntegrals.h) 
   
-  double ca, sa, c2a, c3a, s3a, gmsr;
+  double s, c2a, c3a, s3a;
   
-  double gm2  = gamma*gamma;
-         gmsr = sqrt(gm2-1.0);
-  double s    = v.DsXp*v.BtX + v.DsX*v.AlX;
-  double Ax   = (v.DsX*v.DsX + s*s)/v.BtX;
-         s    = v.DsYp*v.BtY + v.DsY*v.AlY;
-  double Ay   = (v.DsY*v.DsY + s*s)/v.BtY;
   double knu  = 1./(4.*PI*Hrt);
   
   switch( toupper(e.name()[0]) ) {
@@ -79,18 +75,9 @@ void OptimMainWindow::integrStep(double dL, double gamma, double Hrt, double dEn
    case 'D':
      {
       s      = e.tilt()*PI/180.;
-      ca     = cos(s);
-      sa     = sin(s);
+      double ca  = cos(s);
+      double sa  = sin(s);
       c2a    = cos(2.*s);
-      s      = 0.5*dEn2*gm2/(gmsr*gmsr*gmsr*ms*ms*1.e6)*dL/e.length();
-      // contribution to equilibrium emittance 
-      emxn  += Ax*s;
-      emyn  += Ay*s;
-      s      = e.B*(2.*e.G + e.B*e.B/Hrt)*dL;
-      // contribution to damping decrement factors
-      dgx   += v.DsX*ca*s;
-      dgy   += v.DsY*sa*s;
-      dB2   += e.B*e.B*dL;
       // Chromaticity contribution
       double D = v.DsX*ca + v.DsY*sa;
       double h = e.B/Hrt;
@@ -219,9 +206,8 @@ void OptimMainWindow::cmdIntegrals()
   double emyn  = 0.0;
   double nuxpr = 0.0;
   double nuypr = 0.0;
-  double dgx   = 0.0;
-  double dgy   = 0.0;
-  double dB2   = 0.0;
+
+  RadiationIntegrals::Sums ri = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
   
   v.eigenvectors(ev);
  
@@ -231,6 +217,48 @@ void OptimMainWindow::cmdIntegrals()
     char nm = ep->etype();
     int  ns = fabs(ep->length()/stepint)+1;
 
+    // radiation integrals, from the lattice functions at the entrance. Bends in a skew plane are integrated 
+    // numerically, the lattice functions inside being obtained from the matrix of a bend of partial length.  
+
+    RadiationIntegrals::Sums dri = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    double alpha = ep->tilt()*PI/180.;
+
+    switch(nm) {
+      case 'B':
+      case 'D':
+        if ( RadiationIntegrals::planar(alpha) ) {  
+          dri = RadiationIntegrals::bend(ep->length(), ep->B/Hrt, ep->G/Hrt, alpha, v);
+        }
+        else {
+          std::unique_ptr<Element> part(ep->clone());
+          auto local = [&](double s) {
+            Twiss u = v;
+            std::complex<double> eu[4][4];
+            std::copy(&ev[0][0], &ev[0][0]+16, &eu[0][0]);
+            part->length(s);
+            double a  = 0.0;
+            double en = Enr;
+            double ty = tetaY;
+            RMatrix m = part->rmatrix(a, en, ms, ty, 0.0, 3);
+            Element::propagateLatticeFunctions(m, u, eu);
+            return RadiationIntegrals::local(ep->B/Hrt, ep->G/Hrt, alpha, u);
+          };
+          dri = RadiationIntegrals::integrate<RadiationIntegrals::Sums>(local, ep->length());
+        }
+        break;
+      case 'G':
+        dri = RadiationIntegrals::edge(ep->B/Hrt, tan(ep->G*PI/180.), alpha, v);
+        break;
+      default:
+        break;
+    }
+
+    // emittance excitation per unit I5 [normalized emittance, cm] 
+    double qem = 0.5*KE*Hrt*Hrt*Hrt*gm2*gm2*gamma/(ms*ms*ms*gmsr) * gm2/(gmsr*gmsr*gmsr*ms*ms*1.e6);  
+    emxn += qem*dri.I5x; 
+    emyn += qem*dri.I5y;
+    ri   += dri;
+
     // sum over whole Elements
     switch(nm) { // Switch 1
       case 'M':
@@ -252,15 +280,11 @@ void OptimMainWindow::cmdIntegrals()
       	}
 	break;
     case 'G': // magnet edge
-        // damping parameters contribution
         tg   = tan(ep->G*PI/180.);
         s    = ep->tilt()*PI/180.;
 	ca   = cos(s);
 	sa   = sin(s);
 	c2a  = cos(2.*s);
-	s    = (ep->B*ep->B)*tg;
-        dgx -= v.DsX*ca*s;
-	dgy -= v.DsY*sa*s;
 	// Chromaticity contribution
         if (i<(nelm_-1)){
 	  if( (beamline_[i+1]->etype() =='B') || (beamline_[i+1]->etype() =='D') ) {
@@ -300,14 +324,12 @@ void OptimMainWindow::cmdIntegrals()
 	break;
    }  // Switch 1 end
 
-    auto e = std::shared_ptr<Element>(ep->split(ns));
-
     //-----------------------------------------------------------------------
     // *** WARNING *** 
     // Normally cavity are non-splitable elements
-    // so (ep->split(ns) when e is a cavity does not divide the length by ns
+    // so (a slice of a cavity is the whole cavity)
     // here we integrate explicitly through the cavity with integrStep
-    if ((nm == 'A') ||  (nm == 'W') ) e->length( e->length()/ns );  // FORCE CAVITY SPLIT !!!    
+    SliceRef e( *ep, ns, slice_arena_, (nm == 'A') || (nm == 'W'));  // FORCE CAVITY SPLIT !!!    
     //-----------------------------------------------------------------------
     // *** WARNING ****
     // EAcc is a splitable element
@@ -317,7 +339,7 @@ void OptimMainWindow::cmdIntegrals()
     // NOT NEEDED HERE
     //------------------------------------------------------------------------ 
 
-    integrStep(0.5*e->length(), gamma, Hrt, dEn2t, v, *ep, dgx, dgy, dB2, nuxpr, nuypr, emxn, emyn);
+    integrStep(0.5*e->length(), Hrt, v, *ep, nuxpr, nuypr);
 
     double dalfa = 0.0;
     double alfap = 0.0;
@@ -333,8 +355,7 @@ void OptimMainWindow::cmdIntegrals()
       }
       e->propagateLatticeFunctions(tm, v, ev);
       
-      integrStep(e->length(), gamma, Hrt, dEn2t, v, *ep, dgx, dgy, dB2,
-		                           nuxpr, nuypr, emxn, emyn);
+      integrStep(e->length(), Hrt, v, *ep, nuxpr, nuypr);
       Lp    += e->length();
       Hrt    = sqrt(2.*ms*Enr+Enr*Enr)/C_DERV1;
       gamma  = 1.0+Enr/ms;
@@ -343,7 +364,7 @@ void OptimMainWindow::cmdIntegrals()
 
     }
 
-    integrStep(-0.5*e->length(), gamma, Hrt, dEn2t, v, *ep, dgx, dgy, dB2, nuxpr, nuypr, emxn, emyn);
+    integrStep(-0.5*e->length(), Hrt, v, *ep, nuxpr, nuypr);
 
     // Chromaticity contribution
     switch(nm){ // Switch 2
@@ -383,8 +404,8 @@ void OptimMainWindow::cmdIntegrals()
      } // Switch 2 end
   } // for_1 end
   
-  double gx = (dB2==0) ? 1.0 : 1.0-dgx/dB2;
-  double gy = (dB2==0) ? 1.0 : 1.0-dgy/dB2;
+  double gx = (ri.I2==0) ? 1.0 : 1.0-ri.I4x/ri.I2;
+  double gy = (ri.I2==0) ? 1.0 : 1.0-ri.I4y/ri.I2;
   double gs = 4.0 - gx - gy;
 
   double emx0 = (VSR > 1.0e-12) ? 1000.0 *emxn *Enr/(VSR*gx*gamma) : 0.0;
@@ -445,7 +466,9 @@ void OptimMainWindow::cmdIntegrals()
   format_to(outbuf,"Synchrotron Rad. Losses: VSR = {:10g} keV, VSR [rms] = {:10g} keV\n", VSR, sqrt(dEn2));
   format_to(outbuf,"                      VSR/E0 = {:10g},  VSR/E0 [rms] = {:10g} \n", VSR/(Enr*1000.), sqrt(dEn2)/(Enr*1000.));
   format_to(outbuf,"Emittance increase due to SR: (absolute)  ex = {:10g} cm, ey  = {:10g} cm\n",   emxn/gmsr, emyn/gmsr);
-  format_to(outbuf,"                            (normalized) exn = {:10g} cm, eyn = {:10g} cm\n\n", emxn,emyn);
+  format_to(outbuf,"                            (normalized) exn = {:10g} cm, eyn = {:10g} cm\n", emxn,emyn);
+  format_to(outbuf,"Radiation integrals: I1 = {:10g} cm, I2 = {:10g} 1/cm, I3 = {:10g} 1/cm**2\n", ri.I1, ri.I2, ri.I3);
+  format_to(outbuf,"                     I4x = {:10g} 1/cm, I4y = {:10g} 1/cm, I5x = {:10g} 1/cm, I5y = {:10g} 1/cm\n\n", ri.I4x, ri.I4y, ri.I5x, ri.I5y);
 
   
   if (NmbPer!=1) {
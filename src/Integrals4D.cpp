@@ -36,13 +36,16 @@
 //  =================================================================
 //
 
+#include <algorithm>
 #include <limits>
+#include <memory>
 #include <Constants.h>
 #include <GeneralPreferencesDialog.h>
 #include <Element.h>
 #include <Globals.h>
 #include <RMatrix.h>
 #include <OptimCalc.h>
+#include <RadiationIntegrals.h>
 #include <Twiss.h>
 #include <OptimMainWindow.h>
 #include <OptimApp.h>
@@ -163,84 +166,22 @@ static double g2ds(double B0, double alpha, double Hr, double G, Twiss4D const&
 // |||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 // |||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-void OptimMainWindow::integrStep(double dL, double gamma, double Hrt, double dEn2,
-	Twiss4D const& v, Element& e, double& dg1,  double& dg2, double& dB2, double& nu1pr,
-	double& nu2pr, double& em1n, double& em2n)
-{
+namespace {
 
-  
-  // integral quantities through an element 
-  // NOTHING HAPPENS IN THE CFEBEND ??? This is probably WRONG !!!!
-  
-  double ca, sa, c2a, c3a, s3a, gmsr;
-  
-  double gm2  = gamma*gamma;
-         gmsr = sqrt(gm2-1.0);
-	 double A1   = 2*std::norm(B1(v));
-	 double A2   = 2*std::norm(B2(v));
-         double knu  = 1./(4.*PI*Hrt);
+  // integrands of the 4D radiation sums through a bend  
 
-   double s = 0.0; // WARNING: s is sometimes used a temp variable here  
+  struct Rad4D { 
+    double em1, em2, dg1, dg2, dB2; 
 
-   double alpha = 0.0; 
+    Rad4D  operator+( Rad4D const& o) const { return { em1+o.em1, em2+o.em2, dg1+o.dg1, dg2+o.dg2, dB2+o.dB2 }; }
+    Rad4D  operator*( double a)       const { return { a*em1, a*em2, a*dg1, a*dg2, a*dB2 }; }
+    double norm() const { return std::max( std::max(std::max(fabs(em1), fabs(em2)), std::max(fabs(dg1), fabs(dg2))), fabs(dB2)); } 
+  };
 
-   switch( toupper(e.name()[0]) ) {
-    case 'B':  
-    case 'D':
-     {
-      alpha =  e.tilt()*PI/180.; // Tilt in rd
-      
-      ca     = cos(alpha);
-      sa     = sin(alpha);
-      c2a    = cos(2.*alpha);
-  
-      
-      // contribution to equilibrium emittance 
-      s      = 0.5*dEn2*gm2/(gmsr*gmsr*gmsr*ms*ms*1.e6)*dL/e.length(); 
-
-      em1n  += A1*s;
-      em2n  += A2*s;
-
-	  // contribution to damping decrement factors
-      dg1   += dL*g1ds(e.B, alpha, Hrt, e.G, v);
-      dg2   += dL*g2ds(e.B, alpha, Hrt, e.G, v);
-      dB2   += e.B*e.B*dL;
-
-      
-      // Chromaticity contribution
-      double D = v.dx*ca + v.dy*sa;
-      double h = e.B/Hrt;
-      double k = e.G*c2a/Hrt;
-      double A = dL/(4.*PI);
-      double gammaX = (1. + v.alfx1 * v.alfx1) / v.btx1;
-      double gammaY = (1. + v.alfy2 * v.alfy2) / v.bty2;
-      s       = v.btx1*( k*(h*(v.dx*ca+D)-1.) - h*h*ca*ca);
-      nu1pr  += 0.0; // A*(s - 2.*v.alfx1*v.dxp*h*ca + gammaX*h*D); // dnu1/(dp/p) ??? 
-      s       = v.bty2*( k*(1.-h*(v.dy*sa+D)) - h*h*sa*sa);
-      nu2pr  += 0.0;// A*(s - 2.*v.alfy2*v.dyp*h*sa + gammaY*h*D);     
-     }
-   break;
-   case 'Q':
-     s   = e.tilt()*PI/180.;
-     c2a =cos(2*s);
-      // Chromaticity contribution
-     nu1pr -= 0.0;// knu*v.btx1*dL*e.G*c2a;
-     nu2pr += 0.0;// knu*v.bty2*dL*e.G*c2a;
-     break;
-   case 'S':
-     s   = e.tilt()*PI/180.;
-     c3a = cos(3.*s);
-     s3a = sin(3.*s);
-     s   = knu*dL*e.S*(c3a*v.dx+s3a*v.dy);
-      // Chromaticity contribution
-     nu1pr += 0.0;// v.btx1*s;
-     nu2pr -= 0.0;// v.bty2*s;
-   default:
-     break;
-  }
-}
-//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
-//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+} // namespace
+
+// |||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+// |||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
 void OptimMainWindow::cmdIntegrals4D()
 {
@@ -434,6 +375,34 @@ int   status = Get4DBetasFromFile(true, false, v); // 1st arg: Reprint
 	break;
     }  // Switch 1 end
 
+    // radiation sums through the bends, by adaptive quadrature (see RadiationIntegrals.h). The 
+    // lattice functions inside a bend are obtained from the matrix of a bend of partial length.   
+
+    if ( ((nm == 'B') || (nm == 'D')) && ep->length() > 0.0 ) {
+      std::unique_ptr<Element> part(ep->clone());
+      double alpha = ep->tilt()*PI/180.0;
+      double sem   = 0.5*dEn2t*gm2/(gmsr*gmsr*gmsr*ms*ms*1.e6)/ep->length();   // per unit length and unit A   
+      auto local = [&](double s) {
+        Twiss4D u = v;
+        std::complex<double> eu[4][4];
+        std::copy(&ev[0][0], &ev[0][0]+16, &eu[0][0]);
+        part->length(s);
+        double a  = 0.0;
+        double en = Enr;
+        double ty = tetaY;
+        RMatrix m = part->rmatrix(a, en, ms, ty, 0.0, 3);
+        Element::propagateLatticeFunctions(m, u, eu);
+        return Rad4D{ 2.0*std::norm(B1(u))*sem, 2.0*std::norm(B2(u))*sem, g1ds(ep->B, alpha, Hrt, ep->G, u), 
+                      g2ds(ep->B, alpha, Hrt, ep->G, u), ep->B*ep->B };
+      };
+      Rad4D r = RadiationIntegrals::integrate<Rad4D>(local, ep->length());
+      em1n += r.em1;
+      em2n += r.em2;
+      dg1  += r.dg1;
+      dg2  += r.dg2;
+      dB2  += r.dB2;
+    }
+
     //  numerical integration over elements
     //...............................................................
     // This is used for debugging 
@@ -446,14 +415,15 @@ int   status = Get4DBetasFromFile(true, false, v); // 1st arg: Reprint
     }
     //...................................................................
 
-    auto e = std::shared_ptr<Element>(ep->split(ns));
-    
     //-----------------------------------------------------------------------
     // *** WARNING *** 
     // Normally cavity are non-splitable elements
-    // so (ep->split(ns) when e is a cavity does not divide the length by ns
+    // so (a slice of a cavity is the whole cavity)
     // here we integrate explicitly through the cavity with integrStep
-    if ((nm == 'A') ||  (nm == 'W') ) e->length(e->length()/ns);  // FORCE CAVITY SPLIT !!!    
+    std::unique_ptr<Element> cav;
+    if ((nm == 'A') ||  (nm == 'W') ) { cav.reset(ep->clone()); cav->length(cav->length()/ns); }  // FORCE CAVITY SPLIT !!!    
+
+    SliceRef e( cav ? *cav : *ep, ns, slice_arena_);
     //-----------------------------------------------------------------------
     // *** WARNING ****
     // EAcc is a splitable element
@@ -463,8 +433,6 @@ int   status = Get4DBetasFromFile(true, false, v); // 1st arg: Reprint
     // NOT NEEDED HERE
     //------------------------------------------------------------------------ 
 
-    integrStep(0.5*e->length(), gamma, Hrt, dEn2t, v, *ep, dg1, dg2, dB2, nu1pr, nu2pr, em1n, em2n);
-
     double dalfa = 0.0;
     double alfap = 0.0;
     
@@ -481,9 +449,6 @@ int   status = Get4DBetasFromFile(true, false, v); // 1st arg: Reprint
       }
 
       e->propagateLatticeFunctions(tm, v, ev);
-
-      integrStep(e->length(), gamma, Hrt, dEn2t, v, *ep, dg1, dg2, dB2,
-        		                           nu1pr, nu2pr, em1n, em2n);
       Lp    += e->length();
       Hrt    = sqrt(2.*ms*Enr+Enr*Enr)/C_DERV1;
       gamma  = 1.0+Enr/ms;
@@ -492,7 +457,6 @@ int   status = Get4DBetasFromFile(true, false, v); // 1st arg: Reprint
 
     } //  for( int j=0 ; j<ns; ++j)
 
-   integrStep(-0.5*e->length(), gamma, Hrt, dEn2t, v, *ep, dg1, dg2, dB2, nu1pr, nu2pr, em1n, em2n);
    
     // Chromaticity contribution
     switch(nm){ // Switch 2
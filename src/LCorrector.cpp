@@ -40,6 +40,7 @@
 #include <TrackParam.h>
 #include <Constants.h>
 #include <Coordinates.h>
+#include <Tpsa.h>
 
 using Constants::C_DERV1;
 using Constants::C_CGS;
@@ -109,14 +110,8 @@ int LCorrector::trackOnce( double ms,   double& Enr0, int n_elem, int n_turn, Tr
 
   int status = 0; 
   if (status = backwardTest(prm, n_elem, n_turn, v)) return status;
-  double p = prm.p0*(1.0+v[5]);  // p = p0 (1 + dp/p)
- 
-  v[0] += L_*tan(v[1]);
-  v[2] += L_*tan(v[3]);
-
-  double vp  = C_CGS*p/sqrt( p*p*(1.0 + v[1]*v[1] + v[3]*v[3]) + ms*ms );
 
-  v[4] += (vp - prm.vp0) * L_ / prm.vp0;
+  Drift::transport(L_, ms, prm, v.c.data());
   v[5] += G*(Enr0+ms)/(Enr0 * Enr0+2.* Enr0*ms); // apply the longitudinal kick
 
   if (status = transAmpTest(prm, n_elem, n_turn, v)) return status; 
@@ -127,6 +122,17 @@ int LCorrector::trackOnce( double ms,   double& Enr0, int n_elem, int n_turn, Tr
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
+int LCorrector::trackMap( double ms, double& Enr0, int n_elem, TrackParam& prm,
+		          RMatrix const& m1, Tpsa* u) const
+{
+  Drift::transport(L_, ms, prm, u);
+  u[5] += G*(Enr0+ms)/(Enr0 * Enr0+2.* Enr0*ms); // apply the longitudinal kick
+  return 0;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
 RMatrix LCorrector::rmatrixsc(double& alfap, double& energy, double ms, double current, BeamSize& bs,double& tetaY, double dalfa, int st ) const
 {
 
@@ -42,9 +42,9 @@
 #include <Coordinates.h>
 #include <Utility.h>
 #include <TrackParam.h>
+#include <RandomStream.h>
 
 using Constants::PI;
-using Utility::gauss;
 
 
 LScatter::LScatter(const char* nm, char const* fnm)
@@ -120,7 +120,9 @@ int LScatter::trackOnce(double ms, double& Enr0, int n_elem, int n_turn,
 
   s = ( s>0.0) ? sqrt(s) : 0.0;
 
-  v[5] += s*gauss()*(ms+ Enr0)/(prm.p0 * prm.p0);
+  RandomStream rng(n_turn, n_elem, v.pid);  // per-particle stream: reproducible in parallel 
+
+  v[5] += s*rng.normal()*(ms+ Enr0)/(prm.p0 * prm.p0);
 
  done:	
 
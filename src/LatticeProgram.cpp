@@ -0,0 +1,258 @@
+//  =================================================================
+//
+//  LatticeProgram.cpp
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+#include <LatticeProgram.h>
+#include <Element.h>
+#include <Bunch.h>
+#include <Constants.h>
+#include <Coordinates.h>
+#include <algorithm>
+#include <cmath>
+#include <typeinfo>
+
+using Constants::PI;
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+LatticeProgram::LatticeProgram()
+  : ms_(0.0)
+{}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void LatticeProgram::compile( std::vector<std::shared_ptr<Element>> const& line, RMatrix_t<3>& frame, double ms, double Enr, double tetaY )
+{
+  // The element parameters are computed with the energy at the entrance of every element, which
+  // the accelerating elements update as in OptimTrackerNew::cmdTrackingNew(); frame is advanced 
+  // through the line. The instruction is selected from the dynamic type, so that a class derived  
+  // from one of the directly executed elements still goes through its own trackOnce(). 
+
+  int n = line.size();
+
+  ms_  = ms;
+
+  ops_.clear();
+  ops_.reserve(n);
+  prm_.assign(n, TrackParam());
+  m1_.assign(n, RMatrix());
+  enr_.assign(n+1, Enr);
+
+  for (int i=0; i<n; ++i) {
+
+    Element const* ep = line[i].get();
+
+    enr_[i] = Enr;
+    m1_[i].toUnity();
+    ep->preTrack(frame, ms, Enr, i, prm_[i], m1_[i]);
+
+    std::type_info const& t = typeid(*ep);
+    char et = ep->etype();
+
+    if ( (et == 'A') || (et == 'W') || (et == 'E') || (et == 'X') ) {  // accelerating elements 
+      ep->rmatrix(Enr, ms, tetaY, 0.0, 3);
+    }
+
+    if      ( et == 'Y' ) {
+      ops_.push_back( CollectiveOp{} );
+    }
+    else if ( (t == typeid(Drift)) || (t == typeid(Instrument)) ) {
+      ops_.push_back( DriftOp{ep->length()} );
+    }
+    else if ( t == typeid(Quadrupole) ) {
+      ops_.push_back( QuadOp{static_cast<Quadrupole const*>(ep)} );
+    }
+    else if ( t == typeid(Sextupole) ) {
+      ops_.push_back( SextOp{ep} );
+    }
+    else if ( t == typeid(Multipole) ) {
+      ops_.push_back( MultOp{ep, ep->N, ep->S * cos(ep->tilt() / 180. * PI) / prm_[i].Hr0,
+                                        ep->S * sin(ep->tilt() / 180. * PI) / prm_[i].Hr0} );
+    }
+    else if ( (t == typeid(EQuadrupole)) || (t == typeid(BBeam)) || (t == typeid(Element)) ) {
+      ops_.push_back( MatrixOp{} );
+    }
+    else {
+      ops_.push_back( ElementOp{ep} );
+    }
+  }
+  enr_[n] = Enr;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void LatticeProgram::run( int i, int n_turn, Bunch& v, int jbeg, int jend ) const
+{
+  std::visit( [&](auto const& op) { exec(op, i, n_turn, v, jbeg, jend); }, ops_[i] );
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void LatticeProgram::run( int i, int n_turn, Bunch& v, int N, bool parallel ) const
+{
+  // an element that overrides Element::trackBunch() (batched sampling) keeps its own bunch loop  
+
+  if (auto op = std::get_if<ElementOp>(&ops_[i])) {
+    op->e->trackBunch(ms_, enr_[i], i, n_turn, prm_[i], m1_[i], v, N, parallel);
+    return;
+  }
+
+  static int const block_size = 256;  
+
+  int nblocks = (N + block_size - 1)/block_size;
+
+  #pragma omp parallel for schedule(dynamic) if(parallel)
+  for (int b=0; b<nblocks; ++b) {
+    run(i, n_turn, v, b*block_size, std::min(N, (b+1)*block_size));
+  }
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void LatticeProgram::exec( DriftOp const& op, int i, int n_turn, Bunch& v, int jbeg, int jend ) const
+{
+  // Drift::trackOnce(), Instrument::trackOnce() 
+
+  TrackParam& prm = prm_[i];
+
+  for (int j=jbeg; j<jend; ++j) {
+    Coordinates& c = v[j];
+    if (c.lost != 0) continue;
+    if (Element::backwardTest(prm, i, n_turn, c)) continue;
+    Drift::transport(op.L, ms_, prm, c.c.data());
+    Element::transAmpTest(prm, i, n_turn, c);
+  }
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void LatticeProgram::exec( QuadOp const& op, int i, int n_turn, Bunch& v, int jbeg, int jend ) const
+{
+  // Quadrupole::trackOnce() 
+
+  TrackParam& prm = prm_[i];
+
+  for (int j=jbeg; j<jend; ++j) {
+    Coordinates& c = v[j];
+    if (c.lost != 0) continue;
+    if (Element::backwardTest(prm, i, n_turn, c)) continue;
+    op.e->transport(ms_, prm, c.c.data());
+    Element::transAmpTest(prm, i, n_turn, c);
+  }
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void LatticeProgram::exec( SextOp const& op, int i, int n_turn, Bunch& v, int jbeg, int jend ) const
+{
+  // Sextupole::trackOnce() 
+
+  TrackParam& prm = prm_[i];
+
+  for (int j=jbeg; j<jend; ++j) {
+    Coordinates& c = v[j];
+    if (c.lost != 0) continue;
+    if (Element::backwardTest(prm, i, n_turn, c)) continue;
+    Sextupole::sext_trans(op.e, prm.Hr0/(1.+c[5]), &c, &c);
+    Element::transAmpTest(prm, i, n_turn, c);
+  }
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void LatticeProgram::exec( MultOp const& op, int i, int n_turn, Bunch& v, int jbeg, int jend ) const
+{
+  // Multipole::trackOnce() 
+
+  TrackParam& prm = prm_[i];
+
+  for (int j=jbeg; j<jend; ++j) {
+    Coordinates& c = v[j];
+    if (c.lost != 0) continue;
+    if (Element::backwardTest(prm, i, n_turn, c)) continue;
+    if (op.N != 0) {
+      Multipole::multipole_trans(op.e, prm.Hr0/(1.+c[5]), &c, &c);
+    }
+    else {
+      c[1] += op.kx * c[5];
+      c[3] += op.ky * c[5];
+    }
+    Element::transAmpTest(prm, i, n_turn, c);
+  }
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void LatticeProgram::exec( MatrixOp const& op, int i, int n_turn, Bunch& v, int jbeg, int jend ) const
+{
+  // Element::trackOnce() 
+
+  TrackParam&    prm = prm_[i];
+  RMatrix const& m1  = m1_[i];
+
+  for (int j=jbeg; j<jend; ++j) {
+    Coordinates& c = v[j];
+    if (c.lost != 0) continue;
+    if (Element::backwardTest(prm, i, n_turn, c)) continue;
+    c.c = m1*c.c;
+    Element::transAmpTest(prm, i, n_turn, c);
+  }
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void LatticeProgram::exec( ElementOp const& op, int i, int n_turn, Bunch& v, int jbeg, int jend ) const
+{
+  TrackParam&    prm = prm_[i];
+  RMatrix const& m1  = m1_[i];
+
+  for (int j=jbeg; j<jend; ++j) {
+    if (v[j].lost != 0) continue;
+    double enr = enr_[i];
+    op.e->trackOnce(ms_, enr, i, n_turn, prm, m1, v[j]);
+  }
+}
@@ -0,0 +1,234 @@
+//  =================================================================
+//
+//  LeastSquares.cpp
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+#include <LeastSquares.h>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+LeastSquares::LeastSquares( int n, Residuals f, Jacobian df, Monitor monitor)
+  : n_(n), f_(f), df_(df), monitor_(monitor), cost_(0.0), nf_(0), njac_(0), nrefresh_(10)
+{}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+bool LeastSquares::solve( std::vector<std::vector<double>>& A, std::vector<double>& b)
+{
+  // solve A x = b for a symmetric positive definite A. On return, b contains x.
+  // returns false if A is not (numerically) positive definite. 
+
+  int n = b.size();
+
+  for (int j=0; j<n; ++j) {
+    double d = A[j][j];
+    for (int k=0; k<j; ++k) d -= A[j][k]*A[j][k];
+    if ( d <= 0.0 ) return false;
+    A[j][j] = std::sqrt(d);
+    for (int i=j+1; i<n; ++i) {
+      double s = A[i][j];
+      for (int k=0; k<j; ++k) s -= A[i][k]*A[j][k];
+      A[i][j] = s/A[j][j];
+    }
+  }
+
+  for (int i=0; i<n; ++i) {   // L y = b
+    double s = b[i];
+    for (int k=0; k<i; ++k) s -= A[i][k]*b[k];
+    b[i] = s/A[i][i];
+  }
+  for (int i=n-1; i>=0; --i) { // L^T x = y
+    double s = b[i];
+    for (int k=i+1; k<n; ++k) s -= A[k][i]*b[k];
+    b[i] = s/A[i][i];
+  }
+  return true;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+LeastSquares::Status LeastSquares::operator()( std::vector<double>& x, double target, int niters)
+{
+
+  // target: the iterations stop as soon as cost() < target  
+  
+  static double const eps = std::numeric_limits<double>::epsilon(); 
+
+  nf_   = 0;
+  njac_ = 0;
+
+  std::vector<double> r;
+  if ( f_(x, r) ) return failed; 
+  ++nf_;
+
+  int m = r.size();
+
+  cost_ = 0.0;
+  for (auto s : r) cost_ += s*s;
+
+  if (cost_ < target) return converged;
+  
+  std::vector<std::vector<double>> J( m, std::vector<double>(n_, 0.0) );
+  if ( df_(x, r, J) ) return failed;
+  ++njac_;
+
+  bool   fresh   = true;   // J was evaluated (not updated) at the current x  
+  int    naccept = 0;      // accepted steps since last full Jacobian evaluation 
+  double lambda  = 1.0e-3;
+  double nu      = 2.0;
+
+  std::vector<double> dscale(n_, 0.0);  // Marquardt scaling (diag J^T J, running maximum)
+
+  std::vector<std::vector<double>> A(n_, std::vector<double>(n_));
+  std::vector<double> g(n_);
+  std::vector<double> dx(n_);
+  std::vector<double> xn(n_);
+  std::vector<double> rn;
+  std::vector<double> Jdx(m);
+
+  for (int iter=1; iter <= niters; ++iter) {
+
+    // normal equations
+
+    for (int i=0; i<n_; ++i) {
+      g[i] = 0.0; 
+      for (int k=0; k<m; ++k) g[i] += J[k][i]*r[k];
+      for (int j=0; j<=i; ++j) {
+        double s = 0.0; 
+        for (int k=0; k<m; ++k) s += J[k][i]*J[k][j];
+        A[i][j] = A[j][i] = s;
+      }
+      dscale[i] = std::max(dscale[i], A[i][i]);
+    }
+
+    double gnorm = 0.0;
+    for (int i=0; i<n_; ++i) gnorm = std::max(gnorm, std::fabs(g[i]));
+    if ( gnorm < eps*cost_ ) return stalled; 
+
+    // damped step
+
+    auto M = A;
+    for (int i=0; i<n_; ++i) { M[i][i] += lambda*std::max(dscale[i], eps); dx[i] = -g[i]; }
+
+    bool accepted = false;
+    double rho    = -1.0;
+
+    if ( solve(M, dx) ) {
+
+      for (int i=0; i<n_; ++i) xn[i] = x[i] + dx[i];
+
+      for (int k=0; k<m; ++k) {
+        Jdx[k] = 0.0;  
+        for (int i=0; i<n_; ++i) Jdx[k] += J[k][i]*dx[i];
+      }
+
+      double predicted = 0.0;  // predicted reduction:  |r|^2 - |r + J dx|^2 
+      for (int k=0; k<m; ++k) predicted -= Jdx[k]*(2.0*r[k] + Jdx[k]); 
+
+      if ( f_(xn, rn) == 0 ) {
+        ++nf_;
+        double costn = 0.0;
+        for (auto s : rn) costn += s*s;
+        rho = (predicted > 0.0) ? (cost_ - costn)/predicted : -1.0;
+
+        if ( rho > 1.0e-4 ) {
+
+          // Broyden update: J += (rn - r - J dx) dx^T / (dx^T dx)
+
+          double dx2 = 0.0;
+          for (int i=0; i<n_; ++i) dx2 += dx[i]*dx[i];
+          if (dx2 > 0.0) { 
+            for (int k=0; k<m; ++k) {
+              double u = (rn[k] - r[k] - Jdx[k])/dx2;
+              for (int i=0; i<n_; ++i) J[k][i] += u*dx[i];
+            }
+          }
+
+          x.swap(xn);
+          r.swap(rn);
+          cost_    = costn;
+          accepted = true;
+          fresh    = false;
+
+          lambda *= std::max(1.0/3.0, 1.0 - std::pow(2.0*rho - 1.0, 3));
+          nu      = 2.0;
+        }
+      }
+      else { 
+        ++nf_;
+      }
+    }
+
+    if ( !accepted ) {
+      if ( !fresh ) {          // the updated Jacobian may be poor. Re-evaluate before shrinking the trust region.
+        if ( df_(x, r, J) ) return failed;
+        ++njac_;
+        fresh   = true;
+        naccept = 0;
+      }
+      else {
+        lambda *= nu;
+        nu     *= 2.0;
+        if ( lambda > 1.0e16 ) return stalled;
+      }
+    }
+    else if ( ++naccept >= nrefresh_ ) {
+      if ( df_(x, r, J) ) return failed;
+      ++njac_;
+      fresh   = true;
+      naccept = 0;
+    }
+   
+    if ( !monitor_(iter, cost_) ) return aborted;
+
+    if ( cost_ < target ) return converged;
+
+    if ( accepted ) { 
+      double xnorm  = 0.0;
+      double dxnorm = 0.0;
+      for (int i=0; i<n_; ++i) { xnorm += x[i]*x[i]; dxnorm += dx[i]*dx[i]; }
+      if ( std::sqrt(dxnorm) < 1.0e-12*(std::sqrt(xnorm) + 1.0e-12) ) return stalled; 
+    }
+  }
+
+  return maxiters;
+}
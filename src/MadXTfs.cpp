@@ -0,0 +1,604 @@
+//  =================================================================
+//
+//  MadXTfs.cpp
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+
+#include <MadXTfs.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+  double const pi = 4*atan(1.0);
+
+  // character classes of the lexer
+
+  enum : unsigned char { OTHER = 0, BLANK = 1, EOL = 2, QUOTE = 3 };
+
+  struct CharClass {
+    unsigned char c[256];
+    constexpr CharClass() : c{} 
+    {
+      c[' ']  = c['\t'] = c['\r'] = c['\f'] = c['\v'] = BLANK;
+      c['\n'] = EOL;
+      c['"']  = QUOTE;
+    }
+  };
+
+  constexpr CharClass cls;
+
+  inline unsigned char cclass(char c) { return cls.c[static_cast<unsigned char>(c)]; }
+
+  // the TFS columns converted into Attributes   
+
+  struct { char const* name; double MadX::Attributes::* field; } const attributes[] = { 
+    {"L",     &MadX::Attributes::L    },  {"ANGLE", &MadX::Attributes::ANGLE},  {"K0L",   &MadX::Attributes::K0L  },
+    {"K0SL",  &MadX::Attributes::K0SL },  {"K1L",   &MadX::Attributes::K1L  },  {"K1SL",  &MadX::Attributes::K1SL },
+    {"K2L",   &MadX::Attributes::K2L  },  {"K2SL",  &MadX::Attributes::K2SL },  {"LRAD",  &MadX::Attributes::LRAD },
+    {"TILT",  &MadX::Attributes::TILT },  {"E1",    &MadX::Attributes::E1   },  {"E2",    &MadX::Attributes::E2   },
+    {"H1",    &MadX::Attributes::H1   },  {"HGAP",  &MadX::Attributes::HGAP },  {"FINT",  &MadX::Attributes::FINT },
+    {"FINTX", &MadX::Attributes::FINTX},  {"KSI",   &MadX::Attributes::KSI  },  {"HKICK", &MadX::Attributes::HKICK},
+    {"VKICK", &MadX::Attributes::VKICK},  {"BETX",  &MadX::Attributes::BETX },  {"BETY",  &MadX::Attributes::BETY },
+    {"ALFX",  &MadX::Attributes::ALFX },  {"ALFY",  &MadX::Attributes::ALFY },  {"DX",    &MadX::Attributes::DX   },
+    {"DPX",   &MadX::Attributes::DPX  },  {"DY",    &MadX::Attributes::DY   },  {"DPY",   &MadX::Attributes::DPY  } 
+  };
+
+  //.............................................................................................
+  
+  std::string_view token(char const*& p, char const* end)
+  {
+    // next token on the current line; empty at the end of the line. 
+    // A quoted string, which may contain blanks, is a single token.  
+
+    while ( p < end && cclass(*p) == BLANK ) ++p;
+    
+    char const* t = p;
+    while ( p < end ) {
+      unsigned char k = cclass(*p);
+      if (k == OTHER) { ++p; continue; }
+      if (k != QUOTE) break;
+      for ( ++p; p < end && cclass(*p) != QUOTE && cclass(*p) != EOL; ++p ) {}
+      if ( p < end && cclass(*p) == QUOTE ) ++p;
+    }
+    return std::string_view(t, p-t);
+  }
+
+  //.............................................................................................
+
+  std::string_view unquote(std::string_view s)
+  {
+    auto pos1 = s.find_first_not_of("\" ");
+    auto pos2 = s.find_last_not_of("\" ");
+    if (pos1 == std::string_view::npos) return std::string_view(); 
+    return s.substr(pos1, pos2-pos1+1);
+  }
+
+  //.............................................................................................
+
+  class Text {
+
+    // appends to a string as a std::stringstream would, with default flags (doubles as with %g)    
+
+   public:
+
+    Text& operator<<(char const* s)        { s_ += s; return *this; }
+    Text& operator<<(std::string const& s) { s_ += s; return *this; }
+    Text& operator<<(int i)                { return (*this) << double(i); }
+    Text& operator<<(double x)             { char buf[32]; s_.append(buf, std::snprintf(buf, sizeof(buf), "%g", x)); return *this; }
+
+    std::string const& str() const        { return s_; }
+    void               str(char const* s) { s_ = s; } 
+
+   private:
+
+    std::string s_; 
+  };
+
+  //.............................................................................................
+
+  bool number(std::string_view s, double& x)
+  {
+#if defined(__cpp_lib_to_chars) && (__cpp_lib_to_chars >= 201611L)
+    if (s.size() && s[0] == '+') s.remove_prefix(1);  
+    auto r = std::from_chars(s.data(), s.data()+s.size(), x);
+    return (r.ec == std::errc()) && (r.ptr == s.data()+s.size());
+#else
+    char buf[64];
+    if (s.empty() || s.size() >= sizeof(buf)) return false; 
+    std::memcpy(buf, s.data(), s.size());
+    buf[s.size()] = 0;
+    char* e = 0;
+    x = std::strtod(buf, &e);
+    return e == buf+s.size();
+#endif
+  }
+
+} // namespace
+
+//|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int MadX::Tfs::parse(char const* begin, char const* end, std::string& err)
+{
+  params.clear();
+  columns.clear();
+  rows.clear();
+  rows.reserve(std::count(begin, end, '\n'));
+
+  std::vector<double Attributes::*> field; // by column; null when the column is not converted  
+
+  int         nc   = 0;   // number of columns
+  int         line = 0;
+  char const* eol  = begin;
+
+  for (char const* p = begin; p < end; p = eol + (eol < end) ) {
+
+    ++line;
+    eol = static_cast<char const*>(std::memchr(p, '\n', end-p));
+    if (!eol) eol = end;
+    
+    std::string_view t = token(p, eol);
+
+    if (t.empty() || t[0] == '#') continue;
+
+    if ( t == "@" ) {  // @ NAME FORMAT VALUE
+      std::string_view name = token(p, eol);
+      token(p, eol);  
+      params[std::string(name)] = unquote(token(p, eol));
+      continue;
+    }
+    
+    if ( t == "*" ) {  // column names
+      while ( (t = token(p, eol)).size() ) columns.emplace_back(t);
+      nc = columns.size();
+      field.assign(nc, nullptr);
+      for (int i=2; i<nc; ++i) {
+        for (auto const& attr : attributes) { if (columns[i] == attr.name) { field[i] = attr.field; break; } }
+      }
+      continue;
+    }
+
+    if ( t == "$" ) continue; // column formats  
+
+    if (nc < 2) {
+      err = "The column names (*) must precede the table rows and include the element label and type.";
+      return line;
+    }
+
+    Row row;
+    row.label = unquote(t);
+    int n = 1;
+    while ( (t = token(p, eol)).size() ) {
+      if (n == 1) { 
+        row.type = unquote(t);
+      }
+      else if ( n < nc && field[n] && !number(t, row.a.*field[n]) ) {
+        err = "Invalid value <" + std::string(t) + "> in column " + columns[n] + ".";
+        return line;
+      }
+      ++n;
+    }
+    if ( n != nc ) {
+      err = "Found " + std::to_string(n) + " values in a row of a table with " + std::to_string(nc) + " columns.";
+      return line;
+    }
+    if ( row.type.size() ) rows.push_back(row);
+  }
+  return 0;
+}
+
+//|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+double MadX::Tfs::param(char const* name, double dflt) const
+{
+  auto it = params.find(name);
+  double x;
+  return ( it != params.end() && number(it->second, x) ) ? x : dflt;
+}
+
+//|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+std::string MadX::Tfs::text(char const* name) const
+{
+  auto it = params.find(name);
+  return ( it != params.end() ) ? std::string(it->second) : std::string();
+}
+
+//|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void MadX::make_element( std::vector<std::string>& beamline, std::unordered_map<std::string, std::string>& element_dict,
+		   Row const& row, double brho)
+{
+  // ***WARNING***: brho in the arg above is expressed in T-m
+  // 1 T-m = 10 kG * 100 cm m = 1000 kG-cm 
+  // attributes[] are from MADX and they are expressed in MKS
+  // in MADX, the multipole coefficients are normalized w/r to brho. 
+  // in optim, the multipole coefficients are integrated field and field derivatives w/o normalization  
+
+  std::string      elabel(row.label);
+  std::string_view etype = row.type;
+  Attributes const& a    = row.a;
+
+  Text ss;
+
+  double  length   =   a.L*100;  // length in cm
+  double  leps     =   1.0e-4;              //  length in cm of "a thin element" (0 length in MADX) 
+  double  b        =  (a.ANGLE*brho)/a.L*10.0; // in kG
+  double  k0l      =   a.K0L  * brho * 1000.0;     // k0l is in kG-cm in OptiM and (K0L*brho) is in  T-m in MADX;  1 T-m = 10 kG * 100 cm = 1000 kG-cm
+  double  k1l      =   a.K1L  * brho * 10.0;       //  k1l is in kG in OptiM;  (K1L*brho) is in T in MADX;  1 T = 10 kG
+  double  k1sl     =   a.K1SL * brho * 10.0;
+  double  k2l      =   a.K2L  * brho * 10.0*10.0;  //  k2l is in kG/cm in OptiM;  (K2L*brho) is in T/m in MADX;  1 T = 10 kG
+  double  k2sl     =   a.K2SL * brho * 10.0*10.0;
+  double  anglerad =   a.ANGLE;  // bend angle in rad. 
+  double tilt      =   a.TILT * 180.0/pi;  // in degrees
+  double e1        =   a.E1;        // in rd;  optimx angle convention is reverse of MADX ecause +ve rotation direction in OptimX is inverse of MADX  
+  double e2        =   a.E2;        // in rd
+  double hgap      =   a.HGAP*100;  // half-gap in cm 
+  double fint      =   a.FINT;
+  double fintx     =   a.FINTX;
+  fintx            =   (fintx == 0.0) ? fint : fintx; // MADX manual says that if FINTX is undefined, FINTX=FINT (undefined FINTX is FINITX=0.0)  
+  double ksi       =   a.KSI;
+     
+  if (etype == "QUADRUPOLE") {
+    if ( element_dict.find("q"+elabel) == element_dict.end() )  {
+
+      // K1L and K1SL may both be defined. If so, we find the
+      // rotation angle for a normal quadrupole that provides
+      // both multipole coefficients in the right proportion.
+      // The normal quadrupole strength
+      // K1L is then adjusted so that K1L(new) = K1L(old)/cos(tilt). 
+      // Only K1L(new) is used thereafter.
+      
+      if ( (fabs(k1sl) > 1.0e-10) && fabs(k1l) < 1.0e-10) {
+        k1l  =  k1sl;
+	tilt = -45.0;
+      }
+      else if ( (fabs(k1sl) > 1.0e-10 && fabs(k1l) > 1.0e-10) ) {
+	tilt = 0.5*atan2(k1sl,k1l); 
+	k1l   /=  cos(tilt); 
+	tilt  *= -(180.0/pi); 
+      }
+      if (fabs(length) < leps) {
+        ss << " L[cm]="    << leps; // in cm 
+        ss << " G[kG/cm]=" <<  k1l/leps;  // K1*brho is in [T/m] = [10 kG / 100 cm] 
+        ss << " Tilt[deg]=" << tilt;
+      }
+      else {
+        ss << " L[cm]="     << length;     // in cm 
+        ss << " G[kG/cm]="  << k1l/length; // in kG/cm 
+        ss << " Tilt[deg]=" << tilt;
+      }	
+      element_dict.insert( { "q"+elabel, ss.str() } );
+    }
+    beamline.push_back( "q"+elabel); 
+  }
+  else if (etype == "DRIFT") {
+    if ( element_dict.find("o"+elabel) == element_dict.end() )  {
+      ss << " L[cm]=" << length;
+      element_dict.insert( { "o"+elabel, ss.str() } );
+    }
+    beamline.push_back( "o"+elabel); 
+  }
+    else if (etype == "MONITOR") {
+    if ( element_dict.find("o"+elabel) == element_dict.end() )  {
+      ss << " L[cm]=" << length;
+      element_dict.insert( { "o"+elabel, ss.str() } );
+    }
+    beamline.push_back( "o"+elabel); 
+  }
+  else if (etype == "HMONITOR") {
+    if ( element_dict.find("o"+elabel) == element_dict.end() )  {
+      ss << " L[cm]=" << length;
+      element_dict.insert( { "o"+elabel, ss.str() } );
+    }
+    beamline.push_back( "o"+elabel); 
+  }
+  else if (etype == "VMONITOR") {
+    if ( element_dict.find("o"+elabel) == element_dict.end() )  {
+      ss << " L[cm]=" << length;
+      element_dict.insert( { "o"+elabel, ss.str() } );
+    }
+    beamline.push_back( "o"+elabel); 
+  }
+  else if (etype == "YROTATION") {
+    if ( element_dict.find("o"+elabel) == element_dict.end() )  {
+      ss << " L[cm]=" << length;
+      element_dict.insert( { "o"+elabel, ss.str() } );
+    }
+    beamline.push_back( "o"+elabel); 
+  }
+  else if (etype == "PLACEHOLDER") {
+    if ( element_dict.find("i"+elabel) == element_dict.end() )  {
+      ss << " L[cm]=" << length;
+      element_dict.insert( { "i"+elabel, ss.str() } );
+    }
+    beamline.push_back( "i"+elabel); 
+  }
+  else if (etype == "INSTRUMENT") {
+    if ( element_dict.find("i"+elabel) == element_dict.end() )  {
+      ss << " L[cm]=" << length;
+      element_dict.insert( { "i"+elabel, ss.str() } );
+    }
+    beamline.push_back( "i"+elabel); 
+  }
+  else if (etype == "SBEND") {
+     std::string mnemonic = (fabs(k1l) > 0.0) ? "b" : "d"; // cf bend or dipole 
+     double g =  k1l/length;
+     if ( element_dict.find(mnemonic+elabel) == element_dict.end() )  {
+       ss << " L[cm]=" << length;          
+       ss << " B[kG]=" << b; 
+       if ( fabs(k1l) > 0.0) {
+	 ss << " G[kG/cm]=" << g;
+       }	   
+       ss << " Tilt[deg]=" << tilt; 
+       std::string s = ss.str(); 
+
+       double angleu =  e1;
+       double angled =  e2;
+
+       double  gap     = 2*hgap;
+       double  cn      = cos(angleu);
+       double  sn      = sin(angleu);
+       double  efflen  = fint*gap*(1.0+sn*sn)/(cn*cn*cn);   // upstream   edge effective length
+
+       ss.str("");
+       ss << " B[kG]=" << b;
+       ss << " Angle[deg]=" << angleu*180.0/pi;
+       ss << " EffLen[cm]=" << efflen;
+       ss << " T[deg]=" << tilt;
+       auto su = ss.str();
+
+       cn     = cos(angled);
+       sn     = sin(angled);
+       double efflenx = fintx*gap*(1.0+sn*sn)/(cn*cn*cn);    // downstream edge effective length
+
+       ss.str("");
+       ss << " B[kG]=" << b;
+       ss << " Angle[deg]=" << angled*180.0/pi;
+       ss << " EffLen[cm]=" << efflenx;
+       ss << " T[deg]=" << tilt;
+       auto sd = ss.str();
+       
+       element_dict.insert( { "gu"+ elabel, su } );
+       element_dict.insert( { mnemonic + elabel, s } );
+       element_dict.insert( { "gd"+ elabel, sd } );
+     }
+
+     beamline.push_back( "gu"+elabel); // upstream   edge 
+     beamline.push_back( mnemonic + elabel); 
+     beamline.push_back( "gd"+elabel); // downstream edge
+  }
+  else if (etype == "RBEND") {
+
+     double g =  k1l/length;
+     std::string mnemonic = (fabs(g) > 0.0) ? "b" : "d"; // cf bend or dipole 
+
+     if ( element_dict.find(mnemonic+elabel) == element_dict.end() )  {
+
+       ss << " L[cm]=" << length;           
+       ss << " B[kG]=" << b; 
+       if ( fabs(g) > 0.0) {
+	 ss << " G[kG/cm]=" << g;
+       }
+       ss << " Tilt[deg]=" << tilt;  
+       auto s = ss.str();
+
+       double angleu =  e1 + fabs(anglerad)/2; 
+       double angled =  e2 + fabs(anglerad)/2;
+
+       double gap    = 2*hgap;
+       double cn     = cos(angleu);
+       double sn     = sin(angleu);
+       double efflen = fint*gap*(1.0+sn*sn)/(cn*cn*cn);       // upstream edge effective length
+
+       ss.str("");
+       ss << " B[kG]=" << b;
+       ss << " Angle[deg]=" << angleu*180.0/pi;
+       ss << " EffLen[cm]=" << efflen;
+       ss << " T[deg]="     << tilt;
+       auto su = ss.str();
+
+       cn     = cos(angled);
+       sn     = sin(angled);
+       double efflenx = fintx*gap*(1.0+sn*sn)/(cn*cn*cn);       // downstream edge effective length
+ 
+       ss.str("");
+       ss << " B[kG]=" << b;
+       ss << " Angle[deg]=" << angled*180.0/pi;
+       ss << " EffLen[cm]=" << efflenx;
+       ss << " T[deg]=" << tilt;
+       auto sd = ss.str();
+
+       element_dict.insert( { "gu"+ elabel, su } );
+       element_dict.insert( { mnemonic + elabel, s  } );
+       element_dict.insert( { "gd"+ elabel, sd } );
+     }    
+
+     beamline.push_back( "gu"+ elabel); // upstream   edge 
+     beamline.push_back( mnemonic + elabel); 
+     beamline.push_back( "gd"+ elabel); // downstream edge
+  }
+  else if (etype == "MULTIPOLE") {
+     // we care only about 0th and first order (normal) for now ... 
+     bool has_k0 = (fabs(k0l)  > 0.0 ) ;        
+     bool has_k1 = (fabs(k1l)  > 0.0 ) ;        
+
+     if (has_k0) {  
+       if ( element_dict.find("m"+elabel+"_0") == element_dict.end() )  {
+         ss  << " m="             <<  0;          
+         ss  << " S[kG/cm^(m-1)=" <<  k0l;
+         ss  << " Tilt[deg]="     <<  tilt; 
+         element_dict.insert( { "m"+elabel+"_0", ss.str() } );
+	 ss.str("");
+       }
+       beamline.push_back( "m"+elabel+"_0"); 
+     }
+     if (has_k1) {
+       if ( element_dict.find("m"+elabel+"_1") == element_dict.end() )  {
+         ss  << " m="             <<    1;          
+         ss  << " S[kG/cm^(m-1)=" <<  k1l;
+         ss  << " Tilt[deg]="     << tilt; 
+         element_dict.insert( { "m"+elabel+"_1", ss.str() } );
+	 ss.str("");
+       }
+       beamline.push_back( "m"+elabel+"_1"); 
+     }
+  }
+  else if (etype == "SEXTUPOLE") {
+    if ( element_dict.find("s"+elabel) == element_dict.end() )  {
+      if ( (fabs(k2sl) > 0.0) && (fabs(k2l) < 1.0e-10) ) {
+  	  tilt = -30.0;
+      }
+      else if ( (fabs(k2sl) > 1.0e-10 && fabs(k2l) > 1.0e-10)) {
+	tilt = (1.0/3.0)*atan2(k2sl,k2l); 
+	k2l   /=  cos(tilt); 
+	tilt  *= -(180.0/pi); 
+      }
+
+      if (fabs(length) < leps) {
+         ss << " L[cm]="       << leps;          
+         ss << " S[kG/cm/cm]=" << k2l/leps;  // [kG/cm**2] 
+         ss << " Tilt[deg]="   << tilt; 
+      }
+      else {
+          ss << " L[cm]="        << length;       // in cm 
+          ss << " G[kG/cm/cm]="  << k2l/length;  // [kG/cm**2] 
+          ss << " Tilt[deg]="    << tilt;
+      }
+      element_dict.insert( { "s" + elabel, ss.str() } );
+    }
+    beamline.push_back( "s" + elabel); 
+  }
+  else if (etype == "KICKER") {
+    if ( element_dict.find("k"+elabel) == element_dict.end() )  {
+      double hkick = a.HKICK;
+      double vkick = a.VKICK;
+      //if (fabs(hkick) > 0.0 || fabs(vkick)>0.0) std::cout << elabel << " KICKER has finite kick " << std::endl;  
+      ss << " L[cm]="       << length;
+      if ( fabs(length) < 1.0e-6 ) length = 1.0e-6;
+      double  tmp = sqrt((hkick*hkick)+(vkick*vkick))*(brho/length)*1000.0;           
+      ss << " B[kg]="       << tmp;
+      double  ltilt = (fabs(hkick) > 1.0e-12 ) ? atan2(vkick,hkick) : pi/2;     
+      ss << " Tilt="        << tilt + ltilt*180/pi;          
+    }
+    element_dict.insert( { "k"+elabel, ss.str() } );
+    beamline.push_back( "k"+elabel); 
+  }
+  else if (etype == "HKICKER") {
+    if ( element_dict.find("k"+elabel) == element_dict.end() )  {
+      double hkick = a.HKICK;
+      //if (fabs(hkick) > 0.0 ) std::cout << elabel << " HKICKER has finite kick " << std::endl;  
+      ss << " L[cm]="       << length;          
+      if ( fabs(length) < 1.0e-6 ) length = 1.0e-6;
+      double  tmp = hkick*(brho/length)*1000.0;           
+      ss << " B[kG]="       << tmp;          
+      ss << " Tilt="        << 0.0 + tilt;          
+    }
+   element_dict.insert( { "k"+elabel, ss.str() } );
+   beamline.push_back( "k"+elabel); 
+  }
+  else if (etype == "VKICKER") {
+    if ( element_dict.find("k"+elabel) == element_dict.end() )  {
+     double vkick = a.VKICK;
+     //if (fabs(vkick) > 0.0 ) std::cout << elabel << " VKICKER has finite kick " << std::endl;  
+     ss << " L[cm]="       << length;          
+     if ( fabs(length) < 1.0e-6 ) length = 1.0e-6;
+     double  tmp = vkick*(brho/length)*1000.0;           
+     ss << " B[kG]="       << tmp;  // brho: T-m to kG-cm
+     ss << " Tilt[deg]="   << 90.0 + tilt; 
+     element_dict.insert( { "k"+elabel, ss.str() } );
+    }
+    beamline.push_back( "k"+elabel); 
+  }
+  else if (etype == "DIPEDGE") {
+    if ( element_dict.find("g"+elabel) == element_dict.end() )  {
+
+     double edgeang    = e1;
+     double hgap       = a.HGAP*100.0; // half-gap   
+     double oneoverrho = a.H1*0.01;  // 1/rho    
+     double cn         = cos(edgeang);
+     double sn         = sin(edgeang);
+     double efflen     = fint*2*hgap*(1.0+sn*sn)/(cn*cn*cn);  // edge effective length
+
+     ss << " B[kG]="       << (brho*1000.0*oneoverrho);  //  brho*1/rho = B;  brho: T-m to kG-cm
+     ss << " Angle[deg]="  << edgeang*180/pi;
+     ss << " L[cm]="       << efflen;          
+     ss << " Tilt[deg]="   << tilt; 
+     element_dict.insert( { "g"+elabel, ss.str() } );
+    }
+    beamline.push_back( "g"+elabel); 
+  }
+  else if (etype == "SOLENOID") {
+    if ( element_dict.find(std::string((fabs(length) < 1.0e-6) ? "cc" : "c") + elabel) == element_dict.end() )  {
+      if (fabs(length) < 1.0e-6) { // pseudo-solenoid ( focusing only) 
+	 ss << " L[cm]="       << 0.0;          
+         ss << " B[kG]="       << ksi*brho*1000.0;   // brho : T-m to kG-cm
+         ss << " a[cm]="       << 0.0; 
+         element_dict.insert( { "cc"+elabel, ss.str() } );
+      }
+      else {  
+         ss << " L[cm]="       << length;          
+         ss << " B[kG]="       << ksi*brho*1000.0/length; // brho : T-m to kG-cm
+         ss << " a[cm]="       << 0.0;
+         element_dict.insert( { "c"+elabel, ss.str() } );
+      }
+    }
+    (fabs(length) < 1.0e-6) ? beamline.push_back( "cc"+elabel) :  beamline.push_back( "c"+elabel); 
+  }
+  else if (etype == "MARKER") {
+    // we skip markers
+    //std::cout << "MARKER: " << elabel << std::endl;
+  }
+  else {
+     if (etype == "MARKER") {std::cout << "MARKER (converted to drift):  " << elabel << std::endl;}
+     if ( element_dict.find("o"+elabel) == element_dict.end() )  {
+        ss << " L[cm]="       << length;    
+        element_dict.insert( { "o"+elabel, ss.str() } );
+       }
+      beamline.push_back( "o"+elabel); 
+ }
+}
+
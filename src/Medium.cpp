@@ -39,7 +39,8 @@
 #include <Medium.h>
 #include <Beamline.h>
 #include <Utility.h>
-#include <Globals.h>
+#include <Landau.h>
+#include <RandomStream.h>
 #include <Constants.h>
 #include <Coordinates.h>
 #include <random>
@@ -54,20 +55,12 @@ using  Constants::E_SI; // elementary charge
 using  Constants::E_CGS;
 using  Constants::ME_kg;
 
-using  Utility::Landau;
 
 static const double pi = PI;
 static const double         me = 0.511006e6;    // electron rest mass [eV]
 static const double         mp = 938.2720813e6; // proton rest mass [eV]
 
 
-namespace {
-  std::random_device rd;  //Will be used to obtain a seed for the random number engine
-  std::mt19937 gen(rd() );
-  std::normal_distribution<double>       normal(0.0,1.0);  // normal distribution mean=0.0, sigma=1.0
-  std::uniform_real_distribution<double> uniform(0.0,1.0);  // uniform distribution mean=0.0, sigma=1.0
- }
-
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
@@ -134,7 +127,6 @@ Beamline* Medium::splitnew(int nslices) const  // return a sliced element as a b
 int  Medium::trackOnce( double ms,   double& Enr0,    int n_elem, int n_turn, TrackParam& prm, RMatrix const& m1, Coordinates& v) const
 {  
 
-  int i, j, k, i0;
   int ZZ    = N;			// relative charge of absorber madium
   double Dz = L_/100;		// length of the medium [m]
   double xx = v[0]/100;		        // initial x-position [m]
@@ -187,7 +179,7 @@ int  Medium::trackOnce( double ms,   double& Enr0,    int n_elem, int n_turn, Tr
   double eps1    = (1.-bet2)*PotIon*PotIon/(2.*pM*v0*v0)+bet2- 1.+CC;
   double xi0     = x*TanPhi*pi2*Dn*ZZ/(pM*v0*v0*AA);
 
-  i0 = 0;			// initialization for the random number generator
+  RandomStream rng(n_turn, n_elem, v.pid);  // per-particle stream: reproducible in parallel 
   double Eloss = 0;		// Energy loss
   
   for ( int j=0; j<Nl; ++j ){	// Loop over the material slices
@@ -202,27 +194,7 @@ int  Medium::trackOnce( double ms,   double& Enr0,    int n_elem, int n_turn, Tr
     //	Calculation for the energy loss distribution
     xi = xi0*z;
     double dd = xi*(log(xi)-eps1);
-    double Fmax = 0;
-    double Fi[100];
-    for ( int k=0; k<100; ++k){
-      double Del=0.9*E0*(1.+k/100.);
-      double lambda= (Del-dd)/xi;
-      Fi[k]=Landau(lambda);
-      if (Fmax < Fi[k]) Fmax = Fi[k];
-    }
-    double psi=xi*rand()*Fmax;      // ??     randm(i0)
-    int l;
-    bool left = rand() < 0.5;	// choose the left or right branch of the distribution   randm(i0)??
-    for (k=0;k<100;k++){
-      l = k;
-      if(  left && Fi[k]<psi && Fi[k+1]> psi) break;
-      if( !left && Fi[k]>psi && Fi[k+1]< psi) break;
-    }
-    if( l == 99){
-      //cout << '' Error in Energy loss calculation '' << endl;
-      return(3);   //   !!
-    }
-    Eloss += xi*l+dd;
+    Eloss += xi*Landau::quantile(rng.uniform()) + dd;  // Delta = xi*lambda + dd, lambda drawn from the tabulated inverse cdf 
     //	Check, if particle passed the absorber Element 
     if(x < x0){				// particle is lower than the wedge end
       x += (Dz-z)*tan(theta);
@@ -234,8 +206,8 @@ int  Medium::trackOnce( double ms,   double& Enr0,    int n_elem, int n_turn, Tr
     }
     //  Calculation the random angles theta1, phi1 in collision
     double Thet2= sqrt(Dlc*S);
-    double phi1 = rand()/pi2;          //   randm(i0)??
-    double xx = rand();             //   randm(i0)??
+    double phi1 = pi2*rng.uniform();   //  uniform azimuth  
+    double xx   = rng.uniform();
     double theta1;
 
     if(xx < xi)
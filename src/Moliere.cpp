@@ -44,6 +44,8 @@
 #include <iomanip>
 #include <Constants.h>
 #include <Moliere.h>
+#include <RandomStream.h>
+#include <Globals.h>
 #if __clang__
 #include <boost/math/special_functions/bessel.hpp>
 #else
@@ -59,7 +61,7 @@ using std::tr1::cyl_bessel_j;
 using Constants::PI;
 
 Moliere::Moliere(Moliere::Parameters const& data)
-  : generator_(),  rnorm_(0.0,1.0), rnd_(0.0, 1.0)
+  : generator_(GlobalState::generator)
 {
   Lc_       =  data.Lc;        // 3.2    
   theta0_   =  data.theta0;    // 3.585e-5;
@@ -68,49 +70,81 @@ Moliere::Moliere(Moliere::Parameters const& data)
   epsabs_    = 1.0e-8;  // integration absolute error 
   epsrel_    = 1.0e-6;  // integration relative error
   limit_     = 10000;   // maximum number of iteration allowed for integration   
-
-  workspace_ = gsl_integration_romberg_alloc(limit_);
 }
 
 // |||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 // |||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
 Moliere::~Moliere()
+{}
+
+// |||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+// |||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+
+Moliere::Fluctuation Moliere::operator()() const
 {
-  gsl_integration_romberg_free(workspace_);
+     // the distributions are local so that a single (shared) instance can be sampled
+     // concurrently; 4 normal deviates per call keeps the engine stream unchanged.
+
+     std::normal_distribution<double>        rnorm_(0.0, 1.0);
+     std::uniform_real_distribution<double>  rnd_(0.0, 1.0);
+
+     double z1 = rnorm_(generator_);
+     double z2 = rnorm_(generator_);
+     double z3 = rnorm_(generator_);
+     double z4 = rnorm_(generator_);
+     double u1 = rnd_(generator_);
+     double u2 = rnd_(generator_);
+
+     return fluctuation(z1, z2, z3, z4, u1, u2);
 }
 
 // |||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 // |||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
+Moliere::Fluctuation Moliere::operator()(RandomStream& rng) const
+{
+     double z1 = rng.normal();
+     double z2 = rng.normal();
+     double z3 = rng.normal();
+     double z4 = rng.normal();
+     double u1 = rng.uniform();
+     double u2 = rng.uniform();
+
+     return fluctuation(z1, z2, z3, z4, u1, u2);
+}
 
-Moliere::Fluctuation Moliere::operator()()
+// |||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+// |||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+Moliere::Fluctuation Moliere::fluctuation( double z1, double z2, double z3, double z4, double u1, double u2) const
 {
      static const double q      = 1.25; 
      static const double Theta0 = 1.0;
      
-     double z1    = (1.0-q/Lc_) * rnorm_(generator_); 
-     double z2    = (1-0-q/Lc_) * rnorm_(generator_); 
+     z1 *= (1.0-q/Lc_); 
+     z2 *= (1.0-q/Lc_); 
 
      double x     = z1*s_*theta0_/sqrt(12.0) + z2*s_*theta0_/sqrt(2);  
      double tx    = z2*theta0_; 
      //.......
 
-     z1    =  (1.0-q/Lc_)*rnorm_(generator_); 
-     z2    =  (1.0-q/Lc_)*rnorm_(generator_); 
+     z3 *= (1.0-q/Lc_); 
+     z4 *= (1.0-q/Lc_); 
 
-     double y     = z1*s_*theta0_/sqrt(12.0) + z2*s_*theta0_/sqrt(2);  
-     double ty    = z2*theta0_; 
+     double y     = z3*s_*theta0_/sqrt(12.0) + z4*s_*theta0_/sqrt(2);  
+     double ty    = z4*theta0_; 
 
      //.......................................................
      // large angle (single scattering) contribution
      // this contribution is significant only in the far tail
      //.......................................................
 
-     double z     = rnd_(generator_);
+     double z     = u1;
      double Theta  = Theta0/Lc_;
      double psi    = ( z > 1.0/((Theta*Theta)*Lc_) ) ? 0.0 : sqrt( 1.0/(Lc_*z) - (Theta*Theta) );
-     double alpha  = 2*PI*rnd_(generator_);
+     double alpha  = 2*PI*u2;
 
      double dtx    = theta0_*psi*cos(alpha); 
      double dty    = theta0_*psi*sin(alpha); 
@@ -131,10 +165,13 @@ Moliere::Fluctuation Moliere::operator()()
 // |||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 // |||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-Moliere::Distribution Moliere::operator()(int N) // random generation 
+Moliere::Distribution Moliere::operator()(int N) const // random generation 
 {
    static const double q      = 1.25;
    static const double Theta0 = 1.0;
+
+   std::normal_distribution<double>        rnorm_(0.0, 1.0);
+   std::uniform_real_distribution<double>  rnd_(0.0, 1.0);
  
    Distribution dist;
    dist.x.resize(N);
@@ -182,7 +219,7 @@ Moliere::Distribution Moliere::operator()(int N) // random generation
 // |||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 // |||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-double Moliere::pdf( double theta, double Lc)
+double Moliere::pdf( double theta, double Lc) const
 {
 
   // analytic probability density
@@ -200,7 +237,9 @@ double Moliere::pdf( double theta, double Lc)
   double result;   // integration result 
 
   size_t neval = 0; // number of eval performed if the integration fails
-  int status   = gsl_integration_romberg(&wrapper.gslf, epsabs_, 20.0, epsabs_, epsrel_, &result, &neval, workspace_);
+  gsl_integration_romberg_workspace* workspace = gsl_integration_romberg_alloc(limit_);
+  int status   = gsl_integration_romberg(&wrapper.gslf, epsabs_, 20.0, epsabs_, epsrel_, &result, &neval, workspace);
+  gsl_integration_romberg_free(workspace);
 
   return 1.0/(2*PI)*result;
 }
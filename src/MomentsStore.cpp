@@ -0,0 +1,352 @@
+//  =================================================================
+//
+//  MomentsStore.cpp
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+
+#include <MomentsStore.h>
+#include <BeamMoments.h>
+#include <Globals.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <complex>
+#include <map>
+#include <vector>
+
+#undef emit
+#include <sqlite/execute.hpp>
+#include <sqlite/command.hpp>
+#include <sqlite/query.hpp>
+#include <sqlite/private/private_accessor.hpp>
+#include <sqlite3.h>
+
+namespace {
+
+  // moments reduced over a block: covariance[21], uavg[6], umin[6], umax[6] (the order of 
+  // BeamMoments::dbScalarColumns()), eps[3], nlost 
+
+  int const nscalar = 43;
+
+  struct Block {
+    int                  first   = 0;     // first turn of the block
+    int                  n       = 0;     // no of samples 
+    double               pathlen = 0.0;
+    double               lo[nscalar];
+    double               sum[nscalar];
+    double               hi[nscalar];
+    std::complex<double> mode[3][6];      // eigenvectors of the last sample 
+  };
+
+  struct Store {
+    std::map<std::pair<int,int>, Block> blocks;   // (level, eidx) -> block in progress
+    bool attached = false;  // true when the archive db is attached as "arch"
+    int  oldest   = -1;     // oldest turn kept in main.Moments 
+  };
+
+  std::map<sqlite::connection const*, Store> stores;  // one per tracking db  
+
+  Store& store(sqlite::connection& con) { return stores[&con]; }
+
+  bool archAttached(sqlite::connection& con) 
+  {
+    return sqlite3_db_filename(sqlite::private_accessor::get_handle(con), "arch") != 0;
+  }
+
+  std::vector<unsigned char> blob(void const* data, int nbytes)
+  {
+    unsigned char const* p = static_cast<unsigned char const*>(data);
+    return std::vector<unsigned char>(p, p+nbytes);
+  }
+
+  void emitBlock(sqlite::connection& con, int level, int eidx, Block const& b)
+  {
+    static std::string sql = [] () {
+      std::string cols = "level, stat, turn, eidx, pathlen, umin, umax, uavg, covariance, mode1, mode2, mode3, eps1, eps2, eps3, nlost, n";
+      std::string vals = "?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?";
+      for (auto const& name : BeamMoments::dbScalarColumns()) {
+	cols += ", " + name;
+	vals += ", ?";
+      }
+      return "INSERT OR REPLACE INTO arch.MomentsRollup (" + cols + ") VALUES (" + vals + ");";
+    }();
+
+    sqlite::command insert(con, sql);  // a block is emitted every 16 turns at most; not worth caching 
+
+    double x[nscalar];
+
+    for (int stat=0; stat<3; ++stat) {
+      for (int i=0; i<nscalar; ++i) {
+	x[i] = (stat == 0) ? b.lo[i] : ( (stat == 1) ? b.sum[i]/b.n : b.hi[i] ); 
+      }
+      insert.clear();
+      insert % level % stat % b.first % eidx % b.pathlen
+	     % blob(&x[27], 6*sizeof(double)) % blob(&x[33], 6*sizeof(double)) % blob(&x[21], 6*sizeof(double))
+	     % blob(&x[0], 21*sizeof(double))
+	     % blob(b.mode[0], 6*sizeof(std::complex<double>)) % blob(b.mode[1], 6*sizeof(std::complex<double>))
+	     % blob(b.mode[2], 6*sizeof(std::complex<double>))
+	     % x[39] % x[40] % x[41] % x[42] % b.n;
+      for (int i=0; i<39; ++i) insert % x[i];
+      insert.emit();
+    }
+  }
+
+  // the exact state of the blocks in progress, so that a run resumed from a checkpoint completes them  
+
+  void saveBlocks(sqlite::connection& con, Store const& st)
+  {
+    sqlite::execute(con, "DELETE FROM arch.MomentsBlocks;", true);
+
+    sqlite::command insert(con, "INSERT INTO arch.MomentsBlocks (level, eidx, first, n, pathlen, lo, sum, hi, mode) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);");
+
+    for (auto const& it : st.blocks) {
+      Block const& b = it.second;
+      if (b.n == 0) continue;
+      insert.clear();
+      insert % it.first.first % it.first.second % b.first % b.n % b.pathlen
+             % blob(b.lo, sizeof(b.lo)) % blob(b.sum, sizeof(b.sum)) % blob(b.hi, sizeof(b.hi)) % blob(b.mode, sizeof(b.mode));
+      insert.emit();
+    }
+  }
+
+} // namespace
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void MomentsStore::init(sqlite::connection& con)
+{
+  // must be called outside of a transaction; main.Moments must exist. 
+
+  Store& st = store(con);
+  st.blocks.clear();
+  st.oldest   = -1;
+  st.attached = archAttached(con);  // a new connection may reuse the address of a closed one 
+
+  if (!st.attached) {
+    std::string name;
+    for (char c : Globals::preferences().moments_archive) {
+      name += c;
+      if (c == '\'') name += c;
+    }
+    try {
+      sqlite::execute(con, "ATTACH DATABASE '" + name + "' AS arch;", true);
+      st.attached = true;
+    }
+    catch (std::exception const&) {
+      auto optimx_logger = spdlog::get("optimx_logger");
+      SPDLOG_LOGGER_WARN( optimx_logger, fmt::format("Cannot attach the moments archive \"{:s}\"; all turns are kept in memory.",
+						     Globals::preferences().moments_archive) );
+      sqlite::execute(con, "CREATE TEMP VIEW IF NOT EXISTS MomentsAll AS SELECT * FROM main.Moments;", true);
+      return;
+    }
+  }
+
+  // recreated, so that a persistent archive written with an older layout is not reused    
+
+  sqlite::execute(con, "DROP TABLE IF EXISTS arch.Moments;", true);
+  sqlite::execute(con, "DROP TABLE IF EXISTS arch.MomentsRollup;", true);
+  sqlite::execute(con, "DROP TABLE IF EXISTS arch.MomentsBlocks;", true);
+  sqlite::execute(con, "CREATE TABLE arch.Moments AS SELECT * FROM main.Moments WHERE 0;", true);
+  sqlite::execute(con, "CREATE INDEX arch.MomentsEidx ON Moments (eidx, turn);", true);
+
+  std::string cmd = "CREATE TABLE arch.MomentsRollup ("
+    "level      INTEGER NOT NULL, "
+    "stat       INTEGER NOT NULL, "
+    "turn       INTEGER NOT NULL, "
+    "eidx       INTEGER NOT NULL, "
+    "pathlen    REAL NOT NULL, "
+    "umin       BLOB NOT NULL, "
+    "umax       BLOB NOT NULL, "
+    "uavg       BLOB NOT NULL, "
+    "covariance BLOB NOT NULL, "
+    "mode1      BLOB NOT NULL, "
+    "mode2      BLOB NOT NULL, "
+    "mode3      BLOB NOT NULL, "
+    "eps1       REAL NOT NULL, "
+    "eps2       REAL NOT NULL, "
+    "eps3       REAL NOT NULL, "
+    "nlost      REAL NOT NULL, "
+    "n          INTEGER NOT NULL, ";
+
+  for (auto const& name : BeamMoments::dbScalarColumns()) cmd += name + " REAL, ";
+  cmd += "PRIMARY KEY (level, stat, eidx, turn));";
+
+  sqlite::execute(con, cmd, true);
+  sqlite::execute(con, "CREATE TABLE arch.MomentsBlocks (level INTEGER NOT NULL, eidx INTEGER NOT NULL, first INTEGER NOT NULL, n INTEGER NOT NULL, "
+                       "pathlen REAL NOT NULL, lo BLOB NOT NULL, sum BLOB NOT NULL, hi BLOB NOT NULL, mode BLOB NOT NULL, PRIMARY KEY (level, eidx));", true);
+  sqlite::execute(con, "CREATE TEMP VIEW IF NOT EXISTS MomentsAll AS SELECT * FROM main.Moments UNION ALL SELECT * FROM arch.Moments;", true);
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void MomentsStore::record(sqlite::connection& con, BeamMoments const& m, int turn, int eidx)
+{
+  Store& st = store(con);
+  if (!st.attached) return;
+
+  double x[nscalar];
+
+  double const* cov = &m.cov[0][0];
+  std::copy(cov, cov+21,      &x[0]);
+  std::copy(m.uavg, m.uavg+6, &x[21]);
+  std::copy(m.umin, m.umin+6, &x[27]);
+  std::copy(m.umax, m.umax+6, &x[33]);
+  std::copy(m.eps,  m.eps+3,  &x[39]);
+  x[42] = m.nlost;
+
+  // rollups 
+
+  int size = 1;
+  for (int level=1; level<=maxlevel; ++level) {
+    size *= factor;
+    int first = turn - turn%size;
+
+    Block& b = st.blocks[{level, eidx}];
+    if (b.n > 0 && b.first != first) {
+      emitBlock(con, level, eidx, b);
+      b.n = 0;
+    }
+    if (b.n == 0) {
+      b.first = first;
+      std::copy(x, x+nscalar, b.lo);
+      std::copy(x, x+nscalar, b.hi);
+      std::fill(b.sum, b.sum+nscalar, 0.0);
+    }
+    for (int i=0; i<nscalar; ++i) {
+      b.lo[i]   = std::min(b.lo[i], x[i]);
+      b.hi[i]   = std::max(b.hi[i], x[i]);
+      b.sum[i] += x[i];
+    }
+    std::copy(m.mode1, m.mode1+6, b.mode[0]);
+    std::copy(m.mode2, m.mode2+6, b.mode[1]);
+    std::copy(m.mode3, m.mode3+6, b.mode[2]);
+    b.pathlen = m.s;
+    ++b.n;
+  }
+
+  // spill the turns older than the window to the archive; done in batches of window/4 turns 
+  
+  int window = Globals::preferences().moments_window;
+
+  if (st.oldest < 0) st.oldest = turn;
+  if (window == 0 || (turn - st.oldest) < window + window/4) return;
+
+  std::string t = std::to_string(turn - window + 1);
+  sqlite::execute(con, "INSERT INTO arch.Moments SELECT * FROM main.Moments WHERE turn < " + t + ";", true);
+  sqlite::execute(con, "DELETE FROM main.Moments WHERE turn < " + t + ";", true);
+  st.oldest = turn - window + 1;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void MomentsStore::flush(sqlite::connection& con)
+{
+  Store& st = store(con);
+  if (!st.attached) return;
+
+  for (auto const& it : st.blocks) {
+    if (it.second.n > 0) emitBlock(con, it.first.first, it.first.second, it.second);
+  }
+  saveBlocks(con, st);
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void MomentsStore::restore(sqlite::connection& con, std::string const& schema)
+{
+  Store& st = store(con);
+  if (!st.attached) return;
+
+  st.blocks.clear();
+  st.oldest = -1;
+
+  sqlite::query q(con, "SELECT level, eidx, first, n, pathlen, lo, sum, hi, mode FROM " + schema + ".MomentsBlocks;");
+  auto res = q.emit_result();
+
+  std::vector<unsigned char> vec;
+
+  auto get = [&res, &vec](int col, void* data, int nbytes) {
+    res->get_binary(col, vec);
+    if (int(vec.size()) != nbytes) return false;
+    std::copy(vec.begin(), vec.end(), static_cast<unsigned char*>(data));
+    return true;
+  };
+
+  while (res->next_row()) {
+    Block b;
+    b.first   = res->get_int(2);
+    b.n       = res->get_int(3);
+    b.pathlen = res->get_double(4);
+    if ( get(5, b.lo, sizeof(b.lo)) && get(6, b.sum, sizeof(b.sum)) && get(7, b.hi, sizeof(b.hi)) && get(8, b.mode, sizeof(b.mode)) ) {
+      st.blocks[{res->get_int(0), res->get_int(1)}] = b;
+    }
+  }
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void MomentsStore::plotView(sqlite::connection& con, int stat, int maxpoints)
+{
+  std::string source = "MomentsAll";
+
+  if (store(con).attached) {
+
+    flush(con);
+
+    int nturns = 0;
+    { sqlite::query q(con, "SELECT max(turn) FROM main.Moments;");
+      auto res = q.emit_result();
+      nturns = res->get_int(0) + 1;
+    }
+
+    if (nturns > maxpoints) {
+      int level = 1;
+      int size  = factor;
+      while ( (level < maxlevel) && (nturns/size > maxpoints) ) {
+	++level;
+	size *= factor;
+      }
+      source = "arch.MomentsRollup WHERE level=" + std::to_string(level) + " AND stat=" + std::to_string(stat);
+    }
+  }
+
+  sqlite::execute(con, "DROP VIEW IF EXISTS temp.MomentsPlot;", true);
+  sqlite::execute(con, "CREATE TEMP VIEW MomentsPlot AS SELECT * FROM " + source + ";", true);
+}
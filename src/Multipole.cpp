@@ -41,10 +41,71 @@
 #include <Constants.h>
 #include <Coordinates.h>
 #include <TrackParam.h>
+#include <Tpsa.h>
+#include <cmath>
+#include <limits>
 
 using Constants::PI;
 using Constants::C_DERV1;
 
+namespace {
+
+  template <typename T>
+  void multipoleKick( Element const* el, T const& hr, T* v)
+  {
+    // thin multipole kick for map extraction (T = Tpsa). r^m cos(m theta) and r^m sin(m theta)
+    // are the real and imaginary parts of (x+iy)^m; they are obtained by recursion, which remains 
+    // well defined (and polynomial) about r = 0. Tracking (multipole_trans) keeps the polar form.    
+
+    using std::sqrt;
+
+    int m = el->N;
+
+    if (m == 0) return;	
+
+    double factor = 1.0;
+
+    if (m < 0) {  // radial focusing: kick ~ r^(m-1) (x,y) 
+      m = -m;
+      for (int i=2; i<=m; ++i) factor *= i;
+      T r2 = v[0]*v[0] + v[2]*v[2];
+      T rm = 1.0;
+      for (int i=1; i+1<m; i+=2) rm *= r2;
+      if ((m-1)%2) rm *= sqrt(r2);
+      T a = el->S*rm/factor/hr;
+      v[1] -= a*v[0];
+      v[3] -= a*v[2];
+      return;
+    }
+
+    double alfa = el->tilt()*PI/180.;
+    double s    = sin(alfa);
+    double c    = cos(alfa);
+
+    T x  =  c*v[0] + s*v[2];  // tilted frame  
+    T y  = -s*v[0] + c*v[2];
+    T xp =  c*v[1] + s*v[3];
+    T yp = -s*v[1] + c*v[3];
+
+    T re = x;
+    T im = y;
+    for (int i=2; i<=m; ++i) {
+      T t = re*x - im*y;
+      im  = re*y + im*x;
+      re  = t;
+      factor *= i;
+    }
+
+    T a = el->S/factor/hr;
+    xp -= a*re;
+    yp += a*im;
+
+    v[1] = c*xp - s*yp;
+    v[3] = s*xp + c*yp;
+  }
+
+} // namespace
+
 Multipole::Multipole(const char* nm, char const* fnm) // 'M'
   : Element(nm,fnm)
 {}  
@@ -185,6 +246,65 @@ int Multipole::trackOnce( double ms,   double& Enr0, int n_elem, int n_turn, Tra
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
+int Multipole::trackTangent( double ms,   double& Enr0, int n_elem, int n_turn, TrackParam& prm,
+       		             RMatrix const& m1, Coordinates& v, RMatrix& jac) const
+{
+  // same as trackOnce. The multipole is a thin kick: its Jacobian is obtained 
+  // by central differences, at the cost of a few kick evaluations. 
+
+  double const h = 1.0e-7; 
+
+  Coordinates v0 = v;
+
+  int status = 0; 
+  if ( (status = trackOnce(ms, Enr0, n_elem, n_turn, prm, m1, v)) ) return status;
+
+  RMatrix mk;
+  mk.toUnity();
+
+  for (int j=0; j<6; ++j) {
+    if (j==4) continue; // the kick does not depend on the longitudinal position 
+    Coordinates vp = v0;
+    Coordinates vm = v0;
+    double enr = Enr0;
+    vp[j] += h;
+    vm[j] -= h;
+    if ( (status = trackOnce(ms, enr, n_elem, n_turn, prm, m1, vp)) ) { v = vp; return status; }
+    if ( (status = trackOnce(ms, enr, n_elem, n_turn, prm, m1, vm)) ) { v = vm; return status; }
+    for (int i=0; i<4; ++i) mk[i][j] = (vp[i] - vm[i])/(2.0*h);
+  }
+
+  jac = mk * jac;
+
+  return 0;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int Multipole::trackMap( double ms, double& Enr0, int n_elem, TrackParam& prm,
+		         RMatrix const& m1, Tpsa* u) const
+{
+  // the kick of multipole_trans(), in polynomial form, with Tpsa coordinates 
+
+  if (N == 0) {
+    u[1] += S * cos(T_ / 180. * PI) / prm.Hr0 * u[5];
+    u[3] += S * sin(T_ / 180. * PI) / prm.Hr0 * u[5];
+    return 0;
+  }
+
+  // an odd power of r is not analytic about r = 0 
+
+  if ( (N < 0) && (N%2 == 0) && (u[0].value() == 0.0) && (u[2].value() == 0.0) ) return 2; 
+
+  Tpsa hr = prm.Hr0/(1.+u[5]);
+  multipoleKick(this, hr, u);
+  return 0;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
 Beamline* Multipole::splitnew(int nslices) const  // return a sliced element as a beamline 
 {
  // Multipole cannot be split so we return a cloned element with slices_ = 1. 
@@ -390,7 +510,7 @@ RMatrix  Multipole::rmatrix( RMatrix_t<3>& frame, double& energy, double ms, int
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-// el->G - order of multipole; el->S - multipole strength;  el->T - tilt
+// el->N - order of multipole; el->S - multipole strength;  el->T - tilt
 void Multipole::multipole_trans(Element const* el, double hr, Coordinates* vp, Coordinates const* v)
 {
 
@@ -0,0 +1,185 @@
+//  =================================================================
+//
+//  OffMomentum.cpp
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+
+#include <Constants.h>
+#include <ClosedOrbit.h>
+#include <OptimMainWindow.h>
+#include <OptimCalc.h>
+#include <Element.h>
+#include <RMatrix.h>
+#include <Twiss.h>
+#include <Globals.h>
+
+#include <cmath>
+#include <complex>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using Constants::PI;
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+std::vector<std::shared_ptr<Element>> OptimMainWindow::deterministicLine() const
+{
+  // A private copy of the beamline (see clonedLine()) in which the scattering elements are
+  // replaced by drifts of the same length. Tracking through it draws no random numbers and
+  // modifies no element shared with the beamline or with another copy. 
+
+  auto line = clonedLine();
+
+  for (auto& ep : line) {
+    switch (ep->etype()) {
+      case 'T':   // scattering
+      case 'U': 
+      case 'V': 
+      case 'J': {
+        std::string name = std::string("O") + ep->name();
+        auto drift = std::shared_ptr<Element>(Element::makeElement(name.c_str()));
+        drift->length(ep->length());
+        ep = drift;
+        break;
+      }
+      default:
+        break;
+    }
+  }
+  return line;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int OptimMainWindow::offMomentumMap(std::vector<std::shared_ptr<Element>> const& line, double dpp, Coordinates& co, RMatrix& tm) const
+{
+  //-------------------------------------------------------------------------------------------
+  // One-turn map of line (the analyzed beamline or a copy of it, see deterministicLine()) for a
+  // particle with momentum offset dpp, linearized about the 4D closed orbit at that momentum.
+  // Nothing is re-parsed: the orbit is closed by tracking and the map is the derivative of the
+  // tracking map, so that the chromatic terms of all elements are included. The line must be
+  // the one analyzed on the design orbit. 
+  // Returns 0, 1 if the orbit cannot be closed or 2 if a particle is lost. 
+  // Concurrent calls must use distinct copies of the line. 
+  //-------------------------------------------------------------------------------------------
+
+  for (int i=0; i<6; ++i) co[i] = 0.0;
+  co[5] = dpp;
+
+  ClosedOrbit closure;
+  closure.maxIterations(Ncvg);
+  closure.tolerance(CvgErr);
+
+  if ( closure(line, ms, Ein, tetaYo0_, co) ) return 1;
+  if ( ClosedOrbit::jacobian(line, ms, Ein, tetaYo0_, co, tm) ) return 2;
+
+  return 0;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int OptimMainWindow::offMomentumTunes( std::vector<double> const& dpp, std::vector<double>& nu1, std::vector<double>& nu2,
+                                       std::vector<Twiss4D>* v) const
+{
+  //-------------------------------------------------------------------------------------------
+  // 4D tunes and, optionally, the lattice functions at the start of the beamline for each
+  // momentum offset in dpp. The samples are independent and are evaluated in parallel, each
+  // thread on its own copy of the beamline, without the scattering elements.
+  // When dpp is sorted, the mode labels of nu1 and nu2 are exchanged where needed to keep the
+  // tunes continuous in dpp (the lattice functions keep the ordering of the eigensolver).
+  // Returns 0, or the (1-based) index of the first sample for which the optics cannot be found.
+  //-------------------------------------------------------------------------------------------
+
+  int n = dpp.size();
+
+  nu1.resize(n);
+  nu2.resize(n);
+  if (v) v->resize(n);
+
+  std::vector<int> status(n, 0);
+  bool parallel = Globals::preferences().parallel_tracking;
+
+#pragma omp parallel if(parallel)
+  {
+    auto line = deterministicLine();
+
+#pragma omp for schedule(dynamic)
+    for (int k=0; k<n; ++k) {
+
+      Coordinates co;
+      RMatrix     tm;
+      std::complex<double> lambda[4], ev[4][4];
+
+      if ( offMomentumMap(line, dpp[k], co, tm) || RMatrix_t<4,double>(tm).findEigenValues(lambda, ev) ) {
+        status[k] = 1;
+        continue;
+      }
+
+      nu1[k] = -std::arg(lambda[0])/(2*PI);
+      nu2[k] = -std::arg(lambda[2])/(2*PI);
+
+      while (nu1[k] < 0.0) ++nu1[k];
+      while (nu2[k] < 0.0) ++nu2[k];
+
+      if (v) {
+        char err[256];
+        (*v)[k].betatronFromEV(ev);
+        getDisp4D(tm, (*v)[k], err);
+      }
+    }
+  }
+
+  for (int k=0; k<n; ++k) {
+    if (status[k]) return k+1;
+  }
+
+  // attempt to identify modes
+
+  for (int k=1; k<n; ++k) {
+    double d1  = fabs(nu1[k]-nu1[k-1]);
+    double d2  = fabs(nu2[k]-nu2[k-1]);
+    double d1s = fabs(nu2[k]-nu1[k-1]);
+    double d2s = fabs(nu1[k]-nu2[k-1]);
+    if ( (d1 > d1s) && (d2 > d2s) ) std::swap(nu1[k], nu2[k]);
+  }
+
+  return 0;
+}
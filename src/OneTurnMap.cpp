@@ -0,0 +1,358 @@
+//  =================================================================
+//
+//  OneTurnMap.cpp
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+#include <OneTurnMap.h>
+#include <Element.h>
+#include <TrackParam.h>
+#include <RMatrix.h>
+#include <array>
+#include <cmath>
+#include <map>
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+OneTurnMap::OneTurnMap()
+  : order_(0), nmon_(0), failed_(-1), p0_{0.0, 0.0}, P0_{0.0, 0.0}
+{}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+OneTurnMap::Status OneTurnMap::extract( std::vector<std::shared_ptr<Element>> const& line, double ms, double Enr, double tetaY,
+                                        Coordinates const& v0, int order )
+{
+  // The element loop is the same as in ClosedOrbit::track(), with Element::trackMap()
+  // in place of Element::trackOnce().  
+
+  int saved = Tpsa::order();
+  Tpsa::order(order);
+
+  order_  = Tpsa::order();
+  nmon_   = Tpsa::size();
+  failed_ = -1;
+  v0_     = v0;
+  gf_.clear();
+
+  std::vector<Tpsa> u(6);
+  for (int i=0; i<6; ++i) u[i] = Tpsa::variable(v0[i], i);
+
+  RMatrix    me;
+  TrackParam prm;
+  Status     status = ok;
+
+  for (int i=0; i<int(line.size()); ++i) {
+
+    auto const& ep = line[i];
+    double EnrNew = Enr;
+
+    ep->preTrack(ms, Enr, tetaY, i, prm, me);
+
+    int st = ep->trackMap(ms, EnrNew, i, prm, me, u.data());
+    if (st) {
+      failed_ = i;
+      status  = (st == 1) ? lost : unsupported;
+      break;
+    }
+
+    ep->rmatrix(Enr, ms, tetaY, 0.0, 3);  // advance energy and frame angle along the reference orbit 
+  }
+
+  for (int i=0; (status == ok) && (i<6); ++i) {
+    for (int k=0; k<nmon_; ++k) {
+      if (!std::isfinite(u[i][k])) { status = lost; break; }
+    }
+  }
+
+  if (status == ok) {
+    map_ = u;
+    pack(map_.data(), 6, coef_);
+    parent_.resize(nmon_);
+    var_.resize(nmon_);
+    for (int k=0; k<nmon_; ++k) {
+      parent_[k] = Tpsa::parent(k);
+      var_[k]    = Tpsa::var(k);
+    }
+  }
+  else {
+    map_.clear();
+    coef_.clear();
+  }
+
+  Tpsa::order(saved);
+  return status;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+OneTurnMap::Status OneTurnMap::symplectify()
+{
+  // F2(q,P; dp/p) such that p = dF2/dq, Q = dF2/dP. 
+  //
+  // 1. change to canonical variables: x' = p/(1+dp/p) on input, P = (1+dp/p) X' on output
+  // 2. partial inversion: solve P(q,p) for p(q,P), by fixed point iteration on the
+  //    nonlinear part (one order is gained per iteration)
+  // 3. the field G = (p(q,P), Q(q,P)) is a gradient if the map is symplectic. F2 is its
+  //    integral along the ray from the origin, which picks a factor 1/(k+1) for a term 
+  //    of degree k in (q,P). The gradient of F2 is exactly a gradient field, and it agrees
+  //    with G to the order of the map.        
+
+  if (map_.empty()) return unsupported;
+
+  int saved = Tpsa::order();
+  Tpsa::order(order_);
+
+  double e0  = 1.0 + v0_[5];
+  p0_[0] = e0*v0_[1];
+  p0_[1] = e0*v0_[3];
+
+  // 1. canonical map; the variables are the deviations (dq_x, dp_x, dq_y, dp_y, ds, d(dp/p)) 
+
+  Tpsa den = Tpsa::variable(e0, 5);
+
+  Tpsa g[6];
+  for (int i=0; i<6; ++i) g[i] = Tpsa::variable(0.0, i);
+  g[1] = Tpsa::variable(p0_[0], 1)/den - v0_[1];
+  g[3] = Tpsa::variable(p0_[1], 3)/den - v0_[3];
+
+  Tpsa c[6];
+  Tpsa::compose(map_.data(), 6, g, c);
+  c[1] *= den;
+  c[3] *= den;
+
+  Status status = ok;
+
+  Tpsa dd = c[5] - Tpsa::variable(v0_[5], 5);   // dp/p must be conserved 
+  for (int k=0; k<nmon_; ++k) {
+    if (std::fabs(dd[k]) > 1.0e-12) { status = unsupported; break; }
+  }
+
+  // 2. partial inversion. The variables are now (dq_x, dP_x, dq_y, dP_y, ds, d(dp/p)) 
+
+  P0_[0] = c[1].value();
+  P0_[1] = c[3].value();
+
+  double a[2][2] = { { c[1][2], c[1][4] },
+                     { c[3][2], c[3][4] } };   // dP/dp  
+
+  double det = a[0][0]*a[1][1] - a[0][1]*a[1][0];
+  double nrm = std::fabs(a[0][0]) + std::fabs(a[0][1]) + std::fabs(a[1][0]) + std::fabs(a[1][1]);
+
+  if ( (status == ok) && !(std::fabs(det) > 1.0e-12*nrm*nrm) ) status = singular;
+
+  if (status != ok) { 
+    Tpsa::order(saved);
+    return status;
+  }
+
+  double ai[2][2] = { {  a[1][1]/det, -a[0][1]/det },
+                      { -a[1][0]/det,  a[0][0]/det } };
+
+  Tpsa n[2] = { c[1], c[3] };   // nonlinear part of P - P0, in terms of p    
+  for (int j=0; j<2; ++j) {
+    n[j][0] = 0.0;
+    n[j][2] = 0.0;
+    n[j][4] = 0.0;
+  }
+
+  Tpsa h[6];
+  for (int i=0; i<6; ++i) h[i] = Tpsa::variable(0.0, i);
+
+  Tpsa dP[2] = { h[1], h[3] };
+  Tpsa dp[2];
+
+  for (int it=0; it<=order_; ++it) {
+    h[1] = dp[0];
+    h[3] = dp[1];
+    Tpsa r[2];
+    Tpsa::compose(n, 2, h, r);
+    Tpsa t0 = dP[0] - r[0];
+    Tpsa t1 = dP[1] - r[1];
+    dp[0] = ai[0][0]*t0 + ai[0][1]*t1;
+    dp[1] = ai[1][0]*t0 + ai[1][1]*t1;
+  }
+  h[1] = dp[0];
+  h[3] = dp[1];
+
+  Tpsa cq[2] = { c[0], c[2] };
+  Tpsa q[2];
+  Tpsa::compose(cq, 2, h, q);
+
+  // 3. generating function. Only (q,P) are integrated over; ds and d(dp/p) are parameters.   
+
+  Tpsa G[4] = { dp[0] + p0_[0], q[0], dp[1] + p0_[1], q[1] };
+
+  std::map<Tpsa::Exponents,double> F;
+
+  for (int i=0; i<4; ++i) {
+    for (int k=0; k<nmon_; ++k) {
+      if (G[i][k] == 0.0) continue;
+      Tpsa::Exponents e;
+      for (int v=0; v<6; ++v) e[v] = Tpsa::exponent(k,v);
+      int d = e[0] + e[1] + e[2] + e[3];
+      ++e[i];
+      F[e] += G[i][k]/(d+1);
+    }
+  }
+
+  Tpsa grad[4];
+
+  for (auto const& f : F) {
+    for (int j=0; j<4; ++j) {
+      if (f.first[j] == 0) continue;
+      Tpsa::Exponents e = f.first;
+      --e[j];
+      grad[j][Tpsa::index(e)] += f.first[j]*f.second;
+    }
+  }
+
+  Tpsa gf[8] = { grad[0], grad[1], grad[2], grad[3],
+                 grad[0].deriv(1), grad[0].deriv(3), grad[2].deriv(1), grad[2].deriv(3) };
+
+  pack(gf, 8, gf_);
+
+  Tpsa::order(saved);
+  return ok;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int OneTurnMap::track( Coordinates& v ) const
+{
+  if (coef_.empty()) return 1;
+
+  std::array<double,Tpsa::nmax> m;
+  double d[6];
+  double w[6];
+
+  for (int i=0; i<6; ++i) d[i] = v[i] - v0_[i];
+
+  monomials(d, m.data());
+  for (int i=0; i<6; ++i) w[i] = dot(coef_, i, m.data());
+
+  if (!gf_.empty()) {
+
+    // solve p = dF2/dq (q,P) for P by Newton iterations, starting from the 
+    // truncated map, then Q = dF2/dP (q,P). s and dp/p are from the map.     
+
+    double e  = 1.0 + v[5];
+    double px = e*v[1];
+    double py = e*v[3];
+
+    double z[6] = { d[0], e*w[1] - P0_[0], d[2], e*w[3] - P0_[1], d[4], d[5] };
+
+    bool converged = false;
+
+    for (int it=0; it<20; ++it) {
+
+      monomials(z, m.data());
+
+      double r0  = dot(gf_, 0, m.data()) - px;
+      double r1  = dot(gf_, 2, m.data()) - py;
+      double a00 = dot(gf_, 4, m.data());
+      double a01 = dot(gf_, 5, m.data());
+      double a10 = dot(gf_, 6, m.data());
+      double a11 = dot(gf_, 7, m.data());
+
+      double det = a00*a11 - a01*a10;
+      if (det == 0.0) return 1;
+
+      double dz1 = ( a11*r0 - a01*r1)/det;
+      double dz3 = (-a10*r0 + a00*r1)/det;
+
+      z[1] -= dz1;
+      z[3] -= dz3;
+
+      if ( std::fabs(dz1) + std::fabs(dz3) <= 1.0e-15*(std::fabs(P0_[0] + z[1]) + std::fabs(P0_[1] + z[3]) + 1.0e-10) ) {
+        converged = true;
+        break;
+      }
+    }
+
+    if (!converged) return 1;
+
+    monomials(z, m.data());
+
+    double ef = 1.0 + w[5];
+    w[0] = dot(gf_, 1, m.data());
+    w[2] = dot(gf_, 3, m.data());
+    w[1] = (P0_[0] + z[1])/ef;
+    w[3] = (P0_[1] + z[3])/ef;
+  }
+
+  for (int i=0; i<6; ++i) {
+    if (!std::isfinite(w[i])) return 1;
+  }
+
+  for (int i=0; i<6; ++i) v[i] = w[i];
+
+  return 0;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void OneTurnMap::pack( Tpsa const* f, int nf, std::vector<double>& coef ) const
+{
+  coef.resize(nf*nmon_);
+  for (int i=0; i<nf; ++i) {
+    for (int k=0; k<nmon_; ++k) coef[i*nmon_+k] = f[i][k];
+  }
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void OneTurnMap::monomials( double const* x, double* m ) const
+{
+  m[0] = 1.0;
+  for (int k=1; k<nmon_; ++k) m[k] = m[parent_[k]]*x[var_[k]];
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+double OneTurnMap::dot( std::vector<double> const& coef, int i, double const* m ) const
+{
+  double const* c = &coef[i*nmon_];
+  double s = 0.0;
+  for (int k=0; k<nmon_; ++k) s += c[k]*m[k];
+  return s;
+}
@@ -109,6 +109,8 @@ void OptimApp::restorePreferences()
   p.rng_seed                = settings.value("rng_seed",                p.rng_seed).toUInt();
   p.use_set_rng_seed        = settings.value("use_set_rng_seed",        p.use_set_rng_seed).toBool();
   p.parallel_tracking       = settings.value("parallel_tracking",       p.parallel_tracking).toBool();
+  p.moments_archive         = settings.value("moments_archive",         QString::fromStdString(p.moments_archive)).toString().toStdString();
+  p.moments_window          = settings.value("moments_window",          p.moments_window).toUInt();
   settings.endGroup();
 
   Element::fringe_on = Globals::preferences().fringe_effects_on; // !!! FIX ME !!! element constructor (e.g. quad)
@@ -184,6 +186,8 @@ void OptimApp::savePreferences()
   settings.setValue("rng_seed",                p.rng_seed);
   settings.setValue("use_set_rng_seed",        p.use_set_rng_seed);
   settings.setValue("parallel_tracking",       p.parallel_tracking);
+  settings.setValue("moments_archive",         QString::fromStdString(p.moments_archive));
+  settings.setValue("moments_window",          p.moments_window);
   settings.endGroup();
 
   settings.beginGroup("plot_preferences");
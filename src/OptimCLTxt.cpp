@@ -347,7 +347,7 @@ int OptimMainWindow::ViewFunctions (char const* filenm, FunctionDlgStruct* NStf,
 
      // split the Element into ns identical pieces
 
-     std::shared_ptr<Element> e( ep->split(ns) );
+     SliceRef e(*ep, ns, slice_arena_);
 
      // ***FIXME *** what are jm, jp ???
      // this looks like some sort of id for end type 
@@ -737,7 +737,7 @@ int OptimMainWindow::TypeTrajectory(char const* filenm, PTracStruct *NSt, bool C
 
       if( nm=='A' || nm=='W' ||nm=='X' ||nm=='Z'|| nm=='G' ){ns=1;}
     
-      std::shared_ptr<Element> e( ep->split(ns) );
+      SliceRef e(*ep, ns, slice_arena_);
 
       switch ( nm ){
 	case 'Q':
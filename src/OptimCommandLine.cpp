@@ -45,6 +45,10 @@
 #include <OptimEditor.h>
 #include <BeamMoments.h>
 #include <Bunch.h>
+#include <TrackCheckpoint.h>
+#include <OneTurnMap.h>
+#include <ThinLattice.h>
+#include <ClosedOrbit.h>
 #include <Utility.h>
 #include <Twiss.h>
 #include <Element.h>
@@ -55,6 +59,7 @@
 #include <OrbitDialog.h>
 #include <EditReadDialog.h>
 #include <Globals.h>
+#include <RandomStream.h>
 
 #include <QMdiSubWindow>
 #include <QMdiArea>
@@ -79,7 +84,7 @@ using Constants::PI;
 
 #define LSTR 1024
 
-enum  optionIndex { UNKNOWN, TWISS, TWISSMAD, COUPLEDTWISS, COUPLEDTWISSSC, CENTROID, ORBIT, READBDL,  WRITESNAP, MULTIPTRACK, HELP };
+enum  optionIndex { UNKNOWN, TWISS, TWISSMAD, COUPLEDTWISS, COUPLEDTWISSSC, CENTROID, ORBIT, READBDL,  WRITESNAP, MULTIPTRACK, ERRORSTUDY, HELP };
 
 const option::Descriptor usage[] =
  {
@@ -92,6 +97,7 @@ const option::Descriptor usage[] =
   {READBDL,        0, "r", "bdl",               option::Arg::None,  "-r, --bdl:              read BdL from .snap file and create new OptiM file."},
   {WRITESNAP,      0, "w", "write-snap",        option::Arg::None,  "-w, --snap:             create a .snap file."}, 
   {MULTIPTRACK,    0, "p", "--track",           option::Arg::None,  "-p, --track:            multi-particle tracking."},
+  {ERRORSTUDY,     0, "e", "error-study",       option::Arg::None,  "-e, --error-study:      Monte-Carlo study of lattice errors (closed orbit, beta-beat, tunes)."},
   {HELP,           0, "-h" , "help",            option::Arg::None,  "-h  --help              Print usage and exit." },
   {0,0,0,0,0,0}
  };
@@ -187,14 +193,45 @@ swerr:
 
    switch ( toupper(argv[1][1]) ){
      // Multiparticle tracking
-     case 'P':
+     case 'P': {
        //fclose(fp);
-       if(argc >= 5) strcpy(filter, argv[5]); else strcpy(filter, "*");
-       if(argc >= 6) { mtcs = (argv[6][0] == 'Y'); } else { argv[6][0] ='Y';}
-       if(argc >= 7) i    = atoi(argv[7]);  else i   = 1;
-       if(argc >= 8) ring = argv[8][0];     else ring='L';
-       ierr = TrackOffLine( argv[4], argv[3], mtcs, filter, i, ring);
+       int  ckpt   = 0;       // checkpoint interval [turns]; 0: no checkpoints 
+       bool resume = false;
+       int  order  = 0;       // one-turn map order; 0: element by element tracking  
+       bool symp   = false;
+       bool thin   = false;   // thin-lens (kick-drift) lattice 
+       ThinOptions thopt;
+       int  n      = 0; 
+       for (int j=0; j<argc; ++j) {   // strip the options, keep the positional arguments
+         if      ( !strcmp(argv[j],  "--resume") )            resume = true;
+         else if ( !strncmp(argv[j], "--checkpoint=", 13) )   ckpt   = atoi(argv[j]+13);
+         else if ( !strncmp(argv[j], "--map=", 6) )           order  = atoi(argv[j]+6);
+         else if ( !strcmp(argv[j],  "--symplectic") )        symp   = true;
+         else if ( !strcmp(argv[j],  "--thin") )              thin   = true;
+         else if ( !strncmp(argv[j], "--thin=", 7) )        { thin   = true; thopt.nslices = atoi(argv[j]+7); }
+         else if ( !strcmp(argv[j],  "--yoshida") )           thopt.scheme  = ThinOptions::yoshida;
+         else if ( !strcmp(argv[j],  "--no-rematch") )        thopt.rematch = false;
+         else if ( !strncmp(argv[j], "--slices=", 9) ) {      // filter:n[,filter:n ...]  
+           std::string fams(argv[j]+9);
+           for (size_t pos=0; pos < fams.size(); ) {
+             size_t end = fams.find(',', pos);
+             if (end == std::string::npos) end = fams.size();
+             std::string f = fams.substr(pos, end-pos);
+             size_t colon  = f.rfind(':');
+             if (colon != std::string::npos) thopt.families.emplace_back(f.substr(0, colon), atoi(f.c_str()+colon+1));
+             pos = end+1;
+           }
+         }
+         else argv[n++] = argv[j];
+       }
+       argc = n;
+       if(argc >= 6) strcpy(filter, argv[5]); else strcpy(filter, "*");
+       if(argc >= 7) mtcs = (argv[6][0] == 'Y'); else mtcs = true;
+       if(argc >= 8) i    = atoi(argv[7]);       else i    = 1;
+       if(argc >= 9) ring = argv[8][0];          else ring = 'L';
+       ierr = TrackOffLine( argv[4], argv[3], mtcs, filter, i, ring, ckpt, resume, order, symp, thin ? &thopt : 0);
        exit(ierr);
+     }
        // Print twiss functions into a file
      case 'F':  
      case 'S':
@@ -385,6 +422,10 @@ swerr:
          fprintf(fp,"%s\n", buf);
         }
       	exit(0);
+      case 'E':  // Monte-Carlo error study
+        if( argc<5) goto swerr;
+        ierr = ErrorStudyOffLine( argv[4], argv[3], (argc>=6) ? atoi(argv[5]) : 100, (argc>=7) ? atoi(argv[6]) : 0);
+        exit(ierr);
       case 'W':
         {
 	 if(analyzed_) { if(analyze(false , 1)) exit(0); } else { if( analyze( true, 1)) exit(0);}
@@ -439,6 +480,7 @@ swerr:
                   r - read BdL from .snap file crerate new Optim file
                   w - create .snap file
                   p - macro particle tracking
+                  e - Monte-Carlo error study
  ===============================
 	Start program with input file
    	optim32 InputFileName
@@ -478,6 +520,19 @@ swerr:
          	MatchCase=Y
             Nturn=1
             ring=L (should be R or L)
+        options (after the positional arguments):
+            --checkpoint=<n>  save a checkpoint (OutputTrackingFileName.ckpt) every n turns
+            --resume          restart from the last checkpoint
+            --map=<n>         track through the n-th order one-turn map (n <= 6), 
+                              expanded about the closed orbit
+            --symplectic      with --map, track through the generating function of the map
+            --thin[=<n>]      track through a thin-lens (kick-drift) version of the lattice; thick 
+                              magnets are cut into n slices (default 4)
+            --yoshida         with --thin, slice with the 4th order Yoshida integrator (3 kicks per
+                              slice) instead of TEAPOT 
+            --slices=<filter>:<n>[,<filter>:<n>...]
+                              with --thin, number of slices for the magnets matching the filter 
+            --no-rematch      with --thin, do not restore the tunes of the thick lattice
    ===============================
 	Output beam trajectory
    	optim32 -t InputOptimFileName OutputTrajFileName <filter> <MatchCase> <CloseLattice> <OutputType> <step>
@@ -504,6 +559,15 @@ swerr:
             filter=*
          	MatchCase=Y
             HideFirstLetter=Y
+   ===============================
+	Monte-Carlo error study (closed orbit, beta-beat and tunes for random lattice errors)
+   	optim32 -e InputOptimFileName OutputSummaryFileName ErrorSpecFileName <Nseeds> <Nturn>
+      	defaults:
+            Nseeds=100
+            Nturn=0 (no tracking)
+         Each line of ErrorSpecFile is: filter kind sigma [cut] [MatchCase] 
+         kind: X,Y offset[cm]  R roll[deg]  B dB/B  G dG/G;  cut=3 (in units of sigma, 0 = no truncation)
+         Per-seed results are also saved in the ErrorStudy table of the moments database. 
    ===============================
 	To generate beta function list and Element parameters (MAD like structure):
 		server -s InputOptimFileName OutputTwissFileName <filter> <MatchCase>
@@ -518,8 +582,15 @@ swerr:
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
 int OptimMainWindow::TrackOffLine(char *InputPartPosFile, char *TrackResFile,
-				  bool MatchCase, char *filter, int nturn, char ring)
+				  bool MatchCase, char *filter, int nturn, char ring, int ckpt_interval, bool resume,
+				  int map_order, bool symplectic, ThinOptions const* thin)
 {
+  // ckpt_interval > 0: a checkpoint (TrackResFile.ckpt) is saved every ckpt_interval turns
+  // resume:            tracking restarts from the last checkpoint saved for TrackResFile  
+  // map_order > 0:     particles are tracked through the one-turn map of that order 
+  // symplectic:        the map is symplectified (generating function) 
+  // thin:              if not null, particles are tracked through the thin-lens lattice built with these options 
+
   auto con = Globals::preferences().con;
 
   char buf[LSTR+1];
@@ -655,21 +726,106 @@ int OptimMainWindow::TrackOffLine(char *InputPartPosFile, char *TrackResFile,
    
    sqlite::execute(*con, "DELETE FROM Moments WHERE rowid IN (SELECT max(rowid) FROM moments);", true); 
    double spos = 0.0;
+
+   // checkpoint/restart 
+
+   std::string ckpt_name = std::string(TrackResFile) + ".ckpt";
+   int kstart = 0;
+
+   RandomStream::reseed();  // per-particle streams of the stochastic elements; a checkpoint restores the saved epoch
+
+   if (resume) {
+     TrackCheckpoint cp;
+     if ( TrackCheckpoint::read(ckpt_name, cp) || (cp.nelm != nelm_) || (cp.bunch.size() != N) ) {
+       sprintf(buf, "Cannot resume tracking: checkpoint %s is missing or does not match the lattice and particle file", ckpt_name.c_str());
+       OptimMessageBox::warning(this, "Tracking", buf, QMessageBox::Ok);
+       return 1;
+     }
+     if ( TrackCheckpoint::loadMoments(*con, ckpt_name + ".db", cp.turn) ) {
+       sprintf(buf, "Cannot restore the moments saved in %s.db", ckpt_name.c_str());
+       OptimMessageBox::warning(this, "Tracking", buf, QMessageBox::Ok);
+     }
+     cp.restoreRng();
+     v      = std::move(cp.bunch);
+     kstart = cp.turn;
+     Enr    = cp.Enr;
+     gamma  = 1.+Enr/ms;
+   }
+
+   std::unique_ptr<CheckpointWriter> writer;
+   if (ckpt_interval > 0) writer = std::make_unique<CheckpointWriter>(ckpt_name, con);
+
+   // one-turn map, expanded about the 4D closed orbit (or the reference orbit, if the orbit cannot be closed) 
+
+   std::unique_ptr<OneTurnMap> otm;
+
+   if (map_order > 0) {
+     Coordinates orbit;
+     ClosedOrbit closure;
+     if ( closure(beamline_.beamline_, ms, Enr, tetaY, orbit) ) orbit = Coordinates();
+     otm = std::make_unique<OneTurnMap>();
+     OneTurnMap::Status st = otm->extract(beamline_.beamline_, ms, Enr, tetaY, orbit, map_order);
+     if ( (st == OneTurnMap::ok) && symplectic ) st = otm->symplectify();
+     if (st != OneTurnMap::ok) {
+       int ie = otm->failedElement();
+       if (ie >= 0) sprintf(buf, "Cannot extract the one-turn map: element %s cannot be represented by a map or the reference particle is lost", beamline_[ie]->name());
+       else         sprintf(buf, "Cannot %s the one-turn map", (st == OneTurnMap::singular) ? "symplectify" : "extract");
+       OptimMessageBox::warning(this, "Tracking", buf, QMessageBox::Ok);
+       return 1;
+     }
+   }
    
-   if( nturn== 1) {  // INITIAL CONDITION FOR OUTPUT AT ALL ELEMENTS 
+   // thin-lens lattice 
+
+   std::unique_ptr<ThinLattice> thl;
+
+   if (thin && !otm) {
+     thl = std::make_unique<ThinLattice>();
+     ThinLattice::Status st = thl->make(beamline_.beamline_, ms, Enr, tetaY, *thin);
+     if (st == ThinLattice::unsupported) {
+       sprintf(buf, "Cannot make the thin-lens lattice: element %s has no thin-lens representation", beamline_[thl->failedElement()]->name());
+       OptimMessageBox::warning(this, "Tracking", buf, QMessageBox::Ok);
+       return 1;
+     }
+     if (st == ThinLattice::unmatched) {
+       OptimMessageBox::warning(this, "Tracking", "Failed to rematch the tunes of the thin-lens lattice. Tracking proceeds without rematching.", QMessageBox::Ok);
+     }
+   }
+   
+   if( nturn== 1 && kstart == 0) {  // INITIAL CONDITION FOR OUTPUT AT ALL ELEMENTS 
       BeamMoments mom(gamma,v, N, false);
       mom.s = spos;
       mom.dbWrite(*con, 0, 0, N); // NOTE: i is the element index
    }
    
-   for(int k=0; k<nturn; ++k) {
-      for(int i=0; i<nelm_; ++i) {
+   int ckpt_status = 0;
+
+   for(int k=kstart; k<nturn; ++k) {
+      if (otm || thl) { 
+        for (int j=0; j<v.active(); ++j) {
+          auto& particle = v[j];
+          if (particle.lost) continue;
+          if ( otm ? otm->track(particle) : thl->track(particle) ) {
+            particle.lost  = 1;
+            particle.nelem = nelm_;
+            particle.npass = k+1;
+          }
+        }
+        v.compact();
+        for (int i=0; i<nelm_; ++i) spos += beamline_[i]->length()*0.01;
+        if (nturn == 1) {
+          BeamMoments mom(gamma,v, N, false);
+          mom.s = spos;
+          mom.dbWrite(*con, k, nelm_, N);
+        }
+      }
+      for(int i=0; !otm && !thl && (i<nelm_); ++i) {
    	auto  ep = beamline_[i];
       	char nm     = toupper(ep->name()[0]);
         double EnrNew = Enr;
         me = ep->rmatrix(EnrNew, ms, tetaY, 0.0 ,3);
         ep->propagateLatticeFunctions(me, twiss, ev);
-        tracker->trackBunchExact(ep.get(), Enr, frame, v, N, k+1, i);
+        tracker->trackBunchExact(ep.get(), Enr, frame, v, v.active(), k+1, i);
 
 	switch(nm){
           case 'E': 
@@ -699,6 +855,23 @@ int OptimMainWindow::TrackOffLine(char *InputPartPosFile, char *TrackResFile,
 	*/
  
       }
+      if (!otm && !thl) v.compact(); // remove the particles lost during this turn from the active range 
+
+      if ( writer && ((k+1) % ckpt_interval == 0) && (k+1 < nturn) ) {
+        TrackCheckpoint cp;
+        cp.turn  = k+1;
+        cp.nelm  = nelm_;
+        cp.Enr   = Enr;
+        cp.bunch = v;
+        cp.saveRng();
+        ckpt_status |= writer->save(std::move(cp));
+      }
+   }
+
+   if (writer) ckpt_status |= writer->wait();
+   if (ckpt_status) {
+     sprintf(buf, "Failed to write tracking checkpoint %s", ckpt_name.c_str());
+     OptimMessageBox::warning(this, "Tracking", buf, QMessageBox::Ok);
    }
 
  
@@ -52,12 +52,19 @@
 #include <Utility.h>
 #include <Twiss.h>
 #include <OptimCalc.h>
+#include <Dual.h>
+#include <ElementMatrices.h>
+#include <TwissAD.h>
+#include <LeastSquares.h>
+#include <Constants.h>
 #include <QMdiArea>
 #include <QAction>
 #include <QMdiSubWindow>
 #include <QCoreApplication>
 #include <QRegularExpression>
 #include <memory>
+#include <map>
+#include <array>
 
 using Utility::decodeLine;
 using Utility::strcmpr;
@@ -585,146 +592,209 @@ void OptimMainWindow::PrintFitParam (OptimTextEditor* editor, FitStep* fstep, Tw
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-void  OptimMainWindow::addErr(double& err, Twiss const& v, Twiss const& vfin, Twiss const& dv)
-{
-
-  using std::abs;
-  
-  double s =0.0;
+namespace {
 
-  // if a precision parameter is negative, the weight associated with
-  // the variable is 0 i.e. it is ignored in the optimization 
+  template <typename T, typename V>
+  void addResiduals(std::vector<T>& r, V const& v, Twiss const& vfin, Twiss const& dv, bool use_fractional_tune)
+  {
+    // Weighted residuals of the lattice function constraints at one location. V is Twiss, or
+    // Twiss_t<T> for the forward-mode gradient.  
+    // If a precision parameter is negative, the weight associated with
+    // the variable is 0 i.e. it is ignored in the optimization 
 
-  if ( dv.BtX  > 0.0)  { s = (vfin.BtX - v.BtX) / dv.BtX;  err += s*s;}
-  if ( dv.BtY  > 0.0)  { s = (vfin.BtY - v.BtY) / dv.BtY;  err += s*s;}
-  if ( dv.AlX  > 0.0)  { s = (vfin.AlX - v.AlX) / dv.AlX;  err += s*s;}
-  if ( dv.AlY  > 0.0)  { s = (vfin.AlY - v.AlY) / dv.AlY;  err += s*s;}
-  if ( dv.DsX  > 0.0)  { s = (vfin.DsX - v.DsX) / dv.DsX;  err += s*s;}
-  if ( dv.DsY  > 0.0)  { s = (vfin.DsY - v.DsY) / dv.DsY;  err += s*s;}
-  if ( dv.DsXp > 0.0)  { s = (vfin.DsXp -v.DsXp)/ dv.DsXp; err += s*s;}
-  if ( dv.DsYp > 0.0)  { s = (vfin.DsYp -v.DsYp)/ dv.DsYp; err += s*s;}
+    using std::modf;
 
-  if ( dv.nuX  > 0.0)  {
+    if ( dv.BtX  > 0.0)  { r.push_back( (vfin.BtX - v.BtX) / dv.BtX  );}
+    if ( dv.BtY  > 0.0)  { r.push_back( (vfin.BtY - v.BtY) / dv.BtY  );}
+    if ( dv.AlX  > 0.0)  { r.push_back( (vfin.AlX - v.AlX) / dv.AlX  );}
+    if ( dv.AlY  > 0.0)  { r.push_back( (vfin.AlY - v.AlY) / dv.AlY  );}
+    if ( dv.DsX  > 0.0)  { r.push_back( (vfin.DsX - v.DsX) / dv.DsX  );}
+    if ( dv.DsY  > 0.0)  { r.push_back( (vfin.DsY - v.DsY) / dv.DsY  );}
+    if ( dv.DsXp > 0.0)  { r.push_back( (vfin.DsXp -v.DsXp)/ dv.DsXp );}
+    if ( dv.DsYp > 0.0)  { r.push_back( (vfin.DsYp -v.DsYp)/ dv.DsYp );}
 
+    if ( dv.nuX  > 0.0)  {
       double intpart = 0.0;
-      double nuXfin = vfin.nuX;
-      double nuX    = v.nuX;
-       
-      s = ( CtSt_.use_fractional_tune ?  modf((nuXfin - nuX), &intpart) : (nuXfin - nuX)) / dv.nuX;
-      err += s*s;
- 
+      r.push_back( ( use_fractional_tune ?  modf((vfin.nuX - v.nuX), &intpart) : (vfin.nuX - v.nuX)) / dv.nuX );
+    }
+    if ( dv.nuY  > 0.0)  {
+      double intpart = 0.0;
+      r.push_back( ( use_fractional_tune ?  modf((vfin.nuY - v.nuY), &intpart) : (vfin.nuY - v.nuY)) / dv.nuY );
+    }
   }
-  if ( dv.nuY  > 0.0)  {
 
-      double intpart = 0.0;
-      double nuYfin = vfin.nuY;
-      double nuY    = v.nuY;
+  //..........................................................................................................
 
-      s = ( CtSt_.use_fractional_tune ?  modf((nuYfin - nuY), &intpart) : (nuYfin - nuY)) / dv.nuY;
-      err += s*s;
-   
+  template <typename T, typename V>
+  void addBetaExcess(T& ExcX, T& ExcY, V const& v, FitStep const* fstep, bool smooth)
+  {
+    // Squared (weighted) excesses of the beta functions over their maximum values.
+    // smooth = false: the largest excess only, i.e. that of the largest beta value (FindError()).
+    // smooth = true : sums over every location where the maximum is exceeded; unlike the
+    //                 largest beta value alone, the sums are smooth functions of the fit
+    //                 parameters (least squares fit).  
+
+    T s;
+
+    if( (fstep->dbtx > 0.0) && (v.BtX > fstep->btx) ) {
+      s = (v.BtX - fstep->btx) / fstep->dbtx; 
+      if (smooth) ExcX += s*s; else if (s*s > ExcX) ExcX = s*s;
+    }
+    if( (fstep->dbty > 0.0) && (v.BtY > fstep->bty) ) {
+      s = (v.BtY - fstep->bty) / fstep->dbty; 
+      if (smooth) ExcY += s*s; else if (s*s > ExcY) ExcY = s*s;
+    }
   }
 
-}
+  //..........................................................................................................
 
+  template <typename T, typename M>
+  void addLineResiduals(std::vector<T>& r, T const& ExcX, T const& ExcY, M const& tm, FitStep const* fstep,
+                        double const disp[], double length, double gamma)
+  {
+    // Residuals of the constraints on the whole line: maximum beta values and momentum compaction.
+    // ExcX, ExcY: see addBetaExcess(); disp: initial dispersion (DsX, DsXp, DsY, DsYp);
+    // tm: line transfer matrix.  
+
+    using std::sqrt;
+
+    T s;
+
+    // exceeding maximum beta value (one-sided; the residual vanishes below the maximum) 
+
+    if(fstep->dbtx > 0.0 ) r.push_back( ExcX > 0.0 ? sqrt(ExcX) : T(0.0) );
+    if(fstep->dbty > 0.0 ) r.push_back( ExcY > 0.0 ? sqrt(ExcY) : T(0.0) );
+
+    // error on momentum compaction
+
+    if(fstep->dalfa > 0.0){
+      s     = -( disp[0] * tm[4][0] + disp[1] * tm[4][1] +
+	         disp[2] * tm[4][2] + disp[3] * tm[4][3] +   (tm[4][5] - length/(gamma*gamma)) ) / length;
+      r.push_back( (s - fstep->alfa) / fstep->dalfa );
+    }
+  }
+
+} // namespace
 
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-double  OptimMainWindow::FindError(  Twiss vfin[], Twiss dv[], int npoint[], FitStep* fstep) // V7
+template <typename V>
+void  OptimMainWindow::initialLatticeFunctions(V& v) const
 {
+  // lattice functions at the line entrance, for a transfer line 
+
+  v.BtX  = BetaXin;
+  v.BtY  = BetaYin;
+  v.AlX  = AlfaXin;
+  v.AlY  = AlfaYin;
+  v.DsX  = DispXin;
+  v.DsY  = DispYin;
+  v.DsXp = DispPrimeXin;
+  v.DsYp = DispPrimeYin;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int  OptimMainWindow::FindResiduals( std::vector<std::shared_ptr<Element>> const& line, Twiss const vfin[], Twiss const dv[], int const npoint[],
+                                     FitStep const* fstep, std::vector<double>& r, bool smooth) const
+{
+  //-------------------------------------------------------------------------------------------
+  // Weighted residuals of all the fit constraints, for the elements in line. The
+  // objective function is the sum of their squares. The no of residuals depends only
+  // on which constraints are enabled. smooth selects the form of the maximum beta
+  // residuals (see addBetaExcess()): false for FindError(), true for the least squares fit. 
+  //
+  // Returns 0 on success, or the find_tunes() error code if the (ring) lattice cannot be closed. 
+  // This function does not modify the lattice; it may be called concurrently on distinct lines.  
+  //-------------------------------------------------------------------------------------------
 
   Twiss v;
   RMatrix me; // single element matrix
   RMatrix tm;
-  int irt;
   std::complex<double> ev[4][4];
-  char buf[256];
-  char const *cher[3] = { "X" , "Y" , "X&Y"};
 
-  double tetaY, Enr, BetaXm=0., BetaYm=0., err=0., s, alfa;
-  int i, j;
+  double ExcX=0., ExcY=0., alfa;
   
-   if(  !CtSt_.IsRingCh ) {
-     v.BtX  = BetaXin;
-     v.BtY  = BetaYin;
-     v.AlX  = AlfaXin;
-     v.AlY  = AlfaYin;
-     v.DsX  = DispXin;
-     v.DsY  = DispYin;
-     v.DsXp = DispPrimeXin;
-     v.DsYp = DispPrimeYin;
-     v.nuX  = 0.0;
-     v.nuY  = 0.0;
-   }
-   else {
-     findRMatrix(tm);
-     irt=find_tunes(tm, Length_, v, &alfa);
-     if(irt) {
-       strcpy(buf,"Cannot close for ");
-       strcat(buf, cher[irt-1]);
-       OptimMessageBox::warning(this, "Close Error",buf, QMessageBox::Ok);
-       return -1.;
-     }
-   }
-   v.nuY = v.nuX=0.;
-   tetaY = tetaYo0_; 
-   Enr   = Ein;
+  r.clear();
+
+  double tetaY = tetaYo0_; 
+  double Enr   = Ein;
+
+  tm.toUnity();
+
+  if(  !CtSt_.IsRingCh ) {
+     initialLatticeFunctions(v);
+  }
+  else {
+     for (auto const& ep : line) { me = ep->rmatrix(Enr, ms, tetaY, 0.0, 3); tm = me*tm; }
+     int irt = find_tunes(tm, Length_, v, &alfa);
+     if (irt) return irt; 
+     tetaY = tetaYo0_; 
+     Enr   = Ein;
+  }
+  v.nuY = v.nuX=0.;
 
-   if( !CtSt_.IsRingCh ) tm.toUnity();
+  v.eigenvectors(ev);
 
-   v.eigenvectors(ev);
+  int nelm = line.size(); 
 
-   for (i=0, j=1; i<nelm_; ++i){
+  for (int i=0, j=1; i<nelm; ++i){
 
-     auto ep = beamline_[i];
+     auto ep = line[i];
      me = ep->rmatrix(Enr, ms, tetaY, 0.0, 3);
      
      if( !CtSt_.IsRingCh ) tm = me*tm;
 
      ep->propagateLatticeFunctions(me, v, ev); //  lattice functions downstream of element [matrix me]
      
-     if (v.BtX > BetaXm) BetaXm = v.BtX;
-     if (v.BtY > BetaYm) BetaYm = v.BtY;
+     addBetaExcess(ExcX, ExcY, v, fstep, smooth);
 
-     // contribution to objective function from error on lattice functions at intermediate locations, if any ...
+     // error on lattice functions at intermediate locations, if any ...
  
      if (npoint[0]>1) {
           if(npoint[j]==(i+1)){
-	   addErr(err, v, vfin[j], dv[j]); 
+	   addResiduals(r, v, vfin[j], dv[j], CtSt_.use_fractional_tune); 
          ++j;
        }
      }
-   } 
+  } 
 
-   // contribution to objective function from error on lattice functions at line downstream end 
+  // error on lattice functions at line downstream end 
    
-   addErr(err, v, vfin[0], dv[0]);
+  addResiduals(r, v, vfin[0], dv[0], CtSt_.use_fractional_tune);
    
-   // contribution to objective function from exceeding maximum beta value 
+  double const disp[] = { DispXin, DispPrimeXin, DispYin, DispPrimeYin };
 
-   if(fstep->dbtx > 0.0 ) {
-     s = (BetaXm - fstep->btx) / fstep->dbtx;
-     if(s > 0.0) err += s*s;
-   }
+  addLineResiduals(r, ExcX, ExcY, tm, fstep, disp, Length_, 1.0 + Ein/ms);
 
-   if(fstep->dbty > 0.0){
-     s = (BetaYm - fstep->bty) / fstep->dbty;
-     if(s > 0.)err += s*s;
-   }
+  return 0;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-   // contribution to objective function from error on momentum compaction
+double  OptimMainWindow::FindError(  Twiss vfin[], Twiss dv[], int npoint[], FitStep* fstep) // V7
+{
+  char buf[256];
+  char const *cher[3] = { "X" , "Y" , "X&Y"};
 
-   double gamma = 1.0 + Ein/ms; 
+  std::vector<double> r;
 
-   if(fstep->dalfa > 0.0){
-     s     = -( DispXin * tm[4][0] + DispPrimeXin * tm[4][1] +
-	        DispYin * tm[4][2] + DispPrimeYin * tm[4][3] +   (tm[4][5] - Length_/(gamma*gamma)) ) / Length_;
-     s     = (s - fstep->alfa) / fstep->dalfa;
-     err += s*s;
-   }
+  int irt = FindResiduals(beamline_.beamline_, vfin, dv, npoint, fstep, r, false);
 
-   return err;
+  if(irt) {
+    strcpy(buf,"Cannot close for ");
+    strcat(buf, cher[irt-1]);
+    OptimMessageBox::warning(this, "Close Error",buf, QMessageBox::Ok);
+    return -1.;
+  }
+
+  double err = 0.0;
+  for (auto s : r) err += s*s;
+
+  return err;
 }
 
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
@@ -735,6 +805,11 @@ bool  OptimMainWindow::GetGradient(Twiss vfin[], Twiss dv[], int npoint[],
 {
   bool er= false;
 
+  ad_fallback_        = CtSt_.use_ad_gradient ? GetGradientAD(vfin, dv, npoint, group, ngr, fstep, G) : 0;
+  ad_gradient_active_ = CtSt_.use_ad_gradient && !ad_fallback_;
+
+  if (ad_gradient_active_) return false;
+
   double Q0 = FindError(vfin, dv, npoint, fstep); 
 
   if (Q0 < 0.0) return true;
@@ -755,6 +830,191 @@ bool  OptimMainWindow::GetGradient(Twiss vfin[], Twiss dv[], int npoint[],
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
+namespace {
+
+  template <typename T>
+  bool elementMatrixAD( Element const& e, T const& L, T const& B, T const& G, double energy, double ms, RMatrix_t<6,T>& mi)
+  {
+    // Transfer matrix of a fitted element, with L, B and G carrying their derivatives.
+    // Returns false if the element is not supported; the caller then falls back to finite differences. 
+ 
+    double P      = sqrt(energy * (energy + 2.0 * ms));
+    double hr     = P/Constants::C_DERV1;
+    double gamma1 = 1.0 + energy/ms;
+
+    if ( dynamic_cast<Quadrupole const*>(&e) ) {
+      if (e.tilt() != 0.0 ) return false; 
+      ElementMatrices::quadrupole<T>(mi, L, G, hr, gamma1);
+      return true;
+    }
+    if ( dynamic_cast<CFBend const*>(&e) ) {
+      if (e.tilt() != 0.0 ) return false; 
+      ElementMatrices::cfbend<T>(mi, L, B, G, hr, gamma1);
+      return true;
+    }
+    if ( dynamic_cast<Solenoid const*>(&e) ) {
+      if (e.A > 0.0 ) return false;  // soft edges  
+      ElementMatrices::solenoid<T>(mi, L, B, hr, gamma1, (toupper(e.name()[1]) == 'C') );
+      return true;
+    }
+    if ( dynamic_cast<Drift const*>(&e) ) {
+      ElementMatrices::drift<T>(mi, L, gamma1);
+      return true;
+    }
+    return false;
+  }
+
+} // namespace
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+template <int N>
+char const*  OptimMainWindow::FindErrorAD( Twiss vfin[], Twiss dv[], int npoint[], FitElem group[], int ngr, FitStep* fstep, double* G)
+{
+  //-----------------------------------------------------------------------------------------------
+  // Objective function gradient by forward-mode differentiation. The lattice functions are
+  // propagated once, carrying their derivatives w/r to the ngr group settings (ngr <= N).
+  // The derivative is taken w/r to the change of the first element in each group, the
+  // other elements being changed proportionally, as in ChangeGroupSetting(). The residuals
+  // are the same as in FindResiduals() called by FindError(). 
+  //
+  // Returns 0 on success. When the computation is not applicable, returns the reason and
+  // G is not modified.
+  //-----------------------------------------------------------------------------------------------
+
+  using D = Dual_t<N>;
+
+  auto paramValue = [](Element const& e, int param) {
+    switch (grname[param]) {
+      case 'L': return e.length();
+      case 'B': return e.B;
+      default : return e.G;
+    }
+  };
+
+  // L, B, G of the fitted elements, with their derivatives. After lattice compression,
+  // the fitted elements in elmdict_ are shared with the beamline.
+  
+  std::map<Element const*, std::array<D,3>> fitted; 
+
+  for (int i=0; i<ngr; ++i) {
+
+    double v0 = paramValue(*elmdict_[group[i].el[0]], group[i].param);
+
+    if ( (group[i].n > 1) && (v0 == 0.0) ) return "a fit group starts with a zero setting";
+
+    for (int j=0; j<group[i].n; ++j) {
+      Element const* ep = elmdict_[group[i].el[j]].get();
+      auto it = fitted.find(ep);
+      if (it == fitted.end()) {
+        it = fitted.insert( { ep, { D(ep->length()), D(ep->B), D(ep->G) } } ).first;
+      }
+      it->second[group[i].param].deriv(i) += ( j == 0 ? 1.0 : paramValue(*ep, group[i].param)/v0 );
+    }
+  }
+
+  if ( tetaYo0_ != 0.0 ) return "vertical bending"; 
+
+  // element matrices 
+
+  std::vector<RMatrix_t<6,D>> matrices(nelm_);
+  RMatrix_t<6,D> tm;
+  tm.toUnity();
+
+  double tetaY = tetaYo0_; 
+  double Enr   = Ein;
+  int    nfound = 0; 
+
+  for (int i=0; i<nelm_; ++i) {
+
+    auto   ep   = beamline_[i];
+    double Enr0 = Enr;
+    RMatrix me  = ep->rmatrix(Enr, ms, tetaY, 0.0, 3);
+
+    if ( tetaY != 0.0 )            return "vertical bending";
+    if ( TwissAD::isCoupled(me) )  return "coupled optics";
+    
+    auto it = fitted.find(ep.get());
+    if ( it == fitted.end() ) {
+      for (int k=0; k<6; ++k) {
+        for (int l=0; l<6; ++l) matrices[i][k][l] = me[k][l];
+      } 
+    }
+    else {
+      auto const& p = it->second;
+      if ( !elementMatrixAD(*ep, p[0], p[1], p[2], Enr0, ms, matrices[i]) ) return "tilted or unsupported fitted element";
+      ++nfound;
+    }
+    tm = matrices[i]*tm;
+  }
+
+  if (nfound == 0) return "fitted elements not found in the beamline"; 
+  
+  // initial lattice functions 
+
+  Twiss_t<D> v;
+  
+  if( !CtSt_.IsRingCh ) {
+    initialLatticeFunctions(v);
+  }
+  else {
+    if ( TwissAD::periodicSolution(tm, v) ) return "no periodic solution"; // FindError() reports the problem 
+  }
+  v.nuY = v.nuX = 0.0;
+
+  D ExcX(0.0);
+  D ExcY(0.0);
+  std::vector<D> r;
+  
+  for (int i=0, j=1; i<nelm_; ++i){
+
+    TwissAD::propagateLatticeFunctions(matrices[i], v, Element::neg_phase_adv_threshold);
+
+    addBetaExcess(ExcX, ExcY, v, fstep, false);
+
+    if (npoint[0]>1) {
+      if(npoint[j]==(i+1)){
+        addResiduals(r, v, vfin[j], dv[j], CtSt_.use_fractional_tune); 
+        ++j;
+      }
+    }
+  }
+
+  addResiduals(r, v, vfin[0], dv[0], CtSt_.use_fractional_tune);
+
+  double const disp[] = { DispXin, DispPrimeXin, DispYin, DispPrimeYin };
+
+  addLineResiduals(r, ExcX, ExcY, tm, fstep, disp, Length_, 1.0 + Ein/ms);
+
+  D err(0.0);
+  for (auto const& s : r) err += s*s;
+
+  for (int i=0; i<ngr; ++i) G[i] = err.deriv(i);
+  
+  return 0;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+char const*  OptimMainWindow::GetGradientAD(Twiss vfin[], Twiss dv[], int npoint[],
+	                                    FitElem group[], int ngr, FitStep* fstep, double* G)
+{
+  // the no of derivatives carried along is fixed at compile time; use the smallest that fits. 
+
+  if (ngr <=  4) return FindErrorAD<4> (vfin, dv, npoint, group, ngr, fstep, G);
+  if (ngr <=  8) return FindErrorAD<8> (vfin, dv, npoint, group, ngr, fstep, G);
+  if (ngr <= 16) return FindErrorAD<16>(vfin, dv, npoint, group, ngr, fstep, G);
+  if (ngr <= 32) return FindErrorAD<32>(vfin, dv, npoint, group, ngr, fstep, G);
+  if (ngr <= 64) return FindErrorAD<64>(vfin, dv, npoint, group, ngr, fstep, G);
+
+  return "more than 64 fit groups";
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
 bool OptimMainWindow::SetGradientStep(Twiss vfin[], Twiss dv[], int npoint[],
 				      FitElem group[], int ngr, FitStep* fstep) // V7
 {
@@ -856,6 +1116,171 @@ double OptimMainWindow::ChangeGroupSetting(FitElem group[], double delta_d) // V
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
+std::vector<std::shared_ptr<Element>> OptimMainWindow::clonedLine() const
+{
+  // A copy of the beamline made of clones of its elements. An element used several times
+  // in the beamline is cloned once.  
+
+  std::map<Element const*, std::shared_ptr<Element>> clones;
+  std::vector<std::shared_ptr<Element>> line;
+  line.reserve(beamline_.beamline_.size());
+
+  for (auto const& ep : beamline_.beamline_) {
+    auto& e = clones[ep.get()];
+    if (!e) e = std::shared_ptr<Element>(ep->clone());
+    line.push_back(e);
+  }
+  return line;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+std::vector<std::shared_ptr<Element>> OptimMainWindow::perturbedLine(std::vector<std::shared_ptr<Element>> const& base,
+                                                                     FitElem const& group, double delta_d) const
+{
+  // A copy of base (the beamline or a copy of it, see clonedLine()) in which the elements of a
+  // fit group are replaced by clones whose parameter is changed as in ChangeGroupSetting().
+  // The other elements are shared with base. Neither the lattice nor base is modified. 
+
+  char const* cname = 0;
+  switch (grname[group.param]) {
+    case 'G': cname = "gradient"; break;
+    case 'L': cname = "length";   break;
+    case 'B': cname = "bfield";   break;
+    default : return base;
+  }
+
+  double value_old = elmdict_[group.el[0]]->getChannel(cname)->value();
+  double s         = 1.0 + delta_d/value_old; 
+
+  std::map<Element const*, std::shared_ptr<Element>> clones;
+
+  for (int j=0; j<group.n; ++j) {
+    auto ep = elmdict_[group.el[j]];
+    auto e  = std::shared_ptr<Element>(ep->clone());
+    auto channel = e->getChannel(cname);
+    if (j == 0) { *channel += delta_d; }
+    else        { *channel *= s; }
+    clones[ep.get()] = e;
+  }
+
+  std::vector<std::shared_ptr<Element>> line(base);
+  int nelm = line.size();
+  for (int k=0; k<nelm; ++k) {
+    auto it = clones.find(beamline_.beamline_[k].get());
+    if (it != clones.end()) line[k] = it->second;
+  }
+  return line;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int OptimMainWindow::fitLeastSquares(OptimTextEditor* editor, Twiss vfin[], Twiss dv[], int npoint[],
+                                     FitElem group[], int ngr, FitStep* fstep, double& Q0, char* msg)
+{
+  //-------------------------------------------------------------------------------------------
+  // Levenberg-Marquardt fit. The unknowns are the changes of the group settings (first
+  // element in each group; the others follow proportionally, see ChangeGroupSetting()). 
+  // The Jacobian columns are obtained by forward differences on perturbed copies of the
+  // beamline, evaluated concurrently, and are reused across iterations (Broyden updates). 
+  // The maximum beta constraints enter through the sums of squared excesses (see addBetaExcess()), 
+  // which, unlike the largest beta value used by FindError(), are smooth in the fit parameters.
+  //
+  // returns 0 when done (msg is set), 1 if interrupted, 2 if the fit could not proceed
+  // (a message box has been shown). 
+  //-------------------------------------------------------------------------------------------
+
+  std::vector<double> applied(ngr, 0.0);   // changes currently applied to the lattice  
+  int npasses = 0;                         // no of lattice passes 
+  
+  auto apply = [&](std::vector<double> const& x) {
+    for (int i=0; i<ngr; ++i) {
+      if ( x[i] == applied[i] ) continue;
+      ChangeGroupSetting(&group[i], x[i]-applied[i]);
+      applied[i] = x[i];
+    }
+  };
+
+  auto residuals = [&](std::vector<double> const& x, std::vector<double>& r) {
+    apply(x);
+    for (int i=0; i<ngr; ++i) {
+      if( (grname[group[i].param]=='L') && (elmdict_[group[i].el[0]]->length() <= 0.0) ) return 1;  // negative length  
+    }
+    ++npasses;
+    return FindResiduals(beamline_.beamline_, vfin, dv, npoint, fstep, r, true);
+  };
+
+  auto jacobian = [&](std::vector<double> const& x, std::vector<double> const& r, std::vector<std::vector<double>>& J) {
+    apply(x);
+    int m      = r.size();
+    int status = 0;
+
+    // each thread works on its own copy of the beamline; elements are not safe to share
+    // between threads (e.g. the slice state, or caches kept by some elements).
+    
+    #pragma omp parallel reduction(|:status) 
+    {
+      auto line = clonedLine();
+      std::vector<double> rp;
+
+      #pragma omp for
+      for (int i=0; i<ngr; ++i) {
+        double h = FitElem::STEP_MULT*group[i].step;
+        if ( FindResiduals(perturbedLine(line, group[i], h), vfin, dv, npoint, fstep, rp, true) ) { // try the other side 
+          h = -h; 
+          if ( FindResiduals(perturbedLine(line, group[i], h), vfin, dv, npoint, fstep, rp, true) ) { status |= 1; continue; }
+        }
+        for (int k=0; k<m; ++k) J[k][i] = (rp[k]-r[k])/h;
+      }
+    }
+    npasses += ngr;
+    return status;
+  };
+
+  auto monitor = [&](int iter, double cost) {
+    QCoreApplication::processEvents();
+    QTextCursor itcursor = editor->textCursor();
+    itcursor.select(QTextCursor::LineUnderCursor);
+    itcursor.removeSelectedText();
+    editor->setTextCursor(itcursor);
+    editor->insertPlainText(QString::asprintf("n=%d \tQ0=%g \tN_passes=%d", iter, cost, npasses));
+    return !interrupted_;
+  };
+
+  LeastSquares solver(ngr, residuals, jacobian, monitor);
+
+  std::vector<double> x(ngr, 0.0);
+
+  auto status = solver(x, 1.0, 200);
+
+  apply(x);  // the last trial step may have been rejected 
+
+  if ( status == LeastSquares::aborted ) {
+    sprintf(msg, "Calculation was interrupted.");
+    return 1;
+  }
+  
+  if ( status == LeastSquares::failed ) {
+    OptimMessageBox::warning(this, "Fit", "Least squares fit: the lattice could not be evaluated (unstable or negative length). Fitting stopped.", QMessageBox::Ok);
+    return 2;
+  }
+
+  Q0 = FindError(vfin, dv, npoint, fstep);
+  if (Q0 < 0.0) return 2;
+
+  editor->insertPlainText(QString::asprintf("\n%d lattice passes, %d Jacobian evaluations", npasses, solver.jacobians()));
+
+  if ( status == LeastSquares::converged ) { sprintf(msg, "\nFitting successful: Q0=%g", Q0); }
+  else                                     { sprintf(msg, "\nCannot reach Q=1 (no further progress). Q0=%g", Q0); }
+
+  return 0;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
 int OptimMainWindow::DoStep(FitElem group[], int ngr, double* dG, double a) // V7
 {
    int er = 0;
@@ -940,12 +1365,10 @@ void OptimMainWindow::RewriteElementList( std::vector<std::shared_ptr<Element> >
   // AND a constraint on the phase advance has been specified.
   //...............................................................
 
-  if (  !CtSt_.use_fractional_tune && phase_advance_constraint_)  {
-    analyzeWithoutCompress(group, ngr, npoint);
-  }
-  else {
-    analyzeCompress(group, ngr, npoint);
-  }
+  // when the integer part of the phase advance is constrained, frozen segments are kept short
+  // enough for their phase advance to be unambiguous.  
+
+  analyzeCompress(group, ngr, npoint, !CtSt_.use_fractional_tune && phase_advance_constraint_);
   
   if((NElmListFit != nelmlist_ )  || ( ElmListFit_.empty() )) {
     OptimMessageBox::warning( this, "Fit", "Cannot undo fitting", QMessageBox::Ok);
@@ -1081,6 +1504,7 @@ void OptimMainWindow::cmdFitBetas () //V7
   emit fitInProgress();
   
   phase_advance_constraint_ = false; // reset this. It will be set to true if an enabled phase advance constraint is read.
+  ad_gradient_active_       = false;
  
   RMatrix tm;
   Twiss v;
@@ -1102,6 +1526,8 @@ void OptimMainWindow::cmdFitBetas () //V7
   int iter;
   int er=0;
 
+  char const* ad_reported = 0;
+
   FitStep fstep;
 
   char buf[257];
@@ -1131,12 +1557,7 @@ void OptimMainWindow::cmdFitBetas () //V7
   // when possible). 
   PrintFitParam (editor, &fstep, vfin, dv, npoint, group, ngr);
 
-  if ( !CtSt_.use_fractional_tune && phase_advance_constraint_)  {
-    analyzeWithoutCompress(group, ngr, npoint);
-  }
-  else {
-    analyzeCompress(group, ngr, npoint);
-  }
+  analyzeCompress(group, ngr, npoint, !CtSt_.use_fractional_tune && phase_advance_constraint_);
 
   if(GetFitParam (&fstep, vfin, dv, npoint2, group, ngr, false)) {
     emit fitDone();
@@ -1157,6 +1578,13 @@ void OptimMainWindow::cmdFitBetas () //V7
   step_dG  = fstep.dG;
   
   int k = 0;
+
+  if ( CtSt_.use_least_squares ) {
+    er = fitLeastSquares(editor, vfin, dv, npoint, group, ngr, &fstep, Q0, buf);
+    if (er == 2) goto err2;
+    goto err; 
+  }
+
   do {
    iter = 0;
    Qold = Q0;
@@ -1166,7 +1594,7 @@ void OptimMainWindow::cmdFitBetas () //V7
 
      if( interrupted_ ){ editor->insertPlainText("Calculation was interrupted."); er=1; goto err; }
 
-     if(j){
+     if(j && !ad_gradient_active_){ // the finite difference steps are not needed for the analytic gradient
         if(SetGradientStep(vfin, dv, npoint, group, ngr, &fstep)){er=2; goto err2;}
     } // return true if cannot close or step is too small; Message box; does not change settings
     
@@ -1174,6 +1602,11 @@ void OptimMainWindow::cmdFitBetas () //V7
       er=2; goto err2;
     } //return true if cannot close; Message box; does not change settings
 
+    if (ad_fallback_ && (ad_fallback_ != ad_reported)) {
+      editor->insertPlainText(QString::asprintf("Analytic gradient not applicable (%s); using finite differences.\n", ad_fallback_));
+      ad_reported = ad_fallback_;
+    }
+
     s = 0.0;
 
     for (int i=0; i<ngr; ++i)  s += G[i]*G[i];
@@ -1305,9 +1738,27 @@ err2:  // er=2 cannot close or step is too small or length is negative; comes he
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-int OptimMainWindow::analyzeCompress(FitElem group[], int ngr, int npoint[]) // V7
+int OptimMainWindow::analyzeCompress(FitElem group[], int ngr, int npoint[], bool keep_phase) // V7
 {
 
+  //-------------------------------------------------------------------------------------------
+  // Replace every maximal run of elements that is not touched by a fit group ("frozen segment")
+  // by a single transfer matrix. The fit objective is then evaluated over the segment matrices,
+  // the fitted elements and the observation points only.
+  //
+  // keep_phase: the phase advance of a transfer matrix is determined modulo 1/2 only. When
+  // true, frozen segments are split so that their phase advance (for the lattice functions
+  // at the start of the fit) does not exceed max_segment_phase in either plane. The integer
+  // part of the tunes is then preserved, with margin for the changes made by the fit.
+  //
+  // The result is kept in frozen_. A later fit over the same lattice, with the same groups and
+  // constraint locations, reuses the segment matrices as long as the parameters of every frozen
+  // element, the energy and the field tables are unchanged (the fitted elements may differ).
+  // The comparison is exact; it costs a pass over the element parameters, not over the matrices.
+  //-------------------------------------------------------------------------------------------
+
+  static double const max_segment_phase = 0.25;
+
    std::vector<std::shared_ptr<Element>>  edict; // tmp element dict  *ElmList2;
    Beamline bml;                                 // tmp beamline       Element **Elm2;       // references to Elements and their pointers
 
@@ -1356,6 +1807,81 @@ int OptimMainWindow::analyzeCompress(FitElem group[], int ngr, int npoint[]) //
 
   double tetaY =  tetaYo0_;
   double Enr   = Ein;
+
+  // lattice functions, used to limit the phase advance of frozen segments 
+
+  Twiss v;
+  Twiss vp;
+  std::complex<double>  ev[4][4];
+  std::complex<double> evp[4][4];
+
+  if (keep_phase) {
+    if( !CtSt_.IsRingCh ) {
+      setInitialBetas(v);
+    }
+    else {
+      RMatrix tm;
+      double  alfa;
+      findRMatrix(tm);
+      if ( find_tunes(tm, Length_, v, &alfa) ) keep_phase = false; // FindError() will report the problem  
+    }
+    v.nuX = v.nuY = 0.0;
+    v.eigenvectors(ev);
+  }
+
+  auto fitted = [&](Element const* ep) {
+    for(int k=0; k < ngr; ++k) {
+      for (int j=0; j<group[k].n; ++j) {
+        if( strcmp(ep->name(), elmdict_[group[k].el[j]]->name())== 0 ) return true;
+      }
+    }
+    return false;
+  };
+
+  std::vector<double>      key   = { Ein, ms, tetaYo0_, double(keep_phase), double(CtSt_.NStep), double(nelm_) };
+  std::vector<std::string> names;
+
+  key.insert(key.end(), npoint, npoint + std::max(npoint[0], 1));
+  if (keep_phase) key.insert(key.end(), { v.BtX, v.BtY, v.AlX, v.AlY, v.DsX, v.DsY, v.DsXp, v.DsYp });
+  for (auto& dat : ext_dat) {
+    int const n = std::min(dat.n, int(dat.y.size()));
+    key.push_back(n);
+    key.insert(key.end(), dat.x.begin(), dat.x.begin() + n);
+    key.insert(key.end(), dat.y.begin(), dat.y.begin() + n);
+  }
+  names.reserve(nelm_);
+  for (int i=0; i<nelm_; ++i) {
+    Element const* ep = beamline_[i].get();
+    bool fit = fitted(ep);
+    key.push_back(ep->etype());
+    key.push_back(fit);
+    names.push_back(ep->name());
+    if (fit && !keep_phase) continue; // the ring tunes depend on the fitted elements as well
+    char buf[1024];
+    ep->toString(buf);
+    names.back() += buf;
+    key.insert(key.end(), { ep->length(), ep->B, ep->G, ep->S, double(ep->N), ep->A, ep->tilt(), ep->tiltErr(), ep->offsX(), ep->offsY() });
+  }
+
+  if ( key == frozen_.key && names == frozen_.names ) {
+    edict.resize(frozen_.edict.size());
+    for (int k=0; k < int(edict.size()); ++k) {
+      int const src = frozen_.source[k];
+      edict[k] = std::shared_ptr<Element>( src < 0 ? frozen_.edict[k]->clone() : beamline_[src]->clone());
+    }
+    bml.resize(frozen_.layout.size());
+    for (int k=0; k < int(bml.size()); ++k) bml[k] = edict[frozen_.layout[k]];
+    std::copy(frozen_.npoint.begin(), frozen_.npoint.end(), npoint);
+
+    beamline_ = bml;
+    elmdict_  = edict;
+    nelm_     = beamline_.size();
+    nelmlist_ = elmdict_.size();
+    return frozen_.nf;
+  }
+
+  std::vector<int> source;  // see FrozenSegments 
+  std::vector<int> layout;
   
   int n  = 0;
   int nm = 0;
@@ -1366,11 +1892,23 @@ int OptimMainWindow::analyzeCompress(FitElem group[], int ngr, int npoint[]) //
   int br = 0;
 
   while ( i <nelm_) { // outer while loop
+
+    // splitting frozen segments may require more room than estimated above 
+ 
+    if ( nm + 2 > int(tmat2.size()) ) tmat2.resize(nm + 2);
+    if ( n  + 2 > int(bml.size())   ) bml.resize(n + 2);
+    if ( nL + 3 > int(edict.size()) ) edict.resize(nL + 3);
+    if ( nL + 3 > int(source.size())) source.resize(nL + 3);
+
     tmat2[nm].toUnity();
     EnrOld   = Enr;
     tetaYold = tetaY;
     Lelm     = 0.0;
 
+    int    istart = i;        // first element of the segment 
+    double nux0   = v.nuX;    // phase at the start of the segment 
+    double nuy0   = v.nuY;
+
     // compute and write transfer matrix between active Elements
 
     std::shared_ptr<Element> ep;
@@ -1379,13 +1917,7 @@ int OptimMainWindow::analyzeCompress(FitElem group[], int ngr, int npoint[]) //
       ep    = beamline_[i];
       Lelm += ep->length();
 
-      br    = 0;
-      for(int k=0; k < ngr; ++k) {
-        for (int j=0; j<group[k].n; ++j) {
-	   int nn = group[k].el[j];
-	   if( strcmp(ep->name(), elmdict_[nn]->name())== 0 ){ br = 1; break;}
-         }
-      }
+      br    = fitted(ep.get()) ? 1 : 0;
 
       if( npnt < npoint[0]) {
 	if(npoint[npnt]==(i+1)) {
@@ -1394,8 +1926,28 @@ int OptimMainWindow::analyzeCompress(FitElem group[], int ngr, int npoint[]) //
           br |= 2; // bitwise or with b00000010
         }
       }
+      double EnrI   = Enr;
+      double tetaYI = tetaY;
+
       me = ep->rmatrix(Enr, ms, tetaY, 0.0, 3);
 
+      if (keep_phase) {
+        vp = v; 
+        std::copy(&ev[0][0], &ev[0][0]+16, &evp[0][0]);
+        Element::propagateLatticeFunctions(me, vp, evp);
+
+        if ( !br && (i > istart) && ( (vp.nuX - nux0 > max_segment_phase) || (vp.nuY - nuy0 > max_segment_phase) ) ) { 
+          Enr    = EnrI;   // element i starts the next segment 
+          tetaY  = tetaYI;
+          Lelm  -= ep->length();
+          br     = 4;
+          break;
+        }
+
+        v = vp; 
+        std::copy(&evp[0][0], &evp[0][0]+16, &ev[0][0]);
+      }
+
       if(br) break;
 
       tmat2[nm] = me*tmat2[nm];
@@ -1426,12 +1978,15 @@ int OptimMainWindow::analyzeCompress(FitElem group[], int ngr, int npoint[]) //
 
      // ..................................................
      nm++;
+     source[nL] = -1;
+     layout.push_back(nL);
      bml[n++] = edict[nL++];
 
  
      if(i==nelm_)break;    //continue if it was break'ed at Element where twiss parameters have to be fitted
                            // copying parameters of Element to be adjusted (fitted)
      if(br==2){ ++i; continue;}
+     if(br==4){ continue;}      // frozen segment split 
 
      int br1 = 0;
      int k   = 0;
@@ -1439,11 +1994,14 @@ int OptimMainWindow::analyzeCompress(FitElem group[], int ngr, int npoint[]) //
      for( k=0; k<nL; ++k) if(strcmp(ep->name(), edict[k]->name())==0) { br1=1; break;}
 
      if(br1){
+        layout.push_back(k);
         bml[n++] = edict[k];
      }
      else{
 
-       edict[nL] = std::shared_ptr<Element>(ep->clone());
+       edict[nL]  = std::shared_ptr<Element>(ep->clone());
+       source[nL] = i;
+       layout.push_back(nL);
        bml[n++] = edict[nL++];
      }
 
@@ -1471,6 +2029,16 @@ int OptimMainWindow::analyzeCompress(FitElem group[], int ngr, int npoint[]) //
    // bml and  edict need to be trimmed to their actual size 
    bml.erase(bml.begin() + n,  bml.end()); 
    edict.erase(edict.begin() + nL,  edict.end()); 
+   source.resize(nL);
+
+   frozen_.key    = std::move(key);
+   frozen_.names  = std::move(names);
+   frozen_.source = std::move(source);
+   frozen_.layout = std::move(layout);
+   frozen_.npoint.assign(npoint, npoint + std::max(npoint[0], 1));
+   frozen_.nf     = Nf;
+   frozen_.edict.clear();
+   for (auto& e : edict) frozen_.edict.push_back(std::shared_ptr<Element>(e->clone()));
    
    // overwrite beamline and elmdict_ with the new ones
    
@@ -1677,6 +2245,7 @@ void OptimMainWindow::cmdFittingUndo()
                  trajectoryAct_->setEnabled(false);
              typeTrajectoryAct_->setEnabled(false);
             closeTrajectoryAct_->setEnabled(false);
+               correctOrbitAct_->setEnabled(false);
                 tuneDiagramAct_->setEnabled(false);
            showExternalFileAct_->setEnabled(false);
                toolsControlAct_->setEnabled(false);
@@ -1687,6 +2256,7 @@ void OptimMainWindow::cmdFittingUndo()
                     phasesAct_->setEnabled(false);
        functionsAtElementsAct_->setEnabled(false);
                  integralsAct_->setEnabled(false);
+                resonancesAct_->setEnabled(false);
                     matrixAct_->setEnabled(false);
            integrationStepAct_->setEnabled(false);
                  functionsAct_->setEnabled(false);
@@ -546,6 +546,9 @@ void OptimMainWindow::ctor()
   elmdict_.clear();  
   nelmlist_   = 0;
   NElmListFit = 0;
+  ad_gradient_active_ = false;
+  ad_fallback_        = 0;
+  frozen_.nf          = 0;
 
   m1            = 1;
   m2            = 1;
@@ -1387,6 +1390,7 @@ void OptimMainWindow::cmdEditRedo()
             typeTrajectoryAct_ =  new QAction( tr("Type Trajectory"), this);
             typeTrajectoryAct_->setShortcut( QKeySequence(tr("Alt+Shift+T") ));
            closeTrajectoryAct_ =  new QAction( tr("Close Trajectory"), this);
+              correctOrbitAct_ =  new QAction( tr("Orbit Correction ..."), this);
                tuneDiagramAct_ =  new QAction( tr("Tune Diagram ..."), this);
                tuneDiagramAct_->setShortcut( QKeySequence(tr("Alt+Shift+D") ));
               toolsControlAct_ =  new QAction( tr("Control"), this);
@@ -1398,6 +1402,7 @@ void OptimMainWindow::cmdEditRedo()
        connect(tuneDiagramAct_,             SIGNAL(triggered()), this, SLOT(cmdTuneDiagram()) );
        connect(typeTrajectoryAct_,          SIGNAL(triggered()), this, SLOT(cmdTypeTrajectory()) );
        connect(closeTrajectoryAct_,         SIGNAL(triggered()), this, SLOT(cmdCloseTraject()) );
+       connect(correctOrbitAct_,            SIGNAL(triggered()), this, SLOT(cmdCorrectOrbit()) );
        connect(trajectoryAct_,              SIGNAL(triggered()), this, SLOT(cmdTrajectory()) );
        connect(trajectoryNewAct_,           SIGNAL(triggered()), this, SLOT(cmdTrajectoryNew()) );
        connect(trackerAct_,                 SIGNAL(triggered()), this, SLOT(cmdTracker()) );
@@ -1423,6 +1428,7 @@ void OptimMainWindow::cmdEditRedo()
       functionsAtElementsAct_->setShortcut( QKeySequence(tr("F8") ));
                 integralsAct_ =  new QAction( QIcon(":/bitmaps/INTEGR.BMP"),tr("Integrals"),      this);
                 integralsAct_->setShortcut( QKeySequence(tr("Alt+I") ));
+               resonancesAct_ =  new QAction( tr("Resonance Terms"),  this);
                    matrixAct_ =  new QAction( tr("Matrix ..."),         this);
                    matrixAct_->setShortcut( QKeySequence(tr("Alt+M") )); 
           integrationStepAct_ =  new QAction( tr("Integration Step ..."),    this);
@@ -1448,6 +1454,7 @@ void OptimMainWindow::cmdEditRedo()
 	connect(betasNewAct_, SIGNAL(triggered()), this, SLOT(cmdBetasNew()));
 	// connect(betasLAct_,   SIGNAL(triggered()), this, SLOT(cmdLBetas())); // long betas
 	connect(integralsAct_, SIGNAL(triggered()), this, SLOT(cmdIntegrals()));
+	connect(resonancesAct_, SIGNAL(triggered()), this, SLOT(cmdResonances()));
 	connect(phasesAct_,    SIGNAL(triggered()), this, SLOT(cmdPhases()));	
         connect(sizesAct_,     SIGNAL(triggered()), this, SLOT(cmdSizes()));
         connect(matrixAct_,    SIGNAL(triggered()), this, SLOT(cmdViewMatrix()));
@@ -1674,6 +1681,7 @@ void OptimMainWindow::cmdEditRedo()
     toolsMenu_->addAction(trajectoryNewAct_);
     toolsMenu_->addAction(typeTrajectoryAct_);
     toolsMenu_->addAction(closeTrajectoryAct_);
+    toolsMenu_->addAction(correctOrbitAct_);
     toolsMenu_->addSeparator();
     toolsMenu_->addAction(tuneDiagramAct_);
     toolsMenu_->addSeparator();
@@ -1692,6 +1700,7 @@ void OptimMainWindow::cmdEditRedo()
     viewMenu_->addSeparator();
     viewMenu_->addAction(functionsAtElementsAct_); 
     viewMenu_->addAction(integralsAct_);  
+    viewMenu_->addAction(resonancesAct_);  
     viewMenu_->addAction(matrixAct_);  
     viewMenu_->addAction(integrationStepAct_);  
     viewMenu_->addSeparator();
@@ -2060,7 +2069,16 @@ int OptimMainWindow::closeTrajectFull (Coordinates& vf)
   QCursor saved_cursor = cursor();
   setCursor(Qt::BusyCursor);
   
-  
+  if (!NstTool.LinClosure) {  
+    // Newton iterations on the one-turn tracking map. The Jacobian from the previous 
+    // closure is reused when possible, e.g. after a small knob change. 
+    closed_orbit_.maxIterations(Ncvg);
+    closed_orbit_.tolerance(CvgErr);
+    int status = closed_orbit_(beamline_.beamline_, ms, Ein, tetaYo0_, vf, NstTool.Closure4D ? 4 : 6);
+    setCursor(saved_cursor);
+    return status ? 1 : 0;
+  }
+
   Coordinates v = vf;
   
   int ncl = (NstTool.Closure4D) ?  4 : 6;
@@ -3298,6 +3316,7 @@ readFieldIntegralAct_->setEnabled(false);
         trajectoryNewAct_->setEnabled(false);
        typeTrajectoryAct_->setEnabled(false);
       closeTrajectoryAct_->setEnabled(false);
+         correctOrbitAct_->setEnabled(false);
           tuneDiagramAct_->setEnabled(true);
      showExternalFileAct_->setEnabled(true);
          toolsControlAct_->setEnabled(true);
@@ -3308,6 +3327,7 @@ readFieldIntegralAct_->setEnabled(false);
               phasesAct_->setEnabled(false);
  functionsAtElementsAct_->setEnabled(false);
            integralsAct_->setEnabled(false);
+          resonancesAct_->setEnabled(false);
               matrixAct_->setEnabled(false);
      integrationStepAct_->setEnabled(false);
            functionsAct_->setEnabled(false);
@@ -3404,6 +3424,7 @@ readFieldIntegralAct_->setEnabled(true);
         trajectoryNewAct_->setEnabled(true);
        typeTrajectoryAct_->setEnabled(true);
       closeTrajectoryAct_->setEnabled(true);
+         correctOrbitAct_->setEnabled(true);
           tuneDiagramAct_->setEnabled(true);
      showExternalFileAct_->setEnabled(true);
          toolsControlAct_->setEnabled(true);
@@ -3414,6 +3435,7 @@ readFieldIntegralAct_->setEnabled(true);
               phasesAct_->setEnabled(true);
  functionsAtElementsAct_->setEnabled(true);
            integralsAct_->setEnabled(true);
+          resonancesAct_->setEnabled(true);
               matrixAct_->setEnabled(true);
      integrationStepAct_->setEnabled(true);
            functionsAct_->setEnabled(true);
@@ -4863,11 +4885,15 @@ void OptimMainWindow::cmdFittingControl()
   }
 
   dialog->data_.use_fractional_tune = CtSt_.use_fractional_tune;
+  dialog->data_.use_ad_gradient     = CtSt_.use_ad_gradient;
+  dialog->data_.use_least_squares   = CtSt_.use_least_squares;
   dialog->set();
 
   if (dialog->exec() == QDialog::Rejected) return;
 
   CtSt_.use_fractional_tune = dialog->data_.use_fractional_tune; 
+  CtSt_.use_ad_gradient     = dialog->data_.use_ad_gradient; 
+  CtSt_.use_least_squares   = dialog->data_.use_least_squares; 
 
 }
 
@@ -58,6 +58,7 @@
 #include <ScatterData.h>
 #include <ScatterPlotItem.h>
 #include <Structs.h>
+#include <SplineInterpolator.h>
 #include <Tracker3DSeriesData.h>
 #include <TrackerPlot.h>
 #include <TrackerSaveDistributionDialog.h>
@@ -917,23 +918,27 @@ int OptimTracker::trackWake(Element const* ep, Bunch& v, int N, double Enr0, dou
    std::vector<double> sb(nb);
    std::vector<double> wx(nb);
    std::vector<double> wy(nb);
-   std::vector<double> vx(nb);
-   std::vector<double> vy(nb);
+   std::vector<double> ds(nb);
+   std::vector<double> wk(nb);
 
-   int rt=0;
    double deltaS=(smax-smin)/(nb-7);
    for(int i=0; i<nb; ++i){
       sb[i]=smin+(i-3)*deltaS;
       wx[i]=0.;
       wy[i]=0.;
    }
+
+   // wake function; the interval lookup is O(1) when the table is uniformly spaced
+   SplineInterpolator wake(&p->x[0], &p->y[0], p->n);
+
    double x,y;
    // computing wake at reference coordinates
    for(int i=0; i<N; ++i) {
-      for( int n=0; n<nb; ++n) {
-        x = v[i][4] - sb[n];
-        if(x<0.0) continue;
-        if(splint( &p->x[0], &p->y[0], &p->v[0], p->n, x, &y)){rt=3; goto rttw;} //spline err
+     for( int n=0; n<nb; ++n) ds[n] = v[i][4] - sb[n];
+     wake.evaluate(&ds[0], &wk[0], nb);
+     for( int n=0; n<nb; ++n) {
+        if(ds[n]<0.0) continue;
+        y = wk[n];
         switch(ep->plane()){
    	  case 0:  // T - both transverse
       	    wx[n] += v[i][0]*ep->B*y/(N*P0);
@@ -951,18 +956,27 @@ int OptimTracker::trackWake(Element const* ep, Bunch& v, int N, double Enr0, dou
         }
        }
      }
-     // Filtering and setting spline
+     // Filtering and setting spline (uniform bins)
      Filter7(&wx[0], nb);
-     spline(&sb[0], &wx[0], nb, &vx[0]);
+     SplineInterpolator wakex(sb[0], deltaS, &wx[0], nb);
+     SplineInterpolator wakey;
      if(!ep->plane()){
      Filter7(&wy[0], nb);
-     spline(&sb[0], &wy[0], nb, &vy[0]);}
+     wakey = SplineInterpolator(sb[0], deltaS, &wy[0], nb);}
+
      // Computing corrections
+     std::vector<double> s(N);
+     std::vector<double> kx(N);
+     std::vector<double> ky(N);
+     for(int i=0; i<N; ++i) s[i] = v[i][4];
+     wakex.evaluate(&s[0], &kx[0], N);
+     if(!ep->plane()) wakey.evaluate(&s[0], &ky[0], N);
+
      for(int i=0; i<N; ++i) {
-       if(splint(&sb[0], &wx[0], &vx[0], nb, v[i][4], &x)){rt=4; goto rttw;}//spline err
+       x = kx[i];
        switch(ep->plane()){
    	 case 0:  // T - both transverse
-   	   if(splint(&sb[0], &wy[0], &vy[0], nb, v[i][4], &y)){rt=5; goto rttw;}//spline err
+   	   y = ky[i];
       	   v[i][1] +=x;
       	   v[i][3] +=y;
       	   break;
@@ -978,8 +992,7 @@ int OptimTracker::trackWake(Element const* ep, Bunch& v, int N, double Enr0, dou
       }
    }
 
-rttw:
-   return rt;
+   return 0;
 }
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
@@ -50,7 +50,9 @@
 #include <Histogram.h>
 #include <RMatrix.h>
 #include <Cholesky.h>
+#include <LatticeProgram.h>
 //#include <OptimExceptions.h>
+#include <OptimEditor.h>
 #include <OptimMainWindow.h>
 #include <OptimMdiArea.h>
 #include <OptimMdiSubWindow.h>
@@ -63,14 +65,17 @@
 #include <ScatterData.h>
 #include <ScatterPlotItem.h>
 #include <Structs.h>
+#include <SplineInterpolator.h>
 #include <SQLSeriesData.h>
 //#include <Tracker3DSeriesData.h>
+#include <TrackCheckpoint.h>
 #include <TrackerParameters.h>
 #include <TrackerPlot.h>
 #include <TrackerPlot6.h>
 #include <TrackerSaveDistributionDialog.h>
 #include <TrackerDistributionDialogNew.h>
 #include <TrackingParametersNewDialog.h>
+#include <RandomStream.h>
 #include <TrackParam.h>
 #include <Twiss.h>
 #include <Utility.h>
@@ -80,6 +85,7 @@
 #include <QActionGroup>
 #include <QApplication>
 #include <QCheckBox>
+#include <QDir>
 #include <QFileDialog>
 #include <QHBoxLayout>
 #include <QHeaderView>
@@ -324,6 +330,8 @@ eigenemittancesAct_= new QAction( "EigenEmittances",       this);
   MatchCase_      = false;
   p_elm_view_.resize(0) ;
   TotalTurnsTracked_ = 0;
+  CheckpointInterval_ = 0;
+  Resume_            = false;
  
    // Save track data to file
    
@@ -679,6 +687,8 @@ void OptimTrackerNew::cmdParameters()
   st.IncrementTurns  = IncrementTurns_;
   st.MatchCase       = MatchCase_;
   st.dataspec        = TrackerParameters::all;
+  st.CheckpointInterval = CheckpointInterval_;
+  st.Resume          = Resume_;
 
   dialog->set(st);  
 
@@ -693,6 +703,8 @@ void OptimTrackerNew::cmdParameters()
   IncrementTurns_= st.IncrementTurns;
   MatchCase_     = st.MatchCase;
   dataspec_      = st.dataspec;         
+  CheckpointInterval_ = st.CheckpointInterval;
+  Resume_        = st.Resume;
 
   if(nturn_<1) {nturn_=1;}
 
@@ -1085,7 +1097,6 @@ int OptimTrackerNew::trackBunchExact(Element const* ep, double Enr0,  RMatrix_t<
 
   //std::cout << " OptimTrackerNew::trackBunchExact element: " << ep->name() << std::endl;
   TrackParam prm;
-  double enr;
   int    rt = 0;
   static char const *msg[]={
     "Bunch contains only one particle !",
@@ -1110,17 +1121,172 @@ int OptimTrackerNew::trackBunchExact(Element const* ep, double Enr0,  RMatrix_t<
   m1.toUnity();
   ep->preTrack(frame, mainw_->ms, Enr0, n_elem, prm, m1);
 
- 
-int kloop = 0;
-int kcond = 0;
+  return ep->trackBunch(mainw_->ms, Enr0, n_elem, n_turn, prm, m1, v, N, parallel_tracking_); // lost particles are skipped
+}
 
-  #pragma omp parallel for if( parallel_tracking_) 
-  for(int j=0; j<N; ++j) {
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+bool OptimTrackerNew::particleMajorTracking(bool poincare) const
+{
+  // Particle-major tracking is possible when every element acts on each particle
+  // independently and nothing needs the whole bunch between two selected elements. 
+
+  if (TrackFast_ || poincare || IncrementTurns_ ) return false;
+  if (CheckpointInterval_ > 0)                     return false; // checkpoints are taken at turn boundaries
+  if (dataspec_ == TrackerParameters::all)         return false; // moments after every element  
+
+  for (int i=0; i<mainw_->nelm_; ++i) {
+    if (toupper(mainw_->beamline_[i]->name()[0]) == 'Y') return false; // wake field 
+  }
+  return true;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+std::string OptimTrackerNew::checkpointName() const
+{
+  // next to the lattice file: <lattice>.ckpt, the moments in <lattice>.ckpt.db 
+
+  OptimEditor* editor = mainw_->LatticeCh_ ? qobject_cast<OptimEditor*>(mainw_->LatticeCh_->widget()) : 0;
+  QString fname = editor ? editor->fileInfo().absoluteFilePath() : QDir::current().absoluteFilePath("tracking");
+
+  return std::string(fname.toUtf8().data()) + ".ckpt";
+}
 
-    enr = Enr0;
-    if (v[j].lost != 0 ) continue; // do not track lost particles. 
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-    ep->trackOnce(mainw_->ms, enr, n_elem, n_turn,  prm,  m1, v[j] );
+int OptimTrackerNew::trackParticleMajor(RMatrix_t<3> frame, Bunch& v, double gamma, OptimTextEditor* editor)
+{
+  //-------------------------------------------------------------------------------------------
+  // Particle-major scheduler. Each thread takes a block of particles small enough to remain
+  // in cache and carries it through all the elements for a chunk of turns before moving on
+  // to the next block. The moments at the selected elements are accumulated as per-thread
+  // partial sums, merged and written to the database at the end of each chunk.
+  //
+  // The element parameters are computed once; this requires the energy and the orientation
+  // of the frame to be the same at the start of every turn. Returns 1 (nothing tracked) when
+  // this is not the case, 0 otherwise. 
+  //-------------------------------------------------------------------------------------------
+
+  static int const block_size = 256; // particles per block; 256 x sizeof(Coordinates) fits in L1/L2   
+
+  int    nelm  = mainw_->nelm_;
+  double ms    = mainw_->ms;
+  double tetaY = mainw_->tetaYo0_;
+  double Enr   = mainw_->Ein;
+
+  std::vector<double>     spos(nelm);
+
+  RMatrix_t<3> frame0 = frame;
+  double s = 0.0;
+
+  LatticeProgram program;
+  program.compile(mainw_->beamline_.beamline_, frame, ms, Enr, tetaY);
+
+  for (int i=0; i<nelm; ++i) {
+    auto ep = mainw_->beamline_[i];
+    switch (toupper(ep->name()[0])) {
+      case 'A':
+      case 'W':
+      case 'E':
+      case 'X': {
+        double EnrNew = Enr;
+        ep->rmatrix(EnrNew, ms, tetaY, 0.0, 3);
+        if (fabs((EnrNew-Enr)/Enr) > 1.0e-12) return 1; // acceleration
+        break;
+      }
+      default:
+        break;
+    }
+    s += ep->length()*0.01;
+    spos[i] = s;
+  }
+
+  for (int i=0; i<3; ++i) {
+    for (int j=0; j<3; ++j) {
+      if (fabs(frame[i][j]-frame0[i][j]) > 1.0e-9) return 1; // the line does not close on itself
+    }
+  }
+
+  std::vector<int> sel;
+  for (auto it = elm_selection_.s.cbegin(); it != elm_selection_.s.cend(); ++it) {
+    if (it->first >= 0 && it->first < nelm) sel.push_back(it->first);
+  }
+  int nsel = sel.size();
+
+  int nthreads = parallel_tracking_ ? omp_get_max_threads() : 1;
+  int chunk    = std::max(1, nturn_/100);    // turns per chunk
+
+  std::vector<std::vector<MomentSums>> partial(nthreads);
+
+  for (int k0=0; k0<nturn_; k0 += chunk) {
+
+    int nk = std::min(chunk, nturn_-k0);
+
+    v.compact();   // only the survivors are visited 
+    
+    int N       = v.active();
+    int nblocks = (N + block_size - 1)/block_size;
+    int nremoved = v.size() - N;
+
+    for (auto& p : partial) p.assign(nk*nsel, MomentSums());
+
+#pragma omp parallel num_threads(nthreads) if(parallel_tracking_)
+    {
+      auto& sums = partial[omp_get_thread_num()];
+
+#pragma omp for schedule(dynamic)
+      for (int b=0; b<nblocks; ++b) {
+
+        int jbeg = b*block_size;
+        int jend = std::min(N, jbeg+block_size);
+
+        for (int k=0; k<nk; ++k) {
+          int is = 0;
+          for (int i=0; i<nelm; ++i) {
+            program.run(i, TotalTurnsTracked_+k+1, v, jbeg, jend);  // lost particles are skipped 
+            if (is < nsel && sel[is] == i) {
+              MomentSums& acc = sums[k*nsel+is];
+              for (int j=jbeg; j<jend; ++j) acc.add(v[j]);
+              ++is;
+            }
+          }
+        }
+      } // blocks
+    } // parallel
+
+    for (int k=0; k<nk; ++k) {
+      for (int is=0; is<nsel; ++is) {
+        MomentSums total;
+        for (auto const& p : partial) total.merge(p[k*nsel+is]);
+        total.n     += nremoved;
+        total.nlost += nremoved;
+        BeamMoments mom(gamma, total);
+        mom.s = spos[sel[is]];
+        mom.dbWrite(*con_, TotalTurnsTracked_+k, sel[is], N_);
+      }
+    }
+
+    TotalTurnsTracked_ += nk;
+
+    if (PrintResults_) {
+      QTextCursor cursor = editor->textCursor();
+      cursor.select(QTextCursor::LineUnderCursor);
+      cursor.removeSelectedText();
+      editor->insertPlainText(QString("Tracked %1 of %2 turns.").arg(k0+nk).arg(nturn_));
+    }
+
+    progress_bar_->setValue(int( double(k0+nk)/double(nturn_) * 100.0 ));  
+    QCoreApplication::processEvents();
+
+    if (mainw_->interrupted_) {
+      mainw_->interrupted_ = OptimQuestionMessage(this,  "Tracking", "Do you want to interrupt tracking  ?",
+                                                  QMessageBox::Yes| QMessageBox::No) == QMessageBox::Yes;
+      if (mainw_->interrupted_) break;
+    }
   }
 
   return 0;
@@ -1219,7 +1385,7 @@ void OptimTrackerNew::cmdTrackingNew( bool poincare) // V7
   //for(int i=0; i<N_; ++i) loss_[i].lost = 0; // THIS SHOULD NOT BE NEEDED !!
 
   if (TotalTurnsTracked_ == 0 ) {
-    for( int i=0; i<N_; ++i) { vfin_[i] = vin_[i];}
+    vfin_ = vin_;
   }  
 
    Bunch& v = vfin_;
@@ -1257,12 +1423,78 @@ void OptimTrackerNew::cmdTrackingNew( bool poincare) // V7
   // omp_set_num_threads(4); 
 
   int kin = 0;
+
+  RandomStream::reseed();   // per-particle streams of the stochastic elements (foils, scattering) for this run
+
+  // checkpoint/restart. The streams are keyed on the cumulative turn no, so that a resumed run
+  // reproduces the bits of an uninterrupted one.
+
+  std::string ckpt_name = checkpointName();
+  bool resumed = false;
+
+  if (Resume_) {
+    Resume_ = false;
+    TrackCheckpoint cp;
+    if ( TrackCheckpoint::read(ckpt_name, cp) || (cp.nelm != mainw_->nelm_) || (int(cp.bunch.size()) != N_) ) {
+      snprintf(buf, sizeof(buf), "Cannot resume tracking: checkpoint %s is missing or does not match the lattice and the distribution", ckpt_name.c_str());
+      OptimMessageBox::warning(this, "Tracking", buf, QMessageBox::Ok);
+      return;
+    }
+    if ( TrackCheckpoint::loadMoments(*con_, ckpt_name + ".db", cp.turn) ) {
+      snprintf(buf, sizeof(buf), "Cannot restore the moments saved in %s.db", ckpt_name.c_str());
+      OptimMessageBox::warning(this, "Tracking", buf, QMessageBox::Ok);
+    }
+    cp.restoreRng();
+    vfin_              = std::move(cp.bunch);
+    TotalTurnsTracked_ = cp.turn;
+    Enr                = cp.Enr;
+    gamma              = 1.0+Enr/ms;
+    dPdE               = (Enr+ms)/(Enr*Enr+2.*Enr*ms);
+    Hrt                = sqrt(2.*ms*Enr+Enr*Enr)/C_DERV1;
+    resumed            = true;
+    if ( IncrementTurns_ && mainw_->analyze(false, TotalTurnsTracked_+1) ) return;
+  }
+
+  std::unique_ptr<CheckpointWriter> writer;
+  if (CheckpointInterval_ > 0) writer = std::make_unique<CheckpointWriter>(ckpt_name, con_);
+  int ckpt_status = 0;
+
+  // without collective elements, carry blocks of particles through many turns at a time 
+
+  if ( particleMajorTracking(poincare) && !trackParticleMajor(frame, v, gamma, editor) ) kin = nturn_; 
+
+  // exact tracking executes the compiled line. The program covers one turn; it is recompiled
+  // when the energy or the frame at the start of a turn differ from those it was compiled for.   
+
+  LatticeProgram program;
+  RMatrix_t<3>   prog_frame_in;
+  RMatrix_t<3>   prog_frame_out;
+  double         prog_enr = -1.0;
+
+  auto sameFrame = [](RMatrix_t<3> const& a, RMatrix_t<3> const& b) {
+    for (int r=0; r<3; ++r) {
+      for (int c=0; c<3; ++c) if (a[r][c] != b[r][c]) return false;
+    }
+    return true;
+  };
   
   for(int k=kin; k<nturn_; ++k) {
 
      ie = 0;
      double spos = 0.0; // position around the ring
 
+     if (!TrackFast_) {
+       if ( (Enr != prog_enr) || !sameFrame(frame, prog_frame_in) ) {
+         prog_enr      = Enr;
+         prog_frame_in = frame;
+         program.compile(mainw_->beamline_.beamline_, frame, ms, Enr, tetaY);  // advances frame 
+         prog_frame_out = frame;
+       }
+       else {
+         frame = prog_frame_out;
+       }
+     }
+
      if(dataspec_ == TrackerParameters::all) {  // INITIAL CONDITION FOR OUTPUT AT ALL ELEMENTS 
            BeamMoments mom(gamma,v, N_, parallel_tracking_);
 	   mom.s = spos;
@@ -1272,52 +1504,51 @@ void OptimTrackerNew::cmdTrackingNew( bool poincare) // V7
      for(int i=0; i <mainw_->nelm_; ++i) { 
 
        auto ep     = mainw_->beamline_[i];
-       nm     = toupper(ep->name()[0]);
-       dSdP   = ep->length()/(gamma*gamma);
-       EnrNew = Enr;
-       
-       // compute transfer matrix (for fast tracking) 
-       switch(nm){
-         case 'A': // pill-box cavity 
-	 case 'W': // general rf cavity
-           dPdS = dPdE*2.*PI*ep->G/ep->tilt()*sin(PI/180.*ep->S);
-	 case 'E': // electrostatic acc
-	 case 'X': // xfer matrix 
-	    me = ep->rmatrix( EnrNew, ms, tetaY, 0.0, 3);
-	    capa = sqrt(sqrt((2.*Enr*ms+Enr*Enr)/(2.*EnrNew*ms+EnrNew*EnrNew)));
-            break;
-	  case 'K': //transverse corrector
-            dtx = ep->length()*ep->B/Hrt*cos(PI*ep->tilt()/180.);
-            dty = ep->length()*ep->B/Hrt*sin(PI*ep->tilt()/180.);
-          default:
-            if( TrackFast_ ) { me = ep->rmatrix(Enr, ms, tetaY, 0.0, 3); };  // matrix is needed only for fast tracking 
-            break;
-       }
-       
-       //*** ep->propagateLatticeFunctions(me, twiss, ev); // Why is twiss required ??? is it used ???
-                                                           // is this an incomplete attempt at modeling space charge ??  
 
        if( TrackFast_ ) { // TrackFast_ == Track using transfer matrices. Also include correctors
 	                  // and update energy when going through accelerating elements.    
-	     trackBunch(nm, Hrt, ep.get(), v, me, N_, k+1, i, dPdS, dPdE, capa, dtx, dty, dSdP);
+         nm     = toupper(ep->name()[0]);
+         dSdP   = ep->length()/(gamma*gamma);
+         EnrNew = Enr;
+       
+         switch(nm){
+           case 'A': // pill-box cavity 
+	   case 'W': // general rf cavity
+             dPdS = dPdE*2.*PI*ep->G/ep->tilt()*sin(PI/180.*ep->S);
+	   case 'E': // electrostatic acc
+	   case 'X': // xfer matrix 
+	      me = ep->rmatrix( EnrNew, ms, tetaY, 0.0, 3);
+	      capa = sqrt(sqrt((2.*Enr*ms+Enr*Enr)/(2.*EnrNew*ms+EnrNew*EnrNew)));
+              break;
+	    case 'K': //transverse corrector
+              dtx = ep->length()*ep->B/Hrt*cos(PI*ep->tilt()/180.);
+              dty = ep->length()*ep->B/Hrt*sin(PI*ep->tilt()/180.);
+            default:
+              me = ep->rmatrix(Enr, ms, tetaY, 0.0, 3); 
+              break;
+         }
+       
+         //*** ep->propagateLatticeFunctions(me, twiss, ev); // Why is twiss required ??? is it used ???
+                                                             // is this an incomplete attempt at modeling space charge ??  
+
+	 trackBunch(nm, Hrt, ep.get(), v, me, v.active(), TotalTurnsTracked_+1, i, dPdS, dPdE, capa, dtx, dty, dSdP);
        }
        else {
-	   // NOTE: TrackFast_==false
-	   if(trackBunchExact(ep.get(), Enr, frame, v, N_, k+1, i)) { mainw_->interrupted_ = true; return; }
+         if (program.collective(i)) { // wake field 
+	   if(trackBunchExact(ep.get(), Enr, frame, v, v.active(), TotalTurnsTracked_+1, i)) { mainw_->interrupted_ = true; return; }
+         }
+         else {
+           program.run(i, TotalTurnsTracked_+1, v, v.active(), parallel_tracking_);  // lost particles are skipped 
+         }
+         EnrNew = program.energy(i+1);
        }
 	 
-       switch(nm){
-          case 'E': 
-          case 'X': 
-          case 'A': 
-          case 'W':
-             Enr   = EnrNew;
-   	     gamma = 1.0+Enr/ms;
-   	     dPdE  = (Enr+ms)/(Enr*Enr+2.*Enr*ms);
-             Hrt   = sqrt(2.*ms*Enr+Enr*Enr)/C_DERV1;
-           default:
-             break;
-        } // switch
+       if (EnrNew != Enr) {  // accelerating element 
+         Enr   = EnrNew;
+         gamma = 1.0+Enr/ms;
+         dPdE  = (Enr+ms)/(Enr*Enr+2.*Enr*ms);
+         Hrt   = sqrt(2.*ms*Enr+Enr*Enr)/C_DERV1;
+       }
 
   	spos += ep->length()*0.01;
 
@@ -1333,7 +1564,6 @@ void OptimTrackerNew::cmdTrackingNew( bool poincare) // V7
              BeamMoments mom(gamma,v, N_, parallel_tracking_);
 	     mom.s = spos;
 	     mom.dbWrite(*con_, TotalTurnsTracked_, i, N_);
-	     v.lossProfile();
 	  }   
         }
        
@@ -1355,12 +1585,14 @@ void OptimTrackerNew::cmdTrackingNew( bool poincare) // V7
  
      TotalTurnsTracked_++;
 
+     v.compact(); // remove the particles lost during this turn from the active range 
+
      //     if( !averaged_ && (view_at_elem_ == -1 ) ){
      //     BeamMoments mom(gamma,v, N_, parallel_tracking_);
      //     mom.dbWrite(*con_, TotalTurnsTracked_, 0, N_);
      //}
 
-     if(k==kin) { 
+     if( (k==kin) && !resumed ) { 
          if(fabs((mainw_->Ein -Enr)/mainw_->Ein)>1.e-12){
              sprintf(buf,
               "On the first turn, the beam was accelerated by %e percent. This can cause instability in further tracking. Do you want to proceed ?",
@@ -1383,6 +1615,15 @@ void OptimTrackerNew::cmdTrackingNew( bool poincare) // V7
       	  editor->insertPlainText(buf);
       }
 
+     if ( writer && (TotalTurnsTracked_ % CheckpointInterval_ == 0) && (k+1 < nturn_) ) {
+        TrackCheckpoint cp;
+        cp.turn  = TotalTurnsTracked_;
+        cp.nelm  = mainw_->nelm_;
+        cp.Enr   = Enr;
+        cp.bunch = v;
+        cp.saveRng();
+        ckpt_status |= writer->save(std::move(cp));
+     }
 
      
      if( IncrementTurns_){ 
@@ -1398,12 +1639,18 @@ void OptimTrackerNew::cmdTrackingNew( bool poincare) // V7
 	   fmt::print(fpu_.get(),"{:12.6g} {:12.6g} {:12.6g} {:12.6g} {:12.6g} {:12.6g} {:12d} \n",
 	  	                      v[i].c[0],v[i].c[1],
 		                      v[i].c[2],v[i].c[3],
-		                      v[i].c[4],v[i].c[5], i);
+		                      v[i].c[4],v[i].c[5], v[i].pid);
 	};
       } // if poincare
   }; // for int k=nturns ... 
 
 
+  if (writer) ckpt_status |= writer->wait();
+  if (ckpt_status) {
+    snprintf(buf, sizeof(buf), "Failed to write tracking checkpoint %s", ckpt_name.c_str());
+    OptimMessageBox::warning(this, "Tracking", buf, QMessageBox::Ok);
+  }
+
   //....................................................
 
    progress_bar_->setValue(100);
@@ -1435,6 +1682,21 @@ void OptimTrackerNew::cmdTrackingNew( bool poincare) // V7
      sprintf(buf, "Total Turns Tracked %d\n", TotalTurnsTracked_);
      editor->insertPlainText(buf);
 
+     // loss map: no of particles lost in each element  
+
+     auto const& profile = v.lossProfile();
+     if (!profile.empty()) {
+       editor->insertPlainText(fmt::format("\n{:>8s} {:>12s} {:>12s} {:>12s}\n", "Element", "Name", "s[m]", "Lost").c_str());
+       double spos = 0.0;
+       for (int i=0; i<mainw_->nelm_; ++i) {
+         auto ep = mainw_->beamline_[i];
+         spos += ep->length()*0.01;
+         if (i+1 < int(profile.size()) && profile[i+1] > 0) {
+           editor->insertPlainText(fmt::format("{:8d} {:>12s} {:12.4f} {:12d}\n", i+1, ep->name(), spos, profile[i+1]).c_str());
+         }
+       }
+     }
+
      editor->document()->setModified(false);
     }
 
@@ -1533,7 +1795,7 @@ void OptimTrackerNew::trackBunch(char nm, double Hrt, Element const *ep,
 {
   double x, y, s, c;
   
-  for(int j=0; j<N_; ++j) {
+  for(int j=0; j<N; ++j) {
 
     auto& particle = v[j];
     
@@ -1623,7 +1885,9 @@ void OptimTrackerNew::trackBunch(char nm, double Hrt, Element const *ep,
 
 int OptimTrackerNew::trackWake(Element const* ep, Bunch& v, int N, double Enr0, double ms, ExtData* p) // V7
 {
-  if ( N_<2 ) return 1; // only one particle in the beam
+  // N is the no of particles in the active range; the charge per particle is set by the initial no N_  
+
+  if ( N<2 ) return 1; // only one particle in the beam
   
   double P0 = sqrt(2.*ms*Enr0+Enr0*Enr0)*1e6;
 
@@ -1631,7 +1895,7 @@ int OptimTrackerNew::trackWake(Element const* ep, Bunch& v, int N, double Enr0,
   double smin = v[0][4];
   double smax = smin;
 
-  for(int i=0; i<N_; ++i){
+  for(int i=0; i<N; ++i){
      auto& particle = v[i]; 
      if(smin > particle[4]) smin = particle[4];
      if(smax < particle[4]) smax = particle[4];
@@ -1646,55 +1910,67 @@ int OptimTrackerNew::trackWake(Element const* ep, Bunch& v, int N, double Enr0,
    std::vector<double> sb(nb);
    std::vector<double> wx(nb);
    std::vector<double> wy(nb);
-   std::vector<double> vx(nb);
-   std::vector<double> vy(nb);
+   std::vector<double> ds(nb);
+   std::vector<double> wk(nb);
 
-   int rt=0;
    double deltaS=(smax-smin)/(nb-7);
    for(int i=0; i<nb; ++i){
       sb[i]=smin+(i-3)*deltaS;
       wx[i]=0.;
       wy[i]=0.;
    }
+
+   // wake function; the interval lookup is O(1) when the table is uniformly spaced
+   SplineInterpolator wake(&p->x[0], &p->y[0], p->n);
+
    double x,y;
    // computing wake at reference coordinates
    for(int i=0; i<N; ++i) {
      auto& particle = v[i];  
+     for( int n=0; n<nb; ++n) ds[n] = particle[4] - sb[n];
+     wake.evaluate(&ds[0], &wk[0], nb);
      for( int n=0; n<nb; ++n) {
-        x = particle[4] - sb[n];
-        if(x<0.0) continue;
-        if(splint( &p->x[0], &p->y[0], &p->v[0], p->n, x, &y)){rt=3; goto rttw;} //spline err
+        if(ds[n]<0.0) continue;
+        y = wk[n];
         switch(ep->plane()){
    	  case 0:  // T - both transverse
-      	    wx[n] += particle[0]*ep->B*y/(N*P0);
-      	    wy[n] += particle[2]*ep->B*y/(N*P0);
+      	    wx[n] += particle[0]*ep->B*y/(N_*P0);
+      	    wy[n] += particle[2]*ep->B*y/(N_*P0);
       	    break;
    	  case 1:  // X - plane
-      	    wx[n] += particle[0]*ep->B*y/(N*P0);
+      	    wx[n] += particle[0]*ep->B*y/(N_*P0);
       	    break;
    	  case 2:  // Y - plane
-      	    wx[n] += particle[2]*ep->B*y/(N*P0);
+      	    wx[n] += particle[2]*ep->B*y/(N_*P0);
       	    break;
    	  case 3:  // Longitudinal
-      	    wx[n] -= ep->B*y/(N*P0);
+      	    wx[n] -= ep->B*y/(N_*P0);
       	    break;
         }
        }
      }
-     // Filtering and setting spline
+     // Filtering and setting spline (uniform bins)
      Filter7(&wx[0], nb);
-     spline(&sb[0], &wx[0], nb, &vx[0]);
+     SplineInterpolator wakex(sb[0], deltaS, &wx[0], nb);
+     SplineInterpolator wakey;
      if(!ep->plane()){
      Filter7(&wy[0], nb);
-     spline(&sb[0], &wy[0], nb, &vy[0]);}
+     wakey = SplineInterpolator(sb[0], deltaS, &wy[0], nb);}
 
      // Computing corrections
+     std::vector<double> s(N);
+     std::vector<double> kx(N);
+     std::vector<double> ky(N);
+     for(int i=0; i<N; ++i) s[i] = v[i][4];
+     wakex.evaluate(&s[0], &kx[0], N);
+     if(!ep->plane()) wakey.evaluate(&s[0], &ky[0], N);
+
      for(int i=0; i<N; ++i) {
        auto& particle = v[i];
-       if(splint(&sb[0], &wx[0], &vx[0], nb, particle[4], &x)){rt=4; goto rttw;}//spline err
+       x = kx[i];
        switch(ep->plane()){
    	 case 0:  // T - both transverse
-   	   if(splint(&sb[0], &wy[0], &vy[0], nb, particle[4], &y)){rt=5; goto rttw;}//spline err
+   	   y = ky[i];
       	   particle[1] +=x;
       	   particle[3] +=y;
       	   break;
@@ -1710,8 +1986,7 @@ int OptimTrackerNew::trackWake(Element const* ep, Bunch& v, int N, double Enr0,
       }
    }
 
-rttw:
-   return rt;
+   return 0;
 }
 
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
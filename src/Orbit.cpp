@@ -307,7 +307,7 @@ format_to(mbuf, "#{:>5s} {:>24s} {:>12s} {:>12s} {:>12s} {:>12s} {:>12s} {:>12s}
      int ns = (stepo_ <= 0.0) ? 1 : fabs(ep->length()/stepo_)+1;
      if( (nm == 'A') || (nm == 'X') || (nm=='W') ) {ns=1;}
 
-     std::shared_ptr<Element> e(ep->split(ns)); 
+     SliceRef e(*ep, ns, slice_arena_); 
 
      for(int j=0; j<ns; ++j){
        double Hrt = sqrt(2.*ms*Enr+Enr*Enr)/C_DERV1;
@@ -0,0 +1,379 @@
+//  =================================================================
+//
+//  OrbitResponse.cpp
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+
+#include <OrbitResponse.h>
+#include <Constants.h>
+#include <Element.h>
+#include <RMatrix.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <numeric>
+#include <stdexcept>
+#include <gsl/gsl_linalg.h>
+
+using Constants::PI;
+using Constants::C_DERV1;
+
+namespace {
+
+  typedef std::array<double,6> Vec6; 
+
+} // namespace
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+OrbitResponse::OrbitResponse()
+  : m_(0), n_(0), svd_(false)
+{}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int OrbitResponse::build( std::vector<std::shared_ptr<Element>> const& line, double ms, double Enr, double tetaY, bool ring,
+                          Selector monitor, Selector corrector, bool xplane, bool yplane)
+{
+  rows_.clear();
+  knobs_.clear();
+  a_.clear();
+  svd_ = false;
+  m_ = n_ = 0;
+
+  // single pass: cumulative matrices at the monitors, kicks carried back to the start
+  // (R_j^-1 k_j) for every corrector instance  
+
+  struct Kick { int knob; int elm; Vec6 k; };
+
+  std::vector<RMatrix> rm;        // R at the monitors  
+  std::vector<Kick>    kicks;
+  std::map<std::string, int> index; 
+
+  RMatrix r;
+  r.toUnity();
+
+  for (int i=0; i<int(line.size()); ++i) {
+    Element const& e = *line[i];
+    char   t   = e.etype();
+    double enr = Enr;
+
+    r = e.rmatrix(Enr, ms, tetaY, 0.0, 3) * r;
+
+    if (t == 'I' && monitor(e)) { 
+      if (xplane) rows_.push_back({i, 0});
+      if (yplane) rows_.push_back({i, 1});
+      if (xplane || yplane) rm.push_back(r);
+      continue;
+    }
+
+    if (!((t == 'K') || (t == 'Z' && !ring)) || !corrector(e)) continue;
+
+    // kick per unit knob, at the exit of the corrector      
+
+    Vec6 k = {{ 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 }};
+    if (t == 'K') {    
+      double hr    = std::sqrt(enr*(enr + 2.0*ms))/C_DERV1;
+      double theta = e.length()/hr;                     // d(L B/Hr)/dB  
+      double fi    = e.tilt()*PI/180.0;
+      k[1] = theta*std::cos(fi);
+      k[3] = theta*std::sin(fi);
+      k[0] = 0.5*e.length()*k[1];
+      k[2] = 0.5*e.length()*k[3];
+    }
+    else { 
+      k[5] = (enr + ms)/(enr*enr + 2.0*enr*ms);         // d(dp/p)/dE, as in LCorrector::trackOnce  
+    }
+
+    auto it = index.find(e.name());
+    if (it == index.end()) {
+      it = index.insert({ e.name(), int(knobs_.size()) }).first;
+      knobs_.push_back({ e.name(), t, {} });
+    }
+    knobs_[it->second].elms.push_back(i);
+
+    try { 
+      kicks.push_back({ it->second, i, r.inverse()*k });
+    } 
+    catch (std::runtime_error&) { 
+      return 1; 
+    }
+  }
+
+  m_ = rows_.size();
+  n_ = knobs_.size();
+  a_.assign(m_*n_, 0.0);
+
+  // ring: the kicks are replaced by the closed orbit they excite at the start,  w = (I-M)^-1 R_j^-1 k_j. 
+  // A monitor upstream of the corrector sees the orbit after one more turn, M w.  
+
+  RMatrix const& mt = r;
+  std::vector<Vec6> before(kicks.size());   
+
+  if (ring) {
+    RMatrix4 im;
+    for (int i=0; i<4; ++i) { for (int j=0; j<4; ++j) im[i][j] = ((i==j) ? 1.0 : 0.0) - mt[i][j]; }
+    try { 
+      im = im.inverse(); 
+    } 
+    catch (std::runtime_error&) { 
+      return 1; 
+    }
+    for (int c=0; c<int(kicks.size()); ++c) {
+      Vec6 w = {{ 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 }};
+      for (int i=0; i<4; ++i) { for (int j=0; j<4; ++j) w[i] += im[i][j]*kicks[c].k[j]; }
+      kicks[c].k = w;
+      before[c]  = mt*w;
+    }
+  }
+
+  int mon = -1;
+  for (int row=0; row<m_; ++row) {
+    if (row == 0 || rows_[row].elm != rows_[row-1].elm) ++mon;
+    RMatrix const& ri = rm[mon];
+    int   p  = 2*rows_[row].plane;
+    for (int c=0; c<int(kicks.size()); ++c) {
+      Vec6 const* w = 0;  
+      if (kicks[c].elm < rows_[row].elm) w = &kicks[c].k;
+      else if (ring)                     w = &before[c];
+      if (!w) continue;
+      double z = 0.0;
+      for (int j=0; j<6; ++j) z += ri[p][j]*(*w)[j];
+      a_[row*n_ + kicks[c].knob] += z;
+    }
+  }
+  return 0;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+std::vector<double> OrbitResponse::readings( std::vector<Coordinates> const& orbit) const
+{
+  std::vector<double> b(m_);
+  for (int i=0; i<m_; ++i) b[i] = orbit[rows_[i].elm][2*rows_[i].plane];
+  return b;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void OrbitResponse::decompose() const
+{
+  if (svd_) return;
+
+  s_.clear();
+  u_.clear();
+  v_.clear();
+  svd_ = true;
+  if (m_ == 0 || n_ == 0) return;
+
+  // one-sided Jacobi SVD (gsl), which requires rows >= columns: for m < n, the decomposition 
+  // of A^T is computed and U, V swapped.  
+
+  bool tr = (m_ < n_);
+  int  m  = tr ? n_ : m_;
+  int  n  = tr ? m_ : n_;
+
+  gsl_matrix* w = gsl_matrix_alloc(m, n);   // A (or A^T); U on exit 
+  gsl_matrix* x = gsl_matrix_alloc(n, n);   // V 
+  gsl_vector* s = gsl_vector_alloc(n);      // singular values, in decreasing order  
+
+  for (int i=0; i<m_; ++i) {
+    for (int j=0; j<n_; ++j) {
+      if (tr) gsl_matrix_set(w, j, i, a_[i*n_+j]);
+      else    gsl_matrix_set(w, i, j, a_[i*n_+j]);
+    }
+  }
+
+  gsl_linalg_SV_decomp_jacobi(w, x, s);
+
+  int r = n;
+  s_.resize(r);
+  u_.assign(m_*r, 0.0);
+  v_.assign(n_*r, 0.0);
+  for (int k=0; k<r; ++k) {
+    s_[k] = gsl_vector_get(s, k);
+    for (int i=0; i<m; ++i) (tr ? v_ : u_)[i*r+k] = gsl_matrix_get(w, i, k);
+    for (int i=0; i<n; ++i) (tr ? u_ : v_)[i*r+k] = gsl_matrix_get(x, i, k);
+  }
+
+  gsl_vector_free(s);
+  gsl_matrix_free(x);
+  gsl_matrix_free(w);
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+std::vector<double> const& OrbitResponse::singularValues() const
+{
+  decompose();
+  return s_;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int OrbitResponse::solve( std::vector<double> const& b, Method method, double param, std::vector<double>& dk) const
+{
+  dk.assign(n_, 0.0);
+  if (m_ == 0 || n_ == 0) return 0;
+
+  if (method == Micado) { 
+
+    // greedy selection; the selected columns are kept orthonormalized (modified Gram-Schmidt, 
+    // twice) in q, with a the upper triangular factor: A_sel = Q a.  
+
+    int nmax = std::min(std::min(int(param + 0.5), n_), m_);
+
+    std::vector<double>              res(b);
+    std::vector<int>                 sel;
+    std::vector<std::vector<double>> q;
+    std::vector<std::vector<double>> tri;   // columns of the triangular factor 
+    std::vector<double>              qtb;   // Q^T b 
+    std::vector<bool>                used(n_, false);
+
+    auto project = [&](int j, std::vector<double>& col, std::vector<double>& rc) {
+      col.resize(m_);
+      for (int i=0; i<m_; ++i) col[i] = a_[i*n_+j];
+      rc.assign(q.size()+1, 0.0);
+      for (int pass=0; pass<2; ++pass) {
+        for (unsigned k=0; k<q.size(); ++k) {
+          double d = 0.0;
+          for (int i=0; i<m_; ++i) d += q[k][i]*col[i];
+          for (int i=0; i<m_; ++i) col[i] -= d*q[k][i];
+          rc[k] += d;
+        }
+      }
+    };
+
+    // the candidate columns are kept orthogonal to the selected ones in p (m x n) 
+
+    std::vector<double> p(a_);
+    std::vector<double> cn(n_, 0.0);
+    for (int i=0; i<m_; ++i) { for (int j=0; j<n_; ++j) cn[j] += a_[i*n_+j]*a_[i*n_+j]; }
+
+    std::vector<double> col;
+    std::vector<double> rc;
+
+    for (int step=0; step<nmax; ++step) {
+      int    best = -1;
+      double gain = 0.0;
+      for (int j=0; j<n_; ++j) {
+        if (used[j]) continue;
+        double nn = 0.0;
+        double nr = 0.0;
+        for (int i=0; i<m_; ++i) { nn += p[i*n_+j]*p[i*n_+j]; nr += p[i*n_+j]*res[i]; }
+        if (nn <= 1.0e-24*cn[j] || nn == 0.0) continue;   // (nearly) dependent on the selected correctors   
+        if (nr*nr/nn > gain) { gain = nr*nr/nn; best = j; }
+      }
+      if (best < 0) break;
+
+      project(best, col, rc);
+      double nn = std::sqrt(std::inner_product(col.begin(), col.end(), col.begin(), 0.0));
+      for (auto& x: col) x /= nn;
+      rc.back() = nn;
+
+      double d = std::inner_product(col.begin(), col.end(), res.begin(), 0.0);
+      for (int i=0; i<m_; ++i) res[i] -= d*col[i];
+
+      std::vector<double> dj(n_, 0.0);
+      for (int i=0; i<m_; ++i) { for (int j=0; j<n_; ++j) dj[j] += col[i]*p[i*n_+j]; }
+      for (int i=0; i<m_; ++i) { for (int j=0; j<n_; ++j) p[i*n_+j] -= dj[j]*col[i]; }
+
+      q.push_back(col);
+      tri.push_back(rc);
+      qtb.push_back(std::inner_product(col.begin(), col.end(), b.begin(), 0.0));
+      sel.push_back(best);
+      used[best] = true;
+    }
+
+    // a x = -Q^T b  
+
+    int ns = sel.size();
+    std::vector<double> x(ns);
+    for (int k=ns-1; k>=0; --k) {
+      double sum = -qtb[k];
+      for (int l=k+1; l<ns; ++l) sum -= tri[l][k]*x[l];
+      x[k] = sum/tri[k][k];
+    }
+    for (int k=0; k<ns; ++k) dk[sel[k]] = x[k];
+    return ns;
+  }
+
+  decompose();
+
+  int    r    = s_.size();
+  double smax = r ? s_[0] : 0.0;
+  int    used = 0;
+
+  for (int k=0; k<r; ++k) {
+    double f = 0.0;
+    if (method == SVD) {
+      if (s_[k] <= param*smax || s_[k] == 0.0) break;
+      f = 1.0/s_[k];
+    }
+    else {
+      double l = param*smax;
+      if (s_[k] == 0.0) break;
+      f = s_[k]/(s_[k]*s_[k] + l*l);
+    }
+    double utb = 0.0;
+    for (int i=0; i<m_; ++i) utb += u_[i*r+k]*b[i];
+    for (int j=0; j<n_; ++j) dk[j] -= f*utb*v_[j*r+k];
+    ++used;
+  }
+  return used;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+double OrbitResponse::rms( std::vector<double> const& b, std::vector<double> const& dk) const
+{
+  if (m_ == 0) return 0.0;
+  double sum = 0.0;
+  for (int i=0; i<m_; ++i) {
+    double z = b[i];
+    for (int j=0; j<n_; ++j) z += a_[i*n_+j]*dk[j];
+    sum += z*z;
+  }
+  return std::sqrt(sum/m_);
+}
@@ -71,15 +71,6 @@ void PCavity::toString(char* buf) const
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-PCavity* PCavity::split(int nslices) const // return a sliced element
-{
-  // PCavity cannot be split so we return a cloned element. 
-  return this->clone();
-}
-
-//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
-//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
-
 Beamline* PCavity::splitnew(int nslices) const  // return a sliced element as a beamline 
 {
  // PCavity cannot be split so we return a cloned element. 
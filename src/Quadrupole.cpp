@@ -43,7 +43,9 @@
 #include <Structs.h>
 #include <Element.h>
 #include <RMatrix.h>
+#include <ElementMatrices.h>
 #include <TrackParam.h>
+#include <Tpsa.h>
 #include <limits>
 
 using Constants::C_DERV1;
@@ -71,11 +73,9 @@ void Quadrupole::toString( char* buf) const
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-Quadrupole* Quadrupole::split(int nslices) const
+void Quadrupole::slice(int nslices)
 {
-  Quadrupole* e = this->clone();
-  e->L_ /= nslices;
-  return e;
+  L_ /= nslices;
 }
 
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
@@ -88,40 +88,8 @@ RMatrix Quadrupole::rmatrix(double& alfap, double& energy, double ms, double& te
   double hr     = P/C_DERV1;
   double bt     = P/(energy+ms);
   double gamma1 = 1. + energy/ms;
-  double ks;
-  double fi;
-  
   RMatrix mi;
-  mi.toUnity();
-
-  mi[4][5]=L_/(gamma1*gamma1);
-
-  if( fabs(G) < std::numeric_limits<double>::epsilon() ) {
-    mi[0][1] = mi[2][3]= L_;
-    return mi;
-  }
-
-  if(G >0){ // hor focusing, ver defocusing 
-    ks  = sqrt( G / hr );
-    fi = ks * L_;
-    mi[0][0] = mi[1][1] = cos(fi);
-    mi[0][1] = sin(fi)/ks;
-    mi[1][0] = -ks*ks * mi[0][1];
-    mi[2][2] = mi[3][3] = cosh(fi);
-    mi[2][3] = sinh(fi)/ks;
-    mi[3][2] = ks*ks * mi[2][3];
-  }
-  else   { // ver focusing, hor defocusing 
-    ks  = sqrt( - G / hr );
-    fi = ks*L_;
-
-    mi[0][0] = mi[1][1] = cosh(fi);
-    mi[0][1] = sinh(fi)/ks;
-    mi[1][0] = ks*ks * mi[0][1];
-    mi[2][2] = mi[3][3] = cos(fi);
-    mi[2][3] = sin(fi)/ks;
-    mi[3][2] = -ks*ks* mi[2][3];
-  }
+  ElementMatrices::quadrupole<double>(mi, L_, G, hr, gamma1);
 
   //if(T != 0) tilt(T, &mi);
   if(T_ != 0)  mi = mi.similarOrtho(RMatrix::m_tilt(T_*PI/180.0)); // VERIFY SIGN OF ROTATION
@@ -215,33 +183,58 @@ void Quadrupole::setParameters( int np, std::vector<double> const& dat, ... )
 int Quadrupole::trackOnce( double ms, double& Enr0, int n_elem, int n_turn, TrackParam& prm,
 		           RMatrix const& m1, Coordinates& v ) const
 {
-
-  double m00, m01, m10, m22, m23, m32, s,c, ss, cc, sc;
-  double n00, n01, n02, n03, n10, n12, n22, n23, n32;
-  double phi;
-
-  double p     = prm.p0*(1.0+v[5]);  // p = p0 (1 + dp/p)  
-  double delta = v[5];
-   
   int status = 0; 
   if (status = backwardTest(prm, n_elem, n_turn, v )) return status;
 
-
-  double Hr = p/C_DERV1; // brho  in kG-cm  
-  double k1 = fabs(L_) < 1.0e-3 ? 0.0 : G/Hr;  // no fringe for very thin quads ***FIXME***    
-  
+  transport(ms, prm, v.c.data());
   
-  if ( fabs(G) < std::numeric_limits<double>::epsilon() )  {  // treat as a drift
+ done:	
 
-    v[0] += L_*tan(v[1]);
-    v[2] += L_*tan(v[3]);
+   if (status = transAmpTest(prm, n_elem, n_turn, v )) return status;
 
-    double vp  = C_CGS*p/sqrt( p*p*(1.0 + v[1]*v[1] + v[3]*v[3]) + ms*ms );
-    v[4] += (vp - prm.vp0) * L_ / prm.vp0;
+  return 0;
+}
 
-    if (status = transAmpTest(prm, n_elem, n_turn, v )) return status;
-    return 0;
-   }
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int Quadrupole::trackMap( double ms, double& Enr0, int n_elem, TrackParam& prm,
+		          RMatrix const& m1, Tpsa* u) const
+{
+  transport(ms, prm, u);
+  return 0;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+template <typename T>
+void Quadrupole::transport( double ms, TrackParam const& prm, T* v) const
+{
+  // T is double (tracking) or Tpsa (map extraction) 
+
+  using std::sqrt;
+  using std::sin;
+  using std::cos;
+  using std::sinh;
+  using std::cosh;
+
+  T m00, m01, m10, m22, m23, m32;
+  T n00, n01, n02, n03, n10, n12, n22, n23, n32;
+  T phi;
+  double s,c, ss, cc, sc;
+
+  T p     = prm.p0*(1.0+v[5]);  // p = p0 (1 + dp/p)  
+  T delta = v[5];
+   
+  T Hr = p/C_DERV1; // brho  in kG-cm  
+  T k1 = 0.0;       // no fringe for very thin quads ***FIXME***    
+  if (fabs(L_) >= 1.0e-3) k1 = G/Hr;
+  
+  if ( fabs(G) < std::numeric_limits<double>::epsilon() )  {  // treat as a drift
+    Drift::transport(L_, ms, prm, v);
+    return;
+  }
 
   //------------------------------------------------------------------------------------------------------
   // Nonlinear upstream edge correction. The correction is a limit for a sharp field edge.
@@ -250,10 +243,10 @@ int Quadrupole::trackOnce( double ms, double& Enr0, int n_elem, int n_turn, Trac
   // E. Forest, Beam Dynamics: A New Attitude and Framework  Harwood Academic Publishers (1988)
   // .....................................................................................................
 
-  double x  = v[0];
-  double xp = v[1];
-  double y  = v[2];
-  double yp = v[3];
+  T x  = v[0];
+  T xp = v[1];
+  T y  = v[2];
+  T yp = v[3];
   
   if (fringe_on) {
 
@@ -265,7 +258,7 @@ int Quadrupole::trackOnce( double ms, double& Enr0, int n_elem, int n_turn, Trac
   
   //------------------------------------------------------------------------------------------------------
 
-  double ks;
+  T ks;
   
   if( G > 0) { // hor focusing, ver defocusing 
   	ks   = sqrt( G / Hr );
@@ -288,7 +281,7 @@ int Quadrupole::trackOnce( double ms, double& Enr0, int n_elem, int n_turn, Trac
   	m32 = -ks*ks*m23;
   }
 
-  // apply the X,Y offset 
+  // apply the X,Y offset
 
   v[0] -= ofsX_;
   v[2] -= ofsY_;
@@ -308,9 +301,9 @@ int Quadrupole::trackOnce( double ms, double& Enr0, int n_elem, int n_turn, Trac
       v[2] =  x;
   } 
   else {
-      phi = T_/180.*PI;
-      s   = sin(-phi);
-      c   = cos(phi);
+      double alfa = T_/180.*PI;
+      s   = sin(-alfa);
+      c   = cos(alfa);
       cc  = c*c;
       ss  = s*s;
       sc  = s*c;
@@ -360,14 +353,11 @@ int Quadrupole::trackOnce( double ms, double& Enr0, int n_elem, int n_turn, Trac
   v[0] += ofsX_;
   v[2] += ofsY_;
 
-  double vp  = C_CGS*p/sqrt( p*p*(1.0 + v[1]*v[1] + v[3]*v[3]) + ms*ms );  // velocity
+  T vp  = C_CGS*p/sqrt( p*p*(1.0 + v[1]*v[1] + v[3]*v[3]) + ms*ms );  // velocity
   v[4] += (vp/prm.vp0 - 1.0) * L_;
-  
- done:	
-
-   if (status = transAmpTest(prm, n_elem, n_turn, v )) return status;
-
-  return 0;
 }
 
+template void Quadrupole::transport( double ms, TrackParam const& prm, double* v) const;
+template void Quadrupole::transport( double ms, TrackParam const& prm, Tpsa*   v) const;
+
 
@@ -0,0 +1,209 @@
+//  =================================================================
+//
+//  RadiationIntegrals.cpp
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+
+#include <RadiationIntegrals.h>
+#include <Constants.h>
+#include <Twiss.h>
+#include <cmath>
+
+using Constants::PI;
+
+double const RadiationIntegrals::x_[4] = { 0.1834346424956498, 0.5255324099163290, 0.7966664774136267, 0.9602898564975363 };
+double const RadiationIntegrals::w_[4] = { 0.3626837833783620, 0.3137066458778873, 0.2223810344533745, 0.1012285362903763 };
+
+namespace {
+
+  // C, S, F = int S for x'' + K x = 0 (C'= -K S, S' = C, C^2 + K S^2 = 1); series for small |K| s^2  
+
+  struct Principal { double C, S, F; };
+
+  Principal principal( double K, double s)
+  {
+    double phi = K*s*s;
+    if (std::fabs(phi) < 0.5) {
+      double S = 0.0;
+      double F = 0.0;
+      double t = s;            // (-K)^n s^(2n+1)/(2n+1)!  
+      for (int n=0; n<12; ++n) {
+        S += t;
+        F += t*s/(2*n+2);
+        t *= -phi/((2*n+2)*(2*n+3));
+      }
+      return { 1.0 - K*F, S, F };
+    }
+    double w = std::sqrt(std::fabs(K));
+    double C = (K > 0.0) ? std::cos(w*s)   : std::cosh(w*s);
+    double S = (K > 0.0) ? std::sin(w*s)/w : std::sinh(w*s)/w;
+    return { C, S, (1.0-C)/K };
+  }
+
+} // namespace
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+RadiationIntegrals::Sums& RadiationIntegrals::Sums::operator+=( Sums const& o)
+{
+  I1  += o.I1;
+  I2  += o.I2;
+  I3  += o.I3;
+  I4x += o.I4x;
+  I4y += o.I4y;
+  I5x += o.I5x;
+  I5y += o.I5y;
+  return *this;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+RadiationIntegrals::Sums RadiationIntegrals::Sums::operator*( double a) const
+{
+  return { a*I1, a*I2, a*I3, a*I4x, a*I4y, a*I5x, a*I5y };
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+double RadiationIntegrals::Sums::norm() const
+{
+  double const c[] = { I1, I2, I3, I4x, I4y, I5x, I5y };
+  double n = 0.0;
+  for (double x: c) n = std::max(n, std::fabs(x));
+  return n;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+bool RadiationIntegrals::planar( double tilt)
+{
+  double q = tilt/(0.5*PI);
+  return std::fabs(q - std::round(q)) < 1.0e-9;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+RadiationIntegrals::Sums RadiationIntegrals::bend( double L, double h, double k, double tilt, Twiss const& v)
+{
+  // In the bending plane u, with K = h^2 + k, eta = (D, D') and M(s) the betatron matrix,   
+  //   eta(s) = M eta0 + h_u (F, S),   H(s) = (eta0 + h_u w)^T T0 (eta0 + h_u w),  w = M^-1 (F, S) = (-F, S)   
+  // where T0 = [[gamma, alpha], [alpha, beta]] at the entrance. H is constant in the other plane. 
+
+  int  q  = int(std::lround(tilt/(0.5*PI))) & 3;      // 0: +x, 1: +y, 2: -x, 3: -y  
+  bool y  = (q & 1);
+  double hu = (q < 2) ? h : -h;
+  double K  = h*h + k;
+
+  double bt = y ? v.BtY  : v.BtX;
+  double al = y ? v.AlY  : v.AlX;
+  double d0 = y ? v.DsY  : v.DsX;
+  double dp = y ? v.DsYp : v.DsXp;
+  double gm = (1.0 + al*al)/bt;
+
+  double btw = y ? v.BtX  : v.BtY;
+  double alw = y ? v.AlX  : v.AlY;
+  double dw  = y ? v.DsX  : v.DsY;
+  double dwp = y ? v.DsXp : v.DsYp;
+  double Hw  = ((1.0 + alw*alw)*dw*dw + 2.0*alw*btw*dw*dwp + btw*btw*dwp*dwp)/btw;
+
+  // int F, int F^2, int F S, int S^2 over [0,L]; Gauss-Legendre on the series when K L^2 is small    
+
+  Principal p = principal(K, L);
+  double iF, iF2, iFS, iS2;
+
+  if (std::fabs(K*L*L) < 0.5) { 
+    iF = iF2 = iFS = iS2 = 0.0;
+    for (int i=0; i<4; ++i) {
+      for (double s: { 0.5*L*(1.0 - x_[i]), 0.5*L*(1.0 + x_[i]) }) {
+        Principal ps = principal(K, s);
+        double    wi = 0.5*L*w_[i];
+        iF  += wi*ps.F;
+        iF2 += wi*ps.F*ps.F;
+        iFS += wi*ps.F*ps.S;
+        iS2 += wi*ps.S*ps.S;
+      }
+    }
+  }
+  else {
+    iF  = (L - p.S)/K;
+    iF2 = (1.5*L - 2.0*p.S + 0.5*p.S*p.C)/(K*K);
+    iFS = (p.F - 0.5*p.S*p.S)/K;
+    iS2 = (L - p.S*p.C)/(2.0*K);
+  }
+
+  double iD  = d0*p.S + dp*p.F + hu*iF;
+  double ah3 = std::fabs(h*h*h);
+
+  double iH  =     gm*(d0*d0*L - 2.0*d0*hu*iF + h*h*iF2)
+             + 2.0*al*(d0*dp*L + d0*hu*p.F - hu*dp*iF - h*h*iFS)
+             +     bt*(dp*dp*L + 2.0*dp*hu*p.F + h*h*iS2);
+
+  Sums r = { hu*iD, h*h*L, ah3*L, 0.0, 0.0, 0.0, 0.0 };
+  (y ? r.I4y : r.I4x) = hu*(h*h + 2.0*k)*iD;
+  (y ? r.I5y : r.I5x) = ah3*iH;
+  (y ? r.I5x : r.I5y) = ah3*L*Hw;
+  return r;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+RadiationIntegrals::Sums RadiationIntegrals::edge( double h, double tane, double tilt, Twiss const& v)
+{
+  double s = h*h*tane;
+  return { 0.0, 0.0, 0.0, -v.DsX*std::cos(tilt)*s, -v.DsY*std::sin(tilt)*s, 0.0, 0.0 };
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+RadiationIntegrals::Sums RadiationIntegrals::local( double h, double k, double tilt, Twiss const& v)
+{
+  double ca  = std::cos(tilt);
+  double sa  = std::sin(tilt);
+  double ah3 = std::fabs(h*h*h);
+  double s   = h*(h*h + 2.0*k);
+
+  double Hx  = ((1.0 + v.AlX*v.AlX)*v.DsX*v.DsX + 2.0*v.AlX*v.BtX*v.DsX*v.DsXp + v.BtX*v.BtX*v.DsXp*v.DsXp)/v.BtX;
+  double Hy  = ((1.0 + v.AlY*v.AlY)*v.DsY*v.DsY + 2.0*v.AlY*v.BtY*v.DsY*v.DsYp + v.BtY*v.BtY*v.DsYp*v.DsYp)/v.BtY;
+
+  return { h*(v.DsX*ca + v.DsY*sa), h*h, ah3, v.DsX*ca*s, v.DsY*sa*s, ah3*Hx, ah3*Hy };
+}
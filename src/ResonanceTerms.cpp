@@ -0,0 +1,355 @@
+//  =================================================================
+//
+//  ResonanceTerms.cpp
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+
+#include <ResonanceTerms.h>
+#include <Constants.h>
+#include <cmath>
+
+using Constants::PI;
+
+namespace {
+
+  typedef std::complex<double>      cplx;
+  typedef std::vector<cplx>         Poly;
+  typedef ResonanceTerms::Term      Term;
+
+  int const D  = ResonanceTerms::maxdeg;
+  int const DP = ResonanceTerms::maxdp;
+
+  //.......................................................................................
+  // dense polynomials in hx+, hx-, hy+, hy- (total degree <= D) and dp (degree <= DP)   
+  //.......................................................................................
+
+  struct Basis {
+
+    Basis()
+    {
+      for (int a=0; a<=D; ++a) 
+      for (int b=0; b<=D; ++b) 
+      for (int c=0; c<=D; ++c) 
+      for (int d=0; d<=D; ++d) 
+      for (int p=0; p<=DP; ++p) {
+	int& i = index[a][b][c][d][p];
+        i = -1; 
+        if (a+b+c+d > D) continue;
+        i = terms.size();
+        terms.push_back( {{a, b, c, d, p}} ); 
+      }
+    }
+
+    int operator()( int a, int b, int c, int d, int p) const 
+    { 
+      if (a<0 || b<0 || c<0 || d<0 || p<0 || p>DP || a+b+c+d > D) return -1;
+      return index[a][b][c][d][p]; 
+    }
+
+    int  size() const { return terms.size(); }
+    
+    int               index[D+1][D+1][D+1][D+1][DP+1];
+    std::vector<Term> terms;
+  };
+
+  Basis const& basis()
+  {
+    static Basis const b; 
+    return b;
+  }
+
+  //.......................................................................................
+
+  Poly zero() { return Poly(basis().size(), 0.0); }
+
+  Poly mul( Poly const& u, Poly const& v)  // truncated product 
+  {
+    Basis const& B = basis();
+    Poly r = zero();
+    for (int i=0; i<B.size(); ++i) {
+      if (u[i] == 0.0) continue;
+      Term const& s = B.terms[i];
+      for (int j=0; j<B.size(); ++j) {
+        if (v[j] == 0.0) continue;
+        Term const& t = B.terms[j];
+        int k = B(s[0]+t[0], s[1]+t[1], s[2]+t[2], s[3]+t[3], s[4]+t[4]);
+        if (k >= 0) r[k] += u[i]*v[j];
+      }
+    }
+    return r;
+  }
+
+  Poly bar( Poly const& u)  // complex conjugate function: (hx+)* = hx-  
+  {
+    Basis const& B = basis();
+    Poly r = zero();
+    for (int i=0; i<B.size(); ++i) {
+      Term const& s = B.terms[i];
+      r[B(s[1], s[0], s[3], s[2], s[4])] = std::conj(u[i]);
+    }
+    return r;
+  }
+
+  void axpy( cplx a, Poly const& x, Poly& y) 
+  {
+    for (unsigned i=0; i<y.size(); ++i) y[i] += a*x[i];
+  }
+
+  Poly bracket( Poly const& u, Poly const& v)  
+  {
+    // Poisson bracket; [hx+, hx-] = 2i (phi, J canonical)  
+
+    Basis const& B = basis();
+    Poly r = zero();
+    cplx const two_i(0.0, 2.0);
+
+    std::vector<int> nz;                    // the kick potentials are sparse 
+    for (int j=0; j<B.size(); ++j) { if (v[j] != 0.0) nz.push_back(j); }
+
+    for (int i=0; i<B.size(); ++i) {
+      if (u[i] == 0.0) continue;
+      Term const& s = B.terms[i];
+      for (int j: nz) {
+        Term const& t = B.terms[j];
+        for (int q=0; q<4; q+=2) {
+	  // d/dh+ u d/dh- v - d/dh- u d/dh+ v   
+	  Term e = {{ s[0]+t[0], s[1]+t[1], s[2]+t[2], s[3]+t[3], s[4]+t[4] }};
+	  double c = s[q]*t[q+1] - s[q+1]*t[q];
+	  if (c == 0.0) continue;
+	  --e[q]; --e[q+1];
+	  int k = B(e[0], e[1], e[2], e[3], e[4]);
+	  if (k >= 0) r[k] += two_i*c*u[i]*v[j];
+        }
+      }
+    }
+    return r;
+  }
+
+  void rotate( Poly& u, double mux, double muy)  // carry by the phase advances mux, muy [rad] 
+  {
+    Basis const& B = basis();
+    for (int i=0; i<B.size(); ++i) {
+      if (u[i] == 0.0) continue;
+      Term const& s = B.terms[i];
+      u[i] *= std::polar(1.0, (s[0]-s[1])*mux + (s[2]-s[3])*muy);
+    }
+  }
+
+  bool detuning( Term const& s) { return s[0] == s[1] && s[2] == s[3]; }
+
+  //.......................................................................................
+
+  Poly potential( ResonanceTerms::Kick const& k)
+  {
+    Basis const& B = basis();
+
+    // z = x + iy about the dispersion orbit, in the frame of the kick  
+
+    double sx = 0.5*sqrt(k.btx);
+    double sy = 0.5*sqrt(k.bty);
+    cplx   et = std::polar(1.0, -k.tilt);
+    
+    Poly z = zero();
+    z[B(1,0,0,0,0)] = et*sx;
+    z[B(0,1,0,0,0)] = et*sx;
+    z[B(0,0,1,0,0)] = et*cplx(0.0, sy);
+    z[B(0,0,0,1,0)] = et*cplx(0.0, sy);
+
+    Poly zb = z;                            // betatron part only 
+    z[B(0,0,0,0,1)] = et*cplx(k.dx, k.dy);  
+
+    Poly zn = z;
+    double fact = 1.0;
+    for (int i=2; i<=k.n+1; ++i) { zn = mul(zn, z); fact *= i; }
+
+    Poly v = zn;
+    axpy(1.0, bar(zn), v);                  // 2 Re(z^(n+1))  
+    for (auto& c: v) c *= 0.5*k.knl/fact;
+
+    // 1/(1+dp)  
+
+    Poly r = v;
+    Poly t = v;
+    for (int p=1; p<=DP; ++p) {
+      Poly u = zero();
+      for (int i=0; i<B.size(); ++i) {
+	Term const& s = B.terms[i];
+	int j = B(s[0], s[1], s[2], s[3], s[4]+1);
+	if (j >= 0) u[j] = -t[i];
+      }
+      t = u;
+      axpy(1.0, t, r);
+    }
+
+    if (k.linear && k.n == 1) {             // the normal part at dp = 0 is in the lattice 
+      double c2 = cos(2.0*k.tilt); 
+      Poly   zr = zb;                       // x + iy  
+      for (auto& c: zr) c *= std::conj(et);
+      Poly zz = mul(zr, zr);
+      axpy(1.0, bar(zz), zz);
+      for (int i=0; i<B.size(); ++i) {
+        if (B.terms[i][4] == 0) r[i] -= 0.25*k.knl*c2*zz[i];
+      }
+    }
+
+    // bend: dx' = angle dp/(1+dp); the first order in dp is the dispersion 
+
+    if (k.angle != 0.0 && DP >= 2) {
+      Poly zt = zb;
+      axpy(1.0, bar(zb), zt);               // 2 Re(z) 
+      for (int i=0; i<B.size(); ++i) {
+	Term const& s = B.terms[i];
+	if (s[4] == 0 && zt[i] != 0.0) r[B(s[0], s[1], s[2], s[3], 2)] += 0.5*k.angle*zt[i];
+      }
+    }
+
+    // constant terms, and the first order dp/p terms linear in the amplitudes (dispersion)   
+
+    for (int i=0; i<B.size(); ++i) {
+      Term const& s = B.terms[i];
+      int deg = s[0]+s[1]+s[2]+s[3];
+      if (deg == 0 || (deg == 1 && s[4] <= 1)) r[i] = 0.0;
+    }
+
+    return r;
+  }
+
+} // anonymous namespace 
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+ResonanceTerms::ResonanceTerms()
+  : w_(zero()), h2_(zero()), f_(zero()), qx_(0.0), qy_(0.0), 
+    dqxx_(0.0), dqxy_(0.0), dqyy_(0.0), xi1_{0.0, 0.0}, xi2_{0.0, 0.0}, nkicks_(0)
+{}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void ResonanceTerms::add( Kick const& kick)
+{
+  Poly v = potential(kick);
+  rotate(v, 2.0*PI*kick.mux, 2.0*PI*kick.muy);
+
+  // 1/2 sum_{i<j} [V_i, V_j] = 1/2 sum_j [W_{j-1}, V_j]  
+
+  if (nkicks_ > 0) axpy(0.5, bracket(w_, v), h2_);
+  axpy(1.0, v, w_);
+  ++nkicks_;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+std::complex<double> ResonanceTerms::h1( Term const& t) const
+{
+  int i = basis()(t[0], t[1], t[2], t[3], t[4]);
+  return (i < 0) ? 0.0 : -w_[i];
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+std::complex<double> ResonanceTerms::h( Term const& t) const
+{
+  int i = basis()(t[0], t[1], t[2], t[3], t[4]);
+  return (i < 0) ? 0.0 : -w_[i] + h2_[i];
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+std::complex<double> ResonanceTerms::f( Term const& t) const
+{
+  int i = basis()(t[0], t[1], t[2], t[3], t[4]);
+  return (i < 0) ? 0.0 : f_[i];
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void ResonanceTerms::close( double Qx, double Qy)
+{
+  Basis const& B = basis();
+
+  qx_ = Qx;
+  qy_ = Qy;
+
+  // one-turn map e^{:G:} R, G = G1 + G2. With e^{:F:}, F = F1 + ..., the map becomes 
+  // e^{:K:} R with K(J) independent of the phases:   
+  //   K1 = <G1>,  (1 - R) F1 = - (G1 - <G1>) 
+  //   K2 = <G2 + 1/2 ( [F1,G1] - [F1,RF1] - [G1,RF1] )>     
+
+  Poly g1 = zero();
+  Poly g2 = h2_;
+  axpy(-1.0, w_, g1);
+
+  Poly f1  = zero();
+  Poly rf1 = zero();
+  f_       = zero();
+
+  for (int i=0; i<B.size(); ++i) {
+    Term const& s = B.terms[i];
+    if (detuning(s) || g1[i] == 0.0) continue;
+    double th = 2.0*PI*((s[0]-s[1])*Qx + (s[2]-s[3])*Qy);
+    cplx   e  = std::polar(1.0, th);
+    if (std::abs(1.0-e) < 1.0e-12) continue;    // on resonance  
+    f_[i]   =  g1[i]/(1.0-e);                   // f = h/(1 - exp(i theta))  
+    f1[i]   = -f_[i];
+    rf1[i]  =  e*f1[i];
+  }
+
+  Poly k2 = g2;
+  axpy( 0.5, bracket(f1, g1),  k2);
+  axpy(-0.5, bracket(f1, rf1), k2);
+  axpy(-0.5, bracket(g1, rf1), k2);
+
+  Poly k = g1;
+  axpy(1.0, k2, k);
+
+  // tune: Q(J) = Q - 1/(2pi) dK/dJ; hx+ hx- = 2Jx 
+
+  auto c = [&](int a, int b, int cc, int d, int p) { return std::real(k[B(a,b,cc,d,p)]); }; 
+
+  dqxx_   = -4.0*c(2,2,0,0,0)/PI;
+  dqxy_   = -2.0*c(1,1,1,1,0)/PI;
+  dqyy_   = -4.0*c(0,0,2,2,0)/PI;
+  xi1_[0] = -c(1,1,0,0,1)/PI;
+  xi1_[1] = -c(0,0,1,1,1)/PI;
+  xi2_[0] = -c(1,1,0,0,2)/PI;
+  xi2_[1] = -c(0,0,1,1,2)/PI;
+}
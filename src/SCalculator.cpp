@@ -36,6 +36,7 @@
 //  =================================================================
 //
 
+#include <algorithm>
 #include <iostream>
 #include <SCalculator.h>
 #include <Constants.h>
@@ -46,7 +47,6 @@
 #include <fstream>
 #include <iomanip>
 #include <ctime>
-#include <random>
 
 using Constants::PI;
 using Constants::E_NUMB;
@@ -58,11 +58,6 @@ using Constants::Mmu_MEV;
 using Utility::strcmpr;
 using Utility::gauss;
 
-namespace {
-  std::normal_distribution<double>       normal(0.0,1.0);  // normal distribution mean=0.0, sigma=1.0
-  std::uniform_real_distribution<double> uniform(0.0,1.0);  // uniform distribution mean=0.0, sigma=1.0
-}
-
 
 char const* SCalc::FuncList[] = { "sin","cos","tan","asin","acos","atan","exp","log","sqrt","abs","theta","int","fact","hro","sign","gauss","" };
 
@@ -70,6 +65,7 @@ char const* SCalc::FuncList[] = { "sin","cos","tan","asin","acos","atan","exp","
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
 SCalc::SCalc()
+  : epoch_(1), graphok_(true)
 {
   for (int i=0; i<TBLSZ; ++i) { table[i]=0; }
 
@@ -118,6 +114,14 @@ SCalc::~SCalc()
 
 void SCalc::zeroCalc()
 {
+  // compiled lines remain valid; only the variables they refer to are reset 
+
+  std::fill(slotvar_.begin(), slotvar_.end(), nullptr);
+  std::fill(writer_.begin(),  writer_.end(),  -1);
+  tape_.clear();
+  ++epoch_;
+  graphok_ = true;
+
 #if GCC_VERSION >= 70000
   vardict_.clear();
 #else  
@@ -224,6 +228,11 @@ int SCalc::calcLine(char const* buf, double* result,
   pterr      = error;
   num_of_err = 0;
   func_numb  = 0;
+
+  key_.assign(buf);   // key_ keeps its capacity: no allocation once the line has been seen  
+  auto it = compiled_.find(key_);
+  if (it != compiled_.end()) return execute(it->second, result, format, result_str);
+
   b = buf;
   while (*b!='\n' && isspace(*b))b++;  // skip spaces but '\n'
 	// Creates array and sets its values
@@ -309,18 +318,295 @@ int SCalc::calcLine(char const* buf, double* result,
       }
    }
 
-   // expression analysis
+   // expression analysis: the line is compiled once and then run from the cache.  
 
-   b = buf;
-   while (*b){
-     get_token();
-     if(num_of_err)return num_of_err;
-     if(cur_tok == END)break;
-     if(cur_tok == PRINT)continue;
-     *result=expr();
-     sprintf(result_str, format, *result);
+   if (compiled_.size() >= MAX_COMPILED) {
+     compiled_.clear();
+     tape_.clear();      // the tape refers to the cached statements 
+     graphok_ = false;
    }
-   return num_of_err;
+   Program& prog = compiled_[key_];
+   compile(buf, prog);
+   return execute(prog, result, format, result_str);
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int SCalc::slot(char const* name)
+{
+  auto it = slotidx_.find(name);
+  if (it != slotidx_.end()) return it->second;
+
+  int k = slotname_.size();
+  slotidx_[name] = k;
+  slotname_.push_back(name);
+  slotvar_.push_back(nullptr);
+  writer_.push_back(-1);
+  dirty_.push_back(0);
+  return k;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void SCalc::compile(char const* buf, Program& prog)
+{
+  // A syntax error ends the compilation. As in a direct evaluation of the line, 
+  // the statements preceding the error are run before the error is reported.
+
+  prog.stmts.clear();
+  prog.err.clear();
+  prog.depth = 0;
+
+  func_numb = 0;
+  b = buf;
+  while (*b) {
+    get_token();
+    if (num_of_err) break;
+    if (cur_tok == END) break;
+    if (cur_tok == PRINT) continue;
+    Statement st;
+    expr(st);
+    if (num_of_err) break;
+    prog.stmts.push_back(std::move(st));
+  }
+
+  if (num_of_err) {
+    prog.err   = pterr;
+    *pterr     = 0;
+    num_of_err = 0;
+  }
+
+  for (auto& st : prog.stmts) {
+    int depth = 0;
+    for (auto const& in : st.code) {
+      switch (in.op) {
+        case PUSH_OP: 
+        case LOAD_OP:   
+          prog.depth = std::max(prog.depth, ++depth); 
+          break;
+        case ADD_OP: 
+        case SUB_OP:  
+        case MUL_OP: 
+        case DIV_OP: 
+        case POW_OP:
+        case STOREA_OP:
+        case POP_OP:
+	  --depth;
+	  break;
+        default:
+	  break;
+      }
+      if (in.op == LOAD_OP || in.op == LOADA_OP) st.reads.push_back(in.arg);
+      if (in.op == DEFN_OP || in.op == DEFNA_OP) st.writes.push_back(in.arg);
+    }
+    std::sort(st.reads.begin(),  st.reads.end());
+    st.reads.erase(std::unique(st.reads.begin(), st.reads.end()), st.reads.end());
+    std::sort(st.writes.begin(), st.writes.end());
+    st.writes.erase(std::unique(st.writes.begin(), st.writes.end()), st.writes.end());
+  }
+  if (static_cast<int>(stack_.size()) < prog.depth) stack_.resize(prog.depth);
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int SCalc::execute(Program& prog, double* result, char const* format, char* result_str)
+{
+  for (auto& st : prog.stmts) {
+    double value;
+    if (!run(st, value)) return num_of_err;
+    record(st);
+    *result = value;
+    sprintf(result_str, format, value);
+  }
+  if (prog.err.size()) {
+    strcpy(pterr, prog.err.c_str());
+    return ++num_of_err;
+  }
+  return num_of_err;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+bool SCalc::run(Statement const& st, double& result)
+{
+  // evaluates a compiled statement; returns false on error (the message is in pterr) 
+
+  double* sp = stack_.data();   // next free stack entry  
+  Variable* n;
+  double    x;
+  int       i;
+
+  auto element = [&](double x) { int i = (int)(fabs(x)+1.e-10); return ((x+1.e-10)<0) ? -i : i; };  
+
+  for (auto const& in : st.code) {
+    switch (in.op) {
+      case PUSH_OP:
+        *sp++ = in.val;
+	break;
+      case LOAD_OP:
+	if (!(n = slotvar_[in.arg])) {
+	  n = look(slotname_[in.arg].c_str(), 0);
+	  if (num_of_err) return false;
+	  slotvar_[in.arg] = n;
+	}
+        *sp++ = n->value;
+	break;
+      case LOADA_OP:
+	if (!(n = slotvar_[in.arg])) {
+	  n = look(slotname_[in.arg].c_str(), 0);
+	  if (num_of_err) return false;
+	  slotvar_[in.arg] = n;
+	}
+	i = element(sp[-1]);
+      	if ((i<0) || (i >= n->array.size())) {
+	  strcpy(pterr,"Array index outside range");
+	  num_of_err++;
+          return false;
+	}
+	sp[-1] = n->array[i];
+	break;
+      case DEFN_OP:
+      case DEFNA_OP:
+	if (!(n = slotvar_[in.arg])) n = slotvar_[in.arg] = insert(slotname_[in.arg].c_str());
+	if ( in.op == DEFN_OP && n->array.size() > 0) {
+	  strcpy(pterr,"Cannot assign scalar to ARRAY"); 
+	  num_of_err++; 
+	  return false;
+	}
+	if ( in.op == DEFNA_OP && n->array.size() == 0) {
+	  strcpy(pterr,"Array index used with a scalar variable");
+	  num_of_err++; 
+	  return false;
+	}
+	break;
+      case STORE_OP:
+	slotvar_[in.arg]->value = sp[-1];
+	break;
+      case STOREA_OP:
+	n = slotvar_[in.arg];
+	i = element(sp[-2]);
+      	if ((i<0) || (i >= n->array.size())) { 
+	  strcpy(pterr,"Array index out of range");
+	  num_of_err++;
+	  return false;
+	}
+	n->array[i] = sp[-1];
+	sp[-2] = sp[-1];
+	--sp;
+	break;
+      case NEG_OP:
+	sp[-1] = -sp[-1];
+	break;
+      case ADD_OP:
+	--sp; sp[-1] += *sp;
+	break;
+      case SUB_OP:
+	--sp; sp[-1] -= *sp;
+	break;
+      case MUL_OP:
+	--sp; sp[-1] *= *sp;
+	break;
+      case DIV_OP:
+	--sp; 
+	if (*sp == 0) {
+	  strcpy(pterr,"Division by zero");
+	  num_of_err++;
+	  return false;
+	}
+	sp[-1] /= *sp;
+	break;
+      case POW_OP:
+	x = *--sp;
+        i = (int)(x+1e-10);
+        if ((i>=0.) && (i<12.) && (fabs(i-x)<1.e-9)) {
+	  double d = 1.0;
+	  for (int j=0; j<i; ++j) d *= sp[-1];
+	  sp[-1] = d;
+	  break;
+        }
+	if (sp[-1] < 0) {
+	  strcpy(pterr,"negative argument in computing power");
+	  num_of_err++;
+	  return false;
+        }
+        if (sp[-1] != 0) sp[-1] = exp(log(sp[-1])*x);
+	break;
+      case CALL_OP:
+	sp[-1] = Function(sp[-1], (func_value) in.arg);
+	if (num_of_err) return false;
+	break;
+      case POP_OP:
+	--sp;
+	break;
+    }
+  }
+  result = sp[-1];
+  return true;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void SCalc::record(Statement& st)
+{
+  // appends an assignment to the dependency tape. The tape is only usable when every
+  // statement was run once, and every variable was assigned by a single statement 
+  // which does not read it.
+
+  if (st.writes.empty() || !graphok_) return;
+
+  if (st.epoch == epoch_) graphok_ = false;   // repeated by a do{...}while loop 
+  st.epoch = epoch_;
+
+  for (int w : st.writes) {
+    if (writer_[w] >= 0) graphok_ = false;
+    if (std::binary_search(st.reads.begin(), st.reads.end(), w)) graphok_ = false;
+    writer_[w] = tape_.size();
+  }
+  if (graphok_) tape_.push_back(&st);
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int SCalc::assign(char const* var_name, double value, char* error)
+{
+  *error     = 0;
+  pterr      = error;
+  num_of_err = 0;
+
+  auto it = slotidx_.find(var_name);
+  if (!graphok_ || it == slotidx_.end()) return -1;
+
+  int k = it->second;
+  Variable* n = slotvar_[k];
+  if (!n) {
+    n = look(var_name, 0);
+    if (num_of_err) { *error = 0; num_of_err = 0; return -1; }
+    slotvar_[k] = n;
+  }
+  if (n->array.size() || n->str_value != "") return -1;
+
+  n->value = value;
+
+  // the tape is in evaluation order, so that a single pass reaches all the dependents 
+
+  std::fill(dirty_.begin(), dirty_.end(), 0);
+  dirty_[k] = 1;
+
+  for (auto st : tape_) {
+    bool depends = false;
+    for (int r : st->reads) { if (dirty_[r]) { depends = true; break; } }
+    if (!depends) continue;
+    double result;
+    if (!run(*st, result)) return num_of_err;
+    for (int w : st->writes) dirty_[w] = 1;
+  }
+  return 0;
 }
 
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
@@ -422,145 +708,138 @@ SCalc::token_value SCalc::get_token()
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-double SCalc::prim() // primary 
+void SCalc::prim(Statement& st) // primary 
 { 
-  Variable*   n;
-  double      e, iresult, *dref;
-  char        bb[128];
-  int         i;
-  char        save_bf[128];
-  char        save_cur_name[25];
-  char const* bt;
-  token_value save_cur_tok;
-  int         save_func_numb;
-  
+  char  name[sizeof(cur_name)];
+  char  text[ARRAY_POINTER_LEN];
+  int   k;
+
   switch(cur_tok) {
 
     case NUMBER:
+      st.code.push_back({PUSH_OP, 0, number_value});
       if(get_token()==NUMBER){
         strcpy(pterr,"Missing operand between numeric values");
 	num_of_err++;
       }
-      return number_value;
+      return;
     case NAME:
+      strcpy(name, cur_name);
+      strcpy(text, cur_ArrayPointer);
       if(get_token()==NAME){
         strcpy(pterr,"Missing operand between variables");
         num_of_err++;
-	return 0.;
+	return;
       }
+      k = slot(name);
       if(cur_tok == ASSIGN){
-	if(num_of_err)return 0.;
-	n = insert(cur_name);
-        if(*cur_ArrayPointer){
-          if(n->array.size() <= 0){ // FIXME cannot be < 0
-            strcpy(pterr,"Array index used with a scalar variable");
-	    num_of_err++; return 0.;
-	  }
-          //
-          bt = b;
-          strcpy(save_bf, cur_ArrayPointer);
-          strcpy(save_cur_name, cur_name);
-          save_func_numb=func_numb;
-          save_cur_tok = cur_tok;
-   	  if(calcLine(save_bf, &iresult,"%le", bb, pterr)) {
-	     num_of_err++;
-	     return 0;
-	  }
-          b = bt;
-          strcpy(cur_ArrayPointer, save_bf);
-          strcpy(cur_name, save_cur_name);
-          func_numb = save_func_numb;
-          cur_tok   = save_cur_tok;
-          //
-      	  i = ((int)(fabs(iresult)+1.e-10));
-          if((iresult+1.e-10)<0) i=-i;
-      	  if((i<0) || ( i >= n->array.size() )){ 
-             strcpy(pterr,"Array index out of range");
-	     num_of_err++;
-	     return 0.;
-	  }
-          dref = &(n->array[i]);
-        }
+	if(num_of_err) return;
+        if(*text){
+	  st.code.push_back({DEFNA_OP, k, 0.0});
+	  index(st, text);
+	  if(num_of_err) return;
+	}
 	else {
-          if(n->array.size() > 0){
-            strcpy(pterr,"Cannot assign scalar to ARRAY"); num_of_err++; return 0.;}
-            dref=&(n->value);
-          }
-	  get_token();
-	  if(num_of_err) return 0.;
-	  *dref = expr();
-	  if(cur_tok == RP) {
-	    strcpy(pterr,"excessive ')'");
-	    num_of_err++;
-	    return *dref;
-	  }
-	  return *dref;
-      }
-      if(*cur_ArrayPointer){
-        n = look(cur_name, 0);
-        //
-        bt = b;
-        strcpy(save_bf, cur_ArrayPointer);
-        strcpy(save_cur_name, cur_name);
-        save_func_numb=func_numb;
-        save_cur_tok=cur_tok;
-        if(calcLine(save_bf, &iresult,"%le", bb, pterr)){num_of_err++; return 0;}
-        b=bt;
-        strcpy(cur_ArrayPointer, save_bf);
-        strcpy(cur_name, save_cur_name);
-        func_numb = save_func_numb;
-        cur_tok   =  save_cur_tok;
-        //
-      	i = ((int)(fabs(iresult)+1.e-10));
-        if((iresult+1.e-10)<0) i=-i;
-      	if((i<0) || (i >=n->array.size())){
-	  strcpy(pterr,"Array index outside range");
+	  st.code.push_back({DEFN_OP, k, 0.0});
+	}
+	get_token();
+	if(num_of_err) return;
+	expr(st);
+	if(num_of_err) return;
+	if(cur_tok == RP) {
+	  strcpy(pterr,"excessive ')'");
 	  num_of_err++;
-          return 0.;
+	  return;
 	}
-        return n->array[i];
+	st.code.push_back({ (*text ? STOREA_OP : STORE_OP), k, 0.0});
+	return;
       }
-      return look(cur_name, 0)->value;
+      if(*text){
+	index(st, text);
+	if(num_of_err) return;
+	st.code.push_back({LOADA_OP, k, 0.0});
+	return;
+      }
+      st.code.push_back({LOAD_OP, k, 0.0});
+      return;
 
     case MINUS:
       get_token();
-      return -prim();
+      prim(st);
+      st.code.push_back({NEG_OP, 0, 0.0});
+      return;
     case LPx:
       get_token();
-      if(num_of_err) return 0.;
-      e = expr();
-      if(num_of_err) return 0.;
-      if(cur_tok != RP) {strcpy(pterr,"missing ')'"); num_of_err++; return 0.;}
+      if(num_of_err) return;
+      expr(st);
+      if(num_of_err) return;
+      if(cur_tok != RP) {strcpy(pterr,"missing ')'"); num_of_err++; return;}
       get_token();
-      return e;
+      return;
     case FUNCTION:
       get_token();
       if(cur_tok != LPx) {
 	 strcpy(pterr,"missing '(' after function name");
 	 num_of_err++;
-	 return 0.;
+	 return;
       }
       get_token();
-      if(num_of_err) return 0.;
-      e = expr();
-      if(num_of_err) return 0.;
+      if(num_of_err) return;
+      expr(st);
+      if(num_of_err) return;
       if(cur_tok != RP) {
 	 strcpy(pterr,"missing ')'");
-	 num_of_err++; return 0.;}
+	 num_of_err++; return;}
 	 get_token();
-	 return Function(e,cur_func[--func_numb]);
+	 st.code.push_back({CALL_OP, cur_func[--func_numb], 0.0});
+	 return;
     case END:
-      return 1;
+      st.code.push_back({PUSH_OP, 0, 1.0});
+      return;
     default:
       strcpy(pterr,"must be a primary");
       num_of_err++;
-      return 0.;
+      return;
    }
 }
 
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
+void SCalc::index(Statement& st, char const* text)
+{
+  // Array element index: the text between the brackets is a line of its own, 
+  // whose value is the value of its last expression. 
+  
+  char const* bt = b;
+  token_value save_cur_tok   = cur_tok;
+  int         save_func_numb = func_numb;
+  char        save_cur_name[sizeof(cur_name)];
+  strcpy(save_cur_name, cur_name);
+
+  func_numb = 0;
+  int n = 0;
+  b = text;
+  while (*b) {
+    get_token();
+    if (num_of_err) return;
+    if (cur_tok == END) break;
+    if (cur_tok == PRINT) continue;
+    if (n++) st.code.push_back({POP_OP, 0, 0.0});
+    expr(st);
+    if (num_of_err) return;
+  }
+  if (n == 0) st.code.push_back({PUSH_OP, 0, 0.0});
+
+  b         = bt;
+  cur_tok   = save_cur_tok;
+  func_numb = save_func_numb;
+  strcpy(cur_name, save_cur_name);
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
 double SCalc::Function(double x, func_value cur_func)
 {
   int i,j,m;
@@ -583,7 +862,7 @@ double SCalc::Function(double x, func_value cur_func)
     case hrox:
       return x/C_CGS*1e11;
     case gaussx:
-      return x*::normal(appstate.generator); // x*gauss();
+      return x*gauss();
     case factx:
       j = (int)(x+1.e-9);
       if(( j < 1 ) || ( j > 20 )){
@@ -633,71 +912,50 @@ double SCalc::Function(double x, func_value cur_func)
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-double SCalc::power()
+void SCalc::power(Statement& st)
 {
-  double d;
-  int i,j;
-  double left=prim();
-  if(num_of_err) return 0.;
+  prim(st);
+  if(num_of_err) return;
   for(;;){
     switch(cur_tok){
       case POWER:
 	get_token();
-	if(num_of_err) return 0.;
-	d = prim();
-   	if(num_of_err) return 0.;
-        i=(int)(d+1e-10);
-        if((i>=0.) && (i<12.) && (fabs(i-d)<1.e-9) ){
-          d=1.;
-	  j=0;
-          while(j<i) { d=d*left; j++;}
-          left=d;
-           break;
-        }
-	if(left<0){
-	  strcpy(pterr,"negative argument in computing power");
-	  num_of_err++;
-        }
-	else {
-          if(left!=0)left=exp(log(left)*d);
-        }
+	if(num_of_err) return;
+	prim(st);
+   	if(num_of_err) return;
+	st.code.push_back({POW_OP, 0, 0.0});
 	break;
       default:
-	return left;
+	return;
     }
   }
 }
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-double SCalc::term()
+void SCalc::term(Statement& st)
 {
-  double d;                
-  double left = power();
-   if(num_of_err)return 0.;
+  power(st);
+  if(num_of_err) return;
 
    for(;;){
       switch(cur_tok){
         case MUL:
 	  get_token();
-	  if(num_of_err) return 0.;
-	  left *= power();
-	  if(num_of_err) return 0.;
+	  if(num_of_err) return;
+	  power(st);
+	  if(num_of_err) return;
+	  st.code.push_back({MUL_OP, 0, 0.0});
 	  break;
         case DIV:
 	  get_token();
-	  if(num_of_err) return 0.;
-	  d = power();
-	  if(num_of_err) return 0.;
-	  if(d==0) {
-	    strcpy(pterr,"Division by zero");
-	    num_of_err++;
-            return 0.;
-	  }
-	  else left /=d;
+	  if(num_of_err) return;
+	  power(st);
+	  if(num_of_err) return;
+	  st.code.push_back({DIV_OP, 0, 0.0});
 	  break;
 	default:
-	  return left;
+	  return;
       }
     }
 }
@@ -705,28 +963,30 @@ double SCalc::term()
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-double SCalc::expr()
+void SCalc::expr(Statement& st)
 {       // additions and subtractions
 
-   double left = term();
-   if(num_of_err)return 0.;
+   term(st);
+   if(num_of_err) return;
 
    for(;;){
       switch(cur_tok){
         case PLUS:
 	  get_token();
-	  if(num_of_err)return 0.;
-	  left +=term();
-	  if(num_of_err)return 0.;
+	  if(num_of_err) return;
+	  term(st);
+	  if(num_of_err) return;
+	  st.code.push_back({ADD_OP, 0, 0.0});
 	  break;
        case MINUS:
 	  get_token();
-	  if(num_of_err)return 0.;
-	  left -=term();
-	  if(num_of_err)return 0.;
+	  if(num_of_err) return;
+	  term(st);
+	  if(num_of_err) return;
+	  st.code.push_back({SUB_OP, 0, 0.0});
 	  break;
 	default:
-	  return left;
+	  return;
      }
   }
 }
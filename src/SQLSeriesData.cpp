@@ -39,6 +39,8 @@
 #include <QtDebug>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
+#include <algorithm>
 #include <SQLSeriesData.h>
 #include <Globals.h>
 #undef emit
@@ -87,57 +89,40 @@ SQLSeriesData::~SQLSeriesData()
 
 void SQLSeriesData::init( sqlite::connection& con, std::string const& sqlquery)
 {
-  
-   sqlite::query q(con, sqlquery);
-   auto res = q.emit_result();
-
-   //std::cout << sqlquery << std::endl; 
-
-   sqlite::type tp[2];
-   tp[0] = res->get_column_type(0);
-   tp[1] = res->get_column_type(1);
-
-   auto getval = [&res, &tp](int col) { using namespace sqlite;
-                                        double result = 0.0;
-                                        switch (tp[col]) {
-                                         case integer:
-					   result = double(res->get_int(col));
-					   break;
-                                          case real:
-					   result = res->get_double(col);
-					   break;
-					  default:
-					   result = 0.0;  
-                                        };
-					return result;
-                                      };
-
-   points_.push_back({getval(0), getval(1)}); 
-
-   double xmin =  points_.back().x();
-   double xmax =  xmin;
-   double ymin =  points_.back().y();
-   double ymax =  ymin;
-
-   int k = 0;
-   res->next_row();
-   
-   do {
-     double x = getval(0);
-     double y = getval(1);
-
+  // The two result columns are read with the sqlite C api directly into the contiguous point
+  // array; integer and real values are both read with sqlite3_column_double, NULL reads as 0.   
+
+  sqlite3*      db   = sqlite::private_accessor::get_handle(con);
+  sqlite3_stmt* stmt = 0;
+
+  if ( sqlite3_prepare_v2(db, sqlquery.c_str(), -1, &stmt, 0) != SQLITE_OK ) {
+    sqlite3_finalize(stmt);
+    throw std::runtime_error(std::string("SQLSeriesData: ") + sqlite3_errmsg(db));
+  }
+
+  double xmin = 0.0;
+  double xmax = 0.0;
+  double ymin = 0.0;
+  double ymax = 0.0;
+
+  while ( sqlite3_step(stmt) == SQLITE_ROW ) {
+     double x = sqlite3_column_double(stmt, 0);
+     double y = sqlite3_column_double(stmt, 1);
+
+     if (points_.empty()) {
+       xmin = xmax = x;
+       ymin = ymax = y;
+     }
      xmin = std::min(x,xmin);
      xmax = std::max(x,xmax);
      ymin = std::min(y,ymin);
      ymax = std::max(y,ymax);
 
-     ++k;
-
      points_.push_back({x,y});
-     
-   } while(res->next_row()); 
+  }
+  sqlite3_finalize(stmt);
 
-   brect_ = QRectF( QPointF(xmin,ymin), QPointF(xmax,ymax)); 
+  brect_ = QRectF( QPointF(xmin,ymin), QPointF(xmax,ymax)); 
 }
 
 // |||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
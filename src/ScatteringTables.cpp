@@ -0,0 +1,110 @@
+//  =================================================================
+//
+//  ScatteringTables.cpp
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+
+#include <ScatteringTables.h>
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace {
+
+  std::mutex mtx; // guards both tables 
+
+  std::vector<std::pair<Vavilov::Parameters, std::shared_ptr<Vavilov const>>> vtables;
+  std::vector<std::pair<Moliere::Parameters, std::shared_ptr<Moliere const>>> mtables;
+
+  bool same( double a, double b)
+  {
+    return std::abs(a-b) <= ScatteringTables::rtol*std::max(std::abs(a), std::abs(b));
+  }
+
+  bool same( Vavilov::Parameters const& a, Vavilov::Parameters const& b)
+  {
+    return same(a.gma, b.gma) && same(a.I0, b.I0) && same(a.dE, b.dE) && (a.nfft == b.nfft);
+  }
+
+  bool same( Moliere::Parameters const& a, Moliere::Parameters const& b)
+  {
+    return same(a.Lc, b.Lc) && same(a.theta0, b.theta0) && same(a.thetamin, b.thetamin) && same(a.s, b.s);
+  }
+
+  template <typename P, typename T>
+  std::shared_ptr<T const> lookup( std::vector<std::pair<P, std::shared_ptr<T const>>>& tables, P const& p)
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+
+    auto it = std::find_if( tables.begin(), tables.end(), [&p](auto const& e) { return same(e.first, p); });
+    if (it != tables.end()) return it->second;
+
+    if (tables.size() >= ScatteringTables::capacity) tables.erase(tables.begin());
+
+    // the table is built under the lock: concurrent requests for the same parameters build it once.
+
+    tables.emplace_back( p, std::make_shared<T const>(p));
+    return tables.back().second;
+  }
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+std::shared_ptr<Vavilov const> ScatteringTables::vavilov( Vavilov::Parameters const& p)
+{
+  return lookup(vtables, p);
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+std::shared_ptr<Moliere const> ScatteringTables::moliere( Moliere::Parameters const& p)
+{
+  return lookup(mtables, p);
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void ScatteringTables::clear()
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  vtables.clear();
+  mtables.clear();
+}
@@ -40,10 +40,87 @@
 #include <Constants.h>
 #include <Coordinates.h>
 #include <TrackParam.h>
+#include <Dual.h>
+#include <Tpsa.h>
+#include <cmath>
 
 using Constants::C_DERV1;
 using Constants::PI;
 
+namespace {
+
+  template <typename T>
+  void sextupoleKicks( T& x, T& tx, T& y, T& ty, T const& s, double L)
+  {
+    // Ruth 4th order integrator. s is the integrated sextupole strength (optical units). 
+    // T is either double or a dual number (tangent map computation).  
+
+    using std::pow;
+  
+    // *** g++ treats pow as constexpr howeverm pow is NOT constexpr in pre c++26 std. This fails under clang++
+
+    const double c1 = 1.0/(2.0*(2.0-pow(2.0,1.0/3.0))); //0.6756
+    const double c4 = c1;                               //0.6756
+  
+    const double c2 = (1.0-pow(2.0,1.0/3.0))/(2.0*(2.0-pow(2.0,1.0/3.0))); // -0.25992/1.4801 = -0.175
+    const double c3 = c2;
+
+    const double d1 = 1.0/(2.0-pow(2.0,1.0/3.0));// 1/0.74007 = 1.351207
+    const double d3 = d1; // 1.351207 
+  
+    const double d2 = -pow(2.0,1.0/3.0)/(2.0-pow(2.0,1.0/3.0));// -1.2599/0.74007 = -1.702
+    const double d4 = 0;
+
+    x  += c1*tx*L;   y  += c1*ty*L;
+    tx += d1*0.5*s*(y*y-x*x); ty += d1*s*x*y;
+
+    x  += c2*tx*L;   y  += c2*ty*L;
+    tx += d2*0.5*s*(y*y-x*x); ty += d2*s*x*y;
+   
+    x  += c3*tx*L;   y  += c3*ty*L;
+    tx += d3*0.5*s*(y*y-x*x); ty += d3*s*x*y;
+   
+    x  += c4*tx*L;            y  += c4*ty*L;
+    tx += d4*0.5*s*(y*y-x*x); ty += d4*s*x*y;
+  }
+
+  template <typename T>
+  void tiltRotate( T* v, double alfa)
+  {
+    // v -> R(alfa) v, with R = RMatrix::m_tilt(alfa) 
+
+    double s = sin(alfa);
+    double c = cos(alfa);
+
+    T x  = v[0];
+    T xp = v[1];
+
+    v[0] =  c*x  + s*v[2];
+    v[1] =  c*xp + s*v[3];
+    v[2] = -s*x  + c*v[2];
+    v[3] = -s*xp + c*v[3];
+  }
+
+  template <typename T>
+  void sextupoleMap( Element const* el, T const& hr, T* v)
+  {
+    // sextupole transverse map; the longitudinal coordinates are unchanged.
+    // T is double (tracking) or Tpsa (map extraction) 
+
+    double alfa = el->tilt()*PI/180.;
+    double L    = el->length();
+
+    tiltRotate(v, alfa);
+
+    T s = el->S/hr*L;   //sextupole strength in optical units 
+
+    sextupoleKicks(v[0], v[1], v[2], v[3], s, L);
+
+    tiltRotate(v, -alfa);
+  }
+
+} // namespace
+
 Sextupole::Sextupole(const char* nm, char const* fnm)
   : Element(nm,fnm)
 {}
@@ -122,6 +199,53 @@ int Sextupole::trackOnce( double ms,   double& Enr0, int n_elem, int n_turn, Tra
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
+int Sextupole::trackTangent( double ms,   double& Enr0, int n_elem, int n_turn, TrackParam& prm,
+	    	             RMatrix const& m1, Coordinates& v, RMatrix& jac ) const
+{
+  // same as trackOnce. The Jacobian of the kicks is obtained by propagating 
+  // dual numbers w/r to the coordinates through the same map (sextupoleMap). 
+
+  using D = Dual_t<6>; 
+
+  int status = 0; 
+  if ( (status = backwardTest(prm, n_elem, n_turn, v )) ) return status;
+
+  D u[6];
+  for (int j=0; j<6; ++j) u[j] = D::variable(v[j], j);
+
+  D hr = prm.Hr0/(1.0 + u[5]);
+  sextupoleMap(this, hr, u);
+
+  RMatrix mk;
+  mk.toUnity();
+  for (int i=0; i<4; ++i) {
+    v[i] = u[i].value();
+    for (int j=0; j<6; ++j) mk[i][j] = u[i].deriv(j);
+  }
+
+  jac = mk * jac;
+
+  if ( (status = transAmpTest(prm, n_elem, n_turn, v )) ) return status; 
+
+  return 0;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int Sextupole::trackMap( double ms, double& Enr0, int n_elem, TrackParam& prm,
+		         RMatrix const& m1, Tpsa* u) const
+{
+  // same code path as sext_trans_new(), with Tpsa coordinates 
+
+  Tpsa hr = prm.Hr0/(1.+u[5]);
+  sextupoleMap(this, hr, u);
+  return 0;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
 RMatrix Sextupole::rmatrixsc(double& alfap, double& energy, double ms, double current, BeamSize& bs,double& tetaY, double dalfa, int st ) const
 {
 
@@ -174,80 +298,11 @@ RMatrix Sextupole::rmatrixsc(double& alfap, double& energy, double ms, double cu
 
 void Sextupole::sext_trans_new( Element const* el, double hr, Coordinates* vp, Coordinates const* v) 
 {
-
-
-  using std::pow;
-  
-  // *** g++ treats pow as constexpr howeverm pow is NOT constexpr in pre c++26 std. This fails under clang++
-  /***
-  constexpr double c1 = 1.0/(2.0*(2.0-pow(2.0,1.0/3.0))); //0.6756
-  constexpr double c4 = c1;                               //0.6756
-  
-  constexpr double c2 = (1.0-pow(2.0,1.0/3.0))/(2.0*(2.0-pow(2.0,1.0/3.0))); // -0.25992/1.4801 = -0.175
-  constexpr double c3 = c2;
-
-  constexpr double d1 = 1.0/(2.0-pow(2.0,1.0/3.0));// 1/0.74007 = 1.351207
-  constexpr double d3 = d1; // 1.351207 
-  
-  constexpr double d2 = -pow(2.0,1.0/3.0)/(2.0-pow(2.0,1.0/3.0));// -1.2599/0.74007 = -1.702
-  constexpr double d4 = 0;
-  ***/
-
-  const double c1 = 1.0/(2.0*(2.0-pow(2.0,1.0/3.0))); //0.6756
-  const double c4 = c1;                               //0.6756
-  
-  const double c2 = (1.0-pow(2.0,1.0/3.0))/(2.0*(2.0-pow(2.0,1.0/3.0))); // -0.25992/1.4801 = -0.175
-  const double c3 = c2;
-
-  const double d1 = 1.0/(2.0-pow(2.0,1.0/3.0));// 1/0.74007 = 1.351207
-  const double d3 = d1; // 1.351207 
-  
-  const double d2 = -pow(2.0,1.0/3.0)/(2.0-pow(2.0,1.0/3.0));// -1.2599/0.74007 = -1.702
-  const double d4 = 0;
-
-  //std::cout << "c = " << c1 + c2 + c3 +c4 << std::endl;
-  // std::cout << "d = " << d1 + d2 + d3 +d4 << std::endl;
-  // Ruth 4th order integrator  
-
   // sextupole transverse map 
-   
-   double alfa=el->tilt()*PI/180.;
-
-   RMatrix tl = RMatrix::m_tilt(alfa); //  tl = tilt matrix 
-
-   auto vi = tl * (*v).c;
-
-   vp->c[4] = vi[4]; // long coordinates are unchanged 
-   vp->c[5] = vi[5];  
-
-   double L = el->length();
-   double s = el->S/hr*L;   //sextupole strength in optical units 
-
-   double x  = vi[0];
-   double tx = vi[1];
-
-   double y  = vi[2];
-   double ty = vi[3];
-
-   x  += c1*tx*L;   y  += c1*ty*L;
-   tx += d1*0.5*s*(y*y-x*x); ty += d1*s*x*y;
 
-   x  += c2*tx*L;   y  += c2*ty*L;
-   tx += d2*0.5*s*(y*y-x*x); ty += d2*s*x*y;
-   
-   x  += c3*tx*L;   y  += c3*ty*L;
-   tx += d3*0.5*s*(y*y-x*x); ty += d3*s*x*y;
-   
-   x  += c4*tx*L;            y  += c4*ty*L;
-   tx += d4*0.5*s*(y*y-x*x); ty += d4*s*x*y;
-
-   vp->c[0] = x;
-   vp->c[1] = tx;
-   vp->c[2] = y;
-   vp->c[3] = ty;
-   
-   (*vp).c = tl.transpose() * (*vp).c;
+   if (vp != v) vp->c = v->c;
 
+   sextupoleMap(el, hr, vp->c.data());
 }
 
 //|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
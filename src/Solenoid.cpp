@@ -41,6 +41,7 @@
 #include <Constants.h>
 #include <TrackParam.h>
 #include <Coordinates.h>
+#include <ElementMatrices.h>
 #include <memory>
 #include <limits>
 
@@ -79,48 +80,19 @@ RMatrix Solenoid::rmatrix(double& alfap, double& energy, double ms, double& teta
   double hr     = P/C_DERV1;
   double bt     = P/(energy+ms);
   double gamma1 = 1. + energy/ms;
-  double s;
-  double c;
   
-  RMatrix mi;
-  mi.toUnity();
-
   RMatrix me;
   me.toUnity();
   
-  mi[4][5]  = L_/(gamma1*gamma1);
+  double k  =  B / hr;
 
-  double k =  B / hr;
-  double fi = L_ * k;
+  RMatrix mi;
+  ElementMatrices::solenoid<double>(mi, L_, B, hr, gamma1, (toupper(name()[1]) == 'C') ); // 'C': focusing part only
 
   if (fabs(k) < std::numeric_limits<double>::epsilon() ) {
-    mi[0][1] = mi[2][3] = L_;
     return std::move(mi);
   }
 
-  if ( toupper(name()[1]) == 'C'){     // focusing part only
-    s = sin(fi/2.);
-    c = cos(fi/2.);
-    mi[0][0] = mi[1][1] =  mi[2][2]=mi[3][3] = c;
-    mi[0][1] = mi[2][3] =  2.*s/k;
-    mi[1][0] = mi[3][2] = -k*s/2.;
-  }
-  else {                              // 4-dimensional transfer matrix
-    s = sin(fi);
-    c = cos(fi);
-    mi[0][0] =  mi[1][1] 
-             =  mi[2][2]
-             =  mi[3][3] = (1+c)/2.;
-    mi[0][1] =  mi[2][3] =  s/k;
-    mi[1][0] =  mi[3][2] = -k*s/4.;
-    mi[0][2] =  mi[1][3] =  s/2.;
-    mi[2][0] =  mi[3][1] = -s/2.;
-    mi[0][3] =  (1-c)/k;
-    mi[2][1] = -mi[0][3];
-    mi[1][2] = -(1-c)*k/4.;
-    mi[3][0] = -mi[1][2];
-  }
-
   if( A>0.0 ) { // effective aperture != 0 implies soft edge focusing 
                 //                    == 0 hard edge
 
@@ -310,11 +282,9 @@ int Solenoid::trackOnce( double ms,   double &Enr0,  int n_elem,   int n_turn, T
 //|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //|||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-Solenoid* Solenoid::split(int nslices) const
+void Solenoid::slice(int nslices)
 {
-  Solenoid* e = this->clone();
-  e->L_ /= nslices;
-  return e;
+  L_ /= nslices;
 }
 
 
@@ -103,7 +103,7 @@ void OptimMainWindow::spChargeBetas(Twiss4D& v, BunchParam& bunch, double iscale
     if( nm=='A' || nm=='W' ||nm=='X') {ns=1;}
 
  
-    auto e = std::shared_ptr<Element>( ep->split(ns) );
+    SliceRef e(*ep, ns, slice_arena_);
   
     legodata.push_back( { L*0.01, ep->length()*0.01, (ep->G>=0.0 ? 1:-1), ep->fullName()});
     
@@ -107,7 +107,7 @@ void OptimMainWindow::spChargePhases(Twiss4D& v, BunchParam& bunch)
     int ns   = (space_charge_step_<h) ? fabs(ep->length()/space_charge_step_)+1 : fabs(ep->length()/h)+1;
     if( nm=='A' || nm=='W' ||nm=='X'){ns=1;}
 
-    auto e = std::shared_ptr<Element>( ep->split(ns) );
+    SliceRef e(*ep, ns, slice_arena_);
 
     // calculates Element's boxes located at the bottom of screan
 
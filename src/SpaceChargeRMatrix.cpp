@@ -133,7 +133,7 @@ double OptimMainWindow::spChargeRMatrix(RMatrix& tmf, Twiss4D& v, BunchParam& bu
 
     if( nm=='A' || nm=='W' ||nm=='X'){ns=1;}
  
-    auto e = std::shared_ptr<Element>( ep->split(ns) );
+    SliceRef e(*ep, ns, slice_arena_);
     L     += ep->length();
 
     double dalfa  = 0.0;
@@ -241,7 +241,7 @@ int OptimMainWindow::tabulateFunctionsSpCh ( char* filenm,  FunctionDlgStruct*
      double DL = 0.0;
      if( nm=='A' || nm=='W' ||nm=='X') { ns=1;}
 
-     auto e = std::unique_ptr<Element>( ep->split(ns) );     
+     SliceRef e(*ep, ns, slice_arena_);     
 
      double dalfa =0.0; //  bend angle step ?? 
      double alfap =0.0; //  integrated bend angle ??
@@ -36,60 +36,124 @@
 //  =================================================================
 //
 
+
 #include <SplineInterpolator.h>
+#include <algorithm>
+#include <cmath>
 
 SplineInterpolator::SplineInterpolator()
+  : idx_(0.0), last_(0), uniform_(false)
 {}
 
-SplineInterpolator::SplineInterpolator(double const xv[], double const yv[], int n)
-  : x_( &xv[0], &xv[n]), y_( &yv[0], &yv[n])
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+SplineInterpolator::SplineInterpolator(double const xv[], double const yv[], int n, Kind kind)
+  : x_( &xv[0], &xv[n]), idx_(0.0), last_(n-2), uniform_(false)
 {
-  double p;
-  double sig;
-  
-  std::vector<double> u(n);
-  
-  y2_[0] = u[0] = 0.0; // force natural boundary condition 
-
-  for (int i=1; i<n-1; ++i) {
-    sig    = (x_[i]-x_[i-1])/(x_[i+1]-x_[i-1]);
-    p      = sig*y2_[i-1]+2.0;
-    y2_[i] = (sig-1.0)/p;
-    u[i]   = (y_[i+1]-y_[i])/(x_[i+1]-x_[i]) - (y_[i]-y_[i-1])/(x_[i]-x_[i-1]);
-    u[i]   = (6.0*u[i]/(x_[i+1]-x_[i-1])-sig*u[i-1])/p;
+  // tabulated data files are typically written on a uniform grid, with a few significant digits.
+  // Within 1.0e-4*dx of a node, the index may then select the adjacent interval; the cubics of 
+  // the two intervals agree there to O((1.0e-4*dx)^3).     
+
+  double dx = (x_[n-1]-x_[0])/(n-1);
+  uniform_  = (dx > 0.0);
+  for (int i=1; uniform_ && i<n-1; ++i) { 
+    uniform_ = fabs(x_[i] - (x_[0]+i*dx)) < 1.0e-4*dx;
   }
+  if (uniform_) idx_ = 1.0/dx;
 
-  y2_[n-1] = 0.0;  // force natural bounday condition
+  init(yv, kind);
+}
 
-  for (int i=n-2; i>=0; i--) y2_[i] = u[i]+y2_[i]*y2_[i+1];
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
+SplineInterpolator::SplineInterpolator(double x0, double dx, double const yv[], int n, Kind kind)
+  : x_(n), idx_(1.0/dx), last_(n-2), uniform_(true)
+{
+  for (int i=0; i<n; ++i) x_[i] = x0 + i*dx;
+  init(yv, kind);
 }
 
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-double SplineInterpolator::operator()(double x) const
+void SplineInterpolator::init(double const yv[], Kind kind)
 {
+  int n = x_.size();
+
+  c0_.assign(&yv[0], &yv[n]);
+  c1_.resize(n);
+  c2_.resize(n);
+  c3_.resize(n);
+
+  std::vector<double> h(n-1);
+  std::vector<double> s(n-1);  // slopes of the secants 
+
+  for (int i=0; i<n-1; ++i) {
+    h[i] = x_[i+1]-x_[i];
+    s[i] = (c0_[i+1]-c0_[i])/h[i];
+  }
+
+  if (kind == Natural) {
+
+    // second derivatives, natural boundary conditions (see spline() in Cavity.cpp)  
 
- int k;
- int klo = 0;
- int khi = x_.size();
+    std::vector<double> y2(n);
+    std::vector<double> u(n);
+  
+    y2[0] = u[0] = 0.0; 
 
- while (khi-klo > 1) {
-    k = (khi+klo) >> 1;
-    if (x_[k] > x) khi=k;
-    else klo=k;
- }
+    for (int i=1; i<n-1; ++i) {
+      double sig = h[i-1]/(x_[i+1]-x_[i-1]);
+      double p   = sig*y2[i-1]+2.0;
+      y2[i] = (sig-1.0)/p;
+      u[i]  = s[i] - s[i-1];
+      u[i]  = (6.0*u[i]/(x_[i+1]-x_[i-1])-sig*u[i-1])/p;
+    }
 
- double h=x_[khi]-x_[klo];
+    y2[n-1] = 0.0;  
 
- // if (h <= 0.0) return 1;
+    for (int i=n-2; i>=0; i--) y2[i] = u[i]+y2[i]*y2[i+1];
 
- double a = (x_[khi]- x       )/h;
- double b = (x      - x_[klo] )/h;
+    for (int i=0; i<n-1; ++i) {
+      c1_[i] = s[i] - h[i]*(2.0*y2[i] + y2[i+1])/6.0;
+      c2_[i] = 0.5*y2[i];
+      c3_[i] = (y2[i+1]-y2[i])/(6.0*h[i]);
+    }
+  }
+  else {
+
+    // Steffen, Astron. Astrophys. 239, 443 (1990): the slope at a node is limited by the  
+    // adjacent secants; it vanishes at a local extremum of the data.   
+
+    std::vector<double> yp(n);
+    yp[0]   = s[0];
+    yp[n-1] = s[n-2];
+    
+    for (int i=1; i<n-1; ++i) {
+      double p = (s[i-1]*h[i] + s[i]*h[i-1])/(h[i-1]+h[i]);
+      yp[i]    = (copysign(1.0, s[i-1]) + copysign(1.0, s[i])) 
+	         * std::min( std::min(fabs(s[i-1]), fabs(s[i])), 0.5*fabs(p) );
+    }
+
+    for (int i=0; i<n-1; ++i) {
+      c1_[i] = yp[i];
+      c2_[i] = (3.0*s[i] - 2.0*yp[i] - yp[i+1])/h[i];
+      c3_[i] = (yp[i] + yp[i+1] - 2.0*s[i])/(h[i]*h[i]);
+    }
+  }
+}
 
- return a*y_[klo]+b*y_[khi]+((a*a*a-a)*y2_[klo]+(b*b*b-b)*y2_[khi])*(h*h)/6.0;
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+double SplineInterpolator::operator()(double x) const
+{
+  int    k = interval(x);
+  double t = x - x_[k];
 
+  return c0_[k] + t*(c1_[k] + t*(c2_[k] + t*c3_[k]));
 }
 
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
@@ -100,21 +164,39 @@ double SplineInterpolator::operator()(double x, int order)  const
 
   if (order == 0)  return (*this)(x);
   
-  int klo = 0;
-  int khi = x_.size();;
+  int    k = interval(x);
+  double t = x - x_[k];
 
-  while (khi-klo > 1) {
-    int k = (khi+klo) >> 1;
-    if (x_[k] > x) khi = k;
-    else klo = k;
-  }
-  double h =x_[khi]-x_[klo];
+  return c1_[k] + t*(2.0*c2_[k] + 3.0*t*c3_[k]);
+}
 
-  // if (h == 0.0) return 1;
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-  double a = (x_[khi]- x      )/h;
-  double b = (x      - x_[klo])/h;
+void SplineInterpolator::evaluate(double const x[], double y[], int n) const
+{
+  if (!uniform_) {
+    for (int i=0; i<n; ++i) y[i] = (*this)(x[i]);
+    return;
+  }
 
-  return (y_[khi]-y_[klo])/h + ( (3*b*b-1)*y2_[khi] - (3.0*a*a-1)*y2_[klo] )*h/6.0;
+  // no data dependent branch; the loop is vectorizable (the coefficients are gathered)   
+
+  double const  x0   = x_[0];
+  double const  idx  = idx_;
+  int    const  last = last_;
+  double const* xk   = &x_[0];
+  double const* c0   = &c0_[0];
+  double const* c1   = &c1_[0];
+  double const* c2   = &c2_[0];
+  double const* c3   = &c3_[0];
+
+  #pragma omp simd
+  for (int i=0; i<n; ++i) {
+    double u = (x[i]-x0)*idx;
+    u        = std::min(std::max(u, 0.0), double(last));
+    int    k = int(u);
+    double t = x[i] - xk[k];
+    y[i] = c0[k] + t*(c1[k] + t*(c2[k] + t*c3[k]));
+  }
 }
-
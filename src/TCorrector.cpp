@@ -40,11 +40,39 @@
 #include <Constants.h>
 #include <Coordinates.h>
 #include <TrackParam.h>
+#include <Tpsa.h>
+#include <cmath>
 
 using Constants::C_DERV1;
 using Constants::C_CGS;
 using Constants::PI;
 
+namespace {
+
+  template <typename T>
+  void correctorKick( double L, double ms, TrackParam const& prm, T* v)
+  {
+    // T is double or Tpsa 
+
+    using std::sqrt;
+
+    T p  = prm.p0*(1.0+v[5]);  // p = p0 (1 + dp/p)  
+    T Hr = p/C_DERV1;          // brho  =  p/ec   p is in MeV/c   
+
+    T xp = prm.cfi/Hr;
+    T yp = prm.sfi/Hr;
+
+    v[0] += L * ( v[1] + 0.5 *xp);
+    v[1] += xp;
+    v[2] += L * ( v[3] + 0.5 *yp);
+    v[3] += yp;
+     
+    T vp  = C_CGS*p/sqrt( p*p*(1.0 + v[1]*v[1] + v[3]*v[3]) + ms*ms );  
+    v[4] += (vp/prm.vp0 - 1.0) * L;
+  }
+
+} // namespace
+
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
@@ -133,18 +161,7 @@ int  TCorrector::trackOnce( double ms,   double& Enr0,  int n_elem,   int n_turn
     return 1;
   }
 
-  double Hr = p/C_DERV1; // brho  =  p/ec   p is in MeV/c   
-
-  double xp = prm.cfi/Hr;
-  double yp = prm.sfi/Hr;
-
-  v[0] += L_ * ( v[1] + 0.5 *xp);
-  v[1] += xp;
-  v[2] += L_ * ( v[3] + 0.5 *yp);
-  v[3] += yp;
-     
-  double vp    = C_CGS*p/sqrt( p*p*(1.0 + v[1]*v[1] + v[3]*v[3]) + ms*ms );  
-  v[4] += (vp/prm.vp0 - 1.0) * L_;
+  correctorKick(L_, ms, prm, v.c.data());
 
 
  done:	
@@ -159,6 +176,17 @@ int  TCorrector::trackOnce( double ms,   double& Enr0,  int n_elem,   int n_turn
   return 0;
 }
 
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int TCorrector::trackMap( double ms, double& Enr0, int n_elem, TrackParam& prm,
+		          RMatrix const& m1, Tpsa* u) const
+{
+  if (u[5] < -1.0) return 1; // p < 0  
+  correctorKick(L_, ms, prm, u);
+  return 0;
+}
+
 
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
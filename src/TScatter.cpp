@@ -42,9 +42,9 @@
 #include <Utility.h>
 #include <TrackParam.h>
 #include <Coordinates.h>
+#include <RandomStream.h>
 
 using Constants::PI;
-using Utility::gauss;
 
 
 TScatter::TScatter(const char* nm, char const* fnm) // 'T'
@@ -116,8 +116,10 @@ int TScatter::trackOnce(double ms, double& Enr0, int n_elem, int n_turn,
 
   s = ( s>0.0) ? 0.001*sqrt(s) : 0.0;
 
-  v[1] += s*gauss();
-  v[3] += s*gauss();
+  RandomStream rng(n_turn, n_elem, v.pid);  // per-particle stream: reproducible in parallel 
+
+  v[1] += s*rng.normal();
+  v[3] += s*rng.normal();
 
  done:	
 
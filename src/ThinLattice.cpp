@@ -0,0 +1,587 @@
+//  =================================================================
+//
+//  ThinLattice.cpp
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+#include <ThinLattice.h>
+#include <Element.h>
+#include <Constants.h>
+#include <RMatrix.h>
+#include <TrackParam.h>
+#include <Utility.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using Constants::PI;
+using Constants::C_CGS;
+using Constants::C_DERV1;
+
+namespace {
+
+  void slicing( ThinOptions::Scheme scheme, int n, std::vector<double>& d, std::vector<double>& w)
+  {
+    // fractions of the element length: d[0] w[0] d[1] w[1] ... w[n-1] d[n]
+    // d: drifts, w: kick weights (sum of w = 1)
+
+    d.clear();
+    w.clear();
+
+    if (scheme == ThinOptions::yoshida) {
+
+      double const a  = std::pow(2.0, 1.0/3.0);
+      double const c1 = 1.0/(2.0*(2.0-a));          // same coefficients as sextupoleKicks() 
+      double const c2 = (1.0-a)/(2.0*(2.0-a));
+      double const d1 = 1.0/(2.0-a);
+      double const d2 = -a/(2.0-a);
+
+      double const cs[4] = {c1, c2, c2, c1};
+      double const ds[3] = {d1, d2, d1};
+
+      d.push_back(0.0);
+      for (int i=0; i<n; ++i) {
+        for (int j=0; j<3; ++j) {
+          d.back() += cs[j]/n;
+          w.push_back(ds[j]/n);
+          d.push_back(0.0);
+        }
+        d.back() += cs[3]/n;
+      }
+      return;
+    }
+
+    if (n == 1) {
+      d = {0.5, 0.5};
+      w = {1.0};
+      return;
+    }
+
+    double const e = 1.0/(2.0*(n+1));     // TEAPOT spacing 
+    double const c = n/(double(n)*n-1.0);
+
+    d.push_back(e);
+    for (int i=0; i<n; ++i) {
+      w.push_back(1.0/n);
+      d.push_back( (i+1 < n) ? c : e );
+    }
+  }
+
+} // namespace
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+ThinLattice::ThinLattice()
+  : drift_(0.0), phi_(0.0), ms_(0.0), p0_(0.0), vp0_(0.0), knob_{1.0, 1.0}, failed_(-1)
+{}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+ThinLattice::Status ThinLattice::make( std::vector<std::shared_ptr<Element>> const& line, double ms, double Enr, double tetaY,
+                                       ThinOptions const& opt )
+{
+  kicks_.clear();
+  family_.clear();
+  drift_   = 0.0;
+  failed_  = -1;
+  knob_[0] = knob_[1] = 1.0;
+  phi_     = 0.0;
+
+  ms_  = ms;
+  p0_  = sqrt(2.*ms*Enr+Enr*Enr);
+  vp0_ = C_CGS*p0_/sqrt(p0_*p0_+ms*ms);
+
+  double const hr  = p0_/C_DERV1;  // brho in kG-cm
+  double const eps = std::numeric_limits<double>::epsilon();
+
+  RMatrix    me;
+  RMatrix    tm;
+  TrackParam prm;
+
+  tm.toUnity();
+
+  for (int i=0; i<int(line.size()); ++i) {
+
+    auto const& ep = line[i];
+
+    ep->preTrack(ms, Enr, tetaY, i, prm, me);
+
+    double L    = ep->length();
+    double alfa = ep->tilt()*PI/180.;
+    int    n    = 1;
+    int    fam  = 0;
+    Kick   k    = {};
+
+    char et = ep->etype(); 
+
+    if ( (et == 'Q') || (et == 'S') || (et == 'B') || (et == 'C') ) {   // thick magnets  
+      n = opt.nslices;
+      for (auto const& f : opt.families) {
+        if (Utility::filterName(ep->name(), f.first.c_str(), true)) { n = f.second; break; }
+      }
+      n = std::max(n, 1);
+    }
+
+    switch (et) {
+
+      case 'O':    // drift
+      case 'I':    // instrument
+      case 'H':    // aperture (not represented) 
+        drift_ += L;
+        break;
+
+      case 'Z':    // longitudinal corrector, only without a kick  
+        if (ep->G != 0.0) { failed_ = i; return unsupported; }
+        drift_ += L;
+        break;
+
+      case 'K':    // transverse corrector: exact as a kick at the center 
+        k.b[0][0] = -L*ep->B*cos(alfa)/hr;
+        k.b[0][1] =  L*ep->B*sin(alfa)/hr;
+        slice(k, L, 1, ThinOptions::teapot, 0);
+        break;
+
+      case 'G':    // edge: linear kick 
+        if (fabs(ep->B) < eps) break;
+        k.f[0][0] = me[1][0];  k.f[0][1] = me[1][2];
+        k.f[1][0] = me[3][0];  k.f[1][1] = me[3][2];
+        addKick(k, 0);
+        break;
+
+      case 'M': {  // thin multipole 
+        int m = ep->N;
+        if ( (m < 0) || (m > max_order) ) { failed_ = i; return unsupported; }
+        if (m == 0) {
+          k.hx = ep->S*cos(alfa)/hr;
+          k.hy = ep->S*sin(alfa)/hr;
+        }
+        else {
+          double a = ep->S/hr;
+          for (int j=2; j<=m; ++j) a /= j;
+          k.b[m][0] =  a*cos((m+1)*alfa);
+          k.b[m][1] = -a*sin((m+1)*alfa);
+        }
+        slice(k, L, 1, ThinOptions::teapot, 0);
+        break;
+      }
+
+      case 'S': {  // sextupole
+        double a = 0.5*ep->S*L/hr;
+        if (a == 0.0) { drift_ += L; break; }
+        k.b[2][0] =  a*cos(3*alfa);
+        k.b[2][1] = -a*sin(3*alfa);
+        slice(k, L, n, opt.scheme, 0);
+        break;
+      }
+
+      case 'C': {  // hard edge solenoid: rotation by k L/2 and focusing (k/2)^2 L, k = B/(B rho).  
+                   // A pseudo-solenoid (SC...) does not rotate; soft edges (A > 0) are not represented  
+        if (ep->A > 0.0) { failed_ = i; return unsupported; }
+        double ks = ep->B/hr;
+        if (fabs(ks) < eps) { drift_ += L; break; }
+        k.rs = (toupper(ep->name()[1]) == 'C') ? 0.0 : 0.5*ks*L;
+        k.ks = 0.25*ks*ks*L;
+        slice(k, L, n, opt.scheme, 0);
+        break;
+      }
+
+      case 'B':    // combined function dipole; a quadrupole if B = 0 
+      case 'Q': {  // quadrupole (no focusing below 1e-3 cm, as in Quadrupole::transport) 
+
+        double B = (et == 'B') ? ep->B : 0.0;
+        double G = ( (et == 'Q') && (fabs(L) < 1.0e-3) ) ? 0.0 : ep->G;
+
+        double a = G*L/hr;
+        if ( (a == 0.0) && (fabs(B) < eps) ) { drift_ += L; break; }
+
+        k.b[1][0] =  a*cos(2*alfa);
+        k.b[1][1] = -a*sin(2*alfa);
+
+        if (et == 'Q') {                // kick about the magnet axis 
+          k.b[0][0] = -(k.b[1][0]*ep->offsX() - k.b[1][1]*ep->offsY());
+          k.b[0][1] = -(k.b[1][0]*ep->offsY() + k.b[1][1]*ep->offsX());
+        }
+
+        if (fabs(B) < eps) {
+          fam = (G > 0.0) ? 1 : ( (G < 0.0) ? 2 : 0 );
+        }
+        else {                          // bend angle, weak focusing in the bend plane and error kicks (see CFBend::tiltKick)  
+          double phi = L*B/hr;
+          double c   = cos(alfa);
+          double s   = sin(alfa);
+          double kf  = (L > 0.0) ? phi*phi/L : 0.0;
+          k.hx      = phi*c;
+          k.hy      = phi*s;
+          k.f[0][0] = -kf*c*c;  k.f[0][1] = -kf*c*s;
+          k.f[1][0] = -kf*c*s;  k.f[1][1] = -kf*s*s;
+          double te = ep->tiltErr()*PI/180.*phi;
+          double fe = ep->fieldErr()*phi;
+          k.b[0][0] += -s*te + c*fe;
+          k.b[0][1] += -c*te - s*fe;
+        }
+
+        slice(k, L, n, opt.scheme, fam);
+
+        // the frame rotates about the reference orbit when the exit rotation of a tilted
+        // bend differs from the entrance one (see CFBend::preTrack) 
+
+        if (fabs(B) >= eps) phi_ += atan2(prm.sb2, prm.cb2) - alfa;
+        break;
+      }
+
+      default:
+        failed_ = i;
+        return unsupported;
+    }
+
+    tm = ep->rmatrix(Enr, ms, tetaY, 0.0, 3)*tm; // advances the frame angle 
+  }
+
+  if (!opt.rematch) return ok;
+
+  // rematch the eigen-tunes (cos mu) of the thick lattice with the focusing and defocusing 
+  // quadrupole kick strengths 
+
+  bool has[2] = {false, false};
+  for (int f : family_) if (f) has[f-1] = true;
+  if (!has[0] || !has[1]) return unmatched;
+
+  double m[4][4];
+  double target[2];
+  for (int r=0; r<4; ++r) {
+    for (int c=0; c<4; ++c) m[r][c] = tm[r][c];
+  }
+  cosMu(m, target);
+
+  double kn[2] = {1.0, 1.0};
+  bool   converged = false;
+
+  for (int it=0; it<20; ++it) {
+
+    double c0[2];
+    linearMatrix(kn[0], kn[1], m);
+    cosMu(m, c0);
+
+    double r[2] = { c0[0]-target[0], c0[1]-target[1] };
+    if ( (fabs(r[0]) < 1.0e-12) && (fabs(r[1]) < 1.0e-12) ) { converged = true; break; }
+
+    double const h = 1.0e-7;
+    double J[2][2];
+    for (int j=0; j<2; ++j) {
+      double c1[2];
+      double kk[2] = {kn[0], kn[1]};
+      kk[j] += h;
+      linearMatrix(kk[0], kk[1], m);
+      cosMu(m, c1);
+      J[0][j] = (c1[0]-c0[0])/h;
+      J[1][j] = (c1[1]-c0[1])/h;
+    }
+
+    double det = J[0][0]*J[1][1] - J[0][1]*J[1][0];
+    if (fabs(det) < 1.0e-30) break;
+
+    kn[0] -= ( J[1][1]*r[0] - J[0][1]*r[1])/det;
+    kn[1] -= (-J[1][0]*r[0] + J[0][0]*r[1])/det;
+  }
+
+  if (!converged) return unmatched;
+
+  for (int j=0; j<int(kicks_.size()); ++j) {
+    if (!family_[j]) continue;
+    double f = kn[family_[j]-1];
+    for (int l=0; l<2; ++l) {
+      kicks_[j].b[0][l] *= f;
+      kicks_[j].b[1][l] *= f;
+    }
+  }
+
+  knob_[0] = kn[0];
+  knob_[1] = kn[1];
+
+  return ok;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void ThinLattice::slice( Kick const& k, double L, int n, ThinOptions::Scheme scheme, int family )
+{
+  // k is the kick of the whole element 
+
+  std::vector<double> d;
+  std::vector<double> w;
+
+  slicing(scheme, n, d, w);
+
+  for (int j=0; j<int(w.size()); ++j) {
+    drift_ += d[j]*L;
+    Kick kj = k;
+    kj.hx *= w[j];
+    kj.hy *= w[j];
+    kj.rs *= w[j];
+    kj.ks *= w[j];
+    for (int r=0; r<2; ++r) {
+      for (int c=0; c<2; ++c) kj.f[r][c] *= w[j];
+    }
+    for (int m=0; m<=max_order; ++m) {
+      kj.b[m][0] *= w[j];
+      kj.b[m][1] *= w[j];
+    }
+    addKick(kj, family);
+  }
+  drift_ += d.back()*L;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void ThinLattice::addKick( Kick const& k, int family )
+{
+  // The kicks are expressed in the entrance frame; z = x+iy in the current frame 
+  // is exp(i phi_) z in the entrance frame.  
+
+  kicks_.push_back(k);
+
+  Kick& kn = kicks_.back();
+  kn.L = drift_;
+
+  if (phi_ != 0.0) {
+
+    double c = cos(phi_);
+    double s = sin(phi_);
+
+    for (int m=0; m<=max_order; ++m) {      // b_m -> b_m exp(i(m+1)phi) 
+      double cm = cos((m+1)*phi_);
+      double sm = sin((m+1)*phi_);
+      double re = kn.b[m][0];
+      kn.b[m][0] = re*cm - kn.b[m][1]*sm;
+      kn.b[m][1] = re*sm + kn.b[m][1]*cm;
+    }
+
+    double hx = kn.hx;                       // h -> exp(-i phi) h 
+    kn.hx =  c*hx + s*kn.hy;
+    kn.hy = -s*hx + c*kn.hy;
+
+    double f[2][2];                          // F -> R(-phi) F R(phi)
+    for (int r=0; r<2; ++r) {
+      f[r][0] =  k.f[r][0]*c + k.f[r][1]*s;
+      f[r][1] = -k.f[r][0]*s + k.f[r][1]*c;
+    }
+    for (int j=0; j<2; ++j) {
+      kn.f[0][j] =  c*f[0][j] + s*f[1][j];
+      kn.f[1][j] = -s*f[0][j] + c*f[1][j];
+    }
+  }
+
+  family_.push_back(family);
+  drift_ = 0.0;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int ThinLattice::track( Coordinates& v ) const
+{
+  double delta = v[5];
+  if (delta <= -1.0) return 1;  // p < 0
+
+  double p   = p0_*(1.0+delta);
+  double inv = 1.0/(1.0+delta);
+  double hd  = delta*inv;
+  double p2  = p*p;
+  double m2  = ms_*ms_;
+  double a   = C_CGS*p/vp0_;   // vp/vp0 = a/sqrt(p^2(1+x'^2+y'^2)+ms^2) 
+
+  double x  = v[0];
+  double xp = v[1];
+  double y  = v[2];
+  double yp = v[3];
+  double s  = v[4];
+
+  for (auto const& k : kicks_) {
+
+    x += k.L*xp;
+    y += k.L*yp;
+    s += k.L*( a/sqrt(p2*(1.0 + xp*xp + yp*yp) + m2) - 1.0 );
+
+    double re = k.b[max_order][0];     // sum b_m (x+iy)^m (Horner)
+    double im = k.b[max_order][1];
+    for (int m=max_order-1; m>=0; --m) {
+      double t = re*x - im*y + k.b[m][0];
+      im       = re*y + im*x + k.b[m][1];
+      re       = t;
+    }
+
+    xp += -re*inv + k.f[0][0]*x + k.f[0][1]*y + k.hx*hd;
+    yp +=  im*inv + k.f[1][0]*x + k.f[1][1]*y + k.hy*hd;
+    s  -= k.hx*x + k.hy*y;
+
+    if (k.ks != 0.0) {   // solenoid; both terms scale with 1/p 
+      double th = k.rs*inv;
+      double cr = cos(th);
+      double sr = sin(th);
+      double t  = cr*x  + sr*y;
+      y         = -sr*x  + cr*y;
+      x         = t;
+      t         = cr*xp + sr*yp;
+      yp        = -sr*xp + cr*yp;
+      xp        = t;
+      double kf = k.ks*inv*inv;
+      xp -= kf*x;
+      yp -= kf*y;
+    }
+  }
+
+  x += drift_*xp;
+  y += drift_*yp;
+  s += drift_*( a/sqrt(p2*(1.0 + xp*xp + yp*yp) + m2) - 1.0 );
+
+  double c  = cos(phi_);   // back to the exit frame 
+  double sn = sin(phi_);
+
+  v[0] = c*x  - sn*y;
+  v[1] = c*xp - sn*yp;
+  v[2] = sn*x  + c*y;
+  v[3] = sn*xp + c*yp;
+  v[4] = s;
+
+  return ( (fabs(x) <= 1000.0) && (fabs(y) <= 1000.0) ) ? 0 : 1;  // also catches nan 
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+double ThinLattice::length() const
+{
+  double L = drift_;
+  for (auto const& k : kicks_) L += k.L;
+  return L;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void ThinLattice::linearMatrix( double kf, double kd, double m[4][4] ) const
+{
+  // transverse linear matrix about the reference orbit (dp/p = 0), with the quadrupole
+  // kicks scaled by kf (focusing) and kd (defocusing) 
+
+  for (int r=0; r<4; ++r) {
+    for (int c=0; c<4; ++c) m[r][c] = (r == c) ? 1.0 : 0.0;
+  }
+
+  auto drift = [m](double L) {
+    for (int c=0; c<4; ++c) {
+      m[0][c] += L*m[1][c];
+      m[2][c] += L*m[3][c];
+    }
+  };
+
+  for (int j=0; j<int(kicks_.size()); ++j) {
+
+    auto const& k = kicks_[j];
+    drift(k.L);
+
+    double f  = (family_[j] == 1) ? kf : ( (family_[j] == 2) ? kd : 1.0 );
+    double br = f*k.b[1][0];
+    double bi = f*k.b[1][1];
+
+    double k00 = k.f[0][0] - br;
+    double k01 = k.f[0][1] + bi;
+    double k10 = k.f[1][0] + bi;
+    double k11 = k.f[1][1] + br;
+
+    for (int c=0; c<4; ++c) {
+      m[1][c] += k00*m[0][c] + k01*m[2][c];
+      m[3][c] += k10*m[0][c] + k11*m[2][c];
+    }
+
+    if (k.ks != 0.0) {   // solenoid
+      double cr = cos(k.rs);
+      double sr = sin(k.rs);
+      for (int c=0; c<4; ++c) {
+        double x  = m[0][c];
+        double xp = m[1][c];
+        m[0][c] =  cr*x  + sr*m[2][c];
+        m[2][c] = -sr*x  + cr*m[2][c];
+        m[1][c] =  cr*xp + sr*m[3][c] - k.ks*m[0][c];
+        m[3][c] = -sr*xp + cr*m[3][c] - k.ks*m[2][c];
+      }
+    }
+  }
+
+  drift(drift_);
+
+  double c = cos(phi_);
+  double s = sin(phi_);
+
+  for (int j=0; j<4; ++j) {
+    double x  = m[0][j];
+    double xp = m[1][j];
+    m[0][j] = c*x  - s*m[2][j];
+    m[1][j] = c*xp - s*m[3][j];
+    m[2][j] = s*x  + c*m[2][j];
+    m[3][j] = s*xp + c*m[3][j];
+  }
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void ThinLattice::cosMu( double const m[4][4], double c[2] )
+{
+  // cos of the eigen phase advances of a 4x4 symplectic matrix  M = [ A B ]
+  //                                                                  [ C D ]
+  // cos mu1,2 = (tr A + tr D)/4 +/- (1/2) sqrt( ((tr A - tr D)/2)^2 + det(B + Cbar) )
+  // with Cbar the symplectic conjugate of C. The sign is chosen so that mu1 is the 
+  // horizontal phase advance in the uncoupled limit.  
+
+  double trA = m[0][0] + m[1][1];
+  double trD = m[2][2] + m[3][3];
+
+  double h00 = m[0][2] + m[3][1];   // B + Cbar 
+  double h01 = m[0][3] - m[2][1];
+  double h10 = m[1][2] - m[3][0];
+  double h11 = m[1][3] + m[2][0];
+
+  double disc = 0.25*(trA-trD)*(trA-trD) + (h00*h11 - h01*h10);
+  double sq   = (disc > 0.0) ? sqrt(disc) : 0.0;
+  if (trA < trD) sq = -sq;
+
+  c[0] = 0.25*(trA+trD) + 0.5*sq;
+  c[1] = 0.25*(trA+trD) - 0.5*sq;
+}
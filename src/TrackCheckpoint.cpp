@@ -0,0 +1,313 @@
+//  =================================================================
+//
+//  TrackCheckpoint.cpp
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+
+#include <TrackCheckpoint.h>
+#include <BeamMoments.h>
+#include <MomentsStore.h>
+#include <Globals.h>
+#include <RandomStream.h>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#if defined(_MSC_VER)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifdef USE_MSWINDOWS
+#include <windows.h>
+#endif
+
+#undef emit
+#include <sqlite/execute.hpp>
+#include <sqlite/query.hpp>
+#include <sqlite/private/private_accessor.hpp>
+#include <sqlite3.h>
+
+namespace {
+
+  char const magic[8] = {'O','P','T','C','K','P','T','1'};
+
+  // flushes fp to the storage device and closes it; returns 0 on success  
+
+  int syncClose(FILE* fp)
+  {
+    int status = fflush(fp);
+#if defined(_MSC_VER)
+    if (!status) status = _commit(_fileno(fp));
+#else
+    if (!status) status = fsync(fileno(fp));
+#endif
+    return (fclose(fp) || status) ? 1 : 0;
+  }
+
+  // atomically replaces fname by tmp; returns 0 on success 
+
+  int replaceFile(std::string const& tmp, std::string const& fname)
+  {
+#ifdef USE_MSWINDOWS
+    return MoveFileExA(tmp.c_str(), fname.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) ? 0 : 1;
+#else
+    return std::rename(tmp.c_str(), fname.c_str()) ? 1 : 0;
+#endif
+  }
+
+} // namespace
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void TrackCheckpoint::saveRng()
+{
+  std::ostringstream os;
+  os << GlobalState::generator << ' ' << RandomStream::epoch();
+  rng = os.str();
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void TrackCheckpoint::restoreRng() const
+{
+  std::istringstream is(rng);
+  is >> GlobalState::generator;
+
+  RandomStream::result_type epoch; 
+  if (is >> epoch) RandomStream::reseed(epoch);  // absent from older checkpoints
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int TrackCheckpoint::write(std::string const& fname, TrackCheckpoint const& cp)
+{
+  std::string tmp = fname + ".tmp";
+
+  FILE* fp = fopen(tmp.c_str(), "wb");
+  if (!fp) return 1;
+
+  unsigned int nrng = cp.rng.size();
+
+  bool ok = fwrite(magic,     1,               8, fp) == 8 &&
+            fwrite(&cp.turn, sizeof(cp.turn), 1, fp) == 1 &&
+            fwrite(&cp.nelm, sizeof(cp.nelm), 1, fp) == 1 &&
+            fwrite(&cp.Enr,  sizeof(cp.Enr),  1, fp) == 1 &&
+            fwrite(&nrng,    sizeof(nrng),    1, fp) == 1 &&
+            fwrite(cp.rng.data(), 1, nrng, fp) == nrng   &&
+            cp.bunch.write(fp) == 0;
+
+  if ( syncClose(fp) || !ok ) {
+    std::remove(tmp.c_str());
+    return 1;
+  }
+
+  return replaceFile(tmp, fname);
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int TrackCheckpoint::read(std::string const& fname, TrackCheckpoint& cp)
+{
+  FILE* fp = fopen(fname.c_str(), "rb");
+  if (!fp) return 1;
+
+  char         tag[8];
+  unsigned int nrng = 0;
+
+  bool ok = fread(tag,      1,               8, fp) == 8 && !memcmp(tag, magic, 8) &&
+            fread(&cp.turn, sizeof(cp.turn), 1, fp) == 1 &&
+            fread(&cp.nelm, sizeof(cp.nelm), 1, fp) == 1 &&
+            fread(&cp.Enr,  sizeof(cp.Enr),  1, fp) == 1 &&
+            fread(&nrng,    sizeof(nrng),    1, fp) == 1;
+
+  if (ok) {
+    cp.rng.resize(nrng);
+    ok = fread(&cp.rng[0], 1, nrng, fp) == nrng && cp.bunch.read(fp) == 0;
+  }
+
+  fclose(fp);
+  return ok ? 0 : 1;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int TrackCheckpoint::saveMoments(sqlite::connection& con, std::string const& dbname)
+{
+  // online backup of the (possibly in-memory) tracking database. The moments archive (schema arch, 
+  // see MomentsStore), when attached, is saved to dbname.arch  
+
+  BeamMoments::dbFlush(con);
+  MomentsStore::flush(con);
+
+  sqlite3* src = sqlite::private_accessor::get_handle(con);
+
+  auto backup = [src](char const* schema, std::string const& fname) {
+    sqlite3* dst = 0;
+    int rc = sqlite3_open(fname.c_str(), &dst);
+    if (rc == SQLITE_OK) {
+      sqlite3_backup* bk = sqlite3_backup_init(dst, "main", src, schema);
+      if (bk) {
+	sqlite3_backup_step(bk, -1);
+	sqlite3_backup_finish(bk);
+      }
+      rc = sqlite3_errcode(dst);
+    }
+    sqlite3_close(dst);
+    return (rc == SQLITE_OK) ? 0 : 1;
+  };
+
+  int status = backup("main", dbname);
+  if (sqlite3_db_filename(src, "arch")) {
+    std::string arcname = dbname;
+    arcname.insert(arcname.rfind(".db"), ".arch");  // xxx.db.tmp -> xxx.arch.db.tmp 
+    status |= backup("arch", arcname);
+  }
+  return status;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int TrackCheckpoint::loadMoments(sqlite::connection& con, std::string const& dbname, int turn)
+{
+  // the db is renamed into place before the checkpoint file, so that it may hold rows 
+  // past the checkpoint turn; these are discarded, as are the rows of the current db past 
+  // the checkpoint (a run resumed in the same session). The archive is replaced by the saved one
+  // and the rollup blocks in progress are restored from it, unless it is more recent than the 
+  // checkpoint: the rollups then cover the turns up to the checkpoint only and 1 is returned. 
+
+  auto quoted = [](std::string const& s) {
+    std::string name = "'";
+    for (char c : s) {
+      name += c;
+      if (c == '\'') name += c;
+    }
+    return name + "'";
+  };
+
+  std::string where = " WHERE turn <= " + std::to_string(turn) + ";";
+
+  BeamMoments::dbFlush(con);
+
+  bool newer = false;
+
+  try {
+    sqlite::execute(con, "DELETE FROM main.Moments WHERE turn > " + std::to_string(turn) + ";", true);
+    sqlite::execute(con, "ATTACH DATABASE " + quoted(dbname) + " AS ckpt;", true);
+    sqlite::execute(con, "INSERT OR REPLACE INTO main.Moments SELECT * FROM ckpt.Moments" + where, true);
+    { sqlite::query q(con, "SELECT max(turn) FROM ckpt.Moments;");
+      auto res = q.emit_result();
+      newer = res->next_row() && (res->get_int(0) > turn); 
+    }
+    sqlite::execute(con, "DETACH DATABASE ckpt;", true);
+
+    std::string arcname = dbname;
+    arcname.insert(arcname.rfind(".db"), ".arch");
+    FILE* fp = fopen(arcname.c_str(), "rb");
+    if (fp && sqlite3_db_filename(sqlite::private_accessor::get_handle(con), "arch")) {
+      sqlite::execute(con, "ATTACH DATABASE " + quoted(arcname) + " AS ckpt;", true);
+      sqlite::execute(con, "DELETE FROM arch.Moments;", true);
+      sqlite::execute(con, "DELETE FROM arch.MomentsRollup;", true);
+      sqlite::execute(con, "INSERT INTO arch.Moments SELECT * FROM ckpt.Moments" + where, true);
+      if (newer) {
+        sqlite::execute(con, "INSERT INTO arch.MomentsRollup SELECT * FROM ckpt.MomentsRollup" + where, true);
+      }
+      else {
+        sqlite::execute(con, "INSERT INTO arch.MomentsRollup SELECT * FROM ckpt.MomentsRollup;", true);
+        MomentsStore::restore(con, "ckpt");
+      }
+      sqlite::execute(con, "DETACH DATABASE ckpt;", true);
+    }
+    if (fp) fclose(fp);
+  }
+  catch (std::exception const&) {
+    return 1;
+  }
+  return newer ? 1 : 0;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+CheckpointWriter::CheckpointWriter(std::string const& fname, sqlite::connection* con)
+  : fname_(fname), con_(con)
+{}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+CheckpointWriter::~CheckpointWriter()
+{
+  wait();
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int CheckpointWriter::wait()
+{
+  return pending_.valid() ? pending_.get() : 0;
+}
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+int CheckpointWriter::save(TrackCheckpoint&& cp)
+{
+  int status = wait();
+
+  std::string dbname  = fname_ + ".db";
+  std::string arcname = fname_ + ".arch.db";
+  bool withdb = con_ && (TrackCheckpoint::saveMoments(*con_, dbname + ".tmp") == 0);
+
+  pending_ = std::async(std::launch::async,
+                        [fname = fname_, dbname, arcname, withdb, cp = std::move(cp)]() {
+                          if (withdb && replaceFile(dbname + ".tmp", dbname)) return 1;
+                          FILE* fp = fopen((arcname + ".tmp").c_str(), "rb");
+                          if (fp) {
+                            fclose(fp);
+                            if (replaceFile(arcname + ".tmp", arcname)) return 1;
+                          }
+                          return TrackCheckpoint::write(fname, cp);
+                        });
+  return status;
+}
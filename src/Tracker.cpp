@@ -85,126 +85,47 @@ int Tracker::trackParticleExact( Element const& element, double ms, double Enr0,
 
 void OptimMainWindow::chroma4D(double& chroma1, double& chroma2 )
 {
-  // compute first order chromaticities for mode 1 and mode 2
+  // compute first order chromaticities for mode 1 and mode 2.
+  // The off-momentum optics is evaluated in memory on the beamline analyzed on the design orbit  
 
    int     nsteps = 1;
    double dppstep = 0.0001;
-   double nu1v[3];
-   double nu2v[3];
 
-   using std::setw;
-  
    bool CompAtExcitedOrb  = CtSt_.CompAtExcitedOrb;
    bool IsRingCh          = CtSt_.IsRingCh ;
 
-   CtSt_.CompAtExcitedOrb = true;
+   CtSt_.CompAtExcitedOrb = false;
    CtSt_.IsRingCh         = true;
 
-   if(interrupted_){ interrupted_=false; return;} 
-   int status = analyze(!analyzed_);
-   if (status) {
-     // restore state
-     CtSt_.CompAtExcitedOrb = CompAtExcitedOrb;
+   auto restore_state = [this, CompAtExcitedOrb, IsRingCh]() {
+     CtSt_.CompAtExcitedOrb = CompAtExcitedOrb; // restore orginal setting
      CtSt_.IsRingCh         = IsRingCh;
+     if (CompAtExcitedOrb) analyze(false);      // rebuild the beamline on the excited orbit  
+   };
+
+   if(interrupted_){ interrupted_=false; restore_state(); return;} 
+   if (analyze(!analyzed_ || CompAtExcitedOrb)) {
+     restore_state();
      return;
    }  
    auto restore = [](int* p){ QGuiApplication::restoreOverrideCursor(); delete p;};
    std::unique_ptr<int,decltype(restore)> cursor_guard(new int, restore); 
 
    QGuiApplication::setOverrideCursor(Qt::WaitCursor);
-   
-   int ir;
-   char err[256];
-   Twiss4D v;
-   RMatrix tm;
-   std::complex<double> lambda[4], ev[4][4];
-   double dpp0 = 0.0;
-
-   Coordinates v_anlz_tmp = v_anlz;
-   bool Closure4D   = NstTool.Closure4D;
-   
-   // calculate transfer matrix and tunes
-
-   try {
-     findRMatrix(tm);
-     if ( (ir = RMatrix_t<4,double>(tm).findEigenValues(lambda, ev)) !=0 ) {
-       OptimMessageBox::warning(this, "4D View", "Cannot close lattice.", QMessageBox::Ok);
-       throw OptimRuntimeException( "Cannot close lattice." );
-     }
-     else{
-       v.betatronFromEV(ev);
-       getDisp4D(tm, v, err);
-     }
-
-     double nu1 = -std::arg(lambda[0])/(2*PI); 
-     double nu2 = -std::arg(lambda[2])/(2*PI); 
-
-     while (nu1 < 0.0) ++nu1;
-     while (nu2 < 0.0) ++nu2;
-
-     double nu10 = nu1;
-     double nu20 = nu2;
-     dpp0 = v_anlz[5];
-
-   // ....................................................................................
-
-     
-   Closure4D   = NstTool.Closure4D;
-   for (int i=-nsteps; i<=nsteps; ++i) {
-     CtSt_.CompAtExcitedOrb = true;
 
-     if(getTrajParamFromFile(false, false, v_anlz)) return; // to get dpp
-     v_anlz[5] = dpp0 + 0.0001*i; // dpp step size 
+   double dpp0 = v_anlz[5];
 
-     NstTool.Closure4D = false;
-     getTrajParamFromFile(false, true, v_anlz); // update the parameter block (Reprint==false, Update==true )
-     NstTool.Closure4D =  Closure4D;
-
-     if(analyze(true)) throw OptimRuntimeException( "Cannot parse lattice." ); // Reprint == false
-
-     findRMatrix(tm);
-     if ( (ir = RMatrix_t<4,double>(tm).findEigenValues(lambda, ev)) !=0 ) {
-       OptimMessageBox::warning(this, "4D View", "Cannot close lattice.", QMessageBox::Ok);
-       throw OptimRuntimeException( "Cannot close lattice." );
-     }
-     else{
-       v.betatronFromEV(ev);
-       getDisp4D(tm, v, err);
-     }
-
-     nu1 = -std::arg(lambda[0])/(2*PI);
-     nu2 = -std::arg(lambda[2])/(2*PI);
-
-     while (nu1 <0.0) ++nu1;
-     while (nu2 <0.0) ++nu2;
+   std::vector<double> dppv(2*nsteps+1);
+   std::vector<double> nu1v;
+   std::vector<double> nu2v;
 
-     nu1v[i+nsteps] = nu1; // array index  0 <= i <= 2*nsteps   
-     nu2v[i+nsteps] = nu2; 
-    }
-   } // try;
-   
-   // restore initial state
+   for (int i=-nsteps; i<=nsteps; ++i) dppv[i+nsteps] = dpp0 + dppstep*i;  
 
-   catch(std::exception const& e) {
-     CtSt_.CompAtExcitedOrb = CompAtExcitedOrb; // restore orginal setting
-     CtSt_.IsRingCh         = IsRingCh;
-     v_anlz =  v_anlz_tmp;
-     NstTool.Closure4D = false;
-     getTrajParamFromFile(false, true, v_anlz); // update the parameter block (Reprint==false, Update==true )
-     NstTool.Closure4D = Closure4D;
+   if (offMomentumTunes(dppv, nu1v, nu2v)) {
+     OptimMessageBox::warning(this, "4D View", "Cannot close lattice.", QMessageBox::Ok);
+     restore_state();
      return;
    }
-   // attempt to identify modes
-
-   bool swapon = false;
-   for ( int i=1; i<3; ++i) {  
-     double d1  =  fabs(nu1v[i]-nu1v[i-1]); 
-     double d2  =  fabs(nu2v[i]-nu2v[i-1]); 
-     double d1s =  fabs(nu2v[i]-nu1v[i-1]); 
-     double d2s =  fabs(nu1v[i]-nu2v[i-1]); 
-     swapon = (( d1 > d1s) && (d2 >d2s));
-     if (swapon) { std::swap(nu1v[i], nu2v[i]); } 
-   }  
 
    // centered difference
    chroma1 = (nu1v[nsteps+1]-nu1v[nsteps-1])/(2*dppstep);
@@ -213,12 +134,7 @@ void OptimMainWindow::chroma4D(double& chroma1, double& chroma2 )
    // chromap1 = (nu1[nsteps+1]-2*nu1[nsteps]+nu1[nsteps-1])/(dppstep*dppstep);
    // chromap2 = (nu2[nsteps+1]-2*nu2[nsteps]+nu2[nsteps-1])/(dppstep*dppstep);
    
-   CtSt_.CompAtExcitedOrb = CompAtExcitedOrb; // restore orginal setting
-   CtSt_.IsRingCh         = IsRingCh;
-   v_anlz =  v_anlz_tmp;
-   NstTool.Closure4D = false;
-   getTrajParamFromFile(false, true, v_anlz); // update the parameter block (Reprint==false, Update==true )
-   NstTool.Closure4D = Closure4D;
+   restore_state();
    return;
 }
 
@@ -259,117 +175,32 @@ void OptimMainWindow::cmdChroma4D()
    bool CompAtExcitedOrb  = CtSt_.CompAtExcitedOrb;
    bool IsRingCh          = CtSt_.IsRingCh ;
 
-   CtSt_.CompAtExcitedOrb = true;
-   CtSt_.IsRingCh         = dialog->data_.isring;
+   // the off-momentum optics is evaluated in memory on the beamline analyzed on the design orbit  
 
-   if(interrupted_){ interrupted_=false; return;} 
-   if(analyze(!analyzed_)) return;
-
-   int ir;
-   char err[256];
-   Twiss4D v;
-   RMatrix tm;
-   std::complex<double> lambda[4], ev[4][4];
-   double dpp0 = 0.0;
-
-   Coordinates v_anlz_tmp = v_anlz;
-   bool Closure4D   = NstTool.Closure4D;
-   
-   // calculate transfer matrix and tunes
-
-   try {
-     findRMatrix(tm);
-     if ( (ir = RMatrix_t<4,double>(tm).findEigenValues( lambda, ev)) !=0 ) {
-       OptimMessageBox::warning(this, "4D View", "Cannot close lattice.", QMessageBox::Ok);
-       throw OptimRuntimeException( "Cannot close lattice." );
-     }
-     else{
-       v.betatronFromEV(ev);
-       getDisp4D(tm, v, err);
-     }
-
-     double nu1 = -std::arg(lambda[0])/(2*PI); 
-     double nu2 = -std::arg(lambda[2])/(2*PI); 
-
-     while (nu1 < 0.0) ++nu1;
-     while (nu2 < 0.0) ++nu2;
-
-     double nu10 = nu1;
-     double nu20 = nu2;
-     dpp0 = v_anlz[5];
-
-     //std::cout << "#  dpp  nu1  nu2  nu1-nu10 nu2-nu20" << std::endl; 
-
-     // ....................................................................................
-
-     QGuiApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-
-     bool CompAtExcitedOrbSaved = CtSt_.CompAtExcitedOrb;
-     
-     for (int i=-nsteps; i<=nsteps; ++i) {
-       
-       CtSt_.CompAtExcitedOrb = true;
+   CtSt_.CompAtExcitedOrb = false;
+   CtSt_.IsRingCh         = dialog->data_.isring;
 
-       if(getTrajParamFromFile(false, false, v_anlz)) return; // to get dpp
-       v_anlz[5] = dpp0 + dppstep*i; // dpp step size 
+   auto restore_state = [this, CompAtExcitedOrb, IsRingCh]() {
+     CtSt_.CompAtExcitedOrb = CompAtExcitedOrb; // restore orginal setting
+     CtSt_.IsRingCh         = IsRingCh;
+     if (CompAtExcitedOrb) analyze(false);      // rebuild the beamline on the excited orbit  
+   };
 
-       dppv.push_back(v_anlz[5]);
-     
-       Closure4D   = NstTool.Closure4D;
-       NstTool.Closure4D = false;
-       getTrajParamFromFile(false, true, v_anlz); // update the parameter block (Reprint==false, Update==true )
-       NstTool.Closure4D =  Closure4D;
+   if(interrupted_){ interrupted_=false; restore_state(); return;} 
+   if(analyze(!analyzed_ || CompAtExcitedOrb)) { restore_state(); return; }
 
-       if(analyze(true)) {//  argument Reprint == true
-         QGuiApplication::restoreOverrideCursor();
-          throw OptimRuntimeException( "Parser error." );
-       }
-     
-       findRMatrix(tm);
-       if ( (ir = RMatrix_t<4,double>(tm).findEigenValues(lambda, ev)) !=0 ) {
-         OptimMessageBox::warning(this, "4D View", "Cannot close lattice.", QMessageBox::Ok);
-         throw OptimRuntimeException( "Cannot close lattice." );
-       }
-       else{
-         v.betatronFromEV(ev);
-         //getDisp4D(tm, v, err); // NOT NEEDED ?? 
-       }
+   double dpp0 = v_anlz[5];
 
-       nu1 = -std::arg(lambda[0])/(2*PI);
-       nu2 = -std::arg(lambda[2])/(2*PI);
+   for (int i=-nsteps; i<=nsteps; ++i) dppv.push_back(dpp0 + dppstep*i);
 
-       while (nu1 <0.0) ++nu1;
-       while (nu2 <0.0) ++nu2;
-  
-       nu1v.push_back(nu1);
-       nu2v.push_back(nu2);
+   QGuiApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
 
-       }
-     } // try;
-
-     catch(std::exception const& e) {
-       // restore initial state
-       CtSt_.CompAtExcitedOrb = CompAtExcitedOrb; // restore orginal setting
-       CtSt_.IsRingCh         = IsRingCh;
-       v_anlz =  v_anlz_tmp;
-       NstTool.Closure4D = false;
-       getTrajParamFromFile(false, true, v_anlz); // update the parameter block (Reprint==false, Update==true )
-       NstTool.Closure4D = Closure4D;
-       QGuiApplication::restoreOverrideCursor();
-       return;
-    }
-
-   // attempt to identify modes
-
-   bool swapon = false;
-   for ( int i=1; i< nu1v.size(); ++i) {  
-     double d1  =  fabs(nu1v[i]-nu1v[i-1]); 
-     double d2  =  fabs(nu2v[i]-nu2v[i-1]); 
-     double d1s =  fabs(nu2v[i]-nu1v[i-1]); 
-     double d2s =  fabs(nu1v[i]-nu2v[i-1]); 
-     swapon = (( d1 > d1s) && (d2 >d2s));
-     if (swapon) std::swap(nu1v[i], nu2v[i]); 
-   }  
+   if (offMomentumTunes(dppv, nu1v, nu2v)) {
+     QGuiApplication::restoreOverrideCursor();
+     OptimMessageBox::warning(this, "4D View", "Cannot close lattice.", QMessageBox::Ok);
+     restore_state();
+     return;
+   }
    
   PolynomialRegression<double> regression;
   std::vector<double> coeffs1(4); // 3rd order 
@@ -456,13 +287,7 @@ void OptimMainWindow::cmdChroma4D()
 
   }
   // normal return - restore initial state
-  CtSt_.CompAtExcitedOrb = CompAtExcitedOrb; // restore orginal setting
-  CtSt_.IsRingCh         = IsRingCh;
-  v_anlz =  v_anlz_tmp;
-
-  NstTool.Closure4D = false;
-  getTrajParamFromFile(false, true, v_anlz); // update the parameter block (Reprint==false, Update==true )
-  NstTool.Closure4D = Closure4D;
+  restore_state();
 
   plot->replot(); 
   plot->show();
@@ -52,7 +52,9 @@ TrackerParameters::TrackerParameters( TrackerParameters const& o)
     MatchCase(o.MatchCase),
     IncrementTurns(o.IncrementTurns),
     FastTracking(o.FastTracking),
-    PrintResults(o.PrintResults)
+    PrintResults(o.PrintResults),
+    CheckpointInterval(o.CheckpointInterval),
+    Resume(o.Resume)
   {
     strcpy(Filter, o.Filter);
   }
@@ -71,6 +73,8 @@ TrackerParameters::TrackerParameters( TrackerParameters const& o)
     IncrementTurns = rhs.IncrementTurns;
     FastTracking = rhs.FastTracking;
     PrintResults = rhs.PrintResults;
+    CheckpointInterval = rhs.CheckpointInterval;
+    Resume = rhs.Resume;
     strcpy(Filter, rhs.Filter);
 
     return *this;
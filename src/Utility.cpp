@@ -801,17 +801,19 @@ char* fileextn(char* name, char* extn)
 double gauss(unsigned int seed)
 {
 
-  typedef boost::mt19937 random_generator; 
-  static random_generator rng;
+  // draws from the shared engine. The distribution is local: it may not carry a cached 
+  // deviate from one call to the next, so that the engine state saved in a tracking 
+  // checkpoint is the whole state.
+
+  std::mt19937& rng = GlobalState::generator;
 
   if (seed != 0 ) {
     rng.seed(seed);
   }
   
-  static boost::normal_distribution<> nd(0.0, 1.0);
-  static boost::variate_generator<boost::mt19937&, boost::normal_distribution<> > var_nor(rng, nd);
+  boost::normal_distribution<> nd(0.0, 1.0);
 
-  return var_nor();
+  return nd(rng);
 }
 #endif
 
@@ -50,12 +50,12 @@
 #include <gsl/gsl_spline.h>
 
 #include <Vavilov.h>
+#include <RandomStream.h>
+#include <Globals.h>
 
 using Constants::PI;
 
-std::random_device                     Vavilov::dev_;            // random device to initialize seed
-std::mt19937                           Vavilov::rng_(dev_());      // rng_(dev());    
-std::uniform_real_distribution<double> Vavilov::dist_(0.0, 1.0); // distribution in range [0.0, 1.0]
+std::mt19937&                          Vavilov::rng_ = GlobalState::generator; // shared engine    
 
 static const double         me = Constants::ME_MEV*1.0e6; // electron rest mass [eV]
 static constexpr double  egma  = 0.5772156649015328606065120900824024310421;
@@ -149,7 +149,6 @@ Vavilov::Vavilov(Vavilov::Parameters const& parms)
   // initialize the spline interpolators; 
 
   spline_ = gsl_spline_alloc(gsl_interp_steffen, n_+1);
-  acc_    = gsl_interp_accel_alloc();
 
   xa_ = new double[n_+1];
   ya_ = new double[n_+1];
@@ -217,123 +216,30 @@ Vavilov::Vavilov(Vavilov::Parameters const& parms)
     
   
   invcdfspline_ = gsl_spline_alloc(gsl_interp_steffen, ninvcdf);
-  invcdfacc_    = gsl_interp_accel_alloc();
 
   std::cerr << "Initializing the invcdf spline interpolator..."<< std::endl;  
   gsl_spline_init(invcdfspline_, invcdfxa_, invcdfya_,  ninvcdf);
   std::cerr << "Done. [invcdf spline interpolator] " << std::endl;  
 
-#if 0
-  //....................................................... 
-  // reinterpolate at equal probability intervals
+  pmax_ = cdf(epsmax()); 
 
-  ninvcdf = 20000; 
-  int dn  = 5000;
-  
-  double* tmpxa = new double[ninvcdf];
-  double* tmpya = new double[ninvcdf];
-
-  gsl_spline*       tmpspline = gsl_spline_alloc(gsl_interp_steffen, ninvcdf);
-  gsl_interp_accel* tmpacc    = gsl_interp_accel_alloc(); 
+  //....................................................... 
+  // reinterpolate at equal probability intervals: the sampling path (invcdf) locates the 
+  // interval in O(1) rather than by bisection over the cdf samples. The last interval, where
+  // the inverse cdf is steep (the tail up to epsmax()), remains with the gsl spline. 
 
-  int nmin    = 0;
-  int nmax    = dn;
-  double pmin = 0.0;
-  double pmax = 0.7;
-  double dp   = (pmax-pmin)/(nmax-nmin);
+  int nq = 4*n_+1;
+  dq_    = pmax_/(nq-1);
 
-  double  p = 0;
-  
-  std::cout << " pmin = " << pmin << std::endl;
-  std::cout << " pmax = " << pmax << std::endl;
-  std::cout << " p = " << p << std::endl;
-  for (int i=nmin; i<nmax; ++i) {
-   p = pmin + i*dp;
-   tmpxa[i] = p;
-   tmpya[i] = invcdf(p);
+  std::vector<double> q(nq);
+  for (int i=0; i<nq-1; ++i) {
+    q[i] = gsl_spline_eval(invcdfspline_, i*dq_, nullptr);
   }
+  q[nq-1] = epsmax();
 
-  nmin    = dn;
-  nmax    = ninvcdf-dn;
-  pmin = 0.2;
-  pmax = 0.8;
-  dp   = (pmax-pmin)/(nmax-nmin);
-    
-  std::cout << " pmin = " << pmin << std::endl;
-  std::cout << " pmax = " << pmax << std::endl;
-  std::cout << " p = " << p << std::endl;
-  for (int i=nmin; i<nmax; ++i) {
-   p = pmin + (i-nmin)*dp;
-   tmpxa[i] = p;
-   tmpya[i] = invcdf(p);
-  }
+  qtbl_ = SplineInterpolator(0.0, dq_, &q[0], nq, SplineInterpolator::Monotone);
 
-  
-  nmin    = dn;
-  nmax    = ninvcdf;
-  pmin = 0.7;
-  pmax = invcdfxa_[n_];
-  dp   = (pmax-pmin)/(nmax-nmin);
-    
-  std::cout << " pmin = " << pmin << std::endl;
-  std::cout << " pmax = " << pmax << std::endl;
-  std::cout << " p = " << p << std::endl;
-  for (int i=nmin; i<nmax; ++i) {
-   p = pmin + (i-nmin)*dp;
-   tmpxa[i] = p;
-   tmpya[i] = invcdf(p);
   }
-  
-  std::cout << " p = " << p << std::endl;
-
-  tmpxa[ninvcdf-1] = invcdfxa_[n_];
-  tmpya[ninvcdf-1] = invcdfya_[n_];
-
-  gsl_spline_init( tmpspline, tmpxa, tmpya,  ninvcdf);
-
-
-  //std::swap(invcdfspline_, tmpspline);
-  //std::swap(invcdfacc_,    tmpacc);
-  //std::swap(invcdfxa_,     tmpxa);
-  //std::swap(invcdfya_,     tmpya);
-
-  gsl_spline_free(tmpspline);
-  gsl_interp_accel_free(tmpacc);
-
-#endif
-  
-  dist_ =  std::uniform_real_distribution<double>(0.0, cdf(epsmax())); 
-
-  }
-
-// ||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
-// ||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
-
-Vavilov::Vavilov(Vavilov const& o)
-  :
-  A_(o.A_),
-  bta_(o.bta_),
-  gma_(o.gma_),
-  Tmax_(o.Tmax_),
-  I0_(o.I0_),
-  dE_(o.dE_),
-  weps_(o.weps_),
-  delta_eps_(o.delta_eps_),
-  wx_(o.wx_),
-  delta_x_(o.delta_x_),
-  data_(o.data_),
-  n_(o.n_),
-  spline_(o.spline_),
-  invcdfspline_(o.invcdfspline_),
-  xa_(o.xa_),
-  ya_(o.ya_),
-  invcdfxa_(o.invcdfxa_),
-  invcdfya_(o.invcdfya_),
-  acc_(o.acc_),
-  invcdfacc_(o.invcdfacc_)
-{
-  std::cerr << "*************** Vavilov::Vavilov(Vavilov const& o)" << std::endl; 
-}
 
 // ||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 // ||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
@@ -344,10 +250,7 @@ Vavilov::~Vavilov()
   std::cerr << "Vavilov::~Vavilov() "<< std::endl;
 
   gsl_spline_free(spline_);
-  gsl_interp_accel_free(acc_);
-
   gsl_spline_free(invcdfspline_);
-  gsl_interp_accel_free(invcdfacc_);
 
   if (xa_) delete [] xa_; 
   if (ya_) delete [] ya_; 
@@ -423,18 +326,27 @@ void Vavilov::vavsamples() const
 
 double Vavilov::operator()() const
 {
-     double r = dist_(rng_);
+     std::uniform_real_distribution<double> dist(0.0, pmax_);
+     double r = dist(rng_);
      double val = invcdf( r );
      return val;
 }
 
+// ||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+// ||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+double Vavilov::operator()(RandomStream& rng) const
+{
+     return invcdf( pmax_*rng.uniform() );
+}
+
 // ||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 // ||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
  double Vavilov::pdf(double x) const
 {
   if ((x < 0.0) || (x > epsmax() )) return 0.0;
-  return gsl_spline_eval(spline_, x, acc_);
+  return gsl_spline_eval(spline_, x, nullptr);
 }
 
 // ||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
@@ -443,7 +355,7 @@ double Vavilov::operator()() const
 double Vavilov::cdf(double eps) const
 {
   double result = 0.0;
-  int istatus = gsl_spline_eval_integ_e(spline_, 0.0,  eps, acc_, &result); 
+  int istatus = gsl_spline_eval_integ_e(spline_, 0.0,  eps, nullptr, &result); 
   return result;  
 }
 
@@ -452,11 +364,12 @@ double Vavilov::cdf(double eps) const
 
 double Vavilov::invcdf(double p) const
 {
-  static double pmax =  cdf(epsmax()); 
-  if ( p <= 0.0 )  return 0.0;
-  if ( p >= pmax)  return epsmax();
+  if ( p <= 0.0 )   return 0.0;
+  if ( p >= pmax_)  return epsmax();
+
+  if ( p >= pmax_-dq_) return gsl_spline_eval(invcdfspline_, p, nullptr);
 
-  return gsl_spline_eval(invcdfspline_, p, invcdfacc_);
+  return qtbl_(p);
 }
 
 // ||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
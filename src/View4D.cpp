@@ -983,7 +983,7 @@ void OptimMainWindow::Phases4D (Twiss4D& v)
     int  ns = fabs(ep->length()/h)+1;
     if( nm=='A' || nm=='W' ||nm=='X'){ns=1;}
 
-    auto e = std::shared_ptr<Element>(ep->split(ns) );
+    SliceRef e(*ep, ns, slice_arena_);
 
     legodata.push_back( { L*0.01, ep->length()*0.01, (ep->G>=0.0 ? 1 : -1), ep->fullName()});
 
@@ -1101,7 +1101,7 @@ void OptimMainWindow::Sizes4D(Twiss4D& v)
     int  ns  = fabs(ep->length()/h) + 1;
     if( nm=='A' || nm=='W' ||nm=='X') {ns=1;}
 
-    auto e = std::shared_ptr<Element>( ep->split(ns) );
+    SliceRef e(*ep, ns, slice_arena_);
 
     legodata.push_back( { L*0.01, ep->length()*0.01, (e->G>=0.0 ? 1:-1), ep->fullName() });
 
@@ -1233,7 +1233,7 @@ void OptimMainWindow::Proj4D(Twiss4D& v)
     if( nm=='H') ++nscrapers;
     if( nm=='A' || nm=='W' ||nm=='X'){ns=1;}
  
-    auto e = std::shared_ptr<Element>( ep->split(ns) );
+    SliceRef e(*ep, ns, slice_arena_);
 
     // calculates Element's boxes located at the bottom of screan
 
@@ -1398,7 +1398,7 @@ void OptimMainWindow::Sizes4D(Twiss4D& v)
     int  ns  = fabs(ep->length()/h) + 1;
     if( nm=='A' || nm=='W' ||nm=='X'){ns=1;}
 
-    auto e = std::shared_ptr<Element>( ep->split(ns) );
+    SliceRef e(*ep, ns, slice_arena_);
 
     legodata.push_back( { L*0.01, ep->length()*0.01, (e->G>=0.0 ? 1:-1), ep->fullName() });
 
@@ -62,18 +62,18 @@ XferMatrix::XferMatrix(XferMatrix const& o)
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-void XferMatrix::toString(char* buf) const
+void XferMatrix::assign(Element const& o)
 {
- sprintf(buf,"Matrix, D_E[MeV]=%g  L[cm]=%g", G, L_);
+  Element::assign(o);
+  tmat_ = static_cast<XferMatrix const&>(o).tmat_;
 }
 
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
 
-XferMatrix* XferMatrix::split(int nslices) const // return a sliced element
+void XferMatrix::toString(char* buf) const
 {
-  // XferMatrix cannot be split so we return a cloned element. 
-  return this->clone();
+ sprintf(buf,"Matrix, D_E[MeV]=%g  L[cm]=%g", G, L_);
 }
 
 //||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
@@ -156,7 +156,7 @@ Twiss OptimMainWindow::betas(Twiss const& vstart)
     
     if( nm=='A' || nm=='W' || nm=='X') { ns=1; }
 
-    auto e = std::shared_ptr<Element>(ep->split(ns));
+    SliceRef e(*ep, ns, slice_arena_);
 
     // calculate Element's boxes located at the bottom of screen
    
@@ -0,0 +1,311 @@
+//  =================================================================
+//
+//  cmdCorrectOrbit.cpp
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+
+#include <platform.h>
+#include <ClosedOrbit.h>
+#include <Coordinates.h>
+#include <Element.h>
+#include <Globals.h>
+#include <OrbitCorrectionDialog.h>
+#include <OrbitResponse.h>
+#include <Utility.h>
+#include <fmt/format.h>
+#include <OptimEditor.h>
+#include <OptimMainWindow.h>
+#include <OptimMessages.h>
+#include <OptimTextEditor.h>
+#include <Structs.h>
+#include <QGuiApplication>
+
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using Utility::filterName;
+using Utility::getElmName;
+using Utility::strcmpr;
+
+unsigned int const LSTR = 1024;
+
+namespace {
+
+  // rms of the x (plane 0) or y (plane 1) rows of b + A dk   
+
+  double rms( OrbitResponse const& resp, std::vector<double> const& b, std::vector<double> const& dk, int plane) 
+  {
+    double sum = 0.0;
+    int    n   = 0;
+    for (int i=0; i<resp.rows(); ++i) {
+      if (resp.monitors()[i].plane != plane) continue;
+      double r = b[i];
+      for (int j=0; j<resp.columns(); ++j) r += resp(i,j)*dk[j];
+      sum += r*r;
+      ++n;
+    }
+    return n ? std::sqrt(sum/n) : 0.0;
+  }
+
+} // namespace
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void OptimMainWindow::cmdCorrectOrbit()
+{
+  //------------------------------------------------------------------------------------
+  // Orbit correction: the response of the selected monitors to the selected correctors 
+  // is computed from the element transfer matrices (see OrbitResponse.h) and the corrector 
+  // strengths minimizing the orbit at the monitors are obtained by truncated SVD, Tikhonov 
+  // regularization or MICADO. The orbit is the closed orbit (ring) or the trajectory 
+  // launched from the initial coordinates of the input file (transfer line).       
+  //------------------------------------------------------------------------------------
+
+  using fmt::format_to;
+
+  static OrbitCorrectionDialog* dialog = 0;
+  if (!dialog) dialog = new OrbitCorrectionDialog(0);
+
+  dialog->set();
+  if (dialog->exec() == QDialog::Rejected) return;  
+
+  auto const& d = dialog->data_;
+
+  if (!d.xplane && !d.yplane) return;
+
+  auto outbufraw = fmt::memory_buffer();
+  auto outbuf    = std::back_inserter(outbufraw);
+
+  auto restore = [](int* p){ QGuiApplication::restoreOverrideCursor(); delete p;};
+  std::unique_ptr<int,decltype(restore)> cursor_guard(new int, restore); 
+
+  QGuiApplication::setOverrideCursor(Qt::WaitCursor);
+
+  OptimTextEditor* editor = 0;
+  auto DigCh = getAttachedSubWin(WindowId::DigCh); 
+  if (!DigCh) {
+    DigCh = createAttachedSubWin( (editor = new OptimTextEditor()),WindowId::DigCh );
+    connect(editor, SIGNAL(copyAvailable(bool)), this, SLOT(updateEditMenuState(bool)) );
+    connect(editor, SIGNAL(undoAvailable(bool)), this, SLOT(updateEditMenuState(bool)) );
+    connect(editor, SIGNAL(redoAvailable(bool)), this, SLOT(updateEditMenuState(bool)) );
+  }
+  else { 
+    editor = qobject_cast<OptimTextEditor*>( DigCh->widget() );
+  }
+  DigCh->raise();
+
+  if(interrupted_ ) { interrupted_  =  false; return;}
+   
+  if(analyzed_) {
+    if ( analyze(false)) return;
+  } 
+  else { 
+    if(analyze(true)) return;
+  }
+
+  if (CtSt_.ClearText) editor->clear();
+
+  bool ring = CtSt_.IsRingCh;
+
+  std::vector<std::shared_ptr<Element>> line(nelm_);
+  for (int i=0; i<nelm_; ++i) {
+    line[i] = std::shared_ptr<Element>(beamline_[i]->clone());
+  }
+
+  Coordinates v0;
+  for (int i=0; i<6; ++i) v0[i] = 0.0;
+  if (!ring && getTrajParamFromFile(false, false, v0)) return;
+
+  // orbit at the exit of every element 
+
+  auto orbit = [&](std::vector<Coordinates>& record) {
+    Coordinates v = v0;
+    record.clear();
+    if (ring) { 
+      ClosedOrbit closure;
+      closure.maxIterations(Ncvg);
+      closure.tolerance(CvgErr);
+      if (closure(line, ms, Ein, tetaYo0_, v)) return 1;
+    }
+    return ClosedOrbit::track(line, ms, Ein, tetaYo0_, v, 0, 0, &record);
+  };
+
+  std::vector<Coordinates> record;
+  if (orbit(record)) { 
+    OptimMessageBox::warning(this, "Orbit Correction", (ring ? "Cannot find the closed orbit." : "The particle is lost."), QMessageBox::Ok);
+    return;
+  }
+
+  OrbitResponse resp;
+  auto monitor   = [&d](Element const& e) { return filterName(e.fullName(), d.monitors.c_str(),   d.MatchCase); };
+  auto corrector = [&d](Element const& e) { return filterName(e.fullName(), d.correctors.c_str(), d.MatchCase); };
+
+  if (resp.build(line, ms, Ein, tetaYo0_, ring, monitor, corrector, d.xplane, d.yplane)) {
+    OptimMessageBox::warning(this, "Orbit Correction", "Singular transfer matrix.", QMessageBox::Ok);
+    return;
+  }
+
+  if (resp.rows() == 0 || resp.columns() == 0) {
+    OptimMessageBox::warning(this, "Orbit Correction", "No monitor (Instrument) or corrector (TCorrector, LCorrector) selected.", QMessageBox::Ok);
+    return;
+  }
+
+  auto method = OrbitResponse::Method(d.method);
+  double param = (method == OrbitResponse::SVD)      ? d.cutoff :
+                 (method == OrbitResponse::Tikhonov) ? d.lambda : double(d.ncorrectors);
+
+  std::vector<double> b = resp.readings(record);
+  std::vector<double> dk;
+  int nused = resp.solve(b, method, param, dk);
+
+  // corrected line: the achieved orbit includes the nonlinear and energy-dependent parts    
+
+  auto const& knobs = resp.knobs();
+  std::vector<double> kold(knobs.size());
+
+  for (unsigned j=0; j<knobs.size(); ++j) {
+    auto& e = *line[knobs[j].elms[0]];
+    kold[j] = (knobs[j].type == 'K') ? e.B : e.G; 
+    for (int i: knobs[j].elms) { 
+      if (knobs[j].type == 'K') line[i]->B = kold[j] + dk[j];
+      else                      line[i]->G = kold[j] + dk[j];
+    }
+  }
+
+  std::vector<Coordinates> corrected;
+  bool lost = orbit(corrected);
+
+  std::vector<double> zero(knobs.size(), 0.0);
+  std::vector<double> b1 = lost ? b : resp.readings(corrected);
+
+  static char const* const names[] = { "SVD", "Tikhonov", "MICADO" };
+
+  format_to(outbuf, "Orbit correction ({:s}, {:s}): {:d} monitor readings, {:d} correctors\n\n", 
+            names[method], (ring ? "closed orbit" : "trajectory"), resp.rows(), resp.columns());
+  format_to(outbuf, "{:>6s} {:>12s} {:>6s} {:>14s} {:>14s} {:>14s}\n", "N", "Name", "Type", "Old", "Delta", "New");
+  for (unsigned j=0; j<knobs.size(); ++j) {
+    if (dk[j] == 0.0) continue;
+    format_to(outbuf, "{:6d} {:>12s} {:>6s} {:14.6g} {:14.6g} {:14.6g}\n", knobs[j].elms[0]+1, knobs[j].name, 
+              (knobs[j].type == 'K' ? "B[kG]" : "G[MeV]"), kold[j], dk[j], kold[j]+dk[j]);
+  }
+
+  if (method == OrbitResponse::Micado) {
+    format_to(outbuf, "\n{:d} correctors used\n", nused);
+  }
+  else { 
+    auto const& s = resp.singularValues();
+    format_to(outbuf, "\n{:d} of {:d} singular values used, s_max = {:g}, s_min = {:g}", nused, int(s.size()), s.front(), s.back());
+    if (nused > 0) format_to(outbuf, ", s_last = {:g}", s[nused-1]);
+    format_to(outbuf, "\n");
+  }
+
+  format_to(outbuf, "\n{:>10s} {:>14s} {:>14s} {:>14s}\n", "rms [cm]", "Before", "Predicted", "Achieved");
+  for (int p=0; p<2; ++p) {
+    if (!(p ? d.yplane : d.xplane)) continue;
+    format_to(outbuf, "{:>10s} {:14.6g} {:14.6g} ", (p ? "Y" : "X"), rms(resp, b, zero, p), rms(resp, b, dk, p));
+    if (lost) format_to(outbuf, "{:>14s}\n", "lost");
+    else      format_to(outbuf, "{:14.6g}\n", rms(resp, b1, zero, p));
+  }
+
+  // write the corrected strengths to the lattice 
+
+  OptimEditor* latt = LatticeCh_ ? qobject_cast<OptimEditor*>(LatticeCh_->widget()) : 0;     
+
+  if (d.apply && !lost && latt) {
+
+    auto knob = [&knobs](char const* name) { 
+      for (unsigned j=0; j<knobs.size(); ++j) { 
+        if (strcmp(name, knobs[j].name.c_str()) == 0) return int(j); 
+      }
+      return -1;
+    };
+
+    for (int i=0; i<nelmlist_; ++i) {
+      int j = knob(elmdict_[i]->name());
+      if (j < 0) continue;
+      if (knobs[j].type == 'K') elmdict_[i]->B = kold[j] + dk[j];
+      else                      elmdict_[i]->G = kold[j] + dk[j];
+    }
+
+    for (int i=0; i<nelm_; ++i) {
+      int j = knob(beamline_[i]->name());
+      if (j < 0) continue;
+      if (knobs[j].type == 'K') beamline_[i]->B = kold[j] + dk[j];
+      else                      beamline_[i]->G = kold[j] + dk[j];
+    }
+
+    // element list lines, as in RewriteElementListFit  
+
+    char buf[LSTR];
+    char el_name[LSTR];
+    char buf2[NAME_LENGTH];
+
+    int nline = LineLIn-1;
+    do nline = getLineCmt(latt, buf, LSTR, nline); 
+    while(!strcmpr("begin list",buf));
+
+    while(true) {
+      nline = getLineCmt(latt, buf, LSTR, nline);
+      if(nline > LineLFin+1) break;
+
+      char* bufpt = &buf[0];
+      getElmName(ElemNameFCh, &bufpt, el_name, buf2);
+
+      if (knob(el_name) >= 0) {
+        for (int i=0; i<nelmlist_; ++i) {
+          if (strcmp(el_name, elmdict_[i]->name()) != 0) continue;
+          print_elm(elmdict_[i].get(), buf);
+          replaceLine(latt, nline-1, buf);
+          break;
+        }
+      }
+
+      if( toupper(el_name[0])=='X')
+      for(int j=0; j<6; ++j) nline = getLineCmt(latt, buf, LSTR, nline);
+    }
+
+    format_to(outbuf, "\nCorrector strengths written to the lattice.\n");
+  }
+
+  format_to(outbuf,"{:c}",0);
+  editor->insertPlainText(outbufraw.data());
+  editor->document()->setModified(false);
+  editor->show();
+}
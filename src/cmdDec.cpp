@@ -120,6 +120,7 @@ void OptimMainWindow::DecInc(int ddt)
   unsigned int ir = 0;
   unsigned int jr = 0;
   char et = 0;
+  bool calcheader = true;
   
   static QRegularExpression rx("[^\\s]+\\s*=\\s*[0-9,\\.,Ee-]+");  
       
@@ -155,11 +156,32 @@ void OptimMainWindow::DecInc(int ddt)
     if(*b == 0) return;
     ++b;
 
+    // a variable set to a number: only the statements which depend on it need to be
+    // re-evaluated (see SCalc::assign())
+
+    char  var[LSTR+1];
+    char* p = buf;
+    char* q = var;
+    char* endp;
+
+    while (isspace(*p)) ++p;
+    while (isalnum(*p) || (*p=='$') || (*p=='_') || (*p==':')) *q++ = *p++;
+    *q = 0;
+    while (isspace(*p)) ++p;
+    strtod(b, &endp);
+    while (isspace(*endp)) ++endp;
+    bool setvar = (var[0]=='$') && (p == b-1) && (endp != b) && ( !*endp || (*endp==';') || (*endp=='#') );
+
     bufpt = strchr(buf, '>');
     bufpt ?  (++bufpt) : (bufpt = b); 
     double V = atof(bufpt)+ddt*dV_;
     sprintf(b,"%-12.9lg",V);
 
+    if (setvar) {
+      char err[LSTR+1];
+      if (calc_.assign(var, atof(b), err) == 0) calcheader = false; // otherwise, the lines are re-evaluated 
+    }
+
     replaceLine(editor, nline, buf);
     cursor = editor->textCursor();
     // preserve the selection 
@@ -315,7 +337,7 @@ void OptimMainWindow::DecInc(int ddt)
     editor->setTextCursor(cursor); 
       
 dicont:
-     bool status = analyze(false);
+     bool status = analyze(false, 1, calcheader);
      if (status) return;    
  
     // Analyze exit conditions
@@ -143,7 +143,7 @@ void OptimMainWindow::Dispersion4D (Twiss4D& v)
     int  ns  = fabs(ep->length()/h)+1;
     if( nm=='A' || nm=='W' ||nm=='X'){ns=1;}
 
-    auto e = std::shared_ptr<Element>(ep->split(ns) );
+    SliceRef e(*ep, ns, slice_arena_);
 
     legodata.push_back( { L*0.01, ep->length()*0.01, (ep->G>=0.0 ? 1 : -1), ep->fullName() });
 
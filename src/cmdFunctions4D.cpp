@@ -467,7 +467,7 @@ int OptimMainWindow::ViewFunctions4D (char* filenm, FunctionDlgStruct* NStf)
 
        if( nm=='A' || nm=='W' ||nm=='X') {ns = 1;}
 
-       auto e = std::shared_ptr<Element>( ep->split(ns));
+       SliceRef e(*ep, ns, slice_arena_);
 
        double dalpha = 0.0;
        
@@ -0,0 +1,325 @@
+//  =================================================================
+//
+//  cmdResonances.cpp
+//
+//  This file is part of OptiMX, an interactive tool  
+//  for beam optics design and analysis. 
+//
+//  Copyright (c) 2025 Fermi Forward Discovery Group, LLC.
+//  This material was produced under U.S. Government contract
+//  89243024CSC000002 for Fermi National Accelerator Laboratory (Fermilab),
+//  which is operated by Fermi Forward Discovery Group, LLC for the
+//  U.S. Department of Energy. The U.S. Government has rights to use,
+//  reproduce, and distribute this software.
+//
+//  NEITHER THE GOVERNMENT NOR FERMI FORWARD DISCOVERY GROUP, LLC
+//  MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+//  LIABILITY FOR THE USE OF THIS SOFTWARE.
+//
+//  If software is modified to produce derivative works, such modified
+//  software should be clearly marked, so as not to confuse it with the
+//  version available from Fermilab.
+//
+//  Additionally, this program is free software; you can redistribute
+//  it and/or modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version. Accordingly,
+//  this program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//  See the GNU General Public License for more details.
+//
+//  https://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+//  https://www.gnu.org/licenses/gpl-3.0.html
+//
+//  =================================================================
+//
+
+
+#include <platform.h>
+#include <Constants.h>
+#include <Element.h>
+#include <Globals.h>
+#include <RMatrix.h>
+#include <ResonanceTerms.h>
+#include <Twiss.h>
+#include <fmt/format.h>
+#include <OptimMainWindow.h>
+#include <OptimMessages.h>
+#include <OptimPlot.h>
+#include <OptimTextEditor.h>
+#include <QGuiApplication>
+
+#include <cmath>
+#include <complex>
+#include <memory>
+#include <string>
+#include <vector>
+
+using Constants::PI;
+using Constants::C_DERV1;
+
+namespace {
+
+  typedef ResonanceTerms::Term Term;
+
+  // geometric (sextupole) terms, in the order of the table and plot columns   
+
+  Term const geometric[] = { {{2,1,0,0,0}}, {{3,0,0,0,0}}, {{1,0,1,1,0}}, {{1,0,0,2,0}}, {{1,0,2,0,0}} };
+
+  // terms listed in the summary 
+
+  Term const summary[] = { 
+    {{2,1,0,0,0}}, {{3,0,0,0,0}}, {{1,0,1,1,0}}, {{1,0,0,2,0}}, {{1,0,2,0,0}},  // sextupole, first order 
+    {{1,0,0,1,0}}, {{1,0,1,0,0}},                                                // coupling (skew quadrupoles)  
+    {{1,1,0,0,1}}, {{0,0,1,1,1}}, {{2,0,0,0,1}}, {{0,0,2,0,1}}, {{1,0,0,0,2}},   // chromatic 
+    {{2,2,0,0,0}}, {{1,1,1,1,0}}, {{0,0,2,2,0}},                                 // detuning 
+    {{3,1,0,0,0}}, {{4,0,0,0,0}}, {{2,0,1,1,0}}, {{1,1,2,0,0}},                  // octupole-like, second order  
+    {{2,0,0,2,0}}, {{2,0,2,0,0}}, {{0,0,3,1,0}}, {{0,0,4,0,0}}
+  };
+
+  std::string label( Term const& t) 
+  { 
+    return fmt::format("h{:d}{:d}{:d}{:d}{:d}", t[0], t[1], t[2], t[3], t[4]); 
+  }
+
+  bool contributes( Element const& e)
+  {
+    switch (e.etype()) {
+      case 'S': return e.S != 0.0;
+      case 'Q': return e.G != 0.0;
+      case 'B':
+      case 'D': return (e.B != 0.0) || (e.G != 0.0);
+      case 'M': return (e.N >= 0) && (e.S != 0.0);
+      default:  return false;
+    }
+  }
+
+  ResonanceTerms::Kick kick( Element const& e, double dL, double Hrt, double s, Twiss const& v)
+  {
+    // lattice units [cm, kG] are converted to m 
+
+    ResonanceTerms::Kick k = { s*0.01, v.BtX*0.01, v.BtY*0.01, v.nuX, v.nuY, v.DsX*0.01, v.DsY*0.01, 
+                               1, 0.0, e.tilt()*PI/180.0, 0.0, true };
+    switch (e.etype()) {
+      case 'S':
+        k.n      = 2;
+        k.knl    = e.S*dL/Hrt*1.0e4;
+        k.linear = false;
+        break;
+      case 'Q':
+        k.knl    = e.G*dL/Hrt*1.0e2;
+        break;
+      case 'B':
+      case 'D':
+        k.knl    = e.G*dL/Hrt*1.0e2;
+        k.angle  = e.B*dL/Hrt;
+        break;
+      case 'M':                           // S = Bm*L [kG/cm**(m-1)]  
+        if (e.N == 0) { k.angle = e.S/Hrt; break; }  
+        k.n      = e.N;
+        k.knl    = e.S/Hrt*std::pow(1.0e2, e.N);
+        k.linear = (e.N == 1);
+        break;
+    }
+    return k;
+  }
+
+} // namespace
+
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+//||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||
+
+void OptimMainWindow::cmdResonances()
+{
+  //------------------------------------------------------------------------------------
+  // Resonance driving terms, detuning with amplitude and chromaticities to second order,
+  // computed from the uncoupled lattice functions at the sextupoles, multipoles and 
+  // (chromatic part of the) quadrupoles and bend gradients. Each thick element is 
+  // represented by thin kicks at the center of its slices. See ResonanceTerms.h. 
+  //------------------------------------------------------------------------------------
+
+  using fmt::format_to;
+
+  auto outbufraw = fmt::memory_buffer();
+  auto outbuf    = std::back_inserter(outbufraw);
+
+  auto restore = [](int* p){ QGuiApplication::restoreOverrideCursor(); delete p;};
+  std::unique_ptr<int,decltype(restore)> cursor_guard(new int, restore); 
+
+  QGuiApplication::setOverrideCursor(Qt::WaitCursor);
+
+  OptimTextEditor* editor = 0;
+  auto DigCh = getAttachedSubWin(WindowId::DigCh); 
+  if (!DigCh) {
+    DigCh = createAttachedSubWin( (editor = new OptimTextEditor()),WindowId::DigCh );
+    connect(editor, SIGNAL(copyAvailable(bool)), this, SLOT(updateEditMenuState(bool)) );
+    connect(editor, SIGNAL(undoAvailable(bool)), this, SLOT(updateEditMenuState(bool)) );
+    connect(editor, SIGNAL(redoAvailable(bool)), this, SLOT(updateEditMenuState(bool)) );
+  }
+  else { 
+    editor = qobject_cast<OptimTextEditor*>( DigCh->widget() );
+  }
+  DigCh->raise();
+
+  if(interrupted_ ) { interrupted_  =  false; return;}
+   
+  if(analyzed_) {
+    if ( analyze(false)) return;
+  } 
+  else { 
+    if(analyze(true)) return;
+  }
+
+  if (CtSt_.ClearText) editor->clear();
+
+  Twiss   v;
+  RMatrix tm;
+
+  if( CtSt_.IsRingCh ) {
+    findRMatrix(tm);
+    double alfa = 0.0; 
+    if ( find_tunes(tm, Length_, v, &alfa) != 0 ) { 
+      OptimMessageBox::warning(this, "Close Error", "Cannot close for X or Y", QMessageBox::Ok);
+      return;
+    }
+    v.nuY = v.nuX = 0.0;
+  }
+  else {
+    setInitialBetas(v);
+  }
+
+  std::complex<double> ev[4][4];
+  v.eigenvectors(ev);
+
+  // walk the lattice; the kicks are collected first since a ring with NmbPer > 1 
+  // periods needs them NmbPer times. 
+
+  std::vector<ResonanceTerms::Kick> kicks;
+  std::vector<int>                  owner;   // element index of each kick 
+
+  double tetaY = tetaYo0_;
+  double Enr   = Ein;
+  double Hrt   = Hr; 
+  double Lp    = 0.0;
+  double L     = 0.0;
+
+  std::vector<LegoData> legodata;
+
+  for (int i=0; i<nelm_; ++i) {
+    auto ep = beamline_[i];
+    char nm = ep->etype();
+
+    legodata.push_back( { L*0.01, ep->length()*0.01, ((ep->G >=0.0) ? 1 :-1), ep->fullName() });
+    L += ep->length();
+
+    bool thin = (ep->length() == 0.0);
+    bool src  = contributes(*ep);
+    int  ns   = (src && !thin) ? 2*(int(fabs(ep->length()/stepint))+1) : 1;  // kicks at the odd slice boundaries  
+
+    SliceRef e(*ep, ns, slice_arena_);
+
+    double dalfa = 0.0;
+    for (int j=0; j<ns; ++j) {
+      switch(nm) {
+	case 'B':  
+        case 'D':
+	  tm     = e->rmatrix( dalfa, Enr, ms, tetaY, dalfa, e->checkEdge(j,ns) );
+          dalfa -= e->tilt(); 
+	  break;
+	default:
+	  tm = e->rmatrix( Enr, ms, tetaY, 0.0, e->checkEdge(j,ns) );
+      }
+      e->propagateLatticeFunctions(tm, v, ev);
+      Lp += e->length();
+
+      if (src && (thin || (j%2 == 0))) {
+        kicks.push_back( kick(*ep, 2.0*e->length(), Hrt, Lp, v) );
+        owner.push_back(i);
+      }
+      Hrt = sqrt(2.*ms*Enr+Enr*Enr)/C_DERV1;
+    }
+  }
+  legodata.push_back( { L*0.01,  0,  0,   std::string("END") } ); 
+
+  double Qx = v.nuX;
+  double Qy = v.nuY;
+  int    np = CtSt_.IsRingCh ? NmbPer : 1;
+
+  // table: cumulative terms at the end of each contributing element (first period) 
+
+  ResonanceTerms rt;
+
+  format_to(outbuf, "Resonance driving terms (cumulative, first + second order). Units: m \n\n");
+  format_to(outbuf, "{:>6s} {:>12s} {:>10s} {:>10s} {:>10s} {:>10s}", "N", "Name", "S[m]", "BetaX", "BetaY", "DspX");
+  for (auto const& t: geometric) format_to(outbuf, " {:>10s}", label(t));
+  format_to(outbuf, " {:>10s} {:>10s}\n", "h11001", "h00111");
+
+  std::vector<double> x;
+  std::vector<std::vector<double>> y(sizeof(geometric)/sizeof(geometric[0]));
+
+  x.push_back(0.0);
+  for (auto& c: y) c.push_back(0.0);
+
+  for (unsigned k=0; k<kicks.size(); ++k) {
+    rt.add(kicks[k]);
+    if (k+1 < kicks.size() && owner[k+1] == owner[k]) continue; 
+    auto const& kk = kicks[k];
+    format_to(outbuf, "{:6d} {:>12s} {:10.3f} {:10.4g} {:10.4g} {:10.4g}", owner[k]+1, beamline_[owner[k]]->name(), kk.s, kk.btx, kk.bty, kk.dx);
+    for (auto const& t: geometric) format_to(outbuf, " {:10.4g}", std::abs(rt.h(t)));
+    format_to(outbuf, " {:10.4g} {:10.4g}\n", std::abs(rt.h({{1,1,0,0,1}})), std::abs(rt.h({{0,0,1,1,1}})));
+    x.push_back(kk.s);
+    for (unsigned c=0; c<y.size(); ++c) y[c].push_back(std::abs(rt.h(geometric[c])));
+  }
+  x.push_back(Lp*0.01);
+  for (auto& c: y) c.push_back(c.back());
+
+  for (int p=1; p<np; ++p) {
+    for (auto kk: kicks) {
+      kk.mux += p*Qx;
+      kk.muy += p*Qy;
+      rt.add(kk);
+    }
+  }
+
+  if (CtSt_.IsRingCh) rt.close(np*Qx, np*Qy);
+
+  format_to(outbuf, "\n{:d} kicks", rt.kicks());
+  if (np > 1) format_to(outbuf, " ({:d} periods)", np);
+  format_to(outbuf, "\n\n{:>8s} {:>12s} {:>12s} {:>12s} {:>12s}", "Term", "|h|", "Re h", "Im h", "|h1|");
+  if (CtSt_.IsRingCh) format_to(outbuf, " {:>12s}", "|f|");
+  format_to(outbuf, "\n");
+
+  for (auto const& t: summary) {
+    auto h = rt.h(t);
+    format_to(outbuf, "{:>8s} {:12.5g} {:12.5g} {:12.5g} {:12.5g}", label(t), std::abs(h), h.real(), h.imag(), std::abs(rt.h1(t)));
+    if (CtSt_.IsRingCh) format_to(outbuf, " {:12.5g}", std::abs(rt.f(t)));
+    format_to(outbuf, "\n");
+  }
+
+  if (CtSt_.IsRingCh) {
+    format_to(outbuf, "\n{:30s} Qx = {:10g}, Qy = {:10g}\n", "Tunes:", np*Qx, np*Qy);
+    format_to(outbuf, "{:30s} dQx/dJx = {:10g}, dQx/dJy = dQy/dJx = {:10g}, dQy/dJy = {:10g}\n", 
+                      "Detuning with amplitude [1/m]:", rt.dQxdJx(), rt.dQxdJy(), rt.dQydJy());
+    format_to(outbuf, "{:30s} {:10g} (hor) {:10g} (ver)\n", "Chromaticities:", rt.xi1(0), rt.xi1(1));
+    format_to(outbuf, "{:30s} {:10g} (hor) {:10g} (ver)\n", "Second order chromaticities:", rt.xi2(0), rt.xi2(1));
+    format_to(outbuf, "(Q = Q0 + xi1 dp/p + xi2 (dp/p)^2; J in m, bend curvature and edge terms not included)\n");
+  }
+
+  format_to(outbuf,"{:c}",0);
+  editor->insertPlainText(outbufraw.data());
+  editor->document()->setModified(false);
+  editor->show();
+
+  PlotSpec plotspecs;
+  plotspecs.title        = "Resonance Driving Terms (cumulative)";
+  plotspecs.bottom_title = "S [m]";
+  auto& curvespecs = plotspecs.curvespecs;
+
+  for (unsigned c=0; c<y.size(); ++c) {
+    curvespecs.push_back({ label(geometric[c]), &x[0], &y[c][0], int(x.size()), QwtSymbol::NoSymbol, QwtPlot::yLeft, "|h|", ""} );  
+  }
+
+  addPlot(WindowId::RdtCh, plotspecs, legodata);
+}
@@ -179,7 +179,7 @@ void OptimMainWindow::Sizes(Twiss& v)
      if( nm=='A' || nm=='W' ||nm=='X' ) { ns=1; }
     
 
-     auto e = std::shared_ptr<Element>( ep->split(ns) );     
+     SliceRef e(*ep, ns, slice_arena_);     
 
      // calculates Element's boxes located at the bottom of screan
     
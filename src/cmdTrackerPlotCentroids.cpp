@@ -45,6 +45,7 @@
 #include <string>
 #include <Constants.h>
 #include <BeamMoments.h>
+#include <MomentsStore.h>
 #include <Globals.h>
 #include <Element.h>
 #include <RMatrix.h>
@@ -87,6 +88,7 @@ void OptimTrackerNew::cmdTrackerPlotCentroids()
     auto res = q.emit_result();
     nturns = res->get_int(0);
   }
+  MomentsStore::plotView(con);  // full resolution or rollup, depending on the no of turns
 
   std::vector<LegoData> legodata;
   double L = 0.0;
@@ -116,14 +118,14 @@ void OptimTrackerNew::cmdTrackerPlotCentroids()
     std::string q;
     if (dataspec_ == TrackerParameters::all) {  
       // moments are stored in cm.
-       q = fmt::format("SELECT pathlen,  avg(extract_dvec({:1d}, uavg)) FROM Moments GROUP BY eidx ORDER BY eidx;",i);
+       q = fmt::format("SELECT pathlen,  avg(avg{:1d}) FROM MomentsPlot GROUP BY eidx ORDER BY eidx;",i);
        curvespecs.push_back( { labels[i].c_str(),  0,  0,   0, QwtSymbol::Rect,  QwtPlot::yLeft,  "centroid position [mm]",  ""} );
        qlist.insert(qlist.end(), q);
      }
      else {
 	std::string sel;
 	for (auto it=elm_selection_.s.begin(); it != elm_selection_.s.end(); ++it) {
-	  q = fmt::format("SELECT turn, extract_dvec({:1d}, uavg) FROM Moments  WHERE (eidx=={:d}) ORDER BY turn;",i, (*it).first);
+	  q = fmt::format("SELECT turn, avg{:1d} FROM MomentsPlot  WHERE (eidx=={:d}) ORDER BY turn;",i, (*it).first);
           curvespecs.push_back( {(labels[i] + std::string("-") + (*it).second + std::string("-[") + std::to_string((*it).first) +"]").c_str(),  0,  0,   0, QwtSymbol::Rect,  QwtPlot::yLeft,  "centroid position [mm]",  ""} );
           qlist.insert(qlist.end(), q);
          }
@@ -43,6 +43,7 @@
 
 #include <Constants.h>
 #include <BeamMoments.h>
+#include <MomentsStore.h>
 #include <Globals.h>
 #include <Element.h>
 #include <RMatrix.h>
@@ -96,6 +97,7 @@ void OptimTrackerNew::cmdTrackerPlotDispersion()
     auto res = q.emit_result();
     nturns = res->get_int(0);
   }
+  MomentsStore::plotView(con);  // full resolution or rollup, depending on the no of turns
 
   std::vector<LegoData> legodata;
   double L = 0.0;
@@ -117,22 +119,22 @@ void OptimTrackerNew::cmdTrackerPlotDispersion()
   std::string q;
   
   if  (dataspec_ == TrackerParameters::all) {
-    q = fmt::format("SELECT pathlen, 0.01*avg(extract_cov({:1d}, {:1d}, covariance)/extract_cov({:1d}, {:1d}, covariance))  FROM Moments GROUP BY eidx ORDER BY eidx;",0,5,5,5);
+    q = fmt::format("SELECT pathlen, 0.01*avg({:s}/{:s})  FROM MomentsPlot GROUP BY eidx ORDER BY eidx;", BeamMoments::dbCovColumn(0,5), BeamMoments::dbCovColumn(5,5));
     dbspecs.queries.push_back(q);
-    q = fmt::format("SELECT pathlen, 0.01*avg(extract_cov({:1d}, {:1d}, covariance)/extract_cov({:1d}, {:1d}, covariance))  FROM Moments GROUP BY eidx ORDER BY eidx;",2,5,5,5);
+    q = fmt::format("SELECT pathlen, 0.01*avg({:s}/{:s})  FROM MomentsPlot GROUP BY eidx ORDER BY eidx;", BeamMoments::dbCovColumn(2,5), BeamMoments::dbCovColumn(5,5));
     dbspecs.queries.push_back(q);
-    q = fmt::format("SELECT pathlen, avg(extract_cov({:1d}, {:1d}, covariance)/extract_cov({:1d}, {:1d}, covariance)) FROM Moments GROUP BY eidx ORDER BY eidx;" ,1,5,5,5);
+    q = fmt::format("SELECT pathlen, avg({:s}/{:s}) FROM MomentsPlot GROUP BY eidx ORDER BY eidx;", BeamMoments::dbCovColumn(1,5), BeamMoments::dbCovColumn(5,5));
     dbspecs.queries.push_back(q);
-    q = fmt::format("SELECT pathlen, avg(extract_cov({:1d}, {:1d}, covariance)/extract_cov({:1d}, {:1d}, covariance)) FROM Moments GROUP BY eidx ORDER BY eidx;" ,3,5,5,5);
+    q = fmt::format("SELECT pathlen, avg({:s}/{:s}) FROM MomentsPlot GROUP BY eidx ORDER BY eidx;", BeamMoments::dbCovColumn(3,5), BeamMoments::dbCovColumn(5,5));
     dbspecs.queries.push_back(q);
 
   }				
   else {
         dbspecs.queries = 
-                    { "SELECT turn, 0.01*extract_lf(0, 0, mode1,mode2) FROM Moments WHERE (eidx==0) ORDER BY turn;",
-		      "SELECT turn, 0.01*extract_lf(1, 1, mode1,mode2) FROM Moments WHERE (eidx==0) ORDER BY turn;",
-		      "SELECT turn, 0.01*extract_lf(0, 1, mode1,mode2) FROM Moments WHERE (eidx==0) ORDER BY turn;",
-		      "SELECT turn, 0.01*extract_lf(1, 0, mode1,mode2) FROM Moments WHERE (eidx==0) ORDER BY turn;"
+                    { "SELECT turn, 0.01*extract_lf(0, 0, mode1,mode2) FROM MomentsPlot WHERE (eidx==0) ORDER BY turn;",
+		      "SELECT turn, 0.01*extract_lf(1, 1, mode1,mode2) FROM MomentsPlot WHERE (eidx==0) ORDER BY turn;",
+		      "SELECT turn, 0.01*extract_lf(0, 1, mode1,mode2) FROM MomentsPlot WHERE (eidx==0) ORDER BY turn;",
+		      "SELECT turn, 0.01*extract_lf(1, 0, mode1,mode2) FROM MomentsPlot WHERE (eidx==0) ORDER BY turn;"
 		    };
   }
        
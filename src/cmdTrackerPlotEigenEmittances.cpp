@@ -44,6 +44,7 @@
 #include <Constants.h>
 #include <Globals.h>
 #include <BeamMoments.h>
+#include <MomentsStore.h>
 #include <Element.h>
 #include <OptimCalc.h>
 #include <OptimExceptions.h>
@@ -87,6 +88,7 @@ void OptimTrackerNew::cmdTrackerPlotEigenEmittances()
     auto res = q.emit_result();
     nturns = res->get_int(0);
   }
+  MomentsStore::plotView(con);  // full resolution or rollup, depending on the no of turns
 
   std::vector<LegoData> legodata;
 
@@ -113,32 +115,32 @@ void OptimTrackerNew::cmdTrackerPlotEigenEmittances()
   std::string q; 
   
   if (dataspec_ == TrackerParameters::all) {
-    qlist.push_back("SELECT pathlen, avg(eps1) FROM Moments GROUP by eidx ORDER by eidx;");
+    qlist.push_back("SELECT pathlen, avg(eps1) FROM MomentsPlot GROUP by eidx ORDER by eidx;");
       curvespecs.push_back( {"eps1",  0,  0,   0, QwtSymbol::Rect,  QwtPlot::yLeft,  "eps1 [cm-rad]",  ""} );
-    qlist.push_back("SELECT pathlen, avg(eps2) FROM Moments GROUP by eidx ORDER by eidx;");
+    qlist.push_back("SELECT pathlen, avg(eps2) FROM MomentsPlot GROUP by eidx ORDER by eidx;");
       curvespecs.push_back( {"eps2",  0,  0,   0, QwtSymbol::Rect,  QwtPlot::yLeft,  "eps2 [cm-rad]",  ""} );
-      //qlist.push_back("SELECT pathlen, max(extract_dvec(0, umax)) FROM Moments GROUP by eidx ORDER by eidx;");
+      //qlist.push_back("SELECT pathlen, max(extract_dvec(0, umax)) FROM MomentsPlot GROUP by eidx ORDER by eidx;");
       // curvespecs.push_back( {"Xmax",  0,  0,   0, QwtSymbol::Rect,  QwtPlot::yRight,  "eps [cm-rad]",  ""} );
-      //qlist.push_back("SELECT pathlen, max(extract_dvec(2, umax)) FROM Moments GROUP by eidx ORDER by eidx;");
+      //qlist.push_back("SELECT pathlen, max(extract_dvec(2, umax)) FROM MomentsPlot GROUP by eidx ORDER by eidx;");
       //curvespecs.push_back( {"Ymax",  0,  0,   0, QwtSymbol::Rect,  QwtPlot::yRight,  "eps [cm-rad]",  ""} );
   }
   else {
     for (auto it=elm_selection_.begin(); it != elm_selection_.end(); ++it) {
 
       std::string sidx =  "-["+ std::to_string((*it).first) +"]";
-      q = fmt::format("SELECT turn, eps1 FROM Moments WHERE (eidx=={:d}) ORDER BY turn;", (*it).first);
+      q = fmt::format("SELECT turn, eps1 FROM MomentsPlot WHERE (eidx=={:d}) ORDER BY turn;", (*it).first);
       qlist.push_back(q);
       curvespecs.push_back( {(std::string("eps1") + "-" + (*it).second + sidx).c_str(),  0,  0,   0, QwtSymbol::Rect,  QwtPlot::yLeft,  "eps1 [cm-rad]",  ""} );
 
-      q = fmt::format("SELECT turn, eps2 FROM Moments WHERE (eidx=={:d}) ORDER BY turn;", (*it).first);
+      q = fmt::format("SELECT turn, eps2 FROM MomentsPlot WHERE (eidx=={:d}) ORDER BY turn;", (*it).first);
       qlist.push_back(q);
       curvespecs.push_back( {(std::string("eps2") + "-" + (*it).second +sidx).c_str(),  0,  0,   0, QwtSymbol::Rect,  QwtPlot::yLeft,  "eps2 [cm-rad]",  ""} );
  
-      //      q = fmt::format("SELECT turn, extract_dvec(0, umax) FROM Moments WHERE (eidx=={:d})  ORDER BY turn;", (*it).first);
+      //      q = fmt::format("SELECT turn, extract_dvec(0, umax) FROM MomentsPlot WHERE (eidx=={:d})  ORDER BY turn;", (*it).first);
       //qlist.push_back(q);
       //curvespecs.push_back( {(std::string("Xmax") + "-" + (*it).second +sidx).c_str(),  0,  0,   0, QwtSymbol::Rect,  QwtPlot::yRight,  "Xmax or Ymax [cm]",  ""} );
 
-      //q = fmt::format("SELECT turn, extract_dvec(1, umax) FROM Moments WHERE (eidx=={:d})  ORDER BY turn;", (*it).first);
+      //q = fmt::format("SELECT turn, extract_dvec(1, umax) FROM MomentsPlot WHERE (eidx=={:d})  ORDER BY turn;", (*it).first);
       //qlist.push_back(q);
       //curvespecs.push_back( {(std::string("Ymax") + "-" + (*it).second +sidx).c_str(),  0,  0,   0, QwtSymbol::Rect,  QwtPlot::yRight,  "Xmax or Ymax [cm]",  ""} );
     }
@@ -41,6 +41,7 @@
 
 #include <Constants.h>
 #include <BeamMoments.h>
+#include <MomentsStore.h>
 #include <Globals.h>
 #include <Element.h>
 #include <RMatrix.h>
@@ -104,12 +105,14 @@ void OptimTrackerNew::cmdTrackerPlotIntensity()
 
   std::list<std::string> qlist;
 
+  MomentsStore::plotView(*Globals::preferences().con);  // full resolution or rollup, depending on the no of turns
+
   if ( dataspec_ == TrackerParameters::all ) {
-    sql = std::string("SELECT pathlen, avg(nlost) FROM Moments GROUP BY eidx ORDER BY eidx;");
+    sql = std::string("SELECT pathlen, avg(nlost) FROM MomentsPlot GROUP BY eidx ORDER BY eidx;");
     curvespecs.push_back( {"NLost",  0,  0,   0, QwtSymbol::Rect,  QwtPlot::yLeft,  "NLost/turn",  ""} );
   }
   else {
-    sql = fmt::format("SELECT turn, nlost FROM Moments WHERE (eidx ==0) ORDER BY turn;");
+    sql = fmt::format("SELECT turn, nlost FROM MomentsPlot WHERE (eidx ==0) ORDER BY turn;");
     curvespecs.push_back( {"NLost",  0,  0,   0, QwtSymbol::Rect,  QwtPlot::yLeft,  "NLost",  ""} );
   }
 
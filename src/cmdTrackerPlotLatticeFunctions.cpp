@@ -43,6 +43,7 @@
 
 #include <Constants.h>
 #include <BeamMoments.h>
+#include <MomentsStore.h>
 #include <Globals.h>
 #include <Element.h>
 #include <RMatrix.h>
@@ -96,6 +97,7 @@ void OptimTrackerNew::cmdTrackerPlotLatticeFunctions()
     auto res = q.emit_result();
     nturns = res->get_int(0);
   }
+  MomentsStore::plotView(con);  // full resolution or rollup, depending on the no of turns
 
   std::vector<LegoData> legodata;
   double L = 0.0;
@@ -117,19 +119,19 @@ void OptimTrackerNew::cmdTrackerPlotLatticeFunctions()
   
   if  (dataspec_ == TrackerParameters::all) {
        dbspecs.queries = 
-                    { "SELECT pathlen, 0.01*avg(extract_lf(0, 0, mode1,mode2)) FROM Moments GROUP BY eidx ORDER BY eidx;",
-		      "SELECT pathlen, 0.01*avg(extract_lf(1, 1, mode1,mode2)) FROM Moments GROUP BY eidx ORDER BY eidx;",
-		      "SELECT pathlen, 0.01*avg(extract_lf(0, 1, mode1,mode2)) FROM Moments GROUP BY eidx ORDER BY eidx;",
-		      "SELECT pathlen, 0.01*avg(extract_lf(1, 0, mode1,mode2)) FROM Moments GROUP BY eidx ORDER BY eidx;"
+                    { "SELECT pathlen, 0.01*avg(extract_lf(0, 0, mode1,mode2)) FROM MomentsPlot GROUP BY eidx ORDER BY eidx;",
+		      "SELECT pathlen, 0.01*avg(extract_lf(1, 1, mode1,mode2)) FROM MomentsPlot GROUP BY eidx ORDER BY eidx;",
+		      "SELECT pathlen, 0.01*avg(extract_lf(0, 1, mode1,mode2)) FROM MomentsPlot GROUP BY eidx ORDER BY eidx;",
+		      "SELECT pathlen, 0.01*avg(extract_lf(1, 0, mode1,mode2)) FROM MomentsPlot GROUP BY eidx ORDER BY eidx;"
 		    };
 
   }				
   else {
         dbspecs.queries = 
-                    { "SELECT turn, 0.01*extract_lf(0, 0, mode1,mode2) FROM Moments WHERE (eidx==0) ORDER BY turn;",
-		      "SELECT turn, 0.01*extract_lf(1, 1, mode1,mode2) FROM Moments WHERE (eidx==0) ORDER BY turn;",
-		      "SELECT turn, 0.01*extract_lf(0, 1, mode1,mode2) FROM Moments WHERE (eidx==0) ORDER BY turn;",
-		      "SELECT turn, 0.01*extract_lf(1, 0, mode1,mode2) FROM Moments WHERE (eidx==0) ORDER BY turn;"
+                    { "SELECT turn, 0.01*extract_lf(0, 0, mode1,mode2) FROM MomentsPlot WHERE (eidx==0) ORDER BY turn;",
+		      "SELECT turn, 0.01*extract_lf(1, 1, mode1,mode2) FROM MomentsPlot WHERE (eidx==0) ORDER BY turn;",
+		      "SELECT turn, 0.01*extract_lf(0, 1, mode1,mode2) FROM MomentsPlot WHERE (eidx==0) ORDER BY turn;",
+		      "SELECT turn, 0.01*extract_lf(1, 0, mode1,mode2) FROM MomentsPlot WHERE (eidx==0) ORDER BY turn;"
 		    };
   }
        
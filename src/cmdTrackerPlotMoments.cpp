@@ -45,6 +45,7 @@
 #include <string>
 #include <Constants.h>
 #include <BeamMoments.h>
+#include <MomentsStore.h>
 #include <Globals.h>
 #include <Element.h>
 #include <RMatrix.h>
@@ -97,6 +98,7 @@ void OptimTrackerNew::cmdTrackerPlotMoments()
     auto res = q.emit_result();
     nturns = res->get_int(0);
   }
+  MomentsStore::plotView(con);  // full resolution or rollup, depending on the no of turns
 
   std::string labels[6][6];
   for (int i=0; i<6; ++i) {
@@ -137,14 +139,14 @@ void OptimTrackerNew::cmdTrackerPlotMoments()
       
       if (dataspec_ == TrackerParameters::all) {  
          // moments are stored in cm.
-	 q = fmt::format("SELECT pathlen, avg(extract_cov({:1d}, {:1d}, covariance)) FROM Moments GROUP BY eidx ORDER BY eidx;",i,j);
+	 q = fmt::format("SELECT pathlen, avg({:s}) FROM MomentsPlot GROUP BY eidx ORDER BY eidx;", BeamMoments::dbCovColumn(i,j));
 	 curvespecs.push_back( {labels[i][j].c_str(),  0,  0,   0, QwtSymbol::Rect,  QwtPlot::yLeft,  "magnitude [cm**2, cm or none]",  ""} );
          qlist.insert(qlist.end(), q);
       }
       else {
 	std::string sel;
 	for (auto it=elm_selection_.s.begin(); it != elm_selection_.s.end(); ++it) {
-	  q = fmt::format("SELECT turn,  extract_cov({:1d}, {:1d}, covariance) FROM Moments WHERE (eidx=={:d}) ORDER BY turn;", i,j, (*it).first);
+	  q = fmt::format("SELECT turn,  {:s} FROM MomentsPlot WHERE (eidx=={:d}) ORDER BY turn;", BeamMoments::dbCovColumn(i,j), (*it).first);
           curvespecs.push_back( {(labels[i][j] + std::string("-") + (*it).second + std::string("-[") + std::to_string((*it).first) +"]").c_str(),  0,  0,   0, QwtSymbol::Rect,  QwtPlot::yLeft,  "magnitude [cm**2, cm or none]", ""} );
           qlist.insert(qlist.end(), q);
        }
@@ -195,6 +197,7 @@ void OptimTrackerNew::cmdTrackerPlotCorrelations()
     auto res = q.emit_result();
     nturns = res->get_int(0);
   }
+  MomentsStore::plotView(con);  // full resolution or rollup, depending on the no of turns
 
   std::string labels[6][6];
   for (int i=0; i<6; ++i) {
@@ -235,14 +238,14 @@ void OptimTrackerNew::cmdTrackerPlotCorrelations()
       
       if (dataspec_ == TrackerParameters::all) {  
          // moments are stored in cm.
-	 q = fmt::format("SELECT pathlen, avg(extract_cor({:1d}, {:1d}, covariance)) FROM Moments GROUP BY eidx ORDER BY eidx;",i,j);
+	 q = fmt::format("SELECT pathlen, avg(extract_cor({:1d}, {:1d}, covariance)) FROM MomentsPlot GROUP BY eidx ORDER BY eidx;",i,j);
          curvespecs.push_back( {labels[i][j].c_str(),  0,  0,   0, QwtSymbol::Rect,  QwtPlot::yLeft,  "correlation",  ""} );
          qlist.insert(qlist.end(), q);
       }
       else {
 	std::string sel;
 	for (auto it=elm_selection_.s.begin(); it != elm_selection_.s.end(); ++it) {
-	  q = fmt::format("SELECT turn,  extract_cor({:1d}, {:1d}, covariance) FROM Moments WHERE (eidx=={:d}) ORDER BY turn;", i,j, (*it).first);
+	  q = fmt::format("SELECT turn,  extract_cor({:1d}, {:1d}, covariance) FROM MomentsPlot WHERE (eidx=={:d}) ORDER BY turn;", i,j, (*it).first);
           curvespecs.push_back( {(labels[i][j] + std::string("-") + (*it).second + std::string("-[") + std::to_string((*it).first) +"]").c_str(),  0,  0,   0, QwtSymbol::Rect,  QwtPlot::yLeft,  "correlation",  ""} );
           qlist.insert(qlist.end(), q);
        }
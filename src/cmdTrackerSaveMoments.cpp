@@ -109,7 +109,7 @@ void OptimTrackerNew::cmdTrackerSaveMoments()
   }
   fmt::print(fs, "\n");   
 
-  std::string sql = fmt::format("SELECT turn, eidx, pathlen, covariance FROM Moments ORDER BY turn,eidx;");
+  std::string sql = fmt::format("SELECT turn, eidx, pathlen, covariance FROM MomentsAll ORDER BY turn,eidx;");
 
   sqlite::connection& con = *Globals::preferences().con;
   sqlite::query q( con, sql);
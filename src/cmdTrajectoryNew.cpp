@@ -251,7 +251,7 @@ void OptimMainWindow::TrajectoryNew(Coordinates& v, Twiss& vt)
      if( nm == 'H') nscrapers++;
      if( nm == 'A' || nm == 'W' || nm == 'X' || nm=='Z' ) { ns=1; }
 
-     auto e = std::shared_ptr<Element>( ep->split(ns) ); 
+     SliceRef e(*ep, ns, slice_arena_); 
 
      // add element to lego plot 
 